@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * llist_delete_elements() dedupe benchmark, on lists where half of the
+ * elements are the same shared pointer, as Hessian refs make them. It is
+ * compared with the previous nested loop dedupe. Then a synthetic Hessian
+ * map with half of its values shared is deleted, the response destructor
+ * path.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "linkedlist.h"
+#include "hessian.h"
+
+static size_t deleted= 0;
+
+static void count_delete(void * element) {
+    deleted++;
+}
+
+/** the previous dedupe: delete each element not already seen before it */
+static void nested_delete_elements(void ** elements, size_t n, delete_element_func deletef) {
+    size_t i, j;
+    for (i= 0; i < n; i++) {
+        for (j= 0; j < i; j++) {
+            if (elements[j] == elements[i]) break;
+        }
+        if (j == i) deletef(elements[i]);
+    }
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void * element(size_t i) {
+    /* odd elements are the shared one */
+    return (void *)((i % 2) ? 1 : i + 2);
+}
+
+/** usec per nested loop dedupe of n elements */
+static double bench_nested(size_t n, int reps) {
+    void ** elements= calloc(n,sizeof(void *));
+    double elapsed= 0;
+    size_t i;
+    int r;
+    for (i= 0; i < n; i++) {
+        elements[i]= element(i);
+    }
+    for (r= 0; r < reps; r++) {
+        double start= now();
+        nested_delete_elements(elements,n,count_delete);
+        elapsed+= now() - start;
+    }
+    free(elements);
+    return elapsed / reps * 1e6;
+}
+
+/** usec per llist_delete_elements of n elements */
+static double bench_llist(size_t n, int reps) {
+    double elapsed= 0;
+    size_t i;
+    int r;
+    for (r= 0; r < reps; r++) {
+        linkedlist_t * list= llist_create();
+        double start;
+        for (i= 0; i < n; i++) {
+            llist_add(list,element(i));
+        }
+        start= now();
+        llist_delete_elements(list,count_delete);
+        elapsed+= now() - start;
+        llist_delete(list);
+    }
+    return elapsed / reps * 1e6;
+}
+
+/** usec per delete of a Hessian map of n pairs, half of the values shared */
+static double bench_map(size_t n, int reps) {
+    double elapsed= 0;
+    size_t i;
+    int r;
+    char key[32];
+    for (r= 0; r < reps; r++) {
+        hessian_object_t * map= hessian_create(HESSIAN_MAP,"bench.Map");
+        hessian_object_t * shared= hessian_create(HESSIAN_STRING,"shared");
+        double start;
+        for (i= 0; i < n; i++) {
+            snprintf(key,sizeof(key),"key-%d",(int)i);
+            hessian_map_add(map,hessian_create(HESSIAN_STRING,key),(i % 2) ? shared : hessian_create(HESSIAN_INTEGER,(int32_t)i));
+        }
+        start= now();
+        hessian_delete(map);
+        elapsed+= now() - start;
+    }
+    return elapsed / reps * 1e6;
+}
+
+int main(void) {
+    size_t sizes[]= { 10, 1000, 20000 };
+    size_t s;
+    printf("%8s %18s %18s %18s\n","elements","nested loop (us)","pointer set (us)","map delete (us)");
+    for (s= 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t n= sizes[s];
+        int reps= (n >= 20000) ? 3 : ((n >= 1000) ? 50 : 20000);
+        double nested_us= bench_nested(n,reps);
+        double llist_us= bench_llist(n,reps);
+        double map_us= bench_map(n,reps);
+        printf("%8d %18.2f %18.2f %18.2f\n",(int)n,nested_us,llist_us,map_us);
+    }
+    return (deleted == 0) ? 1 : 0;
+}
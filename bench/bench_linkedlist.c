@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * linkedlist_t benchmark: builds a list of n elements, then reads them back by
+ * index as the Hessian and XACML code does. The same is done with a singly
+ * linked node list walked from its head on each get, the previous
+ * linkedlist_t implementation, to show the scaling difference.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "linkedlist.h"
+
+/** node list: the previous linkedlist_t implementation */
+typedef struct node {
+    void * element;
+    struct node * next;
+} node_t;
+
+typedef struct {
+    size_t length;
+    node_t * head;
+    node_t * tail;
+} nodelist_t;
+
+static void nodelist_add(nodelist_t * list, void * element) {
+    node_t * node= calloc(1,sizeof(node_t));
+    node->element= element;
+    if (list->head == NULL) {
+        list->head= node;
+    }
+    else {
+        list->tail->next= node;
+    }
+    list->tail= node;
+    list->length++;
+}
+
+static void * nodelist_get(const nodelist_t * list, size_t i) {
+    node_t * node= list->head;
+    while (i-- > 0) {
+        node= node->next;
+    }
+    return node->element;
+}
+
+static void nodelist_delete(nodelist_t * list) {
+    while (list->head != NULL) {
+        node_t * next= list->head->next;
+        free(list->head);
+        list->head= next;
+    }
+    list->tail= NULL;
+    list->length= 0;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/** usec per build and indexed scan of a linkedlist_t of n elements */
+static double bench_llist(size_t n, int reps, size_t * sum) {
+    int r;
+    size_t i;
+    double start= now();
+    for (r= 0; r < reps; r++) {
+        linkedlist_t * list= llist_create();
+        for (i= 0; i < n; i++) {
+            llist_add(list,(void *)(i + 1));
+        }
+        for (i= 0; i < n; i++) {
+            *sum+= (size_t)llist_get(list,(int)i);
+        }
+        llist_delete(list);
+    }
+    return (now() - start) / reps * 1e6;
+}
+
+/** usec per build and indexed scan of a node list of n elements */
+static double bench_nodelist(size_t n, int reps, size_t * sum) {
+    int r;
+    size_t i;
+    double start= now();
+    for (r= 0; r < reps; r++) {
+        nodelist_t list= { 0, NULL, NULL };
+        for (i= 0; i < n; i++) {
+            nodelist_add(&list,(void *)(i + 1));
+        }
+        for (i= 0; i < n; i++) {
+            *sum+= (size_t)nodelist_get(&list,i);
+        }
+        nodelist_delete(&list);
+    }
+    return (now() - start) / reps * 1e6;
+}
+
+int main(void) {
+    size_t sizes[]= { 10, 100, 10000 };
+    size_t s, sum= 0;
+    printf("%8s %16s %16s\n","elements","node list (us)","linkedlist (us)");
+    for (s= 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t n= sizes[s];
+        int reps= (n >= 10000) ? 5 : (int)(200000 / n);
+        double node_us= bench_nodelist(n,reps,&sum);
+        double llist_us= bench_llist(n,reps,&sum);
+        printf("%8d %16.2f %16.2f\n",(int)n,node_us,llist_us);
+    }
+    /* keep the scans */
+    return (sum == 0) ? 1 : 0;
+}
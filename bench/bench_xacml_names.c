@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * XACML map type and key identification benchmark: xacml_name_lookup() is
+ * compared with the previous strcmp chains on the keys of a response with
+ * obligations. Then responses with 3 results and a growing number of
+ * obligations of 6 attribute assignments are unmarshalled.
+ *
+ * xacml_name_lookup() is static: io.c is included, and not linked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "io.c"
+#include "profiles.h"
+
+#define RESULTS 3
+#define ASSIGNMENTS 6
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/** the previous key identification of the result, obligation and attribute assignment maps */
+static xacml_name_t strcmp_chain(const char * key) {
+    if (strcmp(XACML_HESSIAN_RESULT_DECISION,key) == 0) return XACML_KEY_DECISION;
+    else if (strcmp(XACML_HESSIAN_RESULT_RESOURCEID,key) == 0) return XACML_KEY_RESOURCEID;
+    else if (strcmp(XACML_HESSIAN_RESULT_STATUS,key) == 0) return XACML_KEY_STATUS;
+    else if (strcmp(XACML_HESSIAN_RESULT_OBLIGATIONS,key) == 0) return XACML_KEY_OBLIGATIONS;
+    else if (strcmp(XACML_HESSIAN_OBLIGATION_ID,key) == 0) return XACML_KEY_ID;
+    else if (strcmp(XACML_HESSIAN_OBLIGATION_FULFILLON,key) == 0) return XACML_KEY_FULFILLON;
+    else if (strcmp(XACML_HESSIAN_OBLIGATION_ASSIGNMENTS,key) == 0) return XACML_KEY_ATTRIBUTEASSIGNMENTS;
+    else if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID,key) == 0) return XACML_KEY_ATTRIBUTEID;
+    else if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_DATATYPE,key) == 0) return XACML_KEY_DATATYPE;
+    else if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE,key) == 0) return XACML_KEY_VALUE;
+    else if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUES,key) == 0) return XACML_KEY_VALUES;
+    return XACML_NAME_UNKNOWN;
+}
+
+/* the map types and keys of an obligation, in the order they are read */
+static const char * const obligation_names[]= {
+    XACML_HESSIAN_OBLIGATION_CLASSNAME,
+    XACML_HESSIAN_OBLIGATION_ID,
+    XACML_HESSIAN_OBLIGATION_FULFILLON,
+    XACML_HESSIAN_OBLIGATION_ASSIGNMENTS,
+    XACML_HESSIAN_ATTRIBUTEASSIGNMENT_CLASSNAME,
+    XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID,
+    XACML_HESSIAN_ATTRIBUTEASSIGNMENT_DATATYPE,
+    XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE
+};
+
+#define NAMES (sizeof(obligation_names) / sizeof(obligation_names[0]))
+
+static unsigned long checksum= 0;
+
+/** nsec per name identification, with the lookup or the strcmp chain */
+static double bench_names(int lookup, int reps) {
+    size_t name_l[NAMES], i;
+    double start;
+    int r;
+    for (i= 0; i < NAMES; i++) {
+        name_l[i]= strlen(obligation_names[i]);
+    }
+    start= now();
+    for (r= 0; r < reps; r++) {
+        for (i= 0; i < NAMES; i++) {
+            if (lookup) {
+                checksum+= xacml_name_lookup(obligation_names[i],name_l[i]);
+            }
+            else if (i == 0 || i == 4) {
+                /* map types were checked with one strcmp */
+                checksum+= (strcmp(obligation_names[i],(i == 0) ? XACML_HESSIAN_OBLIGATION_CLASSNAME : XACML_HESSIAN_ATTRIBUTEASSIGNMENT_CLASSNAME) == 0);
+            }
+            else {
+                checksum+= strcmp_chain(obligation_names[i]);
+            }
+        }
+    }
+    return (now() - start) / ((double)reps * NAMES) * 1e9;
+}
+
+static hessian_object_t * model_map(const char * classname) {
+    return hessian_create(HESSIAN_MAP,classname);
+}
+
+static void map_put(hessian_object_t * map, const char * key, hessian_object_t * value) {
+    hessian_map_add(map,hessian_create(HESSIAN_STRING,key),value);
+}
+
+/** Hessian encoding of a response of RESULTS results of n obligations */
+static BUFFER * response_create(int n) {
+    hessian_object_t * response= model_map(XACML_HESSIAN_RESPONSE_CLASSNAME);
+    hessian_object_t * results= hessian_create(HESSIAN_LIST);
+    BUFFER * output= buffer_create(1024);
+    char value[64];
+    int i, j, k;
+    for (i= 0; i < RESULTS; i++) {
+        hessian_object_t * result= model_map(XACML_HESSIAN_RESULT_CLASSNAME);
+        hessian_object_t * status= model_map(XACML_HESSIAN_STATUS_CLASSNAME);
+        hessian_object_t * status_code= model_map(XACML_HESSIAN_STATUSCODE_CLASSNAME);
+        hessian_object_t * obligations= hessian_create(HESSIAN_LIST);
+        map_put(status_code,XACML_HESSIAN_STATUSCODE_VALUE,hessian_create(HESSIAN_STRING,XACML_STATUSCODE_OK));
+        map_put(status_code,XACML_HESSIAN_STATUSCODE_SUBCODE,hessian_create(HESSIAN_NULL));
+        map_put(status,XACML_HESSIAN_STATUS_MESSAGE,hessian_create(HESSIAN_STRING,"OK"));
+        map_put(status,XACML_HESSIAN_STATUS_CODE,status_code);
+        for (j= 0; j < n; j++) {
+            hessian_object_t * obligation= model_map(XACML_HESSIAN_OBLIGATION_CLASSNAME);
+            hessian_object_t * assignments= hessian_create(HESSIAN_LIST);
+            map_put(obligation,XACML_HESSIAN_OBLIGATION_ID,hessian_create(HESSIAN_STRING,XACML_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX));
+            map_put(obligation,XACML_HESSIAN_OBLIGATION_FULFILLON,hessian_create(HESSIAN_INTEGER,(int32_t)XACML_FULFILLON_PERMIT));
+            for (k= 0; k < ASSIGNMENTS; k++) {
+                hessian_object_t * assignment= model_map(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_CLASSNAME);
+                snprintf(value,sizeof(value),"user%d-%d",j,k);
+                map_put(assignment,XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID,hessian_create(HESSIAN_STRING,XACML_GRIDWN_ATTRIBUTE_USER_ID));
+                map_put(assignment,XACML_HESSIAN_ATTRIBUTEASSIGNMENT_DATATYPE,hessian_create(HESSIAN_STRING,XACML_DATATYPE_STRING));
+                map_put(assignment,XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE,hessian_create(HESSIAN_STRING,value));
+                hessian_list_add(assignments,assignment);
+            }
+            map_put(obligation,XACML_HESSIAN_OBLIGATION_ASSIGNMENTS,assignments);
+            hessian_list_add(obligations,obligation);
+        }
+        map_put(result,XACML_HESSIAN_RESULT_DECISION,hessian_create(HESSIAN_INTEGER,(int32_t)XACML_DECISION_PERMIT));
+        map_put(result,XACML_HESSIAN_RESULT_RESOURCEID,hessian_create(HESSIAN_STRING,"x-urn:bench:resource"));
+        map_put(result,XACML_HESSIAN_RESULT_STATUS,status);
+        map_put(result,XACML_HESSIAN_RESULT_OBLIGATIONS,obligations);
+        hessian_list_add(results,result);
+    }
+    map_put(response,XACML_HESSIAN_RESPONSE_REQUEST,hessian_create(HESSIAN_NULL));
+    map_put(response,XACML_HESSIAN_RESPONSE_RESULTS,results);
+    if (hessian_serialize(response,output) != HESSIAN_OK) {
+        fprintf(stderr,"can't serialize the response\n");
+        exit(1);
+    }
+    hessian_delete(response);
+    return output;
+}
+
+/** usec per unmarshalling of the response, best of reps */
+static double bench_unmarshalling(BUFFER * input, int reps) {
+    arena_t * arena= arena_create(0);
+    double best= 0;
+    int r;
+    for (r= 0; r < reps; r++) {
+        xacml_response_t * response= NULL;
+        double start, elapsed;
+        buffer_rewind(input);
+        start= now();
+        if (xacml_response_unmarshalling(&response,input,arena) != PEP_OK) {
+            fprintf(stderr,"can't unmarshal the response\n");
+            exit(1);
+        }
+        elapsed= now() - start;
+        checksum+= xacml_response_results_length(response);
+        xacml_response_delete(response);
+        if (r == 0 || elapsed < best) best= elapsed;
+    }
+    arena_delete(arena);
+    return best * 1e6;
+}
+
+int main(void) {
+    int obligations[]= { 1, 20, 200 };
+    size_t o;
+    printf("%-24s %12s\n","name identification","ns/name");
+    printf("%-24s %12.2f\n","strcmp chain",bench_names(0,2000000));
+    printf("%-24s %12.2f\n","xacml_name_lookup",bench_names(1,2000000));
+    printf("\n%12s %12s %18s\n","obligations","bytes","unmarshal (us)");
+    for (o= 0; o < sizeof(obligations) / sizeof(obligations[0]); o++) {
+        BUFFER * input= response_create(obligations[o]);
+        size_t input_l= buffer_length(input);
+        double unmarshal_us= bench_unmarshalling(input,(obligations[o] >= 200) ? 7 : 200);
+        printf("%12d %12d %18.2f\n",RESULTS * obligations[o],(int)input_l,unmarshal_us);
+        buffer_delete(input);
+    }
+    return (checksum == 0) ? 1 : 0;
+}
@@ -22,9 +22,11 @@
 #include "log.h"
 
 #include "xacml.h"
+#include "attributeindex.h"
 
 struct xacml_action {
     linkedlist_t * attributes;
+    xacml_attributeindex_t * index; /* attributes by id, built by the first lookup */
 };
 
 xacml_action_t * xacml_action_create() {
@@ -51,11 +53,13 @@ int xacml_action_addattribute(xacml_action_t * action, xacml_attribute_t * attr)
         log_error("xacml_action_addattribute: can't add attribute to list.");
         return PEP_XACML_ERROR;
     }
-    else return PEP_XACML_OK;
+    xacml_attributeindex_add(&(action->index),attr);
+    return PEP_XACML_OK;
 }
 
 void xacml_action_delete(xacml_action_t * action) {
     if (action == NULL) return;
+    xacml_attributeindex_delete(action->index);
     llist_delete_elements(action->attributes,(delete_element_func)xacml_attribute_delete);
     llist_delete(action->attributes);
     free(action);
@@ -78,3 +82,11 @@ xacml_attribute_t * xacml_action_getattribute(const xacml_action_t * action, int
     return llist_get(action->attributes, index);
 }
 
+xacml_attribute_t * xacml_action_findattribute(xacml_action_t * action, const char * id) {
+    if (action == NULL || id == NULL) {
+        log_error("xacml_action_findattribute: NULL action or id.");
+        return NULL;
+    }
+    return xacml_attributeindex_find(&(action->index),action->attributes,id);
+}
+
@@ -23,12 +23,15 @@
 #include "log.h"
 
 #include "xacml.h"
+#include "intern.h"
+#include "attributeindex.h"
 
 struct xacml_attribute {
-    char * id; /* mandatory */
-    char * datatype; /* optional */
-    char * issuer; /* optional */
+    const char * id; /* mandatory, interned if known */
+    const char * datatype; /* optional, interned if known */
+    const char * issuer; /* optional, interned if known */
     linkedlist_t * values; /* string list */
+    xacml_attributeindex_t ** index; /* index of the container, once added */
 };
 
 /**
@@ -42,21 +45,20 @@ xacml_attribute_t * xacml_attribute_create(const char * id) {
     }
     attr->id= NULL;
     if (id != NULL) {
-        size_t size= strlen(id);
-        attr->id= calloc(size + 1,sizeof(char));
+        attr->id= xacml_strintern(id);
         if (attr->id == NULL) {
-            log_error("xacml_attribute_create: can't allocate id (%d bytes).",(int)size);
+            log_error("xacml_attribute_create: can't allocate id (%d bytes).",(int)strlen(id));
             free(attr);
             return NULL;
         }
-        strncpy(attr->id,id,size);
     }
     attr->datatype= NULL;
     attr->issuer= NULL;
+    attr->index= NULL;
     attr->values= llist_create();
     if (attr->values == NULL) {
         log_error("xacml_attribute_create: can't create values list.");
-        free(attr->id);
+        xacml_strfree(attr->id);
         free(attr);
         return NULL;
     }
@@ -109,7 +111,6 @@ xacml_attribute_t * xacml_attribute_clone(const xacml_attribute_t * attr) {
  * Sets the PEP attribute id. id is mandatory and can't be NULL.
  */
 int xacml_attribute_setid(xacml_attribute_t * attr, const char * id) {
-    size_t size;
     if (attr == NULL) {
         log_error("xacml_attribute_setid: NULL attribute.");
         return PEP_XACML_ERROR;
@@ -118,19 +119,24 @@ int xacml_attribute_setid(xacml_attribute_t * attr, const char * id) {
         log_error("xacml_attribute_setid: NULL id.");
         return PEP_XACML_ERROR;
     }
-    if (attr->id != NULL) {
-        free(attr->id);
+    if (attr->index != NULL) {
+        /* the container index is rebuilt with the new id by the next lookup */
+        xacml_attributeindex_delete(*(attr->index));
+        *(attr->index)= NULL;
     }
-    size= strlen(id);
-    attr->id= calloc(size + 1,sizeof(char));
+    xacml_strfree(attr->id);
+    attr->id= xacml_strintern(id);
     if (attr->id == NULL) {
-        log_error("xacml_attribute_setid: can't allocate id (%d bytes).", (int)size);
+        log_error("xacml_attribute_setid: can't allocate id (%d bytes).", (int)strlen(id));
         return PEP_XACML_ERROR;
     }
-    strncpy(attr->id,id,size);
     return PEP_XACML_OK;
 }
 
+void xacml_attribute_setindex(xacml_attribute_t * attr, xacml_attributeindex_t ** index) {
+    attr->index= index;
+}
+
 const char * xacml_attribute_getid(const xacml_attribute_t * attr) {
     if (attr == NULL) {
         log_error("xacml_attribute_getid: NULL attribute.");
@@ -147,18 +153,14 @@ int xacml_attribute_setdatatype(xacml_attribute_t * attr, const char * datatype)
         log_error("xacml_attribute_setdatatype: NULL attribute.");
         return PEP_XACML_ERROR;
     }
-    if (attr->datatype != NULL) {
-        free(attr->datatype);
-    }
+    xacml_strfree(attr->datatype);
     attr->datatype= NULL;
     if (datatype != NULL) {
-        size_t size= strlen(datatype);
-        attr->datatype= calloc(size + 1,sizeof(char));
+        attr->datatype= xacml_strintern(datatype);
         if (attr->datatype == NULL) {
-            log_error("xacml_attribute_setdatatype: can't allocate datatype (%d bytes).", (int)size);
+            log_error("xacml_attribute_setdatatype: can't allocate datatype (%d bytes).", (int)strlen(datatype));
             return PEP_XACML_ERROR;
         }
-        strncpy(attr->datatype,datatype,size);
     }
     return PEP_XACML_OK;
 }
@@ -180,18 +182,14 @@ int xacml_attribute_setissuer(xacml_attribute_t * attr, const char * issuer) {
         log_error("xacml_attribute_setissuer: NULL attribute.");
         return PEP_XACML_ERROR;
     }
-    if (attr->issuer != NULL) {
-        free(attr->issuer);
-    }
+    xacml_strfree(attr->issuer);
     attr->issuer= NULL;
     if (issuer != NULL) {
-        size_t size= strlen(issuer);
-        attr->issuer= calloc(size + 1,sizeof(char));
+        attr->issuer= xacml_strintern(issuer);
         if (attr->issuer == NULL) {
-            log_error("xacml_attribute_setissuer: can't allocate issuer (%d bytes).", (int)size);
+            log_error("xacml_attribute_setissuer: can't allocate issuer (%d bytes).", (int)strlen(issuer));
             return PEP_XACML_ERROR;
         }
-        strncpy(attr->issuer,issuer,size);
     }
     return PEP_XACML_OK;
 
@@ -257,9 +255,9 @@ const char * xacml_attribute_getvalue(const xacml_attribute_t * attr,int index)
  */
 void xacml_attribute_delete(xacml_attribute_t * attr) {
     if (attr == NULL) return;
-    if (attr->id != NULL) free(attr->id);
-    if (attr->datatype != NULL) free(attr->datatype);
-    if (attr->issuer != NULL) free(attr->issuer);
+    xacml_strfree(attr->id);
+    xacml_strfree(attr->datatype);
+    xacml_strfree(attr->issuer);
     llist_delete_elements(attr->values,(delete_element_func)free);
     llist_delete(attr->values);
     free(attr);
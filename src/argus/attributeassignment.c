@@ -22,10 +22,11 @@
 #include "log.h"
 
 #include "xacml.h"
+#include "intern.h"
 
 struct xacml_attributeassignment {
-    char * id; /* mandatory */
-    char * datatype;
+    const char * id; /* mandatory, interned if known */
+    const char * datatype; /* interned if known */
     char * value;
 };
 
@@ -40,14 +41,12 @@ xacml_attributeassignment_t * xacml_attributeassignment_create(const char * id)
     }
     attr->id= NULL;
     if (id != NULL) {
-        size_t size= strlen(id);
-        attr->id= calloc(size + 1,sizeof(char));
+        attr->id= xacml_strintern(id);
         if (attr->id == NULL) {
-            log_error("xacml_attributeassignment_create: can't allocate id (%d bytes).",(int)size);
+            log_error("xacml_attributeassignment_create: can't allocate id (%d bytes).",(int)strlen(id));
             free(attr);
             return NULL;
         }
-        strncpy(attr->id,id,size);
     }
     return attr;
 }
@@ -56,7 +55,6 @@ xacml_attributeassignment_t * xacml_attributeassignment_create(const char * id)
  * Sets the PEP attribute id. id is mandatory and can't be NULL.
  */
 int xacml_attributeassignment_setid(xacml_attributeassignment_t * attr, const char * id) {
-    size_t size;
     if (attr == NULL) {
         log_error("xacml_attributeassignment_setid: NULL attribute.");
         return PEP_XACML_ERROR;
@@ -65,16 +63,12 @@ int xacml_attributeassignment_setid(xacml_attributeassignment_t * attr, const ch
         log_error("xacml_attributeassignment_setid: NULL id.");
         return PEP_XACML_ERROR;
     }
-    if (attr->id != NULL) {
-        free(attr->id);
-    }
-    size= strlen(id);
-    attr->id= calloc(size + 1,sizeof(char));
+    xacml_strfree(attr->id);
+    attr->id= xacml_strintern(id);
     if (attr->id == NULL) {
-        log_error("xacml_attributeassignment_setid: can't allocate id (%d bytes).", (int)size);
+        log_error("xacml_attributeassignment_setid: can't allocate id (%d bytes).", (int)strlen(id));
         return PEP_XACML_ERROR;
     }
-    strncpy(attr->id,id,size);
     return PEP_XACML_OK;
 }
 
@@ -98,19 +92,15 @@ int xacml_attributeassignment_setdatatype(xacml_attributeassignment_t * attr, co
         return PEP_XACML_ERROR;
     }
 
-    if (attr->datatype != NULL) {
-        free(attr->datatype);
-    }
+    xacml_strfree(attr->datatype);
 
     attr->datatype= NULL;
     if (datatype!=NULL) {
-        size_t size= strlen(datatype);
-        attr->datatype= calloc(size + 1,sizeof(char));
+        attr->datatype= xacml_strintern(datatype);
         if (attr->datatype == NULL) {
-            log_error("xacml_attributeassignment_setdatatype: can't allocate datatype (%d bytes).", (int)size);
+            log_error("xacml_attributeassignment_setdatatype: can't allocate datatype (%d bytes).", (int)strlen(datatype));
             return PEP_XACML_ERROR;
         }
-        strncpy(attr->datatype,datatype,size);
     }
     return PEP_XACML_OK;
 }
@@ -194,8 +184,8 @@ const char * xacml_attributeassignment_getvalue(const xacml_attributeassignment_
  */
 void xacml_attributeassignment_delete(xacml_attributeassignment_t * attr) {
     if (attr == NULL) return;
-    if (attr->id != NULL) free(attr->id);
-    if (attr->datatype != NULL) free(attr->datatype);
+    xacml_strfree(attr->id);
+    xacml_strfree(attr->datatype);
     if (attr->value != NULL) free(attr->value);
     free(attr);
     attr= NULL;
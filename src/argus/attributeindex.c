@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "attributeindex.h"
+#include "log.h" /* ../util/log.h */
+
+/**
+ * Open addressing hash table of the attributes, at most half full. The id
+ * hash is kept to compare ids only on a hash match.
+ */
+typedef struct xacml_attributeindex_entry {
+    uint64_t hash;
+    xacml_attribute_t * attr;
+} xacml_attributeindex_entry_t;
+
+struct xacml_attributeindex {
+    xacml_attributeindex_entry_t * entries;
+    size_t size; /* power of 2 */
+    size_t entries_l;
+};
+
+#define XACML_ATTRIBUTEINDEX_SIZE 32
+#define XACML_ATTRIBUTEINDEX_MULT UINT64_C(0x9E3779B97F4A7C15)
+
+/**
+ * Hash of the id, a word at a time.
+ */
+static uint64_t xacml_attributeindex_hash(const char * id) {
+    size_t id_l= strlen(id), i;
+    uint64_t hash= id_l * XACML_ATTRIBUTEINDEX_MULT, word;
+    for (i= 0; i + sizeof(word) <= id_l; i+= sizeof(word)) {
+        memcpy(&word,id + i,sizeof(word));
+        hash= (hash ^ word) * XACML_ATTRIBUTEINDEX_MULT;
+        hash^= hash >> 29;
+    }
+    for (; i < id_l; i++) {
+        hash= (hash ^ (unsigned char)id[i]) * XACML_ATTRIBUTEINDEX_MULT;
+    }
+    return hash ^ (hash >> 32);
+}
+
+/**
+ * Returns TRUE iff the ids are equal, interned ids are the same pointer.
+ */
+static int xacml_attributeindex_equals(const char * attr_id, const char * id) {
+    return attr_id == id || strcmp(attr_id,id) == 0;
+}
+
+/**
+ * Inserts the attribute in the table if its id is not already indexed, the
+ * first attribute with an id is kept.
+ */
+static void xacml_attributeindex_insert(xacml_attributeindex_entry_t * entries, size_t size, uint64_t hash, xacml_attribute_t * attr, size_t * entries_l) {
+    size_t slot= (size_t)hash & (size - 1);
+    while (entries[slot].attr != NULL) {
+        if (entries[slot].hash == hash
+            && xacml_attributeindex_equals(xacml_attribute_getid(entries[slot].attr),xacml_attribute_getid(attr))) {
+            return;
+        }
+        slot= (slot + 1) & (size - 1);
+    }
+    entries[slot].hash= hash;
+    entries[slot].attr= attr;
+    (*entries_l)++;
+}
+
+/**
+ * Resizes the table to size entries, and reinserts the attributes.
+ */
+static int xacml_attributeindex_resize(xacml_attributeindex_t * index, size_t size) {
+    xacml_attributeindex_entry_t * entries= calloc(size,sizeof(xacml_attributeindex_entry_t));
+    size_t i, entries_l= 0;
+    if (entries == NULL) {
+        log_error("xacml_attributeindex_resize: can't allocate %d entries.",(int)size);
+        return PEP_XACML_ERROR;
+    }
+    for (i= 0; i < index->size; i++) {
+        if (index->entries[i].attr != NULL) {
+            xacml_attributeindex_insert(entries,size,index->entries[i].hash,index->entries[i].attr,&entries_l);
+        }
+    }
+    free(index->entries);
+    index->entries= entries;
+    index->size= size;
+    index->entries_l= entries_l;
+    return PEP_XACML_OK;
+}
+
+/**
+ * Indexes the attribute, growing the table if needed.
+ */
+static int xacml_attributeindex_put(xacml_attributeindex_t * index, xacml_attribute_t * attr) {
+    const char * id= xacml_attribute_getid(attr);
+    if (id == NULL) {
+        /* can't be found */
+        return PEP_XACML_OK;
+    }
+    if ((index->entries_l + 1) * 2 > index->size
+        && xacml_attributeindex_resize(index,index->size * 2) != PEP_XACML_OK) {
+        return PEP_XACML_ERROR;
+    }
+    xacml_attributeindex_insert(index->entries,index->size,xacml_attributeindex_hash(id),attr,&(index->entries_l));
+    return PEP_XACML_OK;
+}
+
+/**
+ * Creates the index of the attributes list, or returns NULL.
+ */
+static xacml_attributeindex_t * xacml_attributeindex_create(linkedlist_t * attributes) {
+    size_t attributes_l= llist_length(attributes), size= XACML_ATTRIBUTEINDEX_SIZE, i;
+    xacml_attributeindex_t * index= calloc(1,sizeof(xacml_attributeindex_t));
+    if (index == NULL) {
+        log_error("xacml_attributeindex_create: can't allocate index.");
+        return NULL;
+    }
+    while (size < attributes_l * 2) size*= 2;
+    index->entries= calloc(size,sizeof(xacml_attributeindex_entry_t));
+    if (index->entries == NULL) {
+        log_error("xacml_attributeindex_create: can't allocate %d entries.",(int)size);
+        free(index);
+        return NULL;
+    }
+    index->size= size;
+    for (i= 0; i < attributes_l; i++) {
+        if (xacml_attributeindex_put(index,llist_get(attributes,(int)i)) != PEP_XACML_OK) {
+            xacml_attributeindex_delete(index);
+            return NULL;
+        }
+    }
+    return index;
+}
+
+xacml_attribute_t * xacml_attributeindex_find(xacml_attributeindex_t ** index, linkedlist_t * attributes, const char * id) {
+    size_t attributes_l, slot, i;
+    uint64_t hash;
+    if (id == NULL) {
+        return NULL;
+    }
+    attributes_l= llist_length(attributes);
+    if (*index == NULL && attributes_l > XACML_ATTRIBUTEINDEX_MIN) {
+        *index= xacml_attributeindex_create(attributes);
+    }
+    if (*index == NULL) {
+        /* small list, or no memory for the index */
+        for (i= 0; i < attributes_l; i++) {
+            xacml_attribute_t * attr= llist_get(attributes,(int)i);
+            const char * attr_id= xacml_attribute_getid(attr);
+            if (attr_id != NULL && xacml_attributeindex_equals(attr_id,id)) {
+                return attr;
+            }
+        }
+        return NULL;
+    }
+    hash= xacml_attributeindex_hash(id);
+    slot= (size_t)hash & ((*index)->size - 1);
+    while ((*index)->entries[slot].attr != NULL) {
+        const xacml_attributeindex_entry_t * entry= &((*index)->entries[slot]);
+        if (entry->hash == hash && xacml_attributeindex_equals(xacml_attribute_getid(entry->attr),id)) {
+            return entry->attr;
+        }
+        slot= (slot + 1) & ((*index)->size - 1);
+    }
+    return NULL;
+}
+
+void xacml_attributeindex_add(xacml_attributeindex_t ** index, xacml_attribute_t * attr) {
+    xacml_attribute_setindex(attr,index);
+    if (*index == NULL) {
+        return;
+    }
+    if (xacml_attributeindex_put(*index,attr) != PEP_XACML_OK) {
+        xacml_attributeindex_delete(*index);
+        *index= NULL;
+    }
+}
+
+void xacml_attributeindex_delete(xacml_attributeindex_t * index) {
+    if (index == NULL) return;
+    free(index->entries);
+    free(index);
+}
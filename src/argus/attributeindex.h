@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _PEP_ATTRIBUTEINDEX_H_
+#define _PEP_ATTRIBUTEINDEX_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include "linkedlist.h" /* ../util/linkedlist.h */
+#include "xacml.h"
+
+/**
+ * Hash index of the attributes of a Subject, Resource, Action or Environment
+ * by id, built by the first lookup in a list of more than
+ * XACML_ATTRIBUTEINDEX_MIN attributes and updated by the attribute adds.
+ * A smaller list is searched linearly.
+ *
+ * An added attribute refers to the index of its container, which is dropped
+ * by xacml_attribute_setid().
+ */
+typedef struct xacml_attributeindex xacml_attributeindex_t;
+
+#define XACML_ATTRIBUTEINDEX_MIN 8
+
+/**
+ * Returns the first attribute of the list with the id, or NULL. The index is
+ * built if needed: *index is NULL for a not yet built index.
+ */
+xacml_attribute_t * xacml_attributeindex_find(xacml_attributeindex_t ** index, linkedlist_t * attributes, const char * id);
+
+/**
+ * Indexes the attribute just added to the list, if the index is built, and
+ * records the index in the attribute. The index is dropped, to be rebuilt by
+ * the next lookup, if it can't be extended.
+ */
+void xacml_attributeindex_add(xacml_attributeindex_t ** index, xacml_attribute_t * attr);
+
+/**
+ * Releases the index, NULL is ignored.
+ */
+void xacml_attributeindex_delete(xacml_attributeindex_t * index);
+
+/**
+ * Sets the index of the container the attribute was added to, in attribute.c.
+ */
+void xacml_attribute_setindex(xacml_attribute_t * attr, xacml_attributeindex_t ** index);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
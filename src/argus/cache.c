@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "cache.h"
+#include "log.h" /* ../util/log.h */
+
+/**
+ * Cache entry, chained in its hash bucket and in the LRU list.
+ */
+typedef struct pep_cache_entry {
+    uint64_t digest;
+    char * request;
+    size_t request_l;
+    char * response;
+    size_t response_l;
+    time_t expires;
+    struct pep_cache_entry * bucket_next;
+    struct pep_cache_entry * lru_prev; /* more recently used */
+    struct pep_cache_entry * lru_next; /* less recently used */
+} pep_cache_entry_t;
+
+struct pep_cache {
+    pep_cache_entry_t ** buckets;
+    size_t buckets_l; /* power of 2 */
+    size_t length;
+    size_t max_entries;
+    pep_cache_entry_t * lru_head; /* most recently used */
+    pep_cache_entry_t * lru_tail; /* least recently used */
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+};
+
+uint64_t pep_cache_digest(const char * request, size_t request_l) {
+    uint64_t h= 0xcbf29ce484222325ULL;
+    size_t i;
+    for (i= 0; i<request_l; i++) {
+        h^= (unsigned char)request[i];
+        h*= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void cache_lru_unlink(pep_cache_t * cache, pep_cache_entry_t * entry) {
+    if (entry->lru_prev != NULL) entry->lru_prev->lru_next= entry->lru_next;
+    else cache->lru_head= entry->lru_next;
+    if (entry->lru_next != NULL) entry->lru_next->lru_prev= entry->lru_prev;
+    else cache->lru_tail= entry->lru_prev;
+    entry->lru_prev= entry->lru_next= NULL;
+}
+
+static void cache_lru_push(pep_cache_t * cache, pep_cache_entry_t * entry) {
+    entry->lru_prev= NULL;
+    entry->lru_next= cache->lru_head;
+    if (cache->lru_head != NULL) cache->lru_head->lru_prev= entry;
+    cache->lru_head= entry;
+    if (cache->lru_tail == NULL) cache->lru_tail= entry;
+}
+
+/** unlinks the entry from its bucket and the LRU list, and frees it */
+static void cache_remove(pep_cache_t * cache, pep_cache_entry_t * entry) {
+    pep_cache_entry_t ** link= &(cache->buckets[entry->digest & (cache->buckets_l - 1)]);
+    while (*link != entry) {
+        link= &((*link)->bucket_next);
+    }
+    *link= entry->bucket_next;
+    cache_lru_unlink(cache,entry);
+    cache->length--;
+    free(entry->request);
+    free(entry->response);
+    free(entry);
+}
+
+static pep_cache_entry_t * cache_find(pep_cache_t * cache, uint64_t digest, const char * request, size_t request_l) {
+    pep_cache_entry_t * entry= cache->buckets[digest & (cache->buckets_l - 1)];
+    while (entry != NULL) {
+        if (entry->digest == digest && entry->request_l == request_l && memcmp(entry->request,request,request_l) == 0) {
+            return entry;
+        }
+        entry= entry->bucket_next;
+    }
+    return NULL;
+}
+
+/** resizes the buckets array to hold max_entries with a load factor <= 1 */
+static int cache_rehash(pep_cache_t * cache, size_t max_entries) {
+    size_t i, buckets_l= 16;
+    pep_cache_entry_t ** buckets;
+    while (buckets_l < max_entries) {
+        buckets_l<<= 1;
+    }
+    if (buckets_l == cache->buckets_l) {
+        return PEP_CACHE_OK;
+    }
+    buckets= calloc(buckets_l,sizeof(pep_cache_entry_t *));
+    if (buckets == NULL) {
+        log_error("pep_cache: can't allocate %d buckets.",(int)buckets_l);
+        return PEP_CACHE_ERROR;
+    }
+    for (i= 0; i<cache->buckets_l; i++) {
+        pep_cache_entry_t * entry= cache->buckets[i];
+        while (entry != NULL) {
+            pep_cache_entry_t * next= entry->bucket_next;
+            size_t b= entry->digest & (buckets_l - 1);
+            entry->bucket_next= buckets[b];
+            buckets[b]= entry;
+            entry= next;
+        }
+    }
+    free(cache->buckets);
+    cache->buckets= buckets;
+    cache->buckets_l= buckets_l;
+    return PEP_CACHE_OK;
+}
+
+pep_cache_t * pep_cache_create(size_t max_entries) {
+    pep_cache_t * cache= calloc(1,sizeof(pep_cache_t));
+    if (cache == NULL) {
+        log_error("pep_cache_create: can't allocate pep_cache_t.");
+        return NULL;
+    }
+    if (cache_rehash(cache,max_entries) != PEP_CACHE_OK) {
+        free(cache);
+        return NULL;
+    }
+    cache->max_entries= max_entries;
+    return cache;
+}
+
+void pep_cache_setmaxentries(pep_cache_t * cache, size_t max_entries) {
+    if (cache == NULL) return;
+    cache->max_entries= max_entries;
+    while (cache->length > max_entries) {
+        cache_remove(cache,cache->lru_tail);
+        cache->evictions++;
+    }
+    cache_rehash(cache,max_entries);
+}
+
+int pep_cache_get(pep_cache_t * cache, const char * request, size_t request_l, BUFFER * response) {
+    pep_cache_entry_t * entry;
+    if (cache == NULL || request == NULL || response == NULL) {
+        log_error("pep_cache_get: NULL cache, request or response pointer.");
+        return PEP_CACHE_ERROR;
+    }
+    entry= cache_find(cache,pep_cache_digest(request,request_l),request,request_l);
+    if (entry != NULL && entry->expires <= time(NULL)) {
+        log_debug("pep_cache_get: cached response expired.");
+        cache_remove(cache,entry);
+        entry= NULL;
+    }
+    if (entry == NULL) {
+        cache->misses++;
+        return PEP_CACHE_MISS;
+    }
+    if (buffer_write(entry->response,1,entry->response_l,response) != entry->response_l) {
+        log_error("pep_cache_get: can't write %d bytes cached response.",(int)entry->response_l);
+        return PEP_CACHE_ERROR;
+    }
+    cache_lru_unlink(cache,entry);
+    cache_lru_push(cache,entry);
+    cache->hits++;
+    return PEP_CACHE_OK;
+}
+
+int pep_cache_put(pep_cache_t * cache, const char * request, size_t request_l, BUFFER * response, time_t ttl) {
+    pep_cache_entry_t * entry;
+    uint64_t digest;
+    size_t b;
+    if (cache == NULL || request == NULL || response == NULL) {
+        log_error("pep_cache_put: NULL cache, request or response pointer.");
+        return PEP_CACHE_ERROR;
+    }
+    if (ttl <= 0 || cache->max_entries == 0) {
+        return PEP_CACHE_OK;
+    }
+    digest= pep_cache_digest(request,request_l);
+    entry= cache_find(cache,digest,request,request_l);
+    if (entry != NULL) {
+        cache_remove(cache,entry);
+    }
+    entry= calloc(1,sizeof(pep_cache_entry_t));
+    if (entry == NULL) {
+        log_error("pep_cache_put: can't allocate cache entry.");
+        return PEP_CACHE_ERROR;
+    }
+    buffer_rewind(response);
+    entry->response_l= buffer_length(response);
+    entry->request= malloc(request_l);
+    entry->response= malloc(entry->response_l);
+    if (entry->request == NULL || entry->response == NULL) {
+        log_error("pep_cache_put: can't allocate cache entry request (%d bytes) or response (%d bytes).",(int)request_l,(int)entry->response_l);
+        free(entry->request);
+        free(entry->response);
+        free(entry);
+        return PEP_CACHE_ERROR;
+    }
+    memcpy(entry->request,request,request_l);
+    entry->request_l= request_l;
+    buffer_read(entry->response,1,entry->response_l,response);
+    buffer_rewind(response);
+    entry->digest= digest;
+    entry->expires= time(NULL) + ttl;
+
+    /* evict the least recently used entries */
+    while (cache->length >= cache->max_entries) {
+        cache_remove(cache,cache->lru_tail);
+        cache->evictions++;
+    }
+    b= digest & (cache->buckets_l - 1);
+    entry->bucket_next= cache->buckets[b];
+    cache->buckets[b]= entry;
+    cache_lru_push(cache,entry);
+    cache->length++;
+    return PEP_CACHE_OK;
+}
+
+void pep_cache_getstats(const pep_cache_t * cache, unsigned long * hits, unsigned long * misses, unsigned long * evictions) {
+    if (hits != NULL) *hits= (cache != NULL) ? cache->hits : 0;
+    if (misses != NULL) *misses= (cache != NULL) ? cache->misses : 0;
+    if (evictions != NULL) *evictions= (cache != NULL) ? cache->evictions : 0;
+}
+
+void pep_cache_delete(pep_cache_t * cache) {
+    if (cache == NULL) return;
+    while (cache->lru_head != NULL) {
+        cache_remove(cache,cache->lru_head);
+    }
+    free(cache->buckets);
+    free(cache);
+}
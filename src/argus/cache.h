@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _PEP_CACHE_H_
+#define _PEP_CACHE_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+#include <time.h> /* time_t */
+#include "buffer.h" /* ../util/buffer.h */
+
+/**
+ * Decision cache: bounded LRU of serialized Hessian XACML responses, keyed on
+ * the serialized Hessian XACML request.
+ *
+ * Entries are found by a digest of the request bytes, and the request bytes are
+ * compared on lookup, so a digest collision can never return the response of
+ * another request.
+ */
+typedef struct pep_cache pep_cache_t;
+
+/**
+ * Return codes
+ */
+#define PEP_CACHE_OK 0
+#define PEP_CACHE_ERROR -1
+#define PEP_CACHE_MISS 1
+
+/**
+ * Creates a decision cache holding at most max_entries responses.
+ *
+ * @param size_t max_entries maximum number of entries, the least recently used
+ *        entry is evicted when exceeded.
+ *
+ * @return pep_cache_t * the cache or NULL on error.
+ */
+pep_cache_t * pep_cache_create(size_t max_entries);
+
+/**
+ * Sets the maximum number of entries, evicting the least recently used ones if needed.
+ *
+ * @param pep_cache_t * cache the cache.
+ * @param size_t max_entries maximum number of entries.
+ */
+void pep_cache_setmaxentries(pep_cache_t * cache, size_t max_entries);
+
+/**
+ * Looks up the response for the request. On hit, the response bytes are
+ * written into the response buffer.
+ *
+ * @param pep_cache_t * cache the cache.
+ * @param const char * request the serialized request bytes.
+ * @param size_t request_l the request length.
+ * @param BUFFER * response the buffer to write the response bytes to.
+ *
+ * @return int PEP_CACHE_OK on hit, PEP_CACHE_MISS if not cached or expired,
+ *         or PEP_CACHE_ERROR.
+ */
+int pep_cache_get(pep_cache_t * cache, const char * request, size_t request_l, BUFFER * response);
+
+/**
+ * Caches the response for the request, during ttl seconds. An entry for the
+ * same request is replaced.
+ *
+ * @param pep_cache_t * cache the cache.
+ * @param const char * request the serialized request bytes.
+ * @param size_t request_l the request length.
+ * @param BUFFER * response the buffer holding the response bytes (rewound, not consumed).
+ * @param time_t ttl time to live in seconds, nothing is cached if ttl <= 0.
+ *
+ * @return int PEP_CACHE_OK or PEP_CACHE_ERROR.
+ */
+int pep_cache_put(pep_cache_t * cache, const char * request, size_t request_l, BUFFER * response, time_t ttl);
+
+/**
+ * Computes the digest of the serialized request bytes, used to find the cache entries.
+ *
+ * @param const char * request the serialized request bytes.
+ * @param size_t request_l the request length.
+ *
+ * @return uint64_t the FNV-1a 64 bits digest.
+ */
+uint64_t pep_cache_digest(const char * request, size_t request_l);
+
+/**
+ * Gets the cache counters.
+ *
+ * @param pep_cache_t * cache the cache.
+ * @param unsigned long * hits number of lookups which returned a response, or NULL.
+ * @param unsigned long * misses number of lookups which did not, or NULL.
+ * @param unsigned long * evictions number of entries evicted to respect the maximum number of entries, or NULL.
+ */
+void pep_cache_getstats(const pep_cache_t * cache, unsigned long * hits, unsigned long * misses, unsigned long * evictions);
+
+/**
+ * Deletes the cache and all its entries.
+ *
+ * @param pep_cache_t * cache the cache.
+ */
+void pep_cache_delete(pep_cache_t * cache);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
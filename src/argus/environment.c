@@ -22,9 +22,11 @@
 #include "log.h"
 
 #include "xacml.h"
+#include "attributeindex.h"
 
 struct xacml_environment {
 	linkedlist_t * attributes;
+	xacml_attributeindex_t * index; /* attributes by id, built by the first lookup */
 };
 
 xacml_environment_t * xacml_environment_create() {
@@ -51,7 +53,8 @@ int xacml_environment_addattribute(xacml_environment_t * env, xacml_attribute_t
 		log_error("xacml_environment_addattribute: can't add attribute to list.");
 		return PEP_XACML_ERROR;
 	}
-	else return PEP_XACML_OK;
+	xacml_attributeindex_add(&(env->index),attr);
+	return PEP_XACML_OK;
 }
 
 size_t xacml_environment_attributes_length(const xacml_environment_t * env) {
@@ -72,8 +75,17 @@ xacml_attribute_t * xacml_environment_getattribute(const xacml_environment_t * e
 
 }
 
+xacml_attribute_t * xacml_environment_findattribute(xacml_environment_t * env, const char * id) {
+	if (env == NULL || id == NULL) {
+		log_error("xacml_environment_findattribute: NULL environment or id.");
+		return NULL;
+	}
+	return xacml_attributeindex_find(&(env->index),env->attributes,id);
+}
+
 void xacml_environment_delete(xacml_environment_t * env) {
 	if (env == NULL) return;
+	xacml_attributeindex_delete(env->index);
 	llist_delete_elements(env->attributes,(delete_element_func)xacml_attribute_delete);
 	llist_delete(env->attributes);
 	free(env);
@@ -92,6 +92,9 @@ const char * pep_strerror(pep_error_t pep_errno) {
     case PEP_ERR_UNMARSHALLING_IO:
         return "Unmarshalling IO error";
         
+    case PEP_ERR_ABORTED:
+        return "Asynchronous authorization aborted";
+        
     default:
         return "Unkown error";
     }
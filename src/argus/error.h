@@ -72,7 +72,8 @@ typedef enum pep_error {
     PEP_ERR_MARSHALLING_HESSIAN, /**< Hessian marshalling error in pep_authorize(pep_request_t **,pep_response_t **) */
     PEP_ERR_MARSHALLING_IO, /**< IO error in pep_authorize(pep_request_t **,pep_response_t **) */
     PEP_ERR_UNMARSHALLING_HESSIAN, /**< Hessian unmarshalling error in pep_authorize(pep_request_t **,pep_response_t **) */
-    PEP_ERR_UNMARSHALLING_IO /**< IO error in pep_authorize(pep_request_t **,pep_response_t **) */
+    PEP_ERR_UNMARSHALLING_IO, /**< IO error in pep_authorize(pep_request_t **,pep_response_t **) */
+    PEP_ERR_ABORTED /**< In-flight asynchronous authorization aborted: by pep_destroy(PEP *) for pep_authorize_async(...), or by pep_authorize_batch(...) for its remaining requests when driving them fails */
 } pep_error_t;
 
 /**
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "intern.h"
+#include "xacml.h"
+#include "profiles.h"
+#include "log.h" /* ../util/log.h */
+
+/**
+ * The known XACML identifiers: XACML 2.0 datatypes, attribute ids, subject
+ * categories and status codes, and the AuthZ Interop and Grid WN profiles ids.
+ */
+static const char * const xacml_identifiers[]= {
+    XACML_DATATYPE_X500NAME,
+    XACML_DATATYPE_RFC822NAME,
+    XACML_DATATYPE_IPADDRESS,
+    XACML_DATATYPE_DNSNAME,
+    XACML_DATATYPE_STRING,
+    XACML_DATATYPE_BOOLEAN,
+    XACML_DATATYPE_INTEGER,
+    XACML_DATATYPE_DOUBLE,
+    XACML_DATATYPE_TIME,
+    XACML_DATATYPE_DATE,
+    XACML_DATATYPE_DATETIME,
+    XACML_DATATYPE_ANYURI,
+    XACML_DATATYPE_HEXBINARY,
+    XACML_DATATYPE_BASE64BINARY,
+    XACML_DATATYPE_DAY_TIME_DURATION,
+    XACML_DATATYPE_YEAR_MONTH_DURATION,
+    XACML_SUBJECT_ID,
+    XACML_SUBJECT_ID_QUALIFIER,
+    XACML_SUBJECT_KEY_INFO,
+    XACML_SUBJECT_CATEGORY_ACCESS,
+    XACML_SUBJECT_CATEGORY_INTERMEDIARY,
+    XACML_SUBJECT_CATEGORY_RECIPIENT,
+    XACML_SUBJECT_CATEGORY_CODEBASE,
+    XACML_SUBJECT_CATEGORY_REQUESTING_MACHINE,
+    XACML_RESOURCE_ID,
+    XACML_ACTION_ID,
+    XACML_ENVIRONMENT_CURRENT_TIME,
+    XACML_ENVIRONMENT_CURRENT_DATE,
+    XACML_ENVIRONMENT_CURRENT_DATETIME,
+    XACML_STATUSCODE_OK,
+    XACML_STATUSCODE_MISSINGATTRIBUTE,
+    XACML_STATUSCODE_SYNTAXERROR,
+    XACML_STATUSCODE_PROCESSINGERROR,
+    XACML_AUTHZINTEROP_SUBJECT_X509_ID,
+    XACML_AUTHZINTEROP_SUBJECT_X509_ISSUER,
+    XACML_AUTHZINTEROP_SUBJECT_VO,
+    XACML_AUTHZINTEROP_SUBJECT_CERTCHAIN,
+    XACML_AUTHZINTEROP_SUBJECT_VOMS_FQAN,
+    XACML_AUTHZINTEROP_SUBJECT_VOMS_PRIMARY_FQAN,
+    XACML_AUTHZINTEROP_OBLIGATION_UIDGID,
+    XACML_AUTHZINTEROP_OBLIGATION_SECONDARY_GIDS,
+    XACML_AUTHZINTEROP_OBLIGATION_USERNAME,
+    XACML_AUTHZINTEROP_OBLIGATION_AFS_TOKEN,
+    XACML_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_UID,
+    XACML_AUTHZINTEROP_OBLIGATION_ATTR_POSIX_GID,
+    XACML_AUTHZINTEROP_OBLIGATION_ATTR_USERNAME,
+    XACML_AUTHZINTEROP_OBLIGATION_ATTR_AFS_TOKEN,
+    XACML_GRIDWN_PROFILE_VERSION,
+    XACML_GRIDWN_ATTRIBUTE_PROFILE_ID,
+    XACML_GRIDWN_ATTRIBUTE_SUBJECT_ISSUER,
+    XACML_GRIDWN_ATTRIBUTE_VIRTUAL_ORGANIZATION,
+    XACML_GRIDWN_ATTRIBUTE_FQAN,
+    XACML_GRIDWN_ATTRIBUTE_FQAN_PRIMARY,
+    XACML_GRIDWN_ATTRIBUTE_PILOT_JOB_CLASSIFIER,
+    XACML_GRIDWN_ATTRIBUTE_VOMS_ISSUER,
+    XACML_GRIDWN_ATTRIBUTE_USER_ID,
+    XACML_GRIDWN_ATTRIBUTE_GROUP_ID,
+    XACML_GRIDWN_ATTRIBUTE_GROUP_ID_PRIMARY,
+    XACML_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP,
+    XACML_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX,
+    XACML_GRIDWN_DATATYPE_FQAN
+};
+
+#define XACML_IDENTIFIERS_L (sizeof(xacml_identifiers) / sizeof(xacml_identifiers[0]))
+
+/**
+ * Open addressing hash table of the identifiers, at most a quarter full. The
+ * identifiers are copied in one pool, so an interned pointer is recognized by
+ * its address.
+ */
+typedef struct xacml_intern_entry {
+    const char * str;
+    size_t str_l;
+} xacml_intern_entry_t;
+
+#define XACML_INTERN_SIZE 256
+#define XACML_INTERN_POOL_SIZE 4096
+
+static xacml_intern_entry_t xacml_intern_table[XACML_INTERN_SIZE];
+static char xacml_intern_pool[XACML_INTERN_POOL_SIZE];
+static size_t xacml_intern_min_l= 0;
+static pthread_once_t xacml_intern_once= PTHREAD_ONCE_INIT;
+
+/**
+ * Hash of the length and the last 8 chars (str_l >= 8): the identifiers are
+ * URNs and URLs sharing long prefixes.
+ */
+static size_t xacml_intern_hash(const char * str, size_t str_l) {
+    uint64_t word;
+    memcpy(&word,str + str_l - sizeof(word),sizeof(word));
+    word= (word ^ str_l) * UINT64_C(0x9E3779B97F4A7C15);
+    return (size_t)(word >> 56) & (XACML_INTERN_SIZE - 1);
+}
+
+/**
+ * Copies the identifiers in the pool and fills the table, once (pthread_once).
+ */
+static void xacml_intern_init(void) {
+    size_t i, pool_l= 0;
+    xacml_intern_min_l= SIZE_MAX;
+    for (i= 0; i < XACML_IDENTIFIERS_L; i++) {
+        size_t str_l= strlen(xacml_identifiers[i]);
+        size_t slot;
+        if (pool_l + str_l + 1 > XACML_INTERN_POOL_SIZE) {
+            log_error("xacml_intern_init: pool full, %s not interned.",xacml_identifiers[i]);
+            continue;
+        }
+        memcpy(xacml_intern_pool + pool_l,xacml_identifiers[i],str_l + 1);
+        slot= xacml_intern_hash(xacml_identifiers[i],str_l);
+        while (xacml_intern_table[slot].str != NULL) {
+            slot= (slot + 1) & (XACML_INTERN_SIZE - 1);
+        }
+        xacml_intern_table[slot].str= xacml_intern_pool + pool_l;
+        xacml_intern_table[slot].str_l= str_l;
+        pool_l+= str_l + 1;
+        if (str_l < xacml_intern_min_l) xacml_intern_min_l= str_l;
+    }
+}
+
+/**
+ * Returns the interned identifier equal to str of str_l bytes, or NULL.
+ */
+static const char * xacml_intern_lookup(const char * str, size_t str_l) {
+    size_t slot;
+    pthread_once(&xacml_intern_once,xacml_intern_init);
+    if (str_l < xacml_intern_min_l) {
+        return NULL;
+    }
+    slot= xacml_intern_hash(str,str_l);
+    while (xacml_intern_table[slot].str != NULL) {
+        const xacml_intern_entry_t * entry= &xacml_intern_table[slot];
+        if (entry->str_l == str_l && memcmp(entry->str,str,str_l) == 0) {
+            return entry->str;
+        }
+        slot= (slot + 1) & (XACML_INTERN_SIZE - 1);
+    }
+    return NULL;
+}
+
+const char * xacml_intern(const char * str) {
+    if (str == NULL) return NULL;
+    return xacml_intern_lookup(str,strlen(str));
+}
+
+const char * xacml_strintern(const char * str) {
+    size_t str_l;
+    const char * interned;
+    char * copy;
+    if (str == NULL) return NULL;
+    str_l= strlen(str);
+    interned= xacml_intern_lookup(str,str_l);
+    if (interned != NULL) {
+        return interned;
+    }
+    copy= malloc(str_l + 1);
+    if (copy == NULL) {
+        return NULL;
+    }
+    memcpy(copy,str,str_l + 1);
+    return copy;
+}
+
+void xacml_strfree(const char * str) {
+    /* interned identifiers are in the pool */
+    if ((uintptr_t)str - (uintptr_t)xacml_intern_pool < XACML_INTERN_POOL_SIZE) return;
+    free((char *)str);
+}
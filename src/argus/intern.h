@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _PEP_INTERN_H_
+#define _PEP_INTERN_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Interned XACML identifiers: the XACML_* constants of xacml.h and profiles.h
+ * are stored once, in a process-wide table which is immutable once initialized
+ * and safe to read from any thread. See xacml_intern().
+ *
+ * The XACML model setters store their identifiers with xacml_strintern() and
+ * release them with xacml_strfree(): a known identifier is shared, any other
+ * string is copied on the heap.
+ */
+
+/**
+ * Returns the interned identifier equal to str, or a heap copy of str if it
+ * is not a known identifier, or NULL on allocation error.
+ */
+const char * xacml_strintern(const char * str);
+
+/**
+ * Releases a string returned by xacml_strintern(). Does nothing for an interned
+ * identifier or NULL.
+ */
+void xacml_strfree(const char * str);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
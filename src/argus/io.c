@@ -24,23 +24,24 @@
 /** functions return codes  */
 #define PEP_IO_OK     0
 #define PEP_IO_ERROR -1
+#define PEP_IO_REF   -2 /* Hessian ref met by a pull reader */
 
 /**
  * Hessian 1.0 marshalling/unmarshalling prototypes.
  *
  * Returns PEP_IO_OK or PEP_IO_ERROR.
  */
-static int xacml_attribute_marshal(const xacml_attribute_t * attr, hessian_object_t ** h_attribute);
+static int xacml_attribute_marshal(const xacml_attribute_t * attr, BUFFER * output);
 static int xacml_attribute_unmarshal(xacml_attribute_t ** attr, const hessian_object_t * h_attribute);
-static int xacml_subject_marshal(const xacml_subject_t * subject, hessian_object_t ** h_subject);
+static int xacml_subject_marshal(const xacml_subject_t * subject, BUFFER * output);
 static int xacml_subject_unmarshal(xacml_subject_t ** subject, const hessian_object_t * h_subject);
-static int xacml_resource_marshal(const xacml_resource_t * resource, hessian_object_t ** h_resource);
+static int xacml_resource_marshal(const xacml_resource_t * resource, BUFFER * output);
 static int xacml_resource_unmarshal(xacml_resource_t ** resource, const hessian_object_t * h_resource);
-static int xacml_action_marshal(const xacml_action_t * action, hessian_object_t ** h_action);
+static int xacml_action_marshal(const xacml_action_t * action, BUFFER * output);
 static int xacml_action_unmarshal(xacml_action_t ** action, const hessian_object_t * h_action);
-static int xacml_environment_marshal(const xacml_environment_t * env, hessian_object_t ** h_environment);
+static int xacml_environment_marshal(const xacml_environment_t * env, BUFFER * output);
 static int xacml_environment_unmarshal(xacml_environment_t ** env, const hessian_object_t * h_environment);
-static int xacml_request_marshal(const xacml_request_t * request, hessian_object_t ** h_request);
+static int xacml_request_marshal(const xacml_request_t * request, BUFFER * output);
 static int xacml_request_unmarshal(xacml_request_t ** request, const hessian_object_t * h_request);
 static int xacml_response_unmarshal(xacml_response_t ** response, const hessian_object_t * h_response);
 static int xacml_result_unmarshal(xacml_result_t ** result, const hessian_object_t * h_result);
@@ -50,66 +51,186 @@ static int xacml_obligation_unmarshal(xacml_obligation_t ** obligation, const he
 static int xacml_attributeassignment_unmarshal(xacml_attributeassignment_t ** attr, const hessian_object_t * h_attribute);
 
 /**
- * Returns the Hessian map for this Action or a Hessian null if the Action is null.
+ * Hessian pull unmarshalling prototype, token is the already read map token.
+ *
+ * Returns PEP_IO_OK, PEP_IO_ERROR or PEP_IO_REF if the input contains a
+ * Hessian ref, which can only be resolved with the Hessian objects tree.
+ */
+static int xacml_response_read(hessian_reader_t * reader, hessian_t token, xacml_response_t ** response);
+
+/**
+ * Precomputed Hessian encodings of the request map types and keys, written as
+ * is by the marshallers. Must match the XACML_HESSIAN_* names of io.h.
+ */
+HESSIAN_MAP_FRAGMENT(ATTRIBUTE_MAP,"org.glite.authz.common.model.Attribute");
+HESSIAN_STRING_FRAGMENT(ATTRIBUTE_ID_KEY,"id");
+HESSIAN_STRING_FRAGMENT(ATTRIBUTE_DATATYPE_KEY,"dataType");
+HESSIAN_STRING_FRAGMENT(ATTRIBUTE_ISSUER_KEY,"issuer");
+HESSIAN_STRING_FRAGMENT(ATTRIBUTE_VALUES_KEY,"values");
+HESSIAN_STRING_FRAGMENT(ATTRIBUTES_KEY,"attributes");
+HESSIAN_MAP_FRAGMENT(SUBJECT_MAP,"org.glite.authz.common.model.Subject");
+HESSIAN_STRING_FRAGMENT(SUBJECT_CATEGORY_KEY,"category");
+HESSIAN_MAP_FRAGMENT(RESOURCE_MAP,"org.glite.authz.common.model.Resource");
+HESSIAN_STRING_FRAGMENT(RESOURCE_CONTENT_KEY,"resourceContent");
+HESSIAN_MAP_FRAGMENT(ACTION_MAP,"org.glite.authz.common.model.Action");
+HESSIAN_MAP_FRAGMENT(ENVIRONMENT_MAP,"org.glite.authz.common.model.Environment");
+HESSIAN_MAP_FRAGMENT(REQUEST_MAP,"org.glite.authz.common.model.Request");
+HESSIAN_STRING_FRAGMENT(REQUEST_SUBJECTS_KEY,"subjects");
+HESSIAN_STRING_FRAGMENT(REQUEST_RESOURCES_KEY,"resources");
+HESSIAN_STRING_FRAGMENT(REQUEST_ACTION_KEY,"action");
+HESSIAN_STRING_FRAGMENT(REQUEST_ENVIRONMENT_KEY,"environment");
+
+/**
+ * The XACML map types and keys known by the unmarshallers. The names are
+ * identified once with xacml_name_lookup(), and then compared as integers.
+ */
+typedef enum xacml_name {
+    XACML_NAME_UNKNOWN= 0,
+    XACML_CLASS_ATTRIBUTE,
+    XACML_CLASS_SUBJECT,
+    XACML_CLASS_RESOURCE,
+    XACML_CLASS_ACTION,
+    XACML_CLASS_ENVIRONMENT,
+    XACML_CLASS_REQUEST,
+    XACML_CLASS_STATUSCODE,
+    XACML_CLASS_STATUS,
+    XACML_CLASS_ATTRIBUTEASSIGNMENT,
+    XACML_CLASS_OBLIGATION,
+    XACML_CLASS_RESULT,
+    XACML_CLASS_RESPONSE,
+    XACML_KEY_ID, /* id */
+    XACML_KEY_DATATYPE, /* dataType */
+    XACML_KEY_ISSUER, /* issuer */
+    XACML_KEY_VALUES, /* values */
+    XACML_KEY_CATEGORY, /* category */
+    XACML_KEY_ATTRIBUTES, /* attributes */
+    XACML_KEY_RESOURCECONTENT, /* resourceContent */
+    XACML_KEY_SUBJECTS, /* subjects */
+    XACML_KEY_RESOURCES, /* resources */
+    XACML_KEY_ACTION, /* action */
+    XACML_KEY_ENVIRONMENT, /* environment */
+    XACML_KEY_CODE, /* code */
+    XACML_KEY_SUBCODE, /* subCode */
+    XACML_KEY_MESSAGE, /* message */
+    XACML_KEY_STATUSCODE, /* statusCode */
+    XACML_KEY_ATTRIBUTEID, /* attributeId */
+    XACML_KEY_VALUE, /* value */
+    XACML_KEY_FULFILLON, /* fulfillOn */
+    XACML_KEY_ATTRIBUTEASSIGNMENTS, /* attributeAssignments */
+    XACML_KEY_DECISION, /* decision */
+    XACML_KEY_RESOURCEID, /* resourceId */
+    XACML_KEY_STATUS, /* status */
+    XACML_KEY_OBLIGATIONS, /* obligations */
+    XACML_KEY_REQUEST, /* request */
+    XACML_KEY_RESULTS /* results */
+} xacml_name_t;
+
+typedef struct xacml_name_entry {
+    const char * name;
+    size_t name_l;
+    xacml_name_t id;
+} xacml_name_entry_t;
+
+/*
+ * Perfect hash of the XACML_HESSIAN_* names of io.h, on their length and last
+ * two chars. The multipliers are chosen so that all the names fall in distinct
+ * slots: the table must be regenerated if a name is added or changed.
+ */
+#define XACML_NAME_HASH_SIZE 128
+#define XACML_NAME_HASH(name,name_l) \
+    (((name_l) + 6 * (unsigned char)(name)[(name_l) - 1] + 9 * (unsigned char)(name)[(name_l) - 2]) & (XACML_NAME_HASH_SIZE - 1))
+
+static const xacml_name_entry_t xacml_names[XACML_NAME_HASH_SIZE]= {
+    [0]= { XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE, sizeof(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE) - 1, XACML_KEY_VALUE },
+    [1]= { XACML_HESSIAN_REQUEST_ACTION, sizeof(XACML_HESSIAN_REQUEST_ACTION) - 1, XACML_KEY_ACTION },
+    [3]= { XACML_HESSIAN_RESULT_DECISION, sizeof(XACML_HESSIAN_RESULT_DECISION) - 1, XACML_KEY_DECISION },
+    [4]= { XACML_HESSIAN_STATUS_MESSAGE, sizeof(XACML_HESSIAN_STATUS_MESSAGE) - 1, XACML_KEY_MESSAGE },
+    [9]= { XACML_HESSIAN_STATUSCODE_CLASSNAME, sizeof(XACML_HESSIAN_STATUSCODE_CLASSNAME) - 1, XACML_CLASS_STATUSCODE },
+    [11]= { XACML_HESSIAN_ATTRIBUTE_ID, sizeof(XACML_HESSIAN_ATTRIBUTE_ID) - 1, XACML_KEY_ID },
+    [14]= { XACML_HESSIAN_RESPONSE_CLASSNAME, sizeof(XACML_HESSIAN_RESPONSE_CLASSNAME) - 1, XACML_CLASS_RESPONSE },
+    [24]= { XACML_HESSIAN_ATTRIBUTE_CLASSNAME, sizeof(XACML_HESSIAN_ATTRIBUTE_CLASSNAME) - 1, XACML_CLASS_ATTRIBUTE },
+    [27]= { XACML_HESSIAN_RESULT_OBLIGATIONS, sizeof(XACML_HESSIAN_RESULT_OBLIGATIONS) - 1, XACML_KEY_OBLIGATIONS },
+    [30]= { XACML_HESSIAN_ACTION_CLASSNAME, sizeof(XACML_HESSIAN_ACTION_CLASSNAME) - 1, XACML_CLASS_ACTION },
+    [33]= { XACML_HESSIAN_REQUEST_ENVIRONMENT, sizeof(XACML_HESSIAN_REQUEST_ENVIRONMENT) - 1, XACML_KEY_ENVIRONMENT },
+    [34]= { XACML_HESSIAN_OBLIGATION_CLASSNAME, sizeof(XACML_HESSIAN_OBLIGATION_CLASSNAME) - 1, XACML_CLASS_OBLIGATION },
+    [37]= { XACML_HESSIAN_RESOURCE_CONTENT, sizeof(XACML_HESSIAN_RESOURCE_CONTENT) - 1, XACML_KEY_RESOURCECONTENT },
+    [39]= { XACML_HESSIAN_RESULT_CLASSNAME, sizeof(XACML_HESSIAN_RESULT_CLASSNAME) - 1, XACML_CLASS_RESULT },
+    [62]= { XACML_HESSIAN_ENVIRONMENT_CLASSNAME, sizeof(XACML_HESSIAN_ENVIRONMENT_CLASSNAME) - 1, XACML_CLASS_ENVIRONMENT },
+    [63]= { XACML_HESSIAN_ATTRIBUTE_ISSUER, sizeof(XACML_HESSIAN_ATTRIBUTE_ISSUER) - 1, XACML_KEY_ISSUER },
+    [69]= { XACML_HESSIAN_ATTRIBUTE_VALUES, sizeof(XACML_HESSIAN_ATTRIBUTE_VALUES) - 1, XACML_KEY_VALUES },
+    [70]= { XACML_HESSIAN_ATTRIBUTEASSIGNMENT_CLASSNAME, sizeof(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_CLASSNAME) - 1, XACML_CLASS_ATTRIBUTEASSIGNMENT },
+    [72]= { XACML_HESSIAN_REQUEST_RESOURCES, sizeof(XACML_HESSIAN_REQUEST_RESOURCES) - 1, XACML_KEY_RESOURCES },
+    [73]= { XACML_HESSIAN_SUBJECT_ATTRIBUTES, sizeof(XACML_HESSIAN_SUBJECT_ATTRIBUTES) - 1, XACML_KEY_ATTRIBUTES },
+    [74]= { XACML_HESSIAN_RESPONSE_REQUEST, sizeof(XACML_HESSIAN_RESPONSE_REQUEST) - 1, XACML_KEY_REQUEST },
+    [77]= { XACML_HESSIAN_RESPONSE_RESULTS, sizeof(XACML_HESSIAN_RESPONSE_RESULTS) - 1, XACML_KEY_RESULTS },
+    [78]= { XACML_HESSIAN_REQUEST_SUBJECTS, sizeof(XACML_HESSIAN_REQUEST_SUBJECTS) - 1, XACML_KEY_SUBJECTS },
+    [85]= { XACML_HESSIAN_RESULT_STATUS, sizeof(XACML_HESSIAN_RESULT_STATUS) - 1, XACML_KEY_STATUS },
+    [86]= { XACML_HESSIAN_ATTRIBUTE_DATATYPE, sizeof(XACML_HESSIAN_ATTRIBUTE_DATATYPE) - 1, XACML_KEY_DATATYPE },
+    [87]= { XACML_HESSIAN_SUBJECT_CLASSNAME, sizeof(XACML_HESSIAN_SUBJECT_CLASSNAME) - 1, XACML_CLASS_SUBJECT },
+    [90]= { XACML_HESSIAN_OBLIGATION_ASSIGNMENTS, sizeof(XACML_HESSIAN_OBLIGATION_ASSIGNMENTS) - 1, XACML_KEY_ATTRIBUTEASSIGNMENTS },
+    [96]= { XACML_HESSIAN_SUBJECT_CATEGORY, sizeof(XACML_HESSIAN_SUBJECT_CATEGORY) - 1, XACML_KEY_CATEGORY },
+    [100]= { XACML_HESSIAN_OBLIGATION_FULFILLON, sizeof(XACML_HESSIAN_OBLIGATION_FULFILLON) - 1, XACML_KEY_FULFILLON },
+    [102]= { XACML_HESSIAN_STATUSCODE_VALUE, sizeof(XACML_HESSIAN_STATUSCODE_VALUE) - 1, XACML_KEY_CODE },
+    [103]= { XACML_HESSIAN_REQUEST_CLASSNAME, sizeof(XACML_HESSIAN_REQUEST_CLASSNAME) - 1, XACML_CLASS_REQUEST },
+    [105]= { XACML_HESSIAN_STATUSCODE_SUBCODE, sizeof(XACML_HESSIAN_STATUSCODE_SUBCODE) - 1, XACML_KEY_SUBCODE },
+    [108]= { XACML_HESSIAN_STATUS_CODE, sizeof(XACML_HESSIAN_STATUS_CODE) - 1, XACML_KEY_STATUSCODE },
+    [114]= { XACML_HESSIAN_STATUS_CLASSNAME, sizeof(XACML_HESSIAN_STATUS_CLASSNAME) - 1, XACML_CLASS_STATUS },
+    [115]= { XACML_HESSIAN_RESULT_RESOURCEID, sizeof(XACML_HESSIAN_RESULT_RESOURCEID) - 1, XACML_KEY_RESOURCEID },
+    [116]= { XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID, sizeof(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID) - 1, XACML_KEY_ATTRIBUTEID },
+    [126]= { XACML_HESSIAN_RESOURCE_CLASSNAME, sizeof(XACML_HESSIAN_RESOURCE_CLASSNAME) - 1, XACML_CLASS_RESOURCE }
+};
+
+/**
+ * Returns the id of the XACML map type or key name of name_l bytes, or
+ * XACML_NAME_UNKNOWN. Costs one hash and one memcmp.
+ */
+static xacml_name_t xacml_name_lookup(const char * name, size_t name_l) {
+    const xacml_name_entry_t * entry;
+    if (name == NULL || name_l < 2) {
+        return XACML_NAME_UNKNOWN;
+    }
+    entry= &xacml_names[XACML_NAME_HASH(name,name_l)];
+    if (entry->name_l == name_l && memcmp(entry->name,name,name_l) == 0) {
+        return entry->id;
+    }
+    return XACML_NAME_UNKNOWN;
+}
+
+/**
+ * Writes the Hessian map for this Action or a Hessian null if the Action is null.
  */
-static int xacml_action_marshal(const xacml_action_t * action, hessian_object_t ** h_act) {
-    hessian_object_t * h_action, * h_attrs, * h_attrs_key;
+static int xacml_action_marshal(const xacml_action_t * action, BUFFER * output) {
     size_t list_l;
     int i;
     if (action == NULL) {
-        h_action= hessian_create(HESSIAN_NULL);
-        if (h_action == NULL) {
-            log_error("xacml_action_marshal: NULL action, but can't create Hessian null.");
+        if (hessian_write_null(output) != HESSIAN_OK) {
+            log_error("xacml_action_marshal: NULL action, but can't write Hessian null.");
             return PEP_IO_ERROR;
         }
-        *h_act= h_action;
         return PEP_IO_OK;
     }
-    h_action= hessian_create(HESSIAN_MAP,XACML_HESSIAN_ACTION_CLASSNAME);
-    if (h_action == NULL) {
-        log_error("xacml_action_marshal: can't create Hessian map: %s.", XACML_HESSIAN_ACTION_CLASSNAME);
+    if (hessian_write_fragment(&ACTION_MAP,sizeof(ACTION_MAP),output) != HESSIAN_OK) {
+        log_error("xacml_action_marshal: can't write Hessian map: %s.", XACML_HESSIAN_ACTION_CLASSNAME);
         return PEP_IO_ERROR;
     }
     /* attributes list */
-    h_attrs= hessian_create(HESSIAN_LIST);
-    if (h_attrs == NULL) {
-        log_error("xacml_action_marshal: can't create Hessian list: %s.", XACML_HESSIAN_ACTION_ATTRIBUTES);
-        hessian_delete(h_action);
+    list_l= xacml_action_attributes_length(action);
+    if (hessian_write_fragment(&ATTRIBUTES_KEY,sizeof(ATTRIBUTES_KEY),output) != HESSIAN_OK
+        || hessian_writer_begin_list(NULL,list_l,output) != HESSIAN_OK) {
+        log_error("xacml_action_marshal: can't write Hessian list: %s.", XACML_HESSIAN_ACTION_ATTRIBUTES);
         return PEP_IO_ERROR;
     }
-    list_l= xacml_action_attributes_length(action);
     for (i= 0; i < list_l; i++) {
         xacml_attribute_t * attr= xacml_action_getattribute(action,i);
-        hessian_object_t * h_attr= NULL;
-        if (xacml_attribute_marshal(attr,&h_attr) != PEP_IO_OK) {
+        if (xacml_attribute_marshal(attr,output) != PEP_IO_OK) {
             log_error("xacml_action_marshal: can't marshal attribute at: %d.",i);
-            hessian_delete(h_action);
-            hessian_delete(h_attrs);
-            return PEP_IO_ERROR;
-        }
-        if (hessian_list_add(h_attrs,h_attr) != HESSIAN_OK) {
-            log_error("xacml_action_marshal: can't add Hessian attribute to Hessian list at: %d.",i);
-            hessian_delete(h_action);
-            hessian_delete(h_attrs);
-            hessian_delete(h_attr);
             return PEP_IO_ERROR;
         }
     }
-    h_attrs_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_ACTION_ATTRIBUTES);
-    if (h_attrs_key == NULL) {
-        log_error("xacml_action_marshal: can't create Hessian map<key>: %s.", XACML_HESSIAN_ACTION_ATTRIBUTES);
-        hessian_delete(h_action);
-        hessian_delete(h_attrs);
-        return PEP_IO_ERROR;
-    }
-    if (hessian_map_add(h_action,h_attrs_key,h_attrs) != HESSIAN_OK) {
-        log_error("xacml_action_marshal: can't add %s Hessian list to action Hessian map.", XACML_HESSIAN_ACTION_ATTRIBUTES);
-        hessian_delete(h_action);
-        hessian_delete(h_attrs);
-        hessian_delete(h_attrs_key);
+    if (hessian_writer_end(output) != HESSIAN_OK || hessian_writer_end(output) != HESSIAN_OK) {
+        log_error("xacml_action_marshal: can't end action Hessian map.");
         return PEP_IO_ERROR;
     }
-    *h_act= h_action;
     return PEP_IO_OK;
 }
 
@@ -127,7 +248,7 @@ static int xacml_action_unmarshal(xacml_action_t ** act, const hessian_object_t
         log_error("xacml_action_unmarshal: NULL Hessian map type.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_ACTION_CLASSNAME,map_type) != 0) {
+    if (xacml_name_lookup(map_type,strlen(map_type)) != XACML_CLASS_ACTION) {
         log_error("xacml_action_unmarshal: wrong Hessian map type: %s.",map_type);
         return PEP_IO_ERROR;
     }
@@ -142,6 +263,7 @@ static int xacml_action_unmarshal(xacml_action_t ** act, const hessian_object_t
     for(i= 0; i<map_l; i++) {
         hessian_object_t * h_map_key= hessian_map_getkey(h_action,i);
         const char * key;
+        xacml_name_t key_id;
         if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
             log_error("xacml_action_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
             xacml_action_delete(action);
@@ -153,7 +275,8 @@ static int xacml_action_unmarshal(xacml_action_t ** act, const hessian_object_t
             xacml_action_delete(action);
             return PEP_IO_ERROR;
         }
-        if (strcmp(XACML_HESSIAN_ACTION_ATTRIBUTES,key) == 0) {
+        key_id= xacml_name_lookup(key,hessian_string_length(h_map_key));
+        if (key_id == XACML_KEY_ATTRIBUTES) {
             hessian_object_t * h_attributes= hessian_map_getvalue(h_action,i);
             size_t h_attributes_l;
             int j;
@@ -189,11 +312,7 @@ static int xacml_action_unmarshal(xacml_action_t ** act, const hessian_object_t
 }
 
 
-/**
- * Returns the Hessian object representing the XACML attribute.
- */
-static int xacml_attribute_marshal(const xacml_attribute_t * attr, hessian_object_t ** h_attr) {
-    hessian_object_t * h_attribute, * h_value, * h_key, * h_values, * h_values_key;
+static int xacml_attribute_marshal(const xacml_attribute_t * attr, BUFFER * output) {
     const char * attr_id, * attr_dt, * attr_issuer;
     size_t values_l;
     int i;
@@ -201,88 +320,54 @@ static int xacml_attribute_marshal(const xacml_attribute_t * attr, hessian_objec
         log_error("xacml_attribute_marshal: NULL attribute object.");
         return PEP_IO_ERROR;
     }
-    h_attribute= hessian_create(HESSIAN_MAP,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
-    if (h_attribute == NULL) {
-        log_error("xacml_attribute_marshal: can't create attribute Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
+    if (hessian_write_fragment(&ATTRIBUTE_MAP,sizeof(ATTRIBUTE_MAP),output) != HESSIAN_OK) {
+        log_error("xacml_attribute_marshal: can't write attribute Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
         return PEP_IO_ERROR;
     }
 
     /* mandatory attribute */
     attr_id= xacml_attribute_getid(attr);
-    h_value= hessian_create(HESSIAN_STRING,attr_id);
-    if (h_value== NULL) {
-        log_error("xacml_attribute_marshal: can't create Hessian string: %s", attr_id);
-        hessian_delete(h_attribute);
-        return PEP_IO_ERROR;
-    }
-    h_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_ATTRIBUTE_ID);
-    if (hessian_map_add(h_attribute,h_key,h_value) != HESSIAN_OK) {
-        log_error("xacml_attribute_marshal: can't add pair<'%s','%s'> to Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_ID,attr_id,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
-        hessian_delete(h_attribute);
-        hessian_delete(h_key);
-        hessian_delete(h_value);
+    if (hessian_write_fragment(&ATTRIBUTE_ID_KEY,sizeof(ATTRIBUTE_ID_KEY),output) != HESSIAN_OK
+        || hessian_write_string(attr_id,output) != HESSIAN_OK) {
+        log_error("xacml_attribute_marshal: can't write pair<'%s','%s'> to Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_ID,attr_id,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
         return PEP_IO_ERROR;
     }
     /* optional datatype */
     attr_dt= xacml_attribute_getdatatype(attr);
     if (attr_dt != NULL) {
-        h_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_ATTRIBUTE_DATATYPE);
-        h_value= hessian_create(HESSIAN_STRING,attr_dt);
-        if (hessian_map_add(h_attribute,h_key,h_value) != HESSIAN_OK) {
-            log_error("xacml_attribute_marshal: can't add pair<'%s','%s'> to Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_DATATYPE,attr_dt,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
-            hessian_delete(h_attribute);
-            hessian_delete(h_key);
-            hessian_delete(h_value);
+        if (hessian_write_fragment(&ATTRIBUTE_DATATYPE_KEY,sizeof(ATTRIBUTE_DATATYPE_KEY),output) != HESSIAN_OK
+            || hessian_write_string(attr_dt,output) != HESSIAN_OK) {
+            log_error("xacml_attribute_marshal: can't write pair<'%s','%s'> to Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_DATATYPE,attr_dt,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
             return PEP_IO_ERROR;
         }
     }
     /* optional issuer */
     attr_issuer= xacml_attribute_getissuer(attr);
     if (attr_issuer != NULL) {
-        h_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_ATTRIBUTE_ISSUER);
-        h_value= hessian_create(HESSIAN_STRING,attr_issuer);
-        if (hessian_map_add(h_attribute,h_key,h_value) != HESSIAN_OK) {
-            log_error("xacml_attribute_marshal: can't add pair<'%s','%s'> to Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_ISSUER,attr_issuer,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
-            hessian_delete(h_attribute);
-            hessian_delete(h_key);
-            hessian_delete(h_value);
+        if (hessian_write_fragment(&ATTRIBUTE_ISSUER_KEY,sizeof(ATTRIBUTE_ISSUER_KEY),output) != HESSIAN_OK
+            || hessian_write_string(attr_issuer,output) != HESSIAN_OK) {
+            log_error("xacml_attribute_marshal: can't write pair<'%s','%s'> to Hessian map: %s", XACML_HESSIAN_ATTRIBUTE_ISSUER,attr_issuer,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
             return PEP_IO_ERROR;
         }
     }
     /* values list */
-    h_values= hessian_create(HESSIAN_LIST);
-    if (h_values == NULL) {
-        log_error("xacml_attribute_marshal: can't create %s Hessian list.", XACML_HESSIAN_ATTRIBUTE_VALUES);
-        hessian_delete(h_attribute);
+    values_l= xacml_attribute_values_length(attr);
+    if (hessian_write_fragment(&ATTRIBUTE_VALUES_KEY,sizeof(ATTRIBUTE_VALUES_KEY),output) != HESSIAN_OK
+        || hessian_writer_begin_list(NULL,values_l,output) != HESSIAN_OK) {
+        log_error("xacml_attribute_marshal: can't write %s Hessian list.", XACML_HESSIAN_ATTRIBUTE_VALUES);
         return PEP_IO_ERROR;
     }
-    values_l= xacml_attribute_values_length(attr);
     for (i= 0; i < values_l; i++) {
         const char * value= xacml_attribute_getvalue(attr,i);
-        h_value= hessian_create(HESSIAN_STRING,value);
-        if (h_value == NULL) {
-            log_error("xacml_attribute_marshal: can't create Hessian string: %s at: %d.", value, i);
-            hessian_delete(h_attribute);
-            hessian_delete(h_values);
-            return PEP_IO_ERROR;
-        }
-        if (hessian_list_add(h_values,h_value) != HESSIAN_OK) {
-            log_error("xacml_attribute_marshal: can't add Hessian string: %s to Hessian list.", value);
-            hessian_delete(h_attribute);
-            hessian_delete(h_values);
-            hessian_delete(h_value);
+        if (hessian_write_string(value,output) != HESSIAN_OK) {
+            log_error("xacml_attribute_marshal: can't write Hessian string: %s at: %d.", value, i);
             return PEP_IO_ERROR;
         }
     }
-    h_values_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_ATTRIBUTE_VALUES);
-    if (hessian_map_add(h_attribute,h_values_key,h_values) != HESSIAN_OK) {
-        log_error("xacml_attribute_marshal: can't add attributes Hessian list to attribute Hessian map.");
-        hessian_delete(h_attribute);
-        hessian_delete(h_values_key);
-        hessian_delete(h_values);
+    if (hessian_writer_end(output) != HESSIAN_OK || hessian_writer_end(output) != HESSIAN_OK) {
+        log_error("xacml_attribute_marshal: can't end attribute Hessian map.");
         return PEP_IO_ERROR;
     }
-    *h_attr= h_attribute;
     return PEP_IO_OK;
 }
 
@@ -300,7 +385,7 @@ static int xacml_attribute_unmarshal(xacml_attribute_t ** attr, const hessian_ob
         log_error("xacml_attribute_unmarshal: NULL Hessian map type.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_ATTRIBUTE_CLASSNAME,map_type) != 0) {
+    if (xacml_name_lookup(map_type,strlen(map_type)) != XACML_CLASS_ATTRIBUTE) {
         log_error("xacml_attribute_unmarshal: wrong Hessian map type: %s.",map_type);
         return PEP_IO_ERROR;
     }
@@ -316,6 +401,7 @@ static int xacml_attribute_unmarshal(xacml_attribute_t ** attr, const hessian_ob
     for(i= 0; i<map_l; i++) {
         hessian_object_t * h_map_key= hessian_map_getkey(h_attribute,i);
         const char * key;
+        xacml_name_t key_id;
         if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
             log_error("xacml_attribute_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
             xacml_attribute_delete(attribute);
@@ -327,9 +413,10 @@ static int xacml_attribute_unmarshal(xacml_attribute_t ** attr, const hessian_ob
             xacml_attribute_delete(attribute);
             return PEP_IO_ERROR;
         }
+        key_id= xacml_name_lookup(key,hessian_string_length(h_map_key));
 
         /* id (mandatory) */
-        if (strcmp(XACML_HESSIAN_ATTRIBUTE_ID,key) == 0) {
+        if (key_id == XACML_KEY_ID) {
             hessian_object_t * h_string= hessian_map_getvalue(h_attribute,i);
             const char * id;
             if (hessian_gettype(h_string) != HESSIAN_STRING) {
@@ -345,7 +432,7 @@ static int xacml_attribute_unmarshal(xacml_attribute_t ** attr, const hessian_ob
             }
         }
         /* datatype (optional) */
-        else if (strcmp(XACML_HESSIAN_ATTRIBUTE_DATATYPE,key) == 0) {
+        else if (key_id == XACML_KEY_DATATYPE) {
             const char * datatype= NULL;
             hessian_object_t * h_string= hessian_map_getvalue(h_attribute,i);
             hessian_t h_string_type= hessian_gettype(h_string);
@@ -365,7 +452,7 @@ static int xacml_attribute_unmarshal(xacml_attribute_t ** attr, const hessian_ob
 
         }
         /* issuer (optional) */
-        else if (strcmp(XACML_HESSIAN_ATTRIBUTE_ISSUER,key) == 0) {
+        else if (key_id == XACML_KEY_ISSUER) {
             const char * issuer = NULL;
             hessian_object_t * h_string= hessian_map_getvalue(h_attribute,i);
             hessian_t h_string_type= hessian_gettype(h_string);
@@ -385,7 +472,7 @@ static int xacml_attribute_unmarshal(xacml_attribute_t ** attr, const hessian_ob
 
         }
         /* values list */
-        else if (strcmp(XACML_HESSIAN_ATTRIBUTE_VALUES,key) == 0) {
+        else if (key_id == XACML_KEY_VALUES) {
             hessian_object_t * h_values= hessian_map_getvalue(h_attribute,i);
             size_t h_values_l;
             int j;
@@ -420,61 +507,38 @@ static int xacml_attribute_unmarshal(xacml_attribute_t ** attr, const hessian_ob
     return PEP_IO_OK;
 }
 
-/**
- * Returns the Hessian map for this Environment or a Hessian null if the Environment is null.
- */
-static int xacml_environment_marshal(const xacml_environment_t * env, hessian_object_t ** h_env) {
-    hessian_object_t * h_environment, * h_attrs, * h_attrs_key;
+static int xacml_environment_marshal(const xacml_environment_t * env, BUFFER * output) {
     size_t list_l;
     int i;
     if (env == NULL) {
-        hessian_object_t * h_null= hessian_create(HESSIAN_NULL);
-        if (h_null == NULL) {
-            log_error("xacml_environment_marshal: NULL environment, but can't create Hessian null.");
+        if (hessian_write_null(output) != HESSIAN_OK) {
+            log_error("xacml_environment_marshal: NULL environment, but can't write Hessian null.");
             return PEP_IO_ERROR;
         }
-        *h_env= h_null;
         return PEP_IO_OK;
     }
-    h_environment= hessian_create(HESSIAN_MAP,XACML_HESSIAN_ENVIRONMENT_CLASSNAME);
-    if (h_environment == NULL) {
-        log_error("xacml_environment_marshal: can't create Hessian map: %s.", XACML_HESSIAN_ENVIRONMENT_CLASSNAME);
+    if (hessian_write_fragment(&ENVIRONMENT_MAP,sizeof(ENVIRONMENT_MAP),output) != HESSIAN_OK) {
+        log_error("xacml_environment_marshal: can't write Hessian map: %s.", XACML_HESSIAN_ENVIRONMENT_CLASSNAME);
         return PEP_IO_ERROR;
     }
     /* attributes list */
-    h_attrs= hessian_create(HESSIAN_LIST);
-    if (h_attrs == NULL) {
-        log_error("xacml_environment_marshal: can't create %s Hessian list.", XACML_HESSIAN_ENVIRONMENT_ATTRIBUTES);
-        hessian_delete(h_environment);
+    list_l= xacml_environment_attributes_length(env);
+    if (hessian_write_fragment(&ATTRIBUTES_KEY,sizeof(ATTRIBUTES_KEY),output) != HESSIAN_OK
+        || hessian_writer_begin_list(NULL,list_l,output) != HESSIAN_OK) {
+        log_error("xacml_environment_marshal: can't write %s Hessian list.", XACML_HESSIAN_ENVIRONMENT_ATTRIBUTES);
         return PEP_IO_ERROR;
     }
-    list_l= xacml_environment_attributes_length(env);
     for (i= 0; i < list_l; i++) {
         xacml_attribute_t * attr= xacml_environment_getattribute(env,i);
-        hessian_object_t * h_attr= NULL;
-        if (xacml_attribute_marshal(attr,&h_attr) != PEP_IO_OK) {
+        if (xacml_attribute_marshal(attr,output) != PEP_IO_OK) {
             log_error("xacml_environment_marshal: can't marshall XACML attribute at: %d",i);
-            hessian_delete(h_environment);
-            hessian_delete(h_attrs);
-            return PEP_IO_ERROR;
-        }
-        if (hessian_list_add(h_attrs,h_attr) != HESSIAN_OK) {
-            log_error("xacml_environment_marshal: can't add Hessian attribute to Hessian list at: %d",i);
-            hessian_delete(h_environment);
-            hessian_delete(h_attrs);
-            hessian_delete(h_attr);
             return PEP_IO_ERROR;
         }
     }
-    h_attrs_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_ENVIRONMENT_ATTRIBUTES);
-    if (hessian_map_add(h_environment,h_attrs_key,h_attrs) != HESSIAN_OK) {
-        log_error("xacml_environment_marshal: can't add attributes Hessian list to environment Hessian map.");
-        hessian_delete(h_environment);
-        hessian_delete(h_attrs);
-        hessian_delete(h_attrs_key);
+    if (hessian_writer_end(output) != HESSIAN_OK || hessian_writer_end(output) != HESSIAN_OK) {
+        log_error("xacml_environment_marshal: can't end environment Hessian map.");
         return PEP_IO_ERROR;
     }
-    *h_env= h_environment;
     return PEP_IO_OK;
 }
 
@@ -493,7 +557,7 @@ static int xacml_environment_unmarshal(xacml_environment_t ** env, const hessian
         log_error("xacml_environment_unmarshal: NULL Hessian map type.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_ENVIRONMENT_CLASSNAME,map_type) != 0) {
+    if (xacml_name_lookup(map_type,strlen(map_type)) != XACML_CLASS_ENVIRONMENT) {
         log_error("xacml_environment_unmarshal: wrong Hessian map type: %s.",map_type);
         return PEP_IO_ERROR;
     }
@@ -507,6 +571,7 @@ static int xacml_environment_unmarshal(xacml_environment_t ** env, const hessian
     map_l= hessian_map_length(h_environment);
     for(i= 0; i<map_l; i++) {
         const char * key;
+        xacml_name_t key_id;
         hessian_object_t * h_map_key= hessian_map_getkey(h_environment,i);
         if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
             log_error("xacml_environment_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
@@ -519,7 +584,8 @@ static int xacml_environment_unmarshal(xacml_environment_t ** env, const hessian
             xacml_environment_delete(environment);
             return PEP_IO_ERROR;
         }
-        if (strcmp(XACML_HESSIAN_ENVIRONMENT_ATTRIBUTES,key) == 0) {
+        key_id= xacml_name_lookup(key,hessian_string_length(h_map_key));
+        if (key_id == XACML_KEY_ATTRIBUTES) {
             hessian_object_t * h_attributes= hessian_map_getvalue(h_environment,i);
             size_t h_attributes_l;
             int j;
@@ -554,14 +620,7 @@ static int xacml_environment_unmarshal(xacml_environment_t ** env, const hessian
     return PEP_IO_OK;
 }
 
-/**
- * Returns PEP_IO_OK or PEP_IO_ERROR
- */
-static int xacml_request_marshal(const xacml_request_t * request, hessian_object_t ** h_req) {
-    hessian_object_t * h_request, * h_subjects, * h_subjects_key, * h_resources, * h_resources_key; 
-    hessian_object_t * h_action, * h_action_key, * h_environment, * h_environment_key;
-    xacml_action_t * action;
-    xacml_environment_t * environment;
+static int xacml_request_marshal(const xacml_request_t * request, BUFFER * output) {
     size_t list_l;
     int i;
     if (request == NULL) {
@@ -569,110 +628,62 @@ static int xacml_request_marshal(const xacml_request_t * request, hessian_object
         return PEP_IO_ERROR;
     }
     /* request as hessian map */
-    h_request= hessian_create(HESSIAN_MAP,XACML_HESSIAN_REQUEST_CLASSNAME);
-    if (h_request == NULL) {
-        log_error("xacml_request_marshal: can't create request Hessian map: %s.",XACML_HESSIAN_REQUEST_CLASSNAME);
+    if (hessian_write_fragment(&REQUEST_MAP,sizeof(REQUEST_MAP),output) != HESSIAN_OK) {
+        log_error("xacml_request_marshal: can't write request Hessian map: %s.",XACML_HESSIAN_REQUEST_CLASSNAME);
         return PEP_IO_ERROR;
     }
     /* subjects list */
-    h_subjects= hessian_create(HESSIAN_LIST);
-    if (h_subjects == NULL) {
-        log_error("xacml_request_marshal: can't create subjects Hessian list.");
-        hessian_delete(h_request);
+    list_l= xacml_request_subjects_length(request);
+    if (hessian_write_fragment(&REQUEST_SUBJECTS_KEY,sizeof(REQUEST_SUBJECTS_KEY),output) != HESSIAN_OK
+        || hessian_writer_begin_list(NULL,list_l,output) != HESSIAN_OK) {
+        log_error("xacml_request_marshal: can't write subjects Hessian list.");
         return PEP_IO_ERROR;
     }
-    list_l= xacml_request_subjects_length(request);
     for (i= 0; i < list_l; i++) {
         xacml_subject_t * subject= xacml_request_getsubject(request,i);
-        hessian_object_t * h_subject= NULL;
-        if (xacml_subject_marshal(subject,&h_subject) != PEP_IO_OK) {
+        if (xacml_subject_marshal(subject,output) != PEP_IO_OK) {
             log_error("xacml_request_marshal: failed to marshal XACML subject at: %d.",i);
-            hessian_delete(h_request);
-            hessian_delete(h_subjects);
-            return PEP_IO_ERROR;
-        }
-        if (hessian_list_add(h_subjects,h_subject) != HESSIAN_OK) {
-            log_error("xacml_request_marshal: can't add Hessian subject %d in Hessian subjects list.",i);
-            hessian_delete(h_request);
-            hessian_delete(h_subjects);
-            hessian_delete(h_subject);
             return PEP_IO_ERROR;
         }
     }
-    h_subjects_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_REQUEST_SUBJECTS);
-    if (hessian_map_add(h_request,h_subjects_key,h_subjects) != HESSIAN_OK) {
-        log_error("xacml_request_marshal: can't add Hessian subjects list in Hessian request map.");
-        hessian_delete(h_request);
-        hessian_delete(h_subjects_key);
-        hessian_delete(h_subjects);
+    if (hessian_writer_end(output) != HESSIAN_OK) {
+        log_error("xacml_request_marshal: can't end subjects Hessian list.");
         return PEP_IO_ERROR;
     }
     /* resources list */
-    h_resources= hessian_create(HESSIAN_LIST);
-    if (h_resources == NULL) {
-        log_error("xacml_request_marshal: can't create resources Hessian list.");
-        hessian_delete(h_request);
+    list_l= xacml_request_resources_length(request);
+    if (hessian_write_fragment(&REQUEST_RESOURCES_KEY,sizeof(REQUEST_RESOURCES_KEY),output) != HESSIAN_OK
+        || hessian_writer_begin_list(NULL,list_l,output) != HESSIAN_OK) {
+        log_error("xacml_request_marshal: can't write resources Hessian list.");
         return PEP_IO_ERROR;
     }
-    list_l= xacml_request_resources_length(request);
     for (i= 0; i < list_l; i++) {
         xacml_resource_t * resource= xacml_request_getresource(request,i);
-        hessian_object_t * h_resource= NULL;
-        if (xacml_resource_marshal(resource,&h_resource) != PEP_IO_OK) {
+        if (xacml_resource_marshal(resource,output) != PEP_IO_OK) {
             log_error("xacml_request_marshal: failed to marshal XACML resource at: %d.",i);
-            hessian_delete(h_request);
-            hessian_delete(h_resources);
-            return PEP_IO_ERROR;
-        }
-        if (hessian_list_add(h_resources,h_resource) != HESSIAN_OK) {
-            log_error("xacml_request_marshal: can't add Hessian resource %d to Hessian resources list.",i);
-            hessian_delete(h_request);
-            hessian_delete(h_resources);
-            hessian_delete(h_resource);
             return PEP_IO_ERROR;
         }
     }
-    h_resources_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_REQUEST_RESOURCES);
-    if (hessian_map_add(h_request,h_resources_key,h_resources) != HESSIAN_OK) {
-        log_error("xacml_request_marshal: can't add Hessian resources list to Hessian request map.");
-        hessian_delete(h_request);
-        hessian_delete(h_resources_key);
-        hessian_delete(h_resources);
+    if (hessian_writer_end(output) != HESSIAN_OK) {
+        log_error("xacml_request_marshal: can't end resources Hessian list.");
         return PEP_IO_ERROR;
     }
     /* action */
-    action= xacml_request_getaction(request);
-    h_action= NULL;
-    if (xacml_action_marshal(action,&h_action) != PEP_IO_OK) {
+    if (hessian_write_fragment(&REQUEST_ACTION_KEY,sizeof(REQUEST_ACTION_KEY),output) != HESSIAN_OK
+        || xacml_action_marshal(xacml_request_getaction(request),output) != PEP_IO_OK) {
         log_error("xacml_request_marshal: failed to marshal XACML action.");
-        hessian_delete(h_request);
-        return PEP_IO_ERROR;
-    }
-    h_action_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_REQUEST_ACTION);
-    if (hessian_map_add(h_request,h_action_key,h_action) != HESSIAN_OK) {
-        log_error("xacml_request_marshal: can't add Hessian action to Hessian request.");
-        hessian_delete(h_request);
-        hessian_delete(h_action_key);
-        hessian_delete(h_action);
         return PEP_IO_ERROR;
     }
     /* environment */
-    environment= xacml_request_getenvironment(request);
-    h_environment= NULL;
-    if (xacml_environment_marshal(environment,&h_environment) != PEP_IO_OK) {
+    if (hessian_write_fragment(&REQUEST_ENVIRONMENT_KEY,sizeof(REQUEST_ENVIRONMENT_KEY),output) != HESSIAN_OK
+        || xacml_environment_marshal(xacml_request_getenvironment(request),output) != PEP_IO_OK) {
         log_error("xacml_request_marshal: failed to marshal XACML environment.");
-        hessian_delete(h_request);
         return PEP_IO_ERROR;
     }
-    h_environment_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_REQUEST_ENVIRONMENT);
-    if (hessian_map_add(h_request,h_environment_key,h_environment) != HESSIAN_OK) {
-        log_error("xacml_request_marshal: can't add Hessian environment to Hessian request.");
-        hessian_delete(h_request);
-        hessian_delete(h_environment_key);
-        hessian_delete(h_environment);
+    if (hessian_writer_end(output) != HESSIAN_OK) {
+        log_error("xacml_request_marshal: can't end request Hessian map.");
         return PEP_IO_ERROR;
     }
-    *h_req= h_request;
     return PEP_IO_OK;
 }
 
@@ -690,7 +701,7 @@ static int xacml_request_unmarshal(xacml_request_t ** req, const hessian_object_
         log_error("xacml_request_unmarshal: NULL Hessian map type.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_REQUEST_CLASSNAME,map_type) != 0) {
+    if (xacml_name_lookup(map_type,strlen(map_type)) != XACML_CLASS_REQUEST) {
         log_error("xacml_request_unmarshal: wrong Hessian map type: %s.",map_type);
         return PEP_IO_ERROR;
     }
@@ -706,6 +717,7 @@ static int xacml_request_unmarshal(xacml_request_t ** req, const hessian_object_
     for(i= 0; i<map_l; i++) {
         hessian_object_t * h_map_key= hessian_map_getkey(h_request,i);
         const char * key;
+        xacml_name_t key_id;
         int j;
         if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
             log_error("xacml_request_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
@@ -718,8 +730,9 @@ static int xacml_request_unmarshal(xacml_request_t ** req, const hessian_object_
             xacml_request_delete(request);
             return PEP_IO_ERROR;
         }
+        key_id= xacml_name_lookup(key,hessian_string_length(h_map_key));
         /* subjects list */
-        if (strcmp(XACML_HESSIAN_REQUEST_SUBJECTS,key) == 0) {
+        if (key_id == XACML_KEY_SUBJECTS) {
             hessian_object_t * h_subjects= hessian_map_getvalue(h_request,i);
             size_t h_subjects_l;
             if (hessian_gettype(h_subjects) != HESSIAN_LIST) {
@@ -745,7 +758,7 @@ static int xacml_request_unmarshal(xacml_request_t ** req, const hessian_object_
             }
         }
         /* resources list */
-        else if (strcmp(XACML_HESSIAN_REQUEST_RESOURCES,key) == 0) {
+        else if (key_id == XACML_KEY_RESOURCES) {
             hessian_object_t * h_resources= hessian_map_getvalue(h_request,i);
             size_t h_resources_l;
             if (hessian_gettype(h_resources) != HESSIAN_LIST) {
@@ -771,7 +784,7 @@ static int xacml_request_unmarshal(xacml_request_t ** req, const hessian_object_
             }
         }
         /* action (null) */
-        else if (strcmp(XACML_HESSIAN_REQUEST_ACTION,key) == 0) {
+        else if (key_id == XACML_KEY_ACTION) {
             hessian_object_t * h_action= hessian_map_getvalue(h_request,i);
             xacml_action_t * action= NULL;
             if (hessian_gettype(h_action) != HESSIAN_NULL) {
@@ -789,7 +802,7 @@ static int xacml_request_unmarshal(xacml_request_t ** req, const hessian_object_
             }
         }
         /* environment (null) */
-        else if (strcmp(XACML_HESSIAN_REQUEST_ENVIRONMENT,key) == 0) {
+        else if (key_id == XACML_KEY_ENVIRONMENT) {
             hessian_object_t * h_environment= hessian_map_getvalue(h_request,i);
             xacml_environment_t * environment= NULL;
             if (hessian_gettype(h_environment) != HESSIAN_NULL) {
@@ -817,8 +830,7 @@ static int xacml_request_unmarshal(xacml_request_t ** req, const hessian_object_
 }
 
 
-static int xacml_resource_marshal(const xacml_resource_t * resource, hessian_object_t ** h_res) {
-    hessian_object_t * h_resource, * h_attrs, * h_attrs_key;
+static int xacml_resource_marshal(const xacml_resource_t * resource, BUFFER * output) {
     const char * content;
     size_t list_l;
     int i;
@@ -826,64 +838,37 @@ static int xacml_resource_marshal(const xacml_resource_t * resource, hessian_obj
         log_error("xacml_resource_marshal: NULL resource object.");
         return PEP_IO_ERROR;
     }
-    h_resource= hessian_create(HESSIAN_MAP,XACML_HESSIAN_RESOURCE_CLASSNAME);
-    if (h_resource == NULL) {
-        log_error("xacml_resource_marshal: can't create Hessian map: %s.", XACML_HESSIAN_RESOURCE_CLASSNAME);
+    if (hessian_write_fragment(&RESOURCE_MAP,sizeof(RESOURCE_MAP),output) != HESSIAN_OK) {
+        log_error("xacml_resource_marshal: can't write Hessian map: %s.", XACML_HESSIAN_RESOURCE_CLASSNAME);
         return PEP_IO_ERROR;
     }
     /* optional content */
     content= xacml_resource_getcontent(resource);
     if (content != NULL) {
-        hessian_object_t * h_content= hessian_create(HESSIAN_STRING,content);
-        hessian_object_t * h_content_key;
-        if (h_content == NULL) {
-            log_error("xacml_resource_marshal: can't create content Hessian string: %s.", content);
-            hessian_delete(h_resource);
-            return PEP_IO_ERROR;
-        }
-        h_content_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_RESOURCE_CONTENT);
-        if (hessian_map_add(h_resource,h_content_key,h_content) != HESSIAN_OK) {
-            log_error("xacml_resource_marshal: can't add content Hessian string to resource Hessian map.");
-            hessian_delete(h_resource);
-            hessian_delete(h_content);
-            hessian_delete(h_content_key);
+        if (hessian_write_fragment(&RESOURCE_CONTENT_KEY,sizeof(RESOURCE_CONTENT_KEY),output) != HESSIAN_OK
+            || hessian_write_string(content,output) != HESSIAN_OK) {
+            log_error("xacml_resource_marshal: can't write content Hessian string: %s.", content);
             return PEP_IO_ERROR;
         }
     }
     /* attributes list */
-    h_attrs= hessian_create(HESSIAN_LIST);
-    if (h_attrs == NULL) {
-        log_error("xacml_resource_marshal: can't create attributes Hessian list.");
-        hessian_delete(h_resource);
+    list_l= xacml_resource_attributes_length(resource);
+    if (hessian_write_fragment(&ATTRIBUTES_KEY,sizeof(ATTRIBUTES_KEY),output) != HESSIAN_OK
+        || hessian_writer_begin_list(NULL,list_l,output) != HESSIAN_OK) {
+        log_error("xacml_resource_marshal: can't write attributes Hessian list.");
         return PEP_IO_ERROR;
     }
-    list_l= xacml_resource_attributes_length(resource);
     for (i= 0; i < list_l; i++) {
         xacml_attribute_t * attr= xacml_resource_getattribute(resource,i);
-        hessian_object_t * h_attr= NULL;
-        if (xacml_attribute_marshal(attr,&h_attr) != PEP_IO_OK) {
+        if (xacml_attribute_marshal(attr,output) != PEP_IO_OK) {
             log_error("xacml_resource_marshal: can't marshal XACML attribute at: %d.", i);
-            hessian_delete(h_resource);
-            hessian_delete(h_attrs);
-            return PEP_IO_ERROR;
-        }
-        if (hessian_list_add(h_attrs,h_attr) != HESSIAN_OK) {
-            log_error("xacml_resource_marshal: can't add Hessian attribute to attributes Hessian list at: %d.", i);
-            hessian_delete(h_resource);
-            hessian_delete(h_attrs);
-            hessian_delete(h_attr);
             return PEP_IO_ERROR;
         }
     }
-    h_attrs_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_RESOURCE_ATTRIBUTES);
-    if (hessian_map_add(h_resource,h_attrs_key,h_attrs) != HESSIAN_OK) {
-        log_error("xacml_resource_marshal: can't add attributes Hessian list to resource Hessian map.");
-        hessian_delete(h_resource);
-        hessian_delete(h_attrs);
-        hessian_delete(h_attrs_key);
+    if (hessian_writer_end(output) != HESSIAN_OK || hessian_writer_end(output) != HESSIAN_OK) {
+        log_error("xacml_resource_marshal: can't end resource Hessian map.");
         return PEP_IO_ERROR;
     }
-    *h_res= h_resource;
     return PEP_IO_OK;
 }
 
@@ -901,7 +886,7 @@ static int xacml_resource_unmarshal(xacml_resource_t ** res, const hessian_objec
         log_error("xacml_resource_unmarshal: NULL Hessian map type.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_RESOURCE_CLASSNAME,map_type) != 0) {
+    if (xacml_name_lookup(map_type,strlen(map_type)) != XACML_CLASS_RESOURCE) {
         log_error("xacml_resource_unmarshal: wrong Hessian map type: %s.",map_type);
         return PEP_IO_ERROR;
     }
@@ -917,6 +902,7 @@ static int xacml_resource_unmarshal(xacml_resource_t ** res, const hessian_objec
     for(i= 0; i<map_l; i++) {
         hessian_object_t * h_map_key= hessian_map_getkey(h_resource,i);
         const char * key;
+        xacml_name_t key_id;
         if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
             log_error("xacml_resource_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
             xacml_resource_delete(resource);
@@ -928,8 +914,9 @@ static int xacml_resource_unmarshal(xacml_resource_t ** res, const hessian_objec
             xacml_resource_delete(resource);
             return PEP_IO_ERROR;
         }
+        key_id= xacml_name_lookup(key,hessian_string_length(h_map_key));
         /* content (can be null) */
-        if (strcmp(XACML_HESSIAN_RESOURCE_CONTENT,key) == 0) {
+        if (key_id == XACML_KEY_RESOURCECONTENT) {
             hessian_object_t * h_string= hessian_map_getvalue(h_resource,i);
             hessian_t h_string_type= hessian_gettype(h_string);
             const char * content;
@@ -949,7 +936,7 @@ static int xacml_resource_unmarshal(xacml_resource_t ** res, const hessian_objec
             }
         }
         /* attributes list */
-        else if (strcmp(XACML_HESSIAN_RESOURCE_ATTRIBUTES,key) == 0) {
+        else if (key_id == XACML_KEY_ATTRIBUTES) {
             hessian_object_t * h_attributes= hessian_map_getvalue(h_resource,i);
             size_t h_attributes_l;
             if (hessian_gettype(h_attributes) != HESSIAN_LIST) {
@@ -984,8 +971,7 @@ static int xacml_resource_unmarshal(xacml_resource_t ** res, const hessian_objec
 }
 
 
-static int xacml_subject_marshal(const xacml_subject_t * subject, hessian_object_t ** h_sub) {
-    hessian_object_t * h_subject, * h_attrs, * h_attrs_key;
+static int xacml_subject_marshal(const xacml_subject_t * subject, BUFFER * output) {
     const char * category;
     size_t list_l;
     int i;
@@ -993,64 +979,37 @@ static int xacml_subject_marshal(const xacml_subject_t * subject, hessian_object
         log_error("xacml_subject_marshal: NULL subject object.");
         return PEP_IO_ERROR;
     }
-    h_subject= hessian_create(HESSIAN_MAP,XACML_HESSIAN_SUBJECT_CLASSNAME);
-    if (h_subject == NULL) {
-        log_error("xacml_subject_marshal: can't create Hessian map: %s.", XACML_HESSIAN_SUBJECT_CLASSNAME);
+    if (hessian_write_fragment(&SUBJECT_MAP,sizeof(SUBJECT_MAP),output) != HESSIAN_OK) {
+        log_error("xacml_subject_marshal: can't write Hessian map: %s.", XACML_HESSIAN_SUBJECT_CLASSNAME);
         return PEP_IO_ERROR;
     }
     /* category (can be null) */
     category= xacml_subject_getcategory(subject);
     if (category != NULL) {
-        hessian_object_t * h_category= hessian_create(HESSIAN_STRING,category);
-        hessian_object_t * h_category_key;
-        if (h_category == NULL) {
-            log_error("xacml_subject_marshal: can't create category Hessian string: %s.", category);
-            hessian_delete(h_subject);
-            return PEP_IO_ERROR;
-        }
-        h_category_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_SUBJECT_CATEGORY);
-        if (hessian_map_add(h_subject,h_category_key,h_category) != HESSIAN_OK) {
-            log_error("xacml_subject_marshal: can't add category Hessian string to subject Hessian map.");
-            hessian_delete(h_subject);
-            hessian_delete(h_category_key);
-            hessian_delete(h_category);
+        if (hessian_write_fragment(&SUBJECT_CATEGORY_KEY,sizeof(SUBJECT_CATEGORY_KEY),output) != HESSIAN_OK
+            || hessian_write_string(category,output) != HESSIAN_OK) {
+            log_error("xacml_subject_marshal: can't write category Hessian string: %s.", category);
             return PEP_IO_ERROR;
         }
     }
     /* attributes list */
-    h_attrs= hessian_create(HESSIAN_LIST);
-    if (h_attrs == NULL) {
-        log_error("xacml_subject_marshal: can't create attributes Hessian list.");
-        hessian_delete(h_subject);
+    list_l= xacml_subject_attributes_length(subject);
+    if (hessian_write_fragment(&ATTRIBUTES_KEY,sizeof(ATTRIBUTES_KEY),output) != HESSIAN_OK
+        || hessian_writer_begin_list(NULL,list_l,output) != HESSIAN_OK) {
+        log_error("xacml_subject_marshal: can't write attributes Hessian list.");
         return PEP_IO_ERROR;
     }
-    list_l= xacml_subject_attributes_length(subject);
     for (i= 0; i < list_l; i++) {
         xacml_attribute_t * attr= xacml_subject_getattribute(subject,i);
-        hessian_object_t * h_attr= NULL;
-        if (xacml_attribute_marshal(attr,&h_attr) != PEP_IO_OK) {
+        if (xacml_attribute_marshal(attr,output) != PEP_IO_OK) {
             log_error("xacml_subject_marshal: can't marshal XACML attribute at: %d.", i);
-            hessian_delete(h_subject);
-            hessian_delete(h_attrs);
-            return PEP_IO_ERROR;
-        }
-        if (hessian_list_add(h_attrs,h_attr) != HESSIAN_OK) {
-            log_error("xacml_subject_marshal: can't add Hessian attribute to attributes Hessian list at: %d.", i);
-            hessian_delete(h_subject);
-            hessian_delete(h_attrs);
-            hessian_delete(h_attr);
             return PEP_IO_ERROR;
         }
     }
-    h_attrs_key= hessian_create(HESSIAN_STRING,XACML_HESSIAN_SUBJECT_ATTRIBUTES);
-    if (hessian_map_add(h_subject,h_attrs_key,h_attrs) != HESSIAN_OK) {
-        log_error("xacml_subject_marshal: can't add attributes Hessian list to subject Hessian map.");
-        hessian_delete(h_subject);
-        hessian_delete(h_attrs);
-        hessian_delete(h_attrs_key);
+    if (hessian_writer_end(output) != HESSIAN_OK || hessian_writer_end(output) != HESSIAN_OK) {
+        log_error("xacml_subject_marshal: can't end subject Hessian map.");
         return PEP_IO_ERROR;
     }
-    *h_sub= h_subject;
     return PEP_IO_OK;
 }
 
@@ -1068,7 +1027,7 @@ static int xacml_subject_unmarshal(xacml_subject_t ** subj, const hessian_object
         log_error("xacml_subject_unmarshal: NULL Hessian map type.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_SUBJECT_CLASSNAME,map_type) != 0) {
+    if (xacml_name_lookup(map_type,strlen(map_type)) != XACML_CLASS_SUBJECT) {
         log_error("xacml_subject_unmarshal: wrong Hessian map type: %s.",map_type);
         return PEP_IO_ERROR;
     }
@@ -1084,6 +1043,7 @@ static int xacml_subject_unmarshal(xacml_subject_t ** subj, const hessian_object
     for(i= 0; i<map_l; i++) {
         hessian_object_t * h_map_key= hessian_map_getkey(h_subject,i);
         const char * key;
+        xacml_name_t key_id;
         if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
             log_error("xacml_subject_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
             xacml_subject_delete(subject);
@@ -1095,8 +1055,9 @@ static int xacml_subject_unmarshal(xacml_subject_t ** subj, const hessian_object
             xacml_subject_delete(subject);
             return PEP_IO_ERROR;
         }
+        key_id= xacml_name_lookup(key,hessian_string_length(h_map_key));
         /* category (can be null) */
-        if (strcmp(XACML_HESSIAN_SUBJECT_CATEGORY,key) == 0) {
+        if (key_id == XACML_KEY_CATEGORY) {
             hessian_object_t * h_string= hessian_map_getvalue(h_subject,i);
             hessian_t h_string_type= hessian_gettype(h_string);
             const char * category;
@@ -1116,7 +1077,7 @@ static int xacml_subject_unmarshal(xacml_subject_t ** subj, const hessian_object
             }
         }
         /* attributes list */
-        else if (strcmp(XACML_HESSIAN_SUBJECT_ATTRIBUTES,key) == 0) {
+        else if (key_id == XACML_KEY_ATTRIBUTES) {
             hessian_object_t * h_attributes= hessian_map_getvalue(h_subject,i);
             size_t h_attributes_l;
             if (hessian_gettype(h_attributes) != HESSIAN_LIST) {
@@ -1154,41 +1115,294 @@ static int xacml_subject_unmarshal(xacml_subject_t ** subj, const hessian_object
 }
 
 
+/*
+ * Hessian 2.0 marshalling: the XACML objects are written as Hessian 2.0
+ * objects, with the class definitions written once on first use.
+ */
+
+/* Hessian 2.0 class definition fields, in the order of the object values */
+static const char * const ATTRIBUTE_FIELDS[]= { XACML_HESSIAN_ATTRIBUTE_ID, XACML_HESSIAN_ATTRIBUTE_DATATYPE, XACML_HESSIAN_ATTRIBUTE_ISSUER, XACML_HESSIAN_ATTRIBUTE_VALUES };
+static const char * const SUBJECT_FIELDS[]= { XACML_HESSIAN_SUBJECT_CATEGORY, XACML_HESSIAN_SUBJECT_ATTRIBUTES };
+static const char * const RESOURCE_FIELDS[]= { XACML_HESSIAN_RESOURCE_CONTENT, XACML_HESSIAN_RESOURCE_ATTRIBUTES };
+static const char * const ACTION_FIELDS[]= { XACML_HESSIAN_ACTION_ATTRIBUTES };
+static const char * const ENVIRONMENT_FIELDS[]= { XACML_HESSIAN_ENVIRONMENT_ATTRIBUTES };
+static const char * const REQUEST_FIELDS[]= { XACML_HESSIAN_REQUEST_SUBJECTS, XACML_HESSIAN_REQUEST_RESOURCES, XACML_HESSIAN_REQUEST_ACTION, XACML_HESSIAN_REQUEST_ENVIRONMENT };
+
+#define FIELDS_LENGTH(fields) (sizeof(fields) / sizeof(fields[0]))
+
+/* Hessian 2.0 output stream */
+typedef struct xacml_writer2 {
+    BUFFER * output;
+    int classdefs[XACML_CLASS_RESPONSE + 1]; /* class definition index + 1, 0 if not yet written */
+    int classdefs_l;
+} xacml_writer2_t;
+
+/**
+ * Begins an object of the class, and writes the class definition first if
+ * not yet done.
+ */
+static int xacml_write2_object(xacml_writer2_t * writer, xacml_name_t class_id, const char * classname, const char * const fields[], size_t fields_l) {
+    if (writer->classdefs[class_id] == 0) {
+        if (hessian2_write_classdef(classname,fields,fields_l,writer->output) != HESSIAN_OK) {
+            return PEP_IO_ERROR;
+        }
+        writer->classdefs[class_id]= ++(writer->classdefs_l);
+    }
+    if (hessian2_writer_begin_object(writer->classdefs[class_id] - 1,writer->output) != HESSIAN_OK) {
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+/**
+ * Writes the string, or a null if the string is NULL.
+ */
+static int xacml_write2_string(const char * str, BUFFER * output) {
+    if (str == NULL) {
+        return (hessian_write_null(output) == HESSIAN_OK) ? PEP_IO_OK : PEP_IO_ERROR;
+    }
+    return (hessian2_write_string(str,output) == HESSIAN_OK) ? PEP_IO_OK : PEP_IO_ERROR;
+}
+
+static int xacml_attribute_marshal2(const xacml_attribute_t * attr, xacml_writer2_t * writer) {
+    size_t values_l;
+    int i;
+    if (attr == NULL) {
+        log_error("xacml_attribute_marshal2: NULL attribute object.");
+        return PEP_IO_ERROR;
+    }
+    values_l= xacml_attribute_values_length(attr);
+    if (xacml_write2_object(writer,XACML_CLASS_ATTRIBUTE,XACML_HESSIAN_ATTRIBUTE_CLASSNAME,ATTRIBUTE_FIELDS,FIELDS_LENGTH(ATTRIBUTE_FIELDS)) != PEP_IO_OK
+        || xacml_write2_string(xacml_attribute_getid(attr),writer->output) != PEP_IO_OK
+        || xacml_write2_string(xacml_attribute_getdatatype(attr),writer->output) != PEP_IO_OK
+        || xacml_write2_string(xacml_attribute_getissuer(attr),writer->output) != PEP_IO_OK
+        || hessian2_writer_begin_list(values_l,writer->output) != HESSIAN_OK) {
+        log_error("xacml_attribute_marshal2: can't write attribute Hessian object: %s.",xacml_attribute_getid(attr));
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; i < values_l; i++) {
+        const char * value= xacml_attribute_getvalue(attr,i);
+        if (xacml_write2_string(value,writer->output) != PEP_IO_OK) {
+            log_error("xacml_attribute_marshal2: can't write value: %s at: %d.",value,i);
+            return PEP_IO_ERROR;
+        }
+    }
+    return PEP_IO_OK;
+}
+
+/**
+ * Writes the list of attributes returned by get_attribute.
+ */
+static int xacml_attributes_marshal2(const void * container, size_t attrs_l, xacml_attribute_t * (* get_attribute)(const void *, int), xacml_writer2_t * writer) {
+    int i;
+    if (hessian2_writer_begin_list(attrs_l,writer->output) != HESSIAN_OK) {
+        log_error("xacml_attributes_marshal2: can't write attributes Hessian list.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; i < attrs_l; i++) {
+        if (xacml_attribute_marshal2(get_attribute(container,i),writer) != PEP_IO_OK) {
+            log_error("xacml_attributes_marshal2: failed to marshal XACML attribute at: %d.",i);
+            return PEP_IO_ERROR;
+        }
+    }
+    return PEP_IO_OK;
+}
+
+static xacml_attribute_t * xacml_subject_getattribute_cb(const void * subject, int i) {
+    return xacml_subject_getattribute((const xacml_subject_t *)subject,i);
+}
+
+static xacml_attribute_t * xacml_resource_getattribute_cb(const void * resource, int i) {
+    return xacml_resource_getattribute((const xacml_resource_t *)resource,i);
+}
+
+static xacml_attribute_t * xacml_action_getattribute_cb(const void * action, int i) {
+    return xacml_action_getattribute((const xacml_action_t *)action,i);
+}
+
+static xacml_attribute_t * xacml_environment_getattribute_cb(const void * environment, int i) {
+    return xacml_environment_getattribute((const xacml_environment_t *)environment,i);
+}
+
+static int xacml_subject_marshal2(const xacml_subject_t * subject, xacml_writer2_t * writer) {
+    if (subject == NULL) {
+        log_error("xacml_subject_marshal2: NULL subject object.");
+        return PEP_IO_ERROR;
+    }
+    if (xacml_write2_object(writer,XACML_CLASS_SUBJECT,XACML_HESSIAN_SUBJECT_CLASSNAME,SUBJECT_FIELDS,FIELDS_LENGTH(SUBJECT_FIELDS)) != PEP_IO_OK
+        || xacml_write2_string(xacml_subject_getcategory(subject),writer->output) != PEP_IO_OK
+        || xacml_attributes_marshal2(subject,xacml_subject_attributes_length(subject),xacml_subject_getattribute_cb,writer) != PEP_IO_OK) {
+        log_error("xacml_subject_marshal2: can't write subject Hessian object.");
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+static int xacml_resource_marshal2(const xacml_resource_t * resource, xacml_writer2_t * writer) {
+    if (resource == NULL) {
+        log_error("xacml_resource_marshal2: NULL resource object.");
+        return PEP_IO_ERROR;
+    }
+    if (xacml_write2_object(writer,XACML_CLASS_RESOURCE,XACML_HESSIAN_RESOURCE_CLASSNAME,RESOURCE_FIELDS,FIELDS_LENGTH(RESOURCE_FIELDS)) != PEP_IO_OK
+        || xacml_write2_string(xacml_resource_getcontent(resource),writer->output) != PEP_IO_OK
+        || xacml_attributes_marshal2(resource,xacml_resource_attributes_length(resource),xacml_resource_getattribute_cb,writer) != PEP_IO_OK) {
+        log_error("xacml_resource_marshal2: can't write resource Hessian object.");
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+/**
+ * Writes the Hessian object for this Action or a Hessian null if the Action is null.
+ */
+static int xacml_action_marshal2(const xacml_action_t * action, xacml_writer2_t * writer) {
+    if (action == NULL) {
+        return (hessian_write_null(writer->output) == HESSIAN_OK) ? PEP_IO_OK : PEP_IO_ERROR;
+    }
+    if (xacml_write2_object(writer,XACML_CLASS_ACTION,XACML_HESSIAN_ACTION_CLASSNAME,ACTION_FIELDS,FIELDS_LENGTH(ACTION_FIELDS)) != PEP_IO_OK
+        || xacml_attributes_marshal2(action,xacml_action_attributes_length(action),xacml_action_getattribute_cb,writer) != PEP_IO_OK) {
+        log_error("xacml_action_marshal2: can't write action Hessian object.");
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+/**
+ * Writes the Hessian object for this Environment or a Hessian null if the Environment is null.
+ */
+static int xacml_environment_marshal2(const xacml_environment_t * environment, xacml_writer2_t * writer) {
+    if (environment == NULL) {
+        return (hessian_write_null(writer->output) == HESSIAN_OK) ? PEP_IO_OK : PEP_IO_ERROR;
+    }
+    if (xacml_write2_object(writer,XACML_CLASS_ENVIRONMENT,XACML_HESSIAN_ENVIRONMENT_CLASSNAME,ENVIRONMENT_FIELDS,FIELDS_LENGTH(ENVIRONMENT_FIELDS)) != PEP_IO_OK
+        || xacml_attributes_marshal2(environment,xacml_environment_attributes_length(environment),xacml_environment_getattribute_cb,writer) != PEP_IO_OK) {
+        log_error("xacml_environment_marshal2: can't write environment Hessian object.");
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+static int xacml_request_marshal2(const xacml_request_t * request, xacml_writer2_t * writer) {
+    size_t list_l;
+    int i;
+    if (request == NULL) {
+        log_error("xacml_request_marshal2: NULL request object.");
+        return PEP_IO_ERROR;
+    }
+    if (xacml_write2_object(writer,XACML_CLASS_REQUEST,XACML_HESSIAN_REQUEST_CLASSNAME,REQUEST_FIELDS,FIELDS_LENGTH(REQUEST_FIELDS)) != PEP_IO_OK) {
+        log_error("xacml_request_marshal2: can't write request Hessian object: %s.",XACML_HESSIAN_REQUEST_CLASSNAME);
+        return PEP_IO_ERROR;
+    }
+    /* subjects list */
+    list_l= xacml_request_subjects_length(request);
+    if (hessian2_writer_begin_list(list_l,writer->output) != HESSIAN_OK) {
+        log_error("xacml_request_marshal2: can't write subjects Hessian list.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; i < list_l; i++) {
+        if (xacml_subject_marshal2(xacml_request_getsubject(request,i),writer) != PEP_IO_OK) {
+            log_error("xacml_request_marshal2: failed to marshal XACML subject at: %d.",i);
+            return PEP_IO_ERROR;
+        }
+    }
+    /* resources list */
+    list_l= xacml_request_resources_length(request);
+    if (hessian2_writer_begin_list(list_l,writer->output) != HESSIAN_OK) {
+        log_error("xacml_request_marshal2: can't write resources Hessian list.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; i < list_l; i++) {
+        if (xacml_resource_marshal2(xacml_request_getresource(request,i),writer) != PEP_IO_OK) {
+            log_error("xacml_request_marshal2: failed to marshal XACML resource at: %d.",i);
+            return PEP_IO_ERROR;
+        }
+    }
+    /* action and environment */
+    if (xacml_action_marshal2(xacml_request_getaction(request),writer) != PEP_IO_OK) {
+        log_error("xacml_request_marshal2: failed to marshal XACML action.");
+        return PEP_IO_ERROR;
+    }
+    if (xacml_environment_marshal2(xacml_request_getenvironment(request),writer) != PEP_IO_OK) {
+        log_error("xacml_request_marshal2: failed to marshal XACML environment.");
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
 /* OK */
-pep_error_t xacml_request_marshalling(const xacml_request_t * request, BUFFER * output) {
-    hessian_object_t * h_request= NULL;
-    if (xacml_request_marshal(request,&h_request) != PEP_IO_OK) {
-        log_error("xacml_request_marshalling: can't marshal XACML request into Hessian object.");
+pep_error_t xacml_request_marshalling(const xacml_request_t * request, int version, BUFFER * output) {
+    xacml_writer2_t writer;
+    int rc;
+    if (version == HESSIAN_VERSION_2) {
+        memset(&writer,0,sizeof(xacml_writer2_t));
+        writer.output= output;
+        rc= xacml_request_marshal2(request,&writer);
+    }
+    else {
+        rc= xacml_request_marshal(request,output);
+    }
+    if (rc != PEP_IO_OK) {
+        log_error("xacml_request_marshalling: can't write XACML request as Hessian.");
         /* pep_errmsg("failed to marshal XACML request into Hessian object"); */
         return PEP_ERR_MARSHALLING_HESSIAN;
     }
-    if (hessian_serialize(h_request,output) != HESSIAN_OK) {
-        log_error("xacml_request_marshalling: failed to serialize Hessian object.");
-        hessian_delete(h_request);
-        /* pep_errmsg("failed to serialize Hessian object"); */
-        return PEP_ERR_MARSHALLING_IO;
-    }
-    hessian_delete(h_request);
     return PEP_OK;
 }
 
 /* OK */
-pep_error_t xacml_response_unmarshalling(xacml_response_t ** response, BUFFER * input) {
-    hessian_object_t * h_response= hessian_deserialize(input);
-    if (h_response == NULL) {
-        log_error("xacml_response_unmarshalling: failed to deserialize Hessian object.");
-        /* pep_errmsg("failed to deserialize base64 encoded Hessian object"); */
-        return PEP_ERR_UNMARSHALLING_IO;
-    }
-    if (xacml_response_unmarshal(response, h_response) != PEP_IO_OK) {
-        log_error("xacml_response_unmarshalling: can't unmarshal XACML response from Hessian object.");
-        hessian_delete(h_response);
-        /* pep_errmsg("failed to unmarshal XACML response from Hessian object"); */
-        return PEP_ERR_UNMARSHALLING_HESSIAN;
-    }
-    hessian_delete(h_response);
-    return PEP_OK;
-
+pep_error_t xacml_response_unmarshalling(xacml_response_t ** response, BUFFER * input, arena_t * arena) {
+    hessian_object_t * h_response;
+    hessian_reader_t * reader;
+    arena_t * tmp_arena= NULL;
+    size_t input_l;
+    pep_error_t rc= PEP_OK;
+    int read_rc;
+    if (arena == NULL) {
+        arena= tmp_arena= arena_create(0);
+        if (arena == NULL) {
+            log_error("xacml_response_unmarshalling: can't create temp arena.");
+            return PEP_ERR_MEMORY;
+        }
+    }
+    /* pull the XACML response directly from the Hessian encoding */
+    input_l= buffer_length(input);
+    reader= hessian_reader_create_arena(arena,input);
+    if (reader == NULL) {
+        log_error("xacml_response_unmarshalling: can't create Hessian reader.");
+        rc= PEP_ERR_MEMORY;
+    }
+    else if ((read_rc= xacml_response_read(reader,hessian_reader_next(reader),response)) == PEP_IO_REF) {
+        /* Hessian refs point back into the objects tree: restart with it */
+        int version= hessian_reader_getversion(reader);
+        log_debug("xacml_response_unmarshalling: Hessian ref in response, using Hessian objects.");
+        arena_reset(arena);
+        buffer_rewind(input);
+        buffer_skip(input,buffer_length(input) - input_l);
+        if (version == HESSIAN_VERSION_1) {
+            h_response= hessian_deserialize_arena(arena,input);
+        }
+        else {
+            /* the Hessian 2.0 objects tree is built by the pull reader */
+            reader= hessian_reader_create_arena(arena,input);
+            h_response= (reader != NULL) ? hessian_reader_getobject(reader,hessian_reader_next(reader)) : NULL;
+        }
+        if (h_response == NULL) {
+            log_error("xacml_response_unmarshalling: failed to deserialize Hessian object.");
+            rc= PEP_ERR_UNMARSHALLING_IO;
+        }
+        else if (xacml_response_unmarshal(response, h_response) != PEP_IO_OK) {
+            log_error("xacml_response_unmarshalling: can't unmarshal XACML response from Hessian object.");
+            rc= PEP_ERR_UNMARSHALLING_HESSIAN;
+        }
+    }
+    else if (read_rc != PEP_IO_OK) {
+        log_error("xacml_response_unmarshalling: can't unmarshal XACML response from Hessian input.");
+        rc= PEP_ERR_UNMARSHALLING_HESSIAN;
+    }
+    /* release the reader and the Hessian objects at once */
+    arena_reset(arena);
+    arena_delete(tmp_arena);
+    return rc;
 }
 
 /* OK */
@@ -1206,7 +1420,7 @@ static int xacml_response_unmarshal(xacml_response_t ** resp, const hessian_obje
         log_error("xacml_response_unmarshal: NULL Hessian map type.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_RESPONSE_CLASSNAME,map_type) != 0) {
+    if (xacml_name_lookup(map_type,strlen(map_type)) != XACML_CLASS_RESPONSE) {
         log_error("xacml_response_unmarshal: wrong Hessian map type: %s.",map_type);
         return PEP_IO_ERROR;
     }
@@ -1222,6 +1436,7 @@ static int xacml_response_unmarshal(xacml_response_t ** resp, const hessian_obje
     for(i= 0; i<map_l; i++) {
         hessian_object_t * h_map_key= hessian_map_getkey(h_response,i);
         const char * key;
+        xacml_name_t key_id;
         if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
             log_error("xacml_response_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
             xacml_response_delete(response);
@@ -1233,8 +1448,9 @@ static int xacml_response_unmarshal(xacml_response_t ** resp, const hessian_obje
             xacml_response_delete(response);
             return PEP_IO_ERROR;
         }
+        key_id= xacml_name_lookup(key,hessian_string_length(h_map_key));
         /* request (can be null???) */
-        if (strcmp(XACML_HESSIAN_RESPONSE_REQUEST,key) == 0) {
+        if (key_id == XACML_KEY_REQUEST) {
             hessian_object_t * h_request= hessian_map_getvalue(h_response,i);
             if (hessian_gettype(h_request) != HESSIAN_NULL) {
                 xacml_request_t * request= NULL;
@@ -1256,7 +1472,7 @@ static int xacml_response_unmarshal(xacml_response_t ** resp, const hessian_obje
 
         }
         /* results list */
-        else if (strcmp(XACML_HESSIAN_RESPONSE_RESULTS,key) == 0) {
+        else if (key_id == XACML_KEY_RESULTS) {
             hessian_object_t * h_results= hessian_map_getvalue(h_response,i);
             size_t h_results_l;
             if (hessian_gettype(h_results) != HESSIAN_LIST) {
@@ -1305,7 +1521,7 @@ static int xacml_result_unmarshal(xacml_result_t ** res, const hessian_object_t
         log_error("xacml_result_unmarshal: NULL Hessian map type.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_RESULT_CLASSNAME,map_type) != 0) {
+    if (xacml_name_lookup(map_type,strlen(map_type)) != XACML_CLASS_RESULT) {
         log_error("xacml_result_unmarshal: wrong Hessian map type: %s.",map_type);
         return PEP_IO_ERROR;
     }
@@ -1320,6 +1536,7 @@ static int xacml_result_unmarshal(xacml_result_t ** res, const hessian_object_t
     for(i= 0; i<map_l; i++) {
         hessian_object_t * h_map_key= hessian_map_getkey(h_result,i);
         const char * key;
+        xacml_name_t key_id;
         if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
             log_error("xacml_result_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
             xacml_result_delete(result);
@@ -1331,8 +1548,9 @@ static int xacml_result_unmarshal(xacml_result_t ** res, const hessian_object_t
             xacml_result_delete(result);
             return PEP_IO_ERROR;
         }
+        key_id= xacml_name_lookup(key,hessian_string_length(h_map_key));
         /* decision (enum, mandatory) */
-        if (strcmp(XACML_HESSIAN_RESULT_DECISION,key) == 0) {
+        if (key_id == XACML_KEY_DECISION) {
             hessian_object_t * h_integer= hessian_map_getvalue(h_result,i);
             int32_t decision;
             if (hessian_gettype(h_integer) != HESSIAN_INTEGER) {
@@ -1348,7 +1566,7 @@ static int xacml_result_unmarshal(xacml_result_t ** res, const hessian_object_t
             }
         }
         /* resourceid (optional) */
-        else if (strcmp(XACML_HESSIAN_RESULT_RESOURCEID,key) == 0) {
+        else if (key_id == XACML_KEY_RESOURCEID) {
             hessian_object_t * h_string= hessian_map_getvalue(h_result,i);
             hessian_t h_string_type= hessian_gettype(h_string);
             const char * resourceid;
@@ -1368,7 +1586,7 @@ static int xacml_result_unmarshal(xacml_result_t ** res, const hessian_object_t
             }
         }
         /* status (null?) */
-        else if (strcmp(XACML_HESSIAN_RESULT_STATUS,key) == 0) {
+        else if (key_id == XACML_KEY_STATUS) {
             hessian_object_t * h_status= hessian_map_getvalue(h_result,i);
             if (hessian_gettype(h_status) != HESSIAN_NULL) {
                 xacml_status_t * status= NULL;
@@ -1389,7 +1607,7 @@ static int xacml_result_unmarshal(xacml_result_t ** res, const hessian_object_t
             }
         }
         /* obligations list */
-        else if (strcmp(XACML_HESSIAN_RESULT_OBLIGATIONS,key) == 0) {
+        else if (key_id == XACML_KEY_OBLIGATIONS) {
             hessian_object_t * h_obligations= hessian_map_getvalue(h_result,i);
             size_t h_obligations_l;
             if (hessian_gettype(h_obligations) != HESSIAN_LIST) {
@@ -1438,7 +1656,7 @@ static int xacml_status_unmarshal(xacml_status_t ** st, const hessian_object_t *
         log_error("xacml_status_unmarshal: NULL Hessian map type.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_STATUS_CLASSNAME,map_type) != 0) {
+    if (xacml_name_lookup(map_type,strlen(map_type)) != XACML_CLASS_STATUS) {
         log_error("xacml_status_unmarshal: wrong Hessian map type: %s.",map_type);
         return PEP_IO_ERROR;
     }
@@ -1452,6 +1670,7 @@ static int xacml_status_unmarshal(xacml_status_t ** st, const hessian_object_t *
     for(i= 0; i<map_l; i++) {
         hessian_object_t * h_map_key= hessian_map_getkey(h_status,i);
         const char * key;
+        xacml_name_t key_id;
         if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
             log_error("xacml_status_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
             xacml_status_delete(status);
@@ -1463,8 +1682,9 @@ static int xacml_status_unmarshal(xacml_status_t ** st, const hessian_object_t *
             xacml_status_delete(status);
             return PEP_IO_ERROR;
         }
+        key_id= xacml_name_lookup(key,hessian_string_length(h_map_key));
         /* message (can be null) */
-        if (strcmp(XACML_HESSIAN_STATUS_MESSAGE,key) == 0) {
+        if (key_id == XACML_KEY_MESSAGE) {
             hessian_object_t * h_string= hessian_map_getvalue(h_status,i);
             if (hessian_gettype(h_string) != HESSIAN_NULL) {
                 const char * message;
@@ -1482,7 +1702,7 @@ static int xacml_status_unmarshal(xacml_status_t ** st, const hessian_object_t *
             }
         }
         /* subcode (can be null) */
-        else if (strcmp(XACML_HESSIAN_STATUS_CODE,key) == 0) {
+        else if (key_id == XACML_KEY_STATUSCODE) {
             hessian_object_t * h_statuscode= hessian_map_getvalue(h_status,i);
             if (hessian_gettype(h_statuscode) != HESSIAN_NULL) {
                 xacml_statuscode_t * statuscode= NULL;
@@ -1525,7 +1745,7 @@ static int xacml_statuscode_unmarshal(xacml_statuscode_t ** stc, const hessian_o
         log_error("xacml_statuscode_unmarshal: NULL Hessian map type.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_STATUSCODE_CLASSNAME,map_type) != 0) {
+    if (xacml_name_lookup(map_type,strlen(map_type)) != XACML_CLASS_STATUSCODE) {
         log_error("xacml_statuscode_unmarshal: wrong Hessian map type: %s.",map_type);
         return PEP_IO_ERROR;
     }
@@ -1541,6 +1761,7 @@ static int xacml_statuscode_unmarshal(xacml_statuscode_t ** stc, const hessian_o
     for(i= 0; i<map_l; i++) {
         hessian_object_t * h_map_key= hessian_map_getkey(h_statuscode,i);
         const char * key;
+        xacml_name_t key_id;
         if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
             log_error("xacml_statuscode_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
             xacml_statuscode_delete(statuscode);
@@ -1552,8 +1773,9 @@ static int xacml_statuscode_unmarshal(xacml_statuscode_t ** stc, const hessian_o
             xacml_statuscode_delete(statuscode);
             return PEP_IO_ERROR;
         }
+        key_id= xacml_name_lookup(key,hessian_string_length(h_map_key));
         /* code (mandatory) */
-        if (strcmp(XACML_HESSIAN_STATUSCODE_VALUE,key) == 0) {
+        if (key_id == XACML_KEY_CODE) {
             hessian_object_t * h_string= hessian_map_getvalue(h_statuscode,i);
             const char * code;
             if (hessian_gettype(h_string) != HESSIAN_STRING) {
@@ -1569,7 +1791,7 @@ static int xacml_statuscode_unmarshal(xacml_statuscode_t ** stc, const hessian_o
             }
         }
         /* subcode (can be null) */
-        else if (strcmp(XACML_HESSIAN_STATUSCODE_SUBCODE, key) == 0) {
+        else if (key_id == XACML_KEY_SUBCODE) {
             hessian_object_t * h_subcode= hessian_map_getvalue(h_statuscode,i);
             if (hessian_gettype(h_subcode) != HESSIAN_NULL) {
                 xacml_statuscode_t * subcode= NULL;
@@ -1608,7 +1830,7 @@ static int xacml_obligation_unmarshal(xacml_obligation_t ** obl, const hessian_o
         log_error("xacml_obligation_unmarshal: NULL Hessian map type.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_OBLIGATION_CLASSNAME,map_type) != 0) {
+    if (xacml_name_lookup(map_type,strlen(map_type)) != XACML_CLASS_OBLIGATION) {
         log_error("xacml_obligation_unmarshal: wrong Hessian map type: %s.",map_type);
         return PEP_IO_ERROR;
     }
@@ -1623,6 +1845,7 @@ static int xacml_obligation_unmarshal(xacml_obligation_t ** obl, const hessian_o
     for(i= 0; i<map_l; i++) {
         hessian_object_t * h_map_key= hessian_map_getkey(h_obligation,i);
         const char * key;
+        xacml_name_t key_id;
         if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
             log_error("xacml_obligation_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
             xacml_obligation_delete(obligation);
@@ -1634,9 +1857,10 @@ static int xacml_obligation_unmarshal(xacml_obligation_t ** obl, const hessian_o
             xacml_obligation_delete(obligation);
             return PEP_IO_ERROR;
         }
+        key_id= xacml_name_lookup(key,hessian_string_length(h_map_key));
 
         /* id (mandatory) */
-        if (strcmp(XACML_HESSIAN_OBLIGATION_ID,key) == 0) {
+        if (key_id == XACML_KEY_ID) {
             hessian_object_t * h_string= hessian_map_getvalue(h_obligation,i);
             const char * id;
             if (hessian_gettype(h_string) != HESSIAN_STRING) {
@@ -1652,7 +1876,7 @@ static int xacml_obligation_unmarshal(xacml_obligation_t ** obl, const hessian_o
             }
         }
         /* fulfillon (enum) */
-        else if (strcmp(XACML_HESSIAN_OBLIGATION_FULFILLON,key) == 0) {
+        else if (key_id == XACML_KEY_FULFILLON) {
             hessian_object_t * h_integer= hessian_map_getvalue(h_obligation,i);
             int32_t fulfillon;
             if (hessian_gettype(h_integer) != HESSIAN_INTEGER) {
@@ -1668,7 +1892,7 @@ static int xacml_obligation_unmarshal(xacml_obligation_t ** obl, const hessian_o
             }
         }
         /* attribute assignments list */
-        else if (strcmp(XACML_HESSIAN_OBLIGATION_ASSIGNMENTS,key) == 0) {
+        else if (key_id == XACML_KEY_ATTRIBUTEASSIGNMENTS) {
             hessian_object_t * h_assignments= hessian_map_getvalue(h_obligation,i);
             size_t h_assignments_l;
             if (hessian_gettype(h_assignments) != HESSIAN_LIST) {
@@ -1717,7 +1941,7 @@ static int xacml_attributeassignment_unmarshal(xacml_attributeassignment_t ** at
         log_error("xacml_attributeassignment_unmarshal: NULL Hessian map type.");
         return PEP_IO_ERROR;
     }
-    if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_CLASSNAME,map_type) != 0) {
+    if (xacml_name_lookup(map_type,strlen(map_type)) != XACML_CLASS_ATTRIBUTEASSIGNMENT) {
         log_error("xacml_attributeassignment_unmarshal: wrong Hessian map type: %s.",map_type);
         return PEP_IO_ERROR;
     }
@@ -1733,6 +1957,7 @@ static int xacml_attributeassignment_unmarshal(xacml_attributeassignment_t ** at
     for(i= 0; i<map_l; i++) {
         hessian_object_t * h_map_key= hessian_map_getkey(h_attribute,i);
         const char * key;
+        xacml_name_t key_id;
         if (hessian_gettype(h_map_key) != HESSIAN_STRING) {
             log_error("xacml_attributeassignment_unmarshal: Hessian map<key> is not an Hessian string at: %d.",i);
             xacml_attributeassignment_delete(attribute);
@@ -1744,9 +1969,10 @@ static int xacml_attributeassignment_unmarshal(xacml_attributeassignment_t ** at
             xacml_attributeassignment_delete(attribute);
             return PEP_IO_ERROR;
         }
+        key_id= xacml_name_lookup(key,hessian_string_length(h_map_key));
 
         /* id (mandatory) */
-        if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_ID,key) == 0) {
+        if (key_id == XACML_KEY_ATTRIBUTEID) {
             hessian_object_t * h_string= hessian_map_getvalue(h_attribute,i);
             const char * id;
             if (hessian_gettype(h_string) != HESSIAN_STRING) {
@@ -1762,7 +1988,7 @@ static int xacml_attributeassignment_unmarshal(xacml_attributeassignment_t ** at
             }
         }
         /* datatype (optional) */
-        else if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_DATATYPE,key) == 0) {
+        else if (key_id == XACML_KEY_DATATYPE) {
             hessian_object_t * h_string= hessian_map_getvalue(h_attribute,i);
             hessian_t h_string_type= hessian_gettype(h_string);
             const char * datatype= NULL;
@@ -1781,7 +2007,7 @@ static int xacml_attributeassignment_unmarshal(xacml_attributeassignment_t ** at
             }
         }
         /* value (optional) */
-        else if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUE,key) == 0) {
+        else if (key_id == XACML_KEY_VALUE) {
             hessian_object_t * h_string= hessian_map_getvalue(h_attribute,i);
             hessian_t h_string_type= hessian_gettype(h_string);
             const char * value;
@@ -1801,7 +2027,7 @@ static int xacml_attributeassignment_unmarshal(xacml_attributeassignment_t ** at
             }
         }
         /* multiple values (back compatibility with PEPd <= 1.0) */
-        else if (strcmp(XACML_HESSIAN_ATTRIBUTEASSIGNMENT_VALUES,key) == 0) {
+        else if (key_id == XACML_KEY_VALUES) {
             hessian_object_t * h_values= hessian_map_getvalue(h_attribute,i);
             size_t h_values_l;
             if (hessian_gettype(h_values) != HESSIAN_LIST) {
@@ -1835,3 +2061,814 @@ static int xacml_attributeassignment_unmarshal(xacml_attributeassignment_t ** at
     return PEP_IO_OK;
 
 }
+
+/*
+ * Hessian pull unmarshalling: the XACML objects are built directly from
+ * the tokens of the Hessian reader, without the Hessian objects tree.
+ */
+
+/**
+ * Checks the token begins a Hessian map of the class.
+ */
+static int xacml_read_map(hessian_reader_t * reader, hessian_t token, xacml_name_t class_id, const char * classname) {
+    const char * map_type;
+    size_t map_type_l;
+    if (token == HESSIAN_REF) {
+        return PEP_IO_REF;
+    }
+    if (token != HESSIAN_MAP) {
+        log_error("xacml_read_map: wrong Hessian type: %d, expected map: %s.", (int)token, classname);
+        return PEP_IO_ERROR;
+    }
+    map_type= hessian_reader_getstring(reader,&map_type_l);
+    if (map_type == NULL) {
+        log_error("xacml_read_map: NULL Hessian map type, expected: %s.", classname);
+        return PEP_IO_ERROR;
+    }
+    if (xacml_name_lookup(map_type,map_type_l) != class_id) {
+        log_error("xacml_read_map: wrong Hessian map type: %s, expected: %s.", map_type, classname);
+        return PEP_IO_ERROR;
+    }
+    return PEP_IO_OK;
+}
+
+/**
+ * Reads the next Hessian map<key> and its id, or sets key to NULL at the end
+ * of the map. The key is only valid until the next token.
+ */
+static int xacml_read_key(hessian_reader_t * reader, const char ** key, xacml_name_t * key_id) {
+    hessian_t token= hessian_reader_next(reader);
+    size_t key_l;
+    *key= NULL;
+    if (token == HESSIAN_END) {
+        return PEP_IO_OK;
+    }
+    if (token != HESSIAN_STRING) {
+        log_error("xacml_read_key: Hessian map<key> is not an Hessian string: %d.", (int)token);
+        return PEP_IO_ERROR;
+    }
+    *key= hessian_reader_getstring(reader,&key_l);
+    *key_id= xacml_name_lookup(*key,key_l);
+    return PEP_IO_OK;
+}
+
+/**
+ * Reads a Hessian string value, or a Hessian null if nullable (value set to
+ * NULL). The value is only valid until the next token.
+ */
+static int xacml_read_string(hessian_reader_t * reader, int nullable, const char ** value) {
+    hessian_t token= hessian_reader_next(reader);
+    *value= NULL;
+    if (token == HESSIAN_STRING) {
+        *value= hessian_reader_getstring(reader,NULL);
+        return PEP_IO_OK;
+    }
+    if (token == HESSIAN_NULL && nullable) {
+        return PEP_IO_OK;
+    }
+    if (token == HESSIAN_REF) {
+        return PEP_IO_REF;
+    }
+    log_error("xacml_read_string: Hessian value is not a Hessian string%s: %d.", nullable ? " or null" : "", (int)token);
+    return PEP_IO_ERROR;
+}
+
+/**
+ * Reads a Hessian integer value.
+ */
+static int xacml_read_integer(hessian_reader_t * reader, int32_t * value) {
+    hessian_t token= hessian_reader_next(reader);
+    if (token == HESSIAN_INTEGER) {
+        *value= hessian_reader_getinteger(reader);
+        return PEP_IO_OK;
+    }
+    if (token == HESSIAN_REF) {
+        return PEP_IO_REF;
+    }
+    log_error("xacml_read_integer: Hessian value is not a Hessian integer: %d.", (int)token);
+    return PEP_IO_ERROR;
+}
+
+/**
+ * Reads the beginning of a Hessian list value. The elements follow, up to the
+ * HESSIAN_END token.
+ */
+static int xacml_read_list(hessian_reader_t * reader) {
+    hessian_t token= hessian_reader_next(reader);
+    if (token == HESSIAN_LIST) {
+        return PEP_IO_OK;
+    }
+    if (token == HESSIAN_REF) {
+        return PEP_IO_REF;
+    }
+    log_error("xacml_read_list: Hessian value is not a Hessian list: %d.", (int)token);
+    return PEP_IO_ERROR;
+}
+
+/**
+ * Skips the value of an unknown Hessian map<key>.
+ */
+static int xacml_read_skip(hessian_reader_t * reader) {
+    switch (hessian_reader_next(reader)) {
+    case HESSIAN_MAP:
+    case HESSIAN_LIST:
+        return (hessian_reader_skip(reader) == HESSIAN_OK) ? PEP_IO_OK : PEP_IO_ERROR;
+    case HESSIAN_END:
+    case HESSIAN_UNKNOWN:
+        log_error("xacml_read_skip: can't read Hessian map<value>.");
+        return PEP_IO_ERROR;
+    default:
+        return PEP_IO_OK;
+    }
+}
+
+static int xacml_attribute_read(hessian_reader_t * reader, hessian_t token, xacml_attribute_t ** attr) {
+    xacml_attribute_t * attribute;
+    const char * key, * value;
+    xacml_name_t key_id;
+    int rc, i;
+    rc= xacml_read_map(reader,token,XACML_CLASS_ATTRIBUTE,XACML_HESSIAN_ATTRIBUTE_CLASSNAME);
+    if (rc != PEP_IO_OK) {
+        return rc;
+    }
+    attribute= xacml_attribute_create(NULL);
+    if (attribute == NULL) {
+        log_error("xacml_attribute_read: can't create XACML attribute.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; (rc= xacml_read_key(reader,&key,&key_id)) == PEP_IO_OK && key != NULL; i++) {
+        /* id (mandatory) */
+        if (key_id == XACML_KEY_ID) {
+            rc= xacml_read_string(reader,FALSE,&value);
+            if (rc == PEP_IO_OK && xacml_attribute_setid(attribute,value) != PEP_XACML_OK) {
+                log_error("xacml_attribute_read: can't set id: %s to XACML attribute.",value);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* datatype (optional) */
+        else if (key_id == XACML_KEY_DATATYPE) {
+            rc= xacml_read_string(reader,TRUE,&value);
+            if (rc == PEP_IO_OK && xacml_attribute_setdatatype(attribute,value) != PEP_XACML_OK) {
+                log_error("xacml_attribute_read: can't set datatype: %s to XACML attribute.",value);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* issuer (optional) */
+        else if (key_id == XACML_KEY_ISSUER) {
+            rc= xacml_read_string(reader,TRUE,&value);
+            if (rc == PEP_IO_OK && xacml_attribute_setissuer(attribute,value) != PEP_XACML_OK) {
+                log_error("xacml_attribute_read: can't set issuer: %s to XACML attribute.",value);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* values list */
+        else if (key_id == XACML_KEY_VALUES) {
+            rc= xacml_read_list(reader);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_END) {
+                if (token != HESSIAN_STRING) {
+                    log_error("xacml_attribute_read: Hessian list<value> is not a Hessian string: %d.",(int)token);
+                    rc= (token == HESSIAN_REF) ? PEP_IO_REF : PEP_IO_ERROR;
+                }
+                else if (xacml_attribute_addvalue(attribute,hessian_reader_getstring(reader,NULL)) != PEP_XACML_OK) {
+                    log_error("xacml_attribute_read: can't add value: %s to XACML attribute.",hessian_reader_getstring(reader,NULL));
+                    rc= PEP_IO_ERROR;
+                }
+            }
+        }
+        else {
+            log_warn("xacml_attribute_read: unknown Hessian map<key>: %s at: %d.",key,i);
+            rc= xacml_read_skip(reader);
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_attribute_delete(attribute);
+        return rc;
+    }
+    *attr= attribute;
+    return PEP_IO_OK;
+}
+
+/**
+ * Reads a list of XACML attributes, calls add_attribute for each of them.
+ */
+static int xacml_attributes_read(hessian_reader_t * reader, void * container, int (* add_attribute)(void *, xacml_attribute_t *)) {
+    hessian_t token;
+    int rc= xacml_read_list(reader);
+    while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_END) {
+        xacml_attribute_t * attribute= NULL;
+        rc= xacml_attribute_read(reader,token,&attribute);
+        if (rc == PEP_IO_OK && add_attribute(container,attribute) != PEP_XACML_OK) {
+            log_error("xacml_attributes_read: can't add XACML attribute.");
+            xacml_attribute_delete(attribute);
+            rc= PEP_IO_ERROR;
+        }
+    }
+    return rc;
+}
+
+static int xacml_subject_addattribute_cb(void * subject, xacml_attribute_t * attribute) {
+    return xacml_subject_addattribute(subject,attribute);
+}
+
+static int xacml_resource_addattribute_cb(void * resource, xacml_attribute_t * attribute) {
+    return xacml_resource_addattribute(resource,attribute);
+}
+
+static int xacml_action_addattribute_cb(void * action, xacml_attribute_t * attribute) {
+    return xacml_action_addattribute(action,attribute);
+}
+
+static int xacml_environment_addattribute_cb(void * environment, xacml_attribute_t * attribute) {
+    return xacml_environment_addattribute(environment,attribute);
+}
+
+static int xacml_subject_read(hessian_reader_t * reader, hessian_t token, xacml_subject_t ** subj) {
+    xacml_subject_t * subject;
+    const char * key, * category;
+    xacml_name_t key_id;
+    int rc, i;
+    rc= xacml_read_map(reader,token,XACML_CLASS_SUBJECT,XACML_HESSIAN_SUBJECT_CLASSNAME);
+    if (rc != PEP_IO_OK) {
+        return rc;
+    }
+    subject= xacml_subject_create();
+    if (subject == NULL) {
+        log_error("xacml_subject_read: can't create XACML subject.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; (rc= xacml_read_key(reader,&key,&key_id)) == PEP_IO_OK && key != NULL; i++) {
+        /* category (can be null) */
+        if (key_id == XACML_KEY_CATEGORY) {
+            rc= xacml_read_string(reader,TRUE,&category);
+            if (rc == PEP_IO_OK && xacml_subject_setcategory(subject,category) != PEP_XACML_OK) {
+                log_error("xacml_subject_read: can't set category: %s to XACML subject.",category);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* attributes list */
+        else if (key_id == XACML_KEY_ATTRIBUTES) {
+            rc= xacml_attributes_read(reader,subject,xacml_subject_addattribute_cb);
+        }
+        else {
+            log_warn("xacml_subject_read: unknown Hessian map<key>: %s at: %d.",key,i);
+            rc= xacml_read_skip(reader);
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_subject_delete(subject);
+        return rc;
+    }
+    *subj= subject;
+    return PEP_IO_OK;
+}
+
+static int xacml_resource_read(hessian_reader_t * reader, hessian_t token, xacml_resource_t ** res) {
+    xacml_resource_t * resource;
+    const char * key, * content;
+    xacml_name_t key_id;
+    int rc, i;
+    rc= xacml_read_map(reader,token,XACML_CLASS_RESOURCE,XACML_HESSIAN_RESOURCE_CLASSNAME);
+    if (rc != PEP_IO_OK) {
+        return rc;
+    }
+    resource= xacml_resource_create();
+    if (resource == NULL) {
+        log_error("xacml_resource_read: can't create XACML resource.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; (rc= xacml_read_key(reader,&key,&key_id)) == PEP_IO_OK && key != NULL; i++) {
+        /* content (can be null) */
+        if (key_id == XACML_KEY_RESOURCECONTENT) {
+            rc= xacml_read_string(reader,TRUE,&content);
+            if (rc == PEP_IO_OK && xacml_resource_setcontent(resource,content) != PEP_XACML_OK) {
+                log_error("xacml_resource_read: can't set content: %s to XACML resource.",content);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* attributes list */
+        else if (key_id == XACML_KEY_ATTRIBUTES) {
+            rc= xacml_attributes_read(reader,resource,xacml_resource_addattribute_cb);
+        }
+        else {
+            log_warn("xacml_resource_read: unknown Hessian map<key>: %s at: %d.",key,i);
+            rc= xacml_read_skip(reader);
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_resource_delete(resource);
+        return rc;
+    }
+    *res= resource;
+    return PEP_IO_OK;
+}
+
+static int xacml_action_read(hessian_reader_t * reader, hessian_t token, xacml_action_t ** act) {
+    xacml_action_t * action;
+    const char * key;
+    xacml_name_t key_id;
+    int rc, i;
+    rc= xacml_read_map(reader,token,XACML_CLASS_ACTION,XACML_HESSIAN_ACTION_CLASSNAME);
+    if (rc != PEP_IO_OK) {
+        return rc;
+    }
+    action= xacml_action_create();
+    if (action == NULL) {
+        log_error("xacml_action_read: can't create XACML action.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; (rc= xacml_read_key(reader,&key,&key_id)) == PEP_IO_OK && key != NULL; i++) {
+        if (key_id == XACML_KEY_ATTRIBUTES) {
+            rc= xacml_attributes_read(reader,action,xacml_action_addattribute_cb);
+        }
+        else {
+            log_warn("xacml_action_read: unknown Hessian map<key>: %s at: %d.",key,i);
+            rc= xacml_read_skip(reader);
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_action_delete(action);
+        return rc;
+    }
+    *act= action;
+    return PEP_IO_OK;
+}
+
+static int xacml_environment_read(hessian_reader_t * reader, hessian_t token, xacml_environment_t ** env) {
+    xacml_environment_t * environment;
+    const char * key;
+    xacml_name_t key_id;
+    int rc, i;
+    rc= xacml_read_map(reader,token,XACML_CLASS_ENVIRONMENT,XACML_HESSIAN_ENVIRONMENT_CLASSNAME);
+    if (rc != PEP_IO_OK) {
+        return rc;
+    }
+    environment= xacml_environment_create();
+    if (environment == NULL) {
+        log_error("xacml_environment_read: can't create XACML environment.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; (rc= xacml_read_key(reader,&key,&key_id)) == PEP_IO_OK && key != NULL; i++) {
+        if (key_id == XACML_KEY_ATTRIBUTES) {
+            rc= xacml_attributes_read(reader,environment,xacml_environment_addattribute_cb);
+        }
+        else {
+            log_warn("xacml_environment_read: unknown Hessian map<key>: %s at: %d.",key,i);
+            rc= xacml_read_skip(reader);
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_environment_delete(environment);
+        return rc;
+    }
+    *env= environment;
+    return PEP_IO_OK;
+}
+
+static int xacml_request_read(hessian_reader_t * reader, hessian_t token, xacml_request_t ** req) {
+    xacml_request_t * request;
+    const char * key;
+    xacml_name_t key_id;
+    int rc, i;
+    rc= xacml_read_map(reader,token,XACML_CLASS_REQUEST,XACML_HESSIAN_REQUEST_CLASSNAME);
+    if (rc != PEP_IO_OK) {
+        return rc;
+    }
+    request= xacml_request_create();
+    if (request == NULL) {
+        log_error("xacml_request_read: can't create XACML request.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; (rc= xacml_read_key(reader,&key,&key_id)) == PEP_IO_OK && key != NULL; i++) {
+        /* subjects list */
+        if (key_id == XACML_KEY_SUBJECTS) {
+            rc= xacml_read_list(reader);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_END) {
+                xacml_subject_t * subject= NULL;
+                rc= xacml_subject_read(reader,token,&subject);
+                if (rc == PEP_IO_OK && xacml_request_addsubject(request,subject) != PEP_XACML_OK) {
+                    log_error("xacml_request_read: can't add XACML subject to XACML request.");
+                    xacml_subject_delete(subject);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+        }
+        /* resources list */
+        else if (key_id == XACML_KEY_RESOURCES) {
+            rc= xacml_read_list(reader);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_END) {
+                xacml_resource_t * resource= NULL;
+                rc= xacml_resource_read(reader,token,&resource);
+                if (rc == PEP_IO_OK && xacml_request_addresource(request,resource) != PEP_XACML_OK) {
+                    log_error("xacml_request_read: can't add XACML resource to XACML request.");
+                    xacml_resource_delete(resource);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+        }
+        /* action (null) */
+        else if (key_id == XACML_KEY_ACTION) {
+            token= hessian_reader_next(reader);
+            if (token != HESSIAN_NULL) {
+                xacml_action_t * action= NULL;
+                rc= xacml_action_read(reader,token,&action);
+                if (rc == PEP_IO_OK && xacml_request_setaction(request,action) != PEP_XACML_OK) {
+                    log_error("xacml_request_read: can't set XACML action to XACML request.");
+                    xacml_action_delete(action);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+        }
+        /* environment (null) */
+        else if (key_id == XACML_KEY_ENVIRONMENT) {
+            token= hessian_reader_next(reader);
+            if (token != HESSIAN_NULL) {
+                xacml_environment_t * environment= NULL;
+                rc= xacml_environment_read(reader,token,&environment);
+                if (rc == PEP_IO_OK && xacml_request_setenvironment(request,environment) != PEP_XACML_OK) {
+                    log_error("xacml_request_read: can't set XACML environment to XACML request.");
+                    xacml_environment_delete(environment);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+        }
+        else {
+            log_warn("xacml_request_read: unknown Hessian map<key>: %s at: %d.",key,i);
+            rc= xacml_read_skip(reader);
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_request_delete(request);
+        return rc;
+    }
+    *req= request;
+    return PEP_IO_OK;
+}
+
+static int xacml_attributeassignment_read(hessian_reader_t * reader, hessian_t token, xacml_attributeassignment_t ** attr) {
+    xacml_attributeassignment_t * attribute;
+    const char * key, * value;
+    xacml_name_t key_id;
+    int rc, i;
+    rc= xacml_read_map(reader,token,XACML_CLASS_ATTRIBUTEASSIGNMENT,XACML_HESSIAN_ATTRIBUTEASSIGNMENT_CLASSNAME);
+    if (rc != PEP_IO_OK) {
+        return rc;
+    }
+    attribute= xacml_attributeassignment_create(NULL);
+    if (attribute == NULL) {
+        log_error("xacml_attributeassignment_read: can't create XACML attribute assignment.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; (rc= xacml_read_key(reader,&key,&key_id)) == PEP_IO_OK && key != NULL; i++) {
+        /* id (mandatory) */
+        if (key_id == XACML_KEY_ATTRIBUTEID) {
+            rc= xacml_read_string(reader,FALSE,&value);
+            if (rc == PEP_IO_OK && xacml_attributeassignment_setid(attribute,value) != PEP_XACML_OK) {
+                log_error("xacml_attributeassignment_read: can't set id: %s to XACML attribute assignment.",value);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* datatype (optional) */
+        else if (key_id == XACML_KEY_DATATYPE) {
+            rc= xacml_read_string(reader,TRUE,&value);
+            if (rc == PEP_IO_OK && xacml_attributeassignment_setdatatype(attribute,value) != PEP_XACML_OK) {
+                log_error("xacml_attributeassignment_read: can't set datatype: %s to XACML attribute assignment.",value);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* value (optional) */
+        else if (key_id == XACML_KEY_VALUE) {
+            rc= xacml_read_string(reader,TRUE,&value);
+            if (rc == PEP_IO_OK && xacml_attributeassignment_setvalue(attribute,value) != PEP_XACML_OK) {
+                log_error("xacml_attributeassignment_read: can't set value: %s to XACML attribute assignment.",value);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* multiple values (back compatibility with PEPd <= 1.0) */
+        else if (key_id == XACML_KEY_VALUES) {
+            log_warn("xacml_attributeassignment_read: DEPRECATED Hessian map<'%s',...> received at: %d",key,i);
+            rc= xacml_read_list(reader);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_END) {
+                if (token != HESSIAN_STRING) {
+                    log_error("xacml_attributeassignment_read: Hessian list<value> is not a Hessian string: %d.",(int)token);
+                    rc= (token == HESSIAN_REF) ? PEP_IO_REF : PEP_IO_ERROR;
+                }
+                else if (xacml_attributeassignment_setvalue(attribute,hessian_reader_getstring(reader,NULL)) != PEP_XACML_OK) {
+                    log_error("xacml_attributeassignment_read: can't set value: %s to XACML attribute assignment.",hessian_reader_getstring(reader,NULL));
+                    rc= PEP_IO_ERROR;
+                }
+            }
+        }
+        else {
+            log_warn("xacml_attributeassignment_read: unknown Hessian map<key>: %s at: %d.",key,i);
+            rc= xacml_read_skip(reader);
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_attributeassignment_delete(attribute);
+        return rc;
+    }
+    *attr= attribute;
+    return PEP_IO_OK;
+}
+
+static int xacml_obligation_read(hessian_reader_t * reader, hessian_t token, xacml_obligation_t ** obl) {
+    xacml_obligation_t * obligation;
+    const char * key, * id;
+    xacml_name_t key_id;
+    int rc, i;
+    rc= xacml_read_map(reader,token,XACML_CLASS_OBLIGATION,XACML_HESSIAN_OBLIGATION_CLASSNAME);
+    if (rc != PEP_IO_OK) {
+        return rc;
+    }
+    obligation= xacml_obligation_create(NULL);
+    if (obligation == NULL) {
+        log_error("xacml_obligation_read: can't create XACML obligation.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; (rc= xacml_read_key(reader,&key,&key_id)) == PEP_IO_OK && key != NULL; i++) {
+        /* id (mandatory) */
+        if (key_id == XACML_KEY_ID) {
+            rc= xacml_read_string(reader,FALSE,&id);
+            if (rc == PEP_IO_OK && xacml_obligation_setid(obligation,id) != PEP_XACML_OK) {
+                log_error("xacml_obligation_read: can't set id: %s to XACML obligation.",id);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* fulfillon (enum) */
+        else if (key_id == XACML_KEY_FULFILLON) {
+            int32_t fulfillon;
+            rc= xacml_read_integer(reader,&fulfillon);
+            if (rc == PEP_IO_OK && xacml_obligation_setfulfillon(obligation,fulfillon) != PEP_XACML_OK) {
+                log_error("xacml_obligation_read: can't set fulfillon: %d to XACML obligation.",(int)fulfillon);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* attribute assignments list */
+        else if (key_id == XACML_KEY_ATTRIBUTEASSIGNMENTS) {
+            rc= xacml_read_list(reader);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_END) {
+                xacml_attributeassignment_t * attribute= NULL;
+                rc= xacml_attributeassignment_read(reader,token,&attribute);
+                if (rc == PEP_IO_OK && xacml_obligation_addattributeassignment(obligation,attribute) != PEP_XACML_OK) {
+                    log_error("xacml_obligation_read: can't add XACML attribute assignment to XACML obligation.");
+                    xacml_attributeassignment_delete(attribute);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+        }
+        else {
+            log_warn("xacml_obligation_read: unknown Hessian map<key>: %s at: %d.",key,i);
+            rc= xacml_read_skip(reader);
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_obligation_delete(obligation);
+        return rc;
+    }
+    *obl= obligation;
+    return PEP_IO_OK;
+}
+
+static int xacml_statuscode_read(hessian_reader_t * reader, hessian_t token, xacml_statuscode_t ** stc) {
+    xacml_statuscode_t * statuscode;
+    const char * key, * code;
+    xacml_name_t key_id;
+    int rc, i;
+    rc= xacml_read_map(reader,token,XACML_CLASS_STATUSCODE,XACML_HESSIAN_STATUSCODE_CLASSNAME);
+    if (rc != PEP_IO_OK) {
+        return rc;
+    }
+    statuscode= xacml_statuscode_create(NULL);
+    if (statuscode == NULL) {
+        log_error("xacml_statuscode_read: can't create XACML statuscode.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; (rc= xacml_read_key(reader,&key,&key_id)) == PEP_IO_OK && key != NULL; i++) {
+        /* code (mandatory) */
+        if (key_id == XACML_KEY_CODE) {
+            rc= xacml_read_string(reader,FALSE,&code);
+            if (rc == PEP_IO_OK && xacml_statuscode_setvalue(statuscode,code) != PEP_XACML_OK) {
+                log_error("xacml_statuscode_read: can't set value: %s to XACML statuscode.",code);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* subcode (can be null) */
+        else if (key_id == XACML_KEY_SUBCODE) {
+            token= hessian_reader_next(reader);
+            if (token != HESSIAN_NULL) {
+                xacml_statuscode_t * subcode= NULL;
+                rc= xacml_statuscode_read(reader,token,&subcode);
+                if (rc == PEP_IO_OK && xacml_statuscode_setsubcode(statuscode,subcode) != PEP_XACML_OK) {
+                    log_error("xacml_statuscode_read: can't set subcode XACML statuscode to XACML statuscode.");
+                    xacml_statuscode_delete(subcode);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+        }
+        else {
+            log_warn("xacml_statuscode_read: unknown Hessian map<key>: %s at: %d.",key,i);
+            rc= xacml_read_skip(reader);
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_statuscode_delete(statuscode);
+        return rc;
+    }
+    *stc= statuscode;
+    return PEP_IO_OK;
+}
+
+static int xacml_status_read(hessian_reader_t * reader, hessian_t token, xacml_status_t ** st) {
+    xacml_status_t * status;
+    const char * key, * message;
+    xacml_name_t key_id;
+    int rc, i;
+    rc= xacml_read_map(reader,token,XACML_CLASS_STATUS,XACML_HESSIAN_STATUS_CLASSNAME);
+    if (rc != PEP_IO_OK) {
+        return rc;
+    }
+    status= xacml_status_create(NULL);
+    if (status == NULL) {
+        log_error("xacml_status_read: can't create XACML status.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; (rc= xacml_read_key(reader,&key,&key_id)) == PEP_IO_OK && key != NULL; i++) {
+        /* message (can be null) */
+        if (key_id == XACML_KEY_MESSAGE) {
+            rc= xacml_read_string(reader,TRUE,&message);
+            if (rc == PEP_IO_OK && message != NULL && xacml_status_setmessage(status,message) != PEP_XACML_OK) {
+                log_error("xacml_status_read: can't set message: %s to XACML status.",message);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* status code (can be null) */
+        else if (key_id == XACML_KEY_STATUSCODE) {
+            token= hessian_reader_next(reader);
+            if (token != HESSIAN_NULL) {
+                xacml_statuscode_t * statuscode= NULL;
+                rc= xacml_statuscode_read(reader,token,&statuscode);
+                if (rc == PEP_IO_OK && xacml_status_setcode(status,statuscode) != PEP_XACML_OK) {
+                    log_error("xacml_status_read: can't set XACML statuscode to XACML status.");
+                    xacml_statuscode_delete(statuscode);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+            else {
+                log_warn("xacml_status_read: subcode XACML statuscode is NULL.");
+            }
+        }
+        else {
+            log_warn("xacml_status_read: unknown Hessian map<key>: %s at: %d.",key,i);
+            rc= xacml_read_skip(reader);
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_status_delete(status);
+        return rc;
+    }
+    *st= status;
+    return PEP_IO_OK;
+}
+
+static int xacml_result_read(hessian_reader_t * reader, hessian_t token, xacml_result_t ** res) {
+    xacml_result_t * result;
+    const char * key, * resourceid;
+    xacml_name_t key_id;
+    int rc, i;
+    rc= xacml_read_map(reader,token,XACML_CLASS_RESULT,XACML_HESSIAN_RESULT_CLASSNAME);
+    if (rc != PEP_IO_OK) {
+        return rc;
+    }
+    result= xacml_result_create();
+    if (result == NULL) {
+        log_error("xacml_result_read: can't create XACML result.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; (rc= xacml_read_key(reader,&key,&key_id)) == PEP_IO_OK && key != NULL; i++) {
+        /* decision (enum, mandatory) */
+        if (key_id == XACML_KEY_DECISION) {
+            int32_t decision;
+            rc= xacml_read_integer(reader,&decision);
+            if (rc == PEP_IO_OK && xacml_result_setdecision(result,decision) != PEP_XACML_OK) {
+                log_error("xacml_result_read: can't set decision: %d to XACML result.",(int)decision);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* resourceid (optional) */
+        else if (key_id == XACML_KEY_RESOURCEID) {
+            rc= xacml_read_string(reader,TRUE,&resourceid);
+            if (rc == PEP_IO_OK && xacml_result_setresourceid(result,resourceid) != PEP_XACML_OK) {
+                log_error("xacml_result_read: can't set resourceid: %s to XACML result.",resourceid);
+                rc= PEP_IO_ERROR;
+            }
+        }
+        /* status (null?) */
+        else if (key_id == XACML_KEY_STATUS) {
+            token= hessian_reader_next(reader);
+            if (token != HESSIAN_NULL) {
+                xacml_status_t * status= NULL;
+                rc= xacml_status_read(reader,token,&status);
+                if (rc == PEP_IO_OK && xacml_result_setstatus(result,status) != PEP_XACML_OK) {
+                    log_error("xacml_result_read: can't set XACML status to XACML result.");
+                    xacml_status_delete(status);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+            else {
+                log_warn("xacml_result_read: XACML status is NULL.");
+            }
+        }
+        /* obligations list */
+        else if (key_id == XACML_KEY_OBLIGATIONS) {
+            rc= xacml_read_list(reader);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_END) {
+                xacml_obligation_t * obligation= NULL;
+                rc= xacml_obligation_read(reader,token,&obligation);
+                if (rc == PEP_IO_OK && xacml_result_addobligation(result,obligation) != PEP_XACML_OK) {
+                    log_error("xacml_result_read: can't add XACML obligation to XACML result.");
+                    xacml_obligation_delete(obligation);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+        }
+        else {
+            log_warn("xacml_result_read: unknown map<key>: %s at: %d.",key,i);
+            rc= xacml_read_skip(reader);
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_result_delete(result);
+        return rc;
+    }
+    *res= result;
+    return PEP_IO_OK;
+}
+
+static int xacml_response_read(hessian_reader_t * reader, hessian_t token, xacml_response_t ** resp) {
+    xacml_response_t * response;
+    const char * key;
+    xacml_name_t key_id;
+    int rc, i;
+    rc= xacml_read_map(reader,token,XACML_CLASS_RESPONSE,XACML_HESSIAN_RESPONSE_CLASSNAME);
+    if (rc != PEP_IO_OK) {
+        return rc;
+    }
+    response= xacml_response_create();
+    if (response == NULL) {
+        log_error("xacml_response_read: can't create XACML response.");
+        return PEP_IO_ERROR;
+    }
+    for (i= 0; (rc= xacml_read_key(reader,&key,&key_id)) == PEP_IO_OK && key != NULL; i++) {
+        /* request (can be null???) */
+        if (key_id == XACML_KEY_REQUEST) {
+            token= hessian_reader_next(reader);
+            if (token != HESSIAN_NULL) {
+                xacml_request_t * request= NULL;
+                rc= xacml_request_read(reader,token,&request);
+                if (rc == PEP_IO_OK && xacml_response_setrequest(response,request) != PEP_XACML_OK) {
+                    log_error("xacml_response_read: can't set XACML request in XACML response.");
+                    xacml_request_delete(request);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+            else {
+                log_warn("xacml_response_read: XACML request is NULL.");
+            }
+        }
+        /* results list */
+        else if (key_id == XACML_KEY_RESULTS) {
+            rc= xacml_read_list(reader);
+            while (rc == PEP_IO_OK && (token= hessian_reader_next(reader)) != HESSIAN_END) {
+                xacml_result_t * result= NULL;
+                rc= xacml_result_read(reader,token,&result);
+                if (rc == PEP_IO_OK && xacml_response_addresult(response,result) != PEP_XACML_OK) {
+                    log_error("xacml_response_read: can't add XACML result to XACML response.");
+                    xacml_result_delete(result);
+                    rc= PEP_IO_ERROR;
+                }
+            }
+        }
+        else {
+            log_warn("xacml_response_read: unknown Hessian map<key>: %s at: %d.",key,i);
+            rc= xacml_read_skip(reader);
+        }
+        if (rc != PEP_IO_OK) break;
+    }
+    if (rc != PEP_IO_OK) {
+        xacml_response_delete(response);
+        return rc;
+    }
+    *resp= response;
+    return PEP_IO_OK;
+}
@@ -25,17 +25,23 @@ extern "C" {
 #include "error.h"
 #include "xacml.h"
 #include "buffer.h" /* ../util/buffer.h */
+#include "arena.h" /* ../util/arena.h */
 
 /**
  * Marshalls the PEP XACML request object and writes the serialized Hessian bytes
  * into the output buffer.
  *
+ * The Hessian encoding is written directly from the XACML objects, without
+ * temporary Hessian objects. With Hessian 2.0, the XACML objects are written
+ * as compact Hessian objects, each class definition only once.
+ *
  * @param const xacml_request_t * request the PEP XACML request to marshal.
+ * @param int version the Hessian encoding: HESSIAN_VERSION_1 or HESSIAN_VERSION_2.
  * @param BUFFER * output buffer.
  *
  * @return pep_error_t PEP_OK or an error code.
  */
-pep_error_t xacml_request_marshalling(const xacml_request_t * request, BUFFER * output);
+pep_error_t xacml_request_marshalling(const xacml_request_t * request, int version, BUFFER * output);
 
 /**
  * Reads the serialized Hessian bytes from the input buffer and unmarshalls the PEP
@@ -44,14 +50,22 @@ pep_error_t xacml_request_marshalling(const xacml_request_t * request, BUFFER *
  * On error, return code != PEP_OK, the PEP response object state is indeterminate.
  * (should be NULL)
  *
+ * The XACML response is read directly from the Hessian encoding, Hessian 1.0
+ * or 2.0 as detected on the first tag. Only if the input contains a Hessian
+ * ref, it is read again through the Hessian objects tree.
+ * The reader and the temporary Hessian objects are allocated from the arena,
+ * which is reset on return.
+ *
  * @param xacml_response_t ** response the unmarshalled PEP XACML response (output).
  * @param BUFFER * input the buffer to read from.
+ * @param arena_t * arena the arena for the Hessian reader and objects, or NULL
+ *        to use a temporary one.
  *
  * @return pep_error_t PEP_OK or an error code.
  *
  * Example:
  *   xacml_response_t * response= NULL;
- *   int rc= pep_response_unmarshalling(&response, input);
+ *   int rc= xacml_response_unmarshalling(&response, input, NULL);
  *   if (rc == PEP_OK) {
  *      process response...
  *   }
@@ -59,7 +73,7 @@ pep_error_t xacml_request_marshalling(const xacml_request_t * request, BUFFER *
  *      error handling...
  *   }
  */
-pep_error_t xacml_response_unmarshalling(xacml_response_t ** response, BUFFER * input);
+pep_error_t xacml_response_unmarshalling(xacml_response_t ** response, BUFFER * input, arena_t * arena);
 
 /**
  * The Java class namespaces and variable name constants for the PEP model
@@ -21,9 +21,10 @@
 #include "linkedlist.h" /* ../util/linkedlist.h */
 #include "log.h" /* ../util/log.h */
 #include "xacml.h"
+#include "intern.h"
 
 struct xacml_obligation {
-    char * id; /* mandatory */
+    const char * id; /* mandatory, interned if known */
     xacml_fulfillon_t fulfillon; /* optional */
     linkedlist_t * assignments; /* AttributeAssignments list */
 };
@@ -37,19 +38,17 @@ xacml_obligation_t * xacml_obligation_create(const char * id) {
     }
     obligation->id= NULL;
     if (id != NULL) {
-        size_t size= strlen(id);
-        obligation->id= calloc(size + 1,sizeof(char));
+        obligation->id= xacml_strintern(id);
         if (obligation->id == NULL) {
-            log_error("xacml_obligation_create: can't allocate id (%d bytes).",(int)size);
+            log_error("xacml_obligation_create: can't allocate id (%d bytes).",(int)strlen(id));
             free(obligation);
             return NULL;
         }
-        strncpy(obligation->id,id,size);
     }
     obligation->assignments= llist_create();
     if (obligation->assignments == NULL) {
         log_error("xacml_obligation_create: can't create assignments list.");
-        free(obligation->id);
+        xacml_strfree(obligation->id);
         free(obligation);
         return NULL;
     }
@@ -59,7 +58,6 @@ xacml_obligation_t * xacml_obligation_create(const char * id) {
 
 /* id can't be NULL */
 int xacml_obligation_setid(xacml_obligation_t * obligation, const char * id) {
-    size_t size;
     if (obligation == NULL) {
         log_error("xacml_obligation_setid: NULL obligation.");
         return PEP_XACML_ERROR;
@@ -68,16 +66,12 @@ int xacml_obligation_setid(xacml_obligation_t * obligation, const char * id) {
         log_error("xacml_obligation_setid: NULL id.");
         return PEP_XACML_ERROR;
     }
-    if (obligation->id != NULL) {
-        free(obligation->id);
-    }
-    size= strlen(id);
-    obligation->id= calloc(size + 1,sizeof(char));
+    xacml_strfree(obligation->id);
+    obligation->id= xacml_strintern(id);
     if (obligation->id == NULL) {
-        log_error("xacml_obligation_setid: can't allocate id (%d bytes).", (int)size);
+        log_error("xacml_obligation_setid: can't allocate id (%d bytes).", (int)strlen(id));
         return PEP_XACML_ERROR;
     }
-    strncpy(obligation->id,id,size);
     return PEP_XACML_OK;
 
 }
@@ -151,7 +145,7 @@ xacml_attributeassignment_t * xacml_obligation_getattributeassignment(const xacm
 
 void xacml_obligation_delete(xacml_obligation_t * obligation) {
     if (obligation == NULL) return;
-    if (obligation->id != NULL) free(obligation->id);
+    xacml_strfree(obligation->id);
     llist_delete_elements(obligation->assignments,(delete_element_func)xacml_attributeassignment_delete);
     llist_delete(obligation->assignments);
     free(obligation);
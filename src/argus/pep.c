@@ -20,16 +20,22 @@
 #include <stdarg.h>  /* va_list, va_arg, ... */
 #include <string.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include <curl/curl.h>
 
 /* from ../util */
 #include "linkedlist.h"
 #include "buffer.h"
+#include "arena.h"
 #include "base64.h"
 #include "log.h"
 
+/* from ../hessian */
+#include "hessian.h"
+
 #include "pep.h"
 #include "io.h"
+#include "cache.h"
 #include "error.h"
 
 #ifdef HAVE_CONFIG_H
@@ -54,6 +60,13 @@ static const int    DEFAULT_LOG_LEVEL= PEP_LOGLEVEL_NONE;
 static const FILE * DEFAULT_LOG_FILE= NULL;
 static const int    DEFAULT_PIPS_ENABLED= TRUE;
 static const int    DEFAULT_OHS_ENABLED= TRUE;
+static const int    DEFAULT_BASE64_LINE_BREAK= TRUE;
+static const int    DEFAULT_HESSIAN_VERSION= HESSIAN_VERSION_1;
+static const int    DEFAULT_CACHE_SIZE= 0; /* decision cache disabled */
+static const int    DEFAULT_CACHE_TTL= 60; /* seconds */
+/* completed asynchronous transfers kept for reuse, and largest batch context kept */
+static const size_t PEP_TRANSFERS_IDLE_MAX= 32;
+static const size_t PEP_BATCH_ITEMS_MAX= 1024;
 /* default SSL cipher without ECDH: OpenSSL 1.0 bug */
 static const char * DEFAULT_SSL_CIPHER_LIST= "DEFAULT:-ECDH";
 
@@ -74,6 +87,63 @@ static int set_curl_verbose(const PEP * pep);
 static int set_curl_stderr(const PEP * pep);
 static int set_curl_nosignal(const PEP * pep);
 static int set_curl_http_headers(PEP * pep);
+static int set_curl_share(const PEP * pep);
+
+/** internal authorization processing steps, shared by pep_authorize and pep_authorize_async */
+typedef struct pep_transfer pep_transfer_t;
+typedef struct pep_transport pep_transport_t;
+typedef struct pep_flight pep_flight_t;
+static pep_error_t pep_process_pips(PEP * pep, xacml_request_t ** request);
+static pep_error_t pep_prepare_transfer(PEP * pep, pep_transfer_t * transfer);
+static pep_error_t pep_setup_transfer(PEP * pep, CURL * curl, base64_encoder_t * b64output, base64_decoder_t * b64input);
+static pep_error_t pep_decode_transfer(PEP * pep, pep_transfer_t * transfer);
+static pep_error_t pep_complete_transfer(PEP * pep, pep_transfer_t * transfer);
+static time_t pep_cache_ttl(const PEP * pep, const xacml_response_t * response);
+static pep_error_t pep_process_ohs(PEP * pep, xacml_request_t ** request, xacml_response_t ** response);
+static pep_transfer_t * pep_transfer_create(PEP * pep, xacml_request_t ** request, xacml_response_t ** response, pep_authorize_callback * callback, void * callback_arg);
+static void pep_transfer_clear(pep_transfer_t * transfer);
+static void pep_transfer_recycle(PEP * pep, pep_transfer_t * transfer);
+static pep_error_t pep_transport_acquire(PEP * pep, pep_transfer_t * transfer);
+static void pep_transport_release(pep_transport_t * transport, pep_transfer_t * transfer);
+static void pep_transport_delete(pep_transport_t * transport);
+static void pep_transfer_delete(pep_transfer_t * transfer);
+static void pep_transfers_remove(PEP * pep, pep_transfer_t * transfer);
+static void pep_transfers_abort(PEP * pep, pep_authorize_callback * callback);
+static void pep_share_lock(CURL * curl, curl_lock_data data, curl_lock_access access, void * userptr);
+static void pep_share_unlock(CURL * curl, curl_lock_data data, void * userptr);
+static void pep_share_count_transfer(PEP * pep, CURL * curl);
+static uint64_t pep_flight_digest(const PEP * pep, const pep_transfer_t * transfer);
+static int pep_flight_matches(const pep_flight_t * flight, const PEP * pep, const pep_transfer_t * transfer);
+static pep_error_t pep_flight_join(PEP * pep, pep_transfer_t * transfer);
+static void pep_flight_land(PEP * pep, pep_transfer_t * transfer, pep_error_t rc);
+static void pep_batch_done(PEP * pep, xacml_request_t ** request, xacml_response_t ** response, pep_error_t rc, void * callback_arg);
+
+/**
+ * Transport buffers of an authorization: the PEP handle ones are reused by each
+ * pep_authorize call, and each asynchronous transfer keeps its own while idle.
+ * Between two calls, the buffers keep twice the running estimate of the recent
+ * request and response sizes.
+ */
+struct pep_transport {
+    BUFFER * output; /* serialized Hessian request */
+    BUFFER * input; /* serialized Hessian response */
+    base64_encoder_t * b64output;
+    base64_decoder_t * b64input;
+    char * key; /* request key */
+    size_t key_size; /* allocated key size */
+    arena_t * arena; /* Hessian objects of the request and response */
+    size_t output_estimate; /* running estimate of the request size */
+    size_t input_estimate; /* running estimate of the response size */
+};
+
+/**
+ * Batch authorization context: the pending counter shared by all the
+ * requests of the batch, and the error code of one request.
+ */
+typedef struct pep_batch_item {
+    size_t * pending;
+    pep_error_t rc;
+} pep_batch_item_t;
 
 /** 
 * ADT for PEP client handle.
@@ -84,6 +154,16 @@ static int set_curl_http_headers(PEP * pep);
 struct pep_handle {
     int id;
     CURL * curl;
+    CURLM * curlm; /* created on first pep_authorize_async */
+    pep_share_t * share; /* optional shared context, not owned */
+    linkedlist_t * transfers; /* in-flight asynchronous authorizations */
+    size_t transfers_cached; /* in-flight asynchronous authorizations answered by the cache */
+    linkedlist_t * transfers_idle; /* completed asynchronous transfers, reused with their curl handle and buffers */
+    unsigned long options_serial; /* incremented by pep_setoption, outdates the idle transfers curl handles */
+    pep_batch_item_t * batch_items; /* batch context reused by pep_authorize_batch, NULL while in use */
+    size_t batch_items_size;
+    pep_cache_t * cache; /* decision cache, NULL if disabled */
+    pep_transport_t transport; /* buffers reused by pep_authorize */
     struct curl_slist * curl_http_headers;
     linkedlist_t * pips;
     linkedlist_t * ohs;
@@ -100,6 +180,70 @@ struct pep_handle {
     char * option_ssl_cipher_list;
     int option_pips_enabled;
     int option_ohs_enabled;
+    int option_cache_size;
+    int option_cache_ttl_permit;
+    int option_cache_ttl_deny;
+    int option_cache_ttl_notapplicable;
+    int option_base64_line_break;
+    int option_hessian_version;
+};
+
+/**
+ * Request in flight in a shared context, sent by the first caller. The callers
+ * with an identical request, sent to the same PEPd with the same client identity
+ * and SSL options, wait for its serialized response, and the last one to leave
+ * releases it.
+ */
+struct pep_flight {
+    uint64_t digest; /* digest of the request and of the first caller transport options */
+    const PEP * pep; /* first caller handle, its transport options are compared */
+    const char * key; /* serialized Hessian request, owned by the first caller */
+    size_t key_l;
+    size_t waiters;
+    int landed;
+    pep_error_t rc;
+    char * response; /* serialized Hessian response */
+    size_t response_l;
+    pthread_cond_t cond;
+    struct pep_flight * next;
+};
+
+/**
+ * Authorization in flight. An asynchronous one has its own CURL easy handle,
+ * duplicated from the PEP handle one.
+ */
+struct pep_transfer {
+    CURL * curl;
+    unsigned long curl_serial; /* PEP handle options serial when the curl handle was duplicated */
+    pep_transport_t * transport; /* PEP handle buffers for a synchronous transfer, or own_transport */
+    pep_transport_t own_transport; /* buffers of an asynchronous transfer */
+    char * key; /* serialized Hessian request, decision cache and coalescing key, or NULL */
+    size_t key_l;
+    BUFFER * output; /* serialized Hessian request */
+    base64_encoder_t * b64output; /* base64 encodes output on demand for curl */
+    base64_decoder_t * b64input; /* base64 decodes the response into input while curl receives it */
+    BUFFER * input; /* serialized Hessian response */
+    int cached; /* response found in decision cache, no HTTP exchange */
+    int decoded; /* input holds the serialized Hessian response */
+    pep_flight_t * flight; /* request in flight in the shared context, if first caller */
+    xacml_request_t ** request;
+    xacml_response_t ** response;
+    pep_authorize_callback * callback;
+    void * callback_arg;
+};
+
+/**
+ * Shared context: the CURL share handle, one mutex per shared data type
+ * for the lock callbacks, the requests in flight and the statistics.
+ */
+struct pep_share {
+    CURLSH * curlsh;
+    pthread_mutex_t locks[CURL_LOCK_DATA_LAST];
+    pthread_mutex_t stats_lock;
+    unsigned long connections_reused;
+    pthread_mutex_t flights_lock;
+    pep_flight_t * flights; /* guarded by flights_lock */
+    unsigned long requests_coalesced; /* guarded by flights_lock */
 };
 
 const char * pep_version(void) {
@@ -110,6 +254,88 @@ const char * pep_version(void) {
     return VERSION_BUFFER;
 }
 
+pep_share_t * pep_share_initialize(void) {
+    int i;
+    CURLSHcode curlsh_rc;
+    pep_share_t * share= calloc(1,sizeof(struct pep_share));
+    if (share == NULL) {
+        log_error("pep_share_initialize: can't allocate struct pep_share: %d", (int)sizeof(struct pep_share));
+        return NULL;
+    }
+    share->curlsh= curl_share_init();
+    if (share->curlsh == NULL) {
+        log_error("pep_share_initialize: can't create CURL share handle.");
+        free(share);
+        return NULL;
+    }
+    for (i= 0; i<CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&(share->locks[i]),NULL);
+    }
+    pthread_mutex_init(&(share->stats_lock),NULL);
+    pthread_mutex_init(&(share->flights_lock),NULL);
+    curl_share_setopt(share->curlsh,CURLSHOPT_LOCKFUNC,pep_share_lock);
+    curl_share_setopt(share->curlsh,CURLSHOPT_UNLOCKFUNC,pep_share_unlock);
+    curl_share_setopt(share->curlsh,CURLSHOPT_USERDATA,share);
+    /* share DNS cache and SSL session IDs */
+    curlsh_rc= curl_share_setopt(share->curlsh,CURLSHOPT_SHARE,CURL_LOCK_DATA_DNS);
+    if (curlsh_rc != CURLSHE_OK) {
+        log_warn("pep_share_initialize: can't share DNS cache: %s.",curl_share_strerror(curlsh_rc));
+    }
+    curlsh_rc= curl_share_setopt(share->curlsh,CURLSHOPT_SHARE,CURL_LOCK_DATA_SSL_SESSION);
+    if (curlsh_rc != CURLSHE_OK) {
+        log_warn("pep_share_initialize: can't share SSL session IDs: %s.",curl_share_strerror(curlsh_rc));
+    }
+#if LIBCURL_VERSION_NUM >= 0x073900
+    /* share connection cache, libcurl >= 7.57.0 */
+    curlsh_rc= curl_share_setopt(share->curlsh,CURLSHOPT_SHARE,CURL_LOCK_DATA_CONNECT);
+    if (curlsh_rc != CURLSHE_OK) {
+        log_warn("pep_share_initialize: can't share connection cache: %s.",curl_share_strerror(curlsh_rc));
+    }
+#endif
+    return share;
+}
+
+unsigned long pep_share_getconnectionsreused(pep_share_t * share) {
+    unsigned long connections_reused;
+    if (share == NULL) {
+        log_error("pep_share_getconnectionsreused: NULL share handle");
+        return 0;
+    }
+    pthread_mutex_lock(&(share->stats_lock));
+    connections_reused= share->connections_reused;
+    pthread_mutex_unlock(&(share->stats_lock));
+    return connections_reused;
+}
+
+unsigned long pep_share_getrequestscoalesced(pep_share_t * share) {
+    unsigned long requests_coalesced;
+    if (share == NULL) {
+        log_error("pep_share_getrequestscoalesced: NULL share handle");
+        return 0;
+    }
+    pthread_mutex_lock(&(share->flights_lock));
+    requests_coalesced= share->requests_coalesced;
+    pthread_mutex_unlock(&(share->flights_lock));
+    return requests_coalesced;
+}
+
+void pep_share_destroy(pep_share_t * share) {
+    int i;
+    CURLSHcode curlsh_rc;
+    if (share == NULL) return;
+    curlsh_rc= curl_share_cleanup(share->curlsh);
+    if (curlsh_rc != CURLSHE_OK) {
+        log_error("pep_share_destroy: can't cleanup CURL share handle, still in use by a PEP handle?: %s.",curl_share_strerror(curlsh_rc));
+        return;
+    }
+    for (i= 0; i<CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&(share->locks[i]));
+    }
+    pthread_mutex_destroy(&(share->stats_lock));
+    pthread_mutex_destroy(&(share->flights_lock));
+    free(share);
+}
+
 /* create and init */
 PEP * pep_initialize(void) {
 
@@ -148,6 +374,18 @@ PEP * pep_initialize(void) {
         free(pep);
         return NULL;
     }
+    pep->transfers= llist_create();
+    pep->transfers_idle= llist_create();
+    if (pep->transfers == NULL || pep->transfers_idle == NULL) {
+        log_error("pep_initialize: transfers list allocation failed.");
+        curl_easy_cleanup(pep->curl);
+        llist_delete(pep->pips);
+        llist_delete(pep->ohs);
+        llist_delete(pep->transfers);
+        llist_delete(pep->transfers_idle);
+        free(pep);
+        return NULL;
+    }
     
     return pep;
 }
@@ -215,6 +453,8 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
         /* pep_errmsg("NULL PEP handle"); */
         return PEP_ERR_NULL_POINTER;
     }
+    /* the idle asynchronous transfers must duplicate the updated curl handle */
+    pep->options_serial++;
     va_start(args,option);
     switch (option) {
         case PEP_OPTION_ENDPOINT_URL:
@@ -424,6 +664,74 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
             }
             log_debug("pep_setoption: PEP#%d PEP_OPTION_ENABLE_OBLIGATIONHANDLERS: %s",pep->id,(pep->option_ohs_enabled == TRUE) ? "TRUE" : "FALSE");
             break;
+        case PEP_OPTION_CACHE_SIZE:
+            value= va_arg(args,int);
+            if (value < 0) {
+                log_error("pep_setoption: PEP#%d PEP_OPTION_CACHE_SIZE argument is negative: %d.",pep->id,value);
+                rc= PEP_ERR_OPTION_INVALID;
+                break;
+            }
+            pep->option_cache_size= value;
+            log_debug("pep_setoption: PEP#%d PEP_OPTION_CACHE_SIZE: %d",pep->id,pep->option_cache_size);
+            if (pep->option_cache_size == 0) {
+                /* disable the decision cache */
+                pep_cache_delete(pep->cache);
+                pep->cache= NULL;
+            }
+            else if (pep->cache == NULL) {
+                pep->cache= pep_cache_create((size_t)pep->option_cache_size);
+                if (pep->cache == NULL) {
+                    log_error("pep_setoption: PEP#%d can't create decision cache (%d entries).",pep->id,pep->option_cache_size);
+                    rc= PEP_ERR_MEMORY;
+                }
+            }
+            else {
+                pep_cache_setmaxentries(pep->cache,(size_t)pep->option_cache_size);
+            }
+            break;
+        case PEP_OPTION_CACHE_TTL_PERMIT:
+            value= va_arg(args,int);
+            pep->option_cache_ttl_permit= (value > 0) ? value : 0;
+            log_debug("pep_setoption: PEP#%d PEP_OPTION_CACHE_TTL_PERMIT: %d",pep->id,pep->option_cache_ttl_permit);
+            break;
+        case PEP_OPTION_CACHE_TTL_DENY:
+            value= va_arg(args,int);
+            pep->option_cache_ttl_deny= (value > 0) ? value : 0;
+            log_debug("pep_setoption: PEP#%d PEP_OPTION_CACHE_TTL_DENY: %d",pep->id,pep->option_cache_ttl_deny);
+            break;
+        case PEP_OPTION_CACHE_TTL_NOTAPPLICABLE:
+            value= va_arg(args,int);
+            pep->option_cache_ttl_notapplicable= (value > 0) ? value : 0;
+            log_debug("pep_setoption: PEP#%d PEP_OPTION_CACHE_TTL_NOTAPPLICABLE: %d",pep->id,pep->option_cache_ttl_notapplicable);
+            break;
+        case PEP_OPTION_ENDPOINT_BASE64_LINE_BREAK:
+            value= va_arg(args,int);
+            if (value == 1) {
+                pep->option_base64_line_break= TRUE;
+            }
+            else {
+                pep->option_base64_line_break= FALSE;
+            }
+            log_debug("pep_setoption: PEP#%d PEP_OPTION_ENDPOINT_BASE64_LINE_BREAK: %s",pep->id,(pep->option_base64_line_break == TRUE) ? "TRUE" : "FALSE");
+            break;
+        case PEP_OPTION_HESSIAN_VERSION:
+            value= va_arg(args,int);
+            if (value != HESSIAN_VERSION_1 && value != HESSIAN_VERSION_2) {
+                log_error("pep_setoption: PEP#%d PEP_OPTION_HESSIAN_VERSION argument is not 1 or 2: %d.",pep->id,value);
+                rc= PEP_ERR_OPTION_INVALID;
+                break;
+            }
+            pep->option_hessian_version= value;
+            log_debug("pep_setoption: PEP#%d PEP_OPTION_HESSIAN_VERSION: %d",pep->id,pep->option_hessian_version);
+            break;
+        case PEP_OPTION_SHARE:
+            pep->share= va_arg(args,pep_share_t *);
+            log_debug("pep_setoption: PEP#%d PEP_OPTION_SHARE: %p",pep->id,pep->share);
+            if (set_curl_share(pep) != 0) {
+                pep->share= NULL;
+                rc= PEP_ERR_CURL;
+            }
+            break;
         case PEP_OPTION_LOG_LEVEL:
             value= va_arg(args,int);
             if (PEP_LOGLEVEL_NONE <= value && value <= PEP_LOGLEVEL_DEBUG) {
@@ -457,14 +765,9 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... ) {
 
 
 pep_error_t pep_authorize(PEP * pep, xacml_request_t ** request, xacml_response_t ** response) {
-    int i= 0;
-    int pip_rc, oh_rc;
-    BUFFER * output, * b64output, * b64input, * input;
-    size_t output_l, b64output_l;
-    pep_error_t marshal_rc, unmarshal_rc;
+    pep_error_t rc;
+    pep_transfer_t transfer;
     CURLcode curl_rc;
-    long http_code= 0;
-    xacml_request_t * effective_request;
     if (pep == NULL) {
         log_error("pep_authorize: NULL pep handle");
         /* pep_errmsg("NULL PEP handle"); */
@@ -479,194 +782,332 @@ pep_error_t pep_authorize(PEP * pep, xacml_request_t ** request, xacml_response_
         /* pep_errmsg("NULL xacml_request_t pointer"); */
         return PEP_ERR_NULL_POINTER;
     }
-    
+
     /* apply pips if enabled and any */
-    if (pep->option_pips_enabled && llist_length(pep->pips) > 0) {
-        size_t pips_l= llist_length(pep->pips);
-        log_info("pep_authorize: PEP#%d %d PIPs available, processing...",pep->id, (int)pips_l);
-        for (i= 0; i<pips_l; i++) {
-            pep_pip_t * pip= llist_get(pep->pips,i);
-            if (pip != NULL) {
-                log_debug("pep_authorize: PEP#%d calling pip[%s]->process(request)...",pep->id,pip->id);
-                pip_rc= pip->process(request);
-                if (pip_rc != 0) {
-                    log_error("pep_authorize: PIP[%s] process(request) failed: %d", pip->id, pip_rc);
-                    /* pep_errmsg("PIP[%s] process(request) failed: %d", pip->id, pip_rc); */
-                    return PEP_ERR_PIP_PROCESS;
-                }
-            }
+    rc= pep_process_pips(pep,request);
+    if (rc != PEP_OK) {
+        return rc;
+    }
+
+    /* marshal the request, and lookup the decision cache or configure curl handler */
+    memset(&transfer,0,sizeof(pep_transfer_t));
+    transfer.curl= pep->curl;
+    transfer.transport= &(pep->transport);
+    transfer.request= request;
+    transfer.response= response;
+    rc= pep_prepare_transfer(pep,&transfer);
+    if (rc != PEP_OK) {
+        pep_transfer_clear(&transfer);
+        return rc;
+    }
+
+    /* wait for an identical request in flight in the shared context, if any */
+    if (!transfer.decoded && pep->share != NULL) {
+        rc= pep_flight_join(pep,&transfer);
+        if (rc != PEP_OK) {
+            pep_transfer_clear(&transfer);
+            return rc;
         }
     }
 
-    /* marshal the authorization request into output buffer */
-    output= buffer_create(512);
-    if (output == NULL) {
-        log_error("pep_authorize: PEP#%d can't create output buffer (512 bytes).",pep->id);
-        return PEP_ERR_MEMORY;
-    }
-    marshal_rc= xacml_request_marshalling(*request,output);
-    if ( marshal_rc != PEP_OK ) {
-        log_error("pep_authorize: PEP#%d can't marshal XACML request: %s.",pep->id,pep_strerror(marshal_rc));
-        buffer_delete(output);
-        return marshal_rc;
-    }
-
-    /* base64 encode the output buffer */
-    output_l= buffer_length(output);
-    b64output= buffer_create( output_l );
-    if (b64output == NULL) {
-        log_error("pep_authorize: PEP#%d can't create base64 output buffer (%d bytes).",pep->id,(int)output_l);
-        buffer_delete(output);
-        return PEP_ERR_MEMORY;
+    if (!transfer.decoded) {
+        /* send the request, check HTTP status and decode the response */
+        log_info("pep_authorize: PEP#%d sending XACML request to: %s",pep->id,pep->option_endpoint_url);
+        curl_rc= curl_easy_perform(pep->curl);
+        if (curl_rc != CURLE_OK) {
+            log_error("pep_authorize: PEP#%d sending XACML request failed: curl[%d] %s.",pep->id,(int)curl_rc,curl_easy_strerror(curl_rc));
+            rc= PEP_ERR_CURL_PERFORM;
+        }
+        else {
+            rc= pep_decode_transfer(pep,&transfer);
+        }
+        /* hand the response, or the error, to the identical requests waiting for it */
+        if (transfer.flight != NULL) {
+            pep_flight_land(pep,&transfer,rc);
+        }
+        if (rc != PEP_OK) {
+            pep_transfer_clear(&transfer);
+            return rc;
+        }
     }
-    base64_encode_l(output,b64output,BASE64_DEFAULT_LINE_SIZE);
 
-    /* output buffer not needed anymore. */
-    buffer_delete(output);
+    /* unmarshal the response, then apply OHs */
+    rc= pep_complete_transfer(pep,&transfer);
+    pep_transfer_clear(&transfer);
+    return rc;
+}
 
-    /* configure curl handler to POST the base64 encoded marshalled PEP request buffer */
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_POST, 1L);
-    if (curl_rc != CURLE_OK) {
-        log_error("pep_authorize: PEP#%d curl_easy_setopt(curl,CURLOPT_POST,1) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        buffer_delete(b64output);
-        return PEP_ERR_CURL;
+pep_error_t pep_authorize_async(PEP * pep, xacml_request_t ** request, xacml_response_t ** response, pep_authorize_callback * callback, void * callback_arg) {
+    pep_error_t rc;
+    pep_transfer_t * transfer;
+    CURLMcode curlm_rc;
+    if (pep == NULL) {
+        log_error("pep_authorize_async: NULL pep handle");
+        return PEP_ERR_NULL_POINTER;
     }
-    b64output_l= buffer_length(b64output);
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_POSTFIELDSIZE, (long)b64output_l);
-    if (curl_rc != CURLE_OK) {
-        log_error("pep_authorize: PEP#%d curl_easy_setopt(curl,CURLOPT_POSTFIELDSIZE,%d) failed: %s.",pep->id,(int)b64output_l,curl_easy_strerror(curl_rc));
-        buffer_delete(b64output);
-        return PEP_ERR_CURL;
+    if (pep->option_endpoint_url == NULL) {
+        log_error("pep_authorize_async: NULL mandatory option PEP_OPTION_ENDPOINT_URL");
+        return PEP_ERR_NULL_POINTER;
     }
-
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_READDATA, b64output);
-    if (curl_rc != CURLE_OK) {
-        log_error("pep_authorize: PEP#%d curl_easy_setopt(curl,CURLOPT_READDATA,b64output) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        buffer_delete(b64output);
-        return PEP_ERR_CURL;
+    if (request == NULL || *request == NULL) {
+        log_error("pep_authorize_async: PEP#%d NULL request pointer",pep->id);
+        return PEP_ERR_NULL_POINTER;
+    }
+    if (response == NULL) {
+        log_error("pep_authorize_async: PEP#%d NULL response pointer",pep->id);
+        return PEP_ERR_NULL_POINTER;
+    }
+    if (callback == NULL) {
+        log_error("pep_authorize_async: PEP#%d NULL callback function",pep->id);
+        return PEP_ERR_NULL_POINTER;
     }
 
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_READFUNCTION, buffer_read);
-    if (curl_rc != CURLE_OK) {
-        log_error("pep_authorize: PEP#%d curl_easy_setopt(curl,CURLOPT_READFUNCTION,buffer_read) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        buffer_delete(b64output);
-        return PEP_ERR_CURL;
+    /* create the multi handle on first use */
+    if (pep->curlm == NULL) {
+        pep->curlm= curl_multi_init();
+        if (pep->curlm == NULL) {
+            log_error("pep_authorize_async: PEP#%d can't create CURL multi handle.",pep->id);
+            return PEP_ERR_CURL;
+        }
     }
 
+    /* apply pips if enabled and any */
+    rc= pep_process_pips(pep,request);
+    if (rc != PEP_OK) {
+        return rc;
+    }
 
-    /* configure curl handler to read the base64 encoded HTTP response */
-    b64input= buffer_create(1024);
-    if (b64input == NULL) {
-        log_error("pep_authorize: PEP#%d can't create base64 input buffer.",pep->id);
-        buffer_delete(b64output);
+    transfer= pep_transfer_create(pep,request,response,callback,callback_arg);
+    if (transfer == NULL) {
+        log_error("pep_authorize_async: PEP#%d can't create transfer.",pep->id);
         return PEP_ERR_MEMORY;
     }
 
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_WRITEDATA, b64input);
-    if (curl_rc != CURLE_OK) {
-        log_error("pep_authorize: PEP#%d curl_easy_setopt(curl,CURLOPT_WRITEDATA,b64input) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        buffer_delete(b64output);
-        buffer_delete(b64input);
-        return PEP_ERR_CURL;
+    /* marshal the request, and lookup the decision cache or configure curl handler */
+    rc= pep_prepare_transfer(pep,transfer);
+    if (rc != PEP_OK) {
+        pep_transfer_recycle(pep,transfer);
+        return rc;
     }
-    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_WRITEFUNCTION, buffer_write);
-    if (curl_rc != CURLE_OK) {
-        log_error("pep_authorize: PEP#%d curl_easy_setopt(curl,CURLOPT_WRITEFUNCTION,buffer_write) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        buffer_delete(b64output);
-        buffer_delete(b64input);
+
+    /* queue the transfer, it is completed by the next pep_perform(pep) */
+    if (llist_add(pep->transfers,transfer) != LLIST_OK) {
+        log_error("pep_authorize_async: PEP#%d can't add transfer to in-flight list.",pep->id);
+        pep_transfer_recycle(pep,transfer);
+        return PEP_ERR_LLIST;
+    }
+    if (transfer->cached) {
+        pep->transfers_cached++;
+        log_info("pep_authorize_async: PEP#%d XACML response found in decision cache",pep->id);
+        return PEP_OK;
+    }
+    curl_easy_setopt(transfer->curl,CURLOPT_PRIVATE,transfer);
+    curlm_rc= curl_multi_add_handle(pep->curlm,transfer->curl);
+    if (curlm_rc != CURLM_OK) {
+        log_error("pep_authorize_async: PEP#%d curl_multi_add_handle(curlm,curl) failed: %s.",pep->id,curl_multi_strerror(curlm_rc));
+        pep_transfers_remove(pep,transfer);
+        pep_transfer_recycle(pep,transfer);
         return PEP_ERR_CURL;
     }
+    log_info("pep_authorize_async: PEP#%d XACML request queued for: %s",pep->id,pep->option_endpoint_url);
+    return PEP_OK;
+}
 
-    /* create the Hessian input buffer */
-    input= buffer_create(1024);
-    if (output == NULL) {
-        log_error("pep_authorize: PEP#%d can't create input buffer.",pep->id);
-        buffer_delete(b64output);
-        buffer_delete(b64input);
-        return PEP_ERR_MEMORY;
+pep_error_t pep_perform(PEP * pep, int * running) {
+    CURLMcode curlm_rc;
+    CURLMsg * msg;
+    char * private;
+    pep_transfer_t * transfer;
+    pep_error_t rc;
+    size_t i;
+    int still_running= 0, msgs_left= 0;
+    if (pep == NULL) {
+        log_error("pep_perform: NULL pep handle");
+        return PEP_ERR_NULL_POINTER;
     }
-
-    /* send the request */
-    log_info("pep_authorize: PEP#%d sending XACML request to: %s",pep->id,pep->option_endpoint_url);
-    curl_rc= curl_easy_perform(pep->curl);
-    if (curl_rc != CURLE_OK) {
-        log_error("pep_authorize: PEP#%d sending XACML request failed: curl[%d] %s.",pep->id,(int)curl_rc,curl_easy_strerror(curl_rc));
-        buffer_delete(b64output);
-        buffer_delete(b64input);
-        buffer_delete(input);
+    if (pep->curlm == NULL) {
+        /* no asynchronous authorization ever submitted */
+        if (running != NULL) *running= 0;
+        return PEP_OK;
+    }
+    /* complete the transfers answered by the decision cache */
+    i= 0;
+    while (pep->transfers_cached > 0 && i < llist_length(pep->transfers)) {
+        transfer= llist_get(pep->transfers,i);
+        if (!transfer->cached) {
+            i++;
+            continue;
+        }
+        llist_remove(pep->transfers,i);
+        pep->transfers_cached--;
+        rc= pep_complete_transfer(pep,transfer);
+        transfer->callback(pep,transfer->request,transfer->response,rc,transfer->callback_arg);
+        pep_transfer_recycle(pep,transfer);
+    }
+    curlm_rc= curl_multi_perform(pep->curlm,&still_running);
+    if (curlm_rc != CURLM_OK) {
+        log_error("pep_perform: PEP#%d curl_multi_perform(curlm) failed: %s.",pep->id,curl_multi_strerror(curlm_rc));
         return PEP_ERR_CURL_PERFORM;
     }
-
-    /* check for HTTP 200 response code */
-    http_code= 0;
-    curl_rc= curl_easy_getinfo(pep->curl,CURLINFO_RESPONSE_CODE,&http_code);
-    if (curl_rc != CURLE_OK) {
-        log_error("pep_authorize: PEP#%d curl_easy_getinfo(pep->curl,CURLINFO_RESPONSE_CODE,&http_code) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
-        buffer_delete(b64output);
-        buffer_delete(b64input);
-        buffer_delete(input);
-        return PEP_ERR_CURL;
+    /* complete the finished transfers */
+    while ((msg= curl_multi_info_read(pep->curlm,&msgs_left)) != NULL) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+        private= NULL;
+        curl_easy_getinfo(msg->easy_handle,CURLINFO_PRIVATE,&private);
+        transfer= (pep_transfer_t *)private;
+        curl_multi_remove_handle(pep->curlm,msg->easy_handle);
+        if (transfer == NULL) {
+            log_error("pep_perform: PEP#%d finished transfer without context.",pep->id);
+            continue;
+        }
+        pep_transfers_remove(pep,transfer);
+        if (msg->data.result != CURLE_OK) {
+            log_error("pep_perform: PEP#%d sending XACML request failed: curl[%d] %s.",pep->id,(int)msg->data.result,curl_easy_strerror(msg->data.result));
+            rc= PEP_ERR_CURL_PERFORM;
+        }
+        else {
+            rc= pep_complete_transfer(pep,transfer);
+        }
+        transfer->callback(pep,transfer->request,transfer->response,rc,transfer->callback_arg);
+        pep_transfer_recycle(pep,transfer);
     }
-    if (http_code != 200) {
-        log_error("pep_authorize: PEP#%d: HTTP status code: %d.",pep->id,(int)http_code);
-        buffer_delete(b64output);
-        buffer_delete(b64input);
-        buffer_delete(input);
-        return PEP_ERR_AUTHZ_REQUEST;
+    if (running != NULL) {
+        *running= (int)llist_length(pep->transfers);
     }
+    return PEP_OK;
+}
 
-    log_debug("pep_authorize: PEP#%d: HTTP status code: %d.",pep->id,(int)http_code);
-
-    /* base64 decode the input buffer into the Hessian buffer. */
-    base64_decode(b64input,input);
-
-    /* unmarshal the PEP response */
-    unmarshal_rc= xacml_response_unmarshalling(response,input);
-    if ( unmarshal_rc != PEP_OK) {
-        log_error("pep_authorize: PEP#%d can't unmarshal the XACML response: %s.", pep->id, pep_strerror(unmarshal_rc));
-        buffer_delete(b64output);
-        buffer_delete(b64input);
-        buffer_delete(input);
-        return unmarshal_rc;
+pep_error_t pep_wait(PEP * pep, int timeout_ms, int * running) {
+    CURLMcode curlm_rc;
+#if LIBCURL_VERSION_NUM < 0x071c00
+    fd_set fdread, fdwrite, fdexcep;
+    struct timeval timeout;
+    long curl_timeout= -1;
+    int maxfd= -1;
+#endif
+    if (pep == NULL) {
+        log_error("pep_wait: NULL pep handle");
+        return PEP_ERR_NULL_POINTER;
+    }
+    if (pep->curlm == NULL || llist_length(pep->transfers) == 0) {
+        if (running != NULL) *running= 0;
+        return PEP_OK;
+    }
+    if (pep->transfers_cached > 0) {
+        /* responses already available, don't wait */
+        return pep_perform(pep,running);
     }
+#if LIBCURL_VERSION_NUM >= 0x071c00
+    curlm_rc= curl_multi_wait(pep->curlm,NULL,0,timeout_ms,NULL);
+    if (curlm_rc != CURLM_OK) {
+        log_error("pep_wait: PEP#%d curl_multi_wait(curlm,%d) failed: %s.",pep->id,timeout_ms,curl_multi_strerror(curlm_rc));
+        return PEP_ERR_CURL_PERFORM;
+    }
+#else
+    /* libcurl < 7.28.0: no curl_multi_wait, use select(2) on the transfer sockets */
+    FD_ZERO(&fdread);
+    FD_ZERO(&fdwrite);
+    FD_ZERO(&fdexcep);
+    curlm_rc= curl_multi_fdset(pep->curlm,&fdread,&fdwrite,&fdexcep,&maxfd);
+    if (curlm_rc != CURLM_OK) {
+        log_error("pep_wait: PEP#%d curl_multi_fdset(curlm) failed: %s.",pep->id,curl_multi_strerror(curlm_rc));
+        return PEP_ERR_CURL_PERFORM;
+    }
+    curl_multi_timeout(pep->curlm,&curl_timeout);
+    if (curl_timeout < 0 || curl_timeout > timeout_ms) {
+        curl_timeout= timeout_ms;
+    }
+    if (maxfd == -1 && curl_timeout > 100) {
+        /* no socket to wait on yet (e.g. name resolving), retry soon */
+        curl_timeout= 100;
+    }
+    timeout.tv_sec= curl_timeout / 1000;
+    timeout.tv_usec= (curl_timeout % 1000) * 1000;
+    select(maxfd + 1,&fdread,&fdwrite,&fdexcep,&timeout);
+#endif
+    return pep_perform(pep,running);
+}
 
-    log_info("pep_authorize: PEP#%d XACML Response decoded and unmarshalled.",pep->id);
+pep_error_t pep_authorize_batch(PEP * pep, xacml_request_t ** requests, size_t n, xacml_response_t ** responses, pep_error_t * errors) {
+    pep_error_t rc= PEP_OK;
+    pep_batch_item_t * items;
+    size_t i, items_size, pending= 0;
+    if (pep == NULL) {
+        log_error("pep_authorize_batch: NULL pep handle");
+        return PEP_ERR_NULL_POINTER;
+    }
+    if (requests == NULL || responses == NULL) {
+        log_error("pep_authorize_batch: PEP#%d NULL requests or responses array",pep->id);
+        return PEP_ERR_NULL_POINTER;
+    }
+    if (n == 0) {
+        return PEP_OK;
+    }
+    /* reuse the previous batch context, unless too small or in use by a running batch */
+    if (pep->batch_items != NULL && pep->batch_items_size >= n) {
+        items= pep->batch_items;
+        items_size= pep->batch_items_size;
+        pep->batch_items= NULL;
+    }
+    else {
+        items= calloc(n,sizeof(pep_batch_item_t));
+        items_size= n;
+        if (items == NULL) {
+            log_error("pep_authorize_batch: PEP#%d can't allocate batch context (%d requests).",pep->id,(int)n);
+            return PEP_ERR_MEMORY;
+        }
+    }
 
-    /* not required anymore */
-    buffer_delete(b64output);
+    /* marshal and submit all the requests, before driving any of them */
+    log_info("pep_authorize_batch: PEP#%d submitting %d XACML requests...",pep->id,(int)n);
+    for (i= 0; i<n; i++) {
+        items[i].pending= &pending;
+        responses[i]= NULL;
+        items[i].rc= pep_authorize_async(pep,&requests[i],&responses[i],pep_batch_done,&items[i]);
+        if (items[i].rc == PEP_OK) {
+            pending++;
+        }
+    }
 
-    /* get effective response */
-    effective_request= xacml_response_getrequest(*response);
-    if (effective_request != NULL) {
-        log_debug("pep_authorize: PEP#%d effective request received",pep->id);
-        /* delete original */
-        xacml_request_delete(*request);
-        /* and replace by effective one */
-        *request= xacml_response_relinquishrequest(*response);
+    /* drive them concurrently until all are completed */
+    while (pending > 0) {
+        pep_error_t wait_rc= pep_wait(pep,1000,NULL);
+        if (wait_rc != PEP_OK) {
+            log_error("pep_authorize_batch: PEP#%d pep_wait failed: %s.",pep->id,pep_strerror(wait_rc));
+            pep_transfers_abort(pep,pep_batch_done);
+            break;
+        }
     }
 
-    /* apply obligation handlers if enabled and any */
-    if (pep->option_ohs_enabled && llist_length(pep->ohs) > 0) {
-        size_t ohs_l= llist_length(pep->ohs);
-        log_info("pep_authorize: PEP#%d %d OHs available, processing...",pep->id,(int)ohs_l);
-        for (i= 0; i<ohs_l; i++) {
-            pep_obligationhandler_t * oh= llist_get(pep->ohs,i);
-            if (oh != NULL) {
-                log_debug("pep_authorize: PEP#%d calling OH[%s]->process(request,response)...",pep->id,oh->id);
-                oh_rc = oh->process(request,response);
-                if (oh_rc != 0) {
-                    log_error("pep_authorize: PEP#%d OH[%s] process(request,response) failed: %d.",pep->id,oh->id,oh_rc);
-                    buffer_delete(b64input);
-                    buffer_delete(input);
-                    return PEP_ERR_OH_PROCESS;
-                }
-            }
+    /* per request error codes, the first one is returned */
+    for (i= 0; i<n; i++) {
+        if (errors != NULL) {
+            errors[i]= items[i].rc;
+        }
+        if (rc == PEP_OK && items[i].rc != PEP_OK) {
+            rc= items[i].rc;
         }
     }
-    
-    buffer_delete(b64input);
-    buffer_delete(input);
+    /* keep the largest batch context for the next batch */
+    if (items_size <= PEP_BATCH_ITEMS_MAX && (pep->batch_items == NULL || pep->batch_items_size < items_size)) {
+        free(pep->batch_items);
+        pep->batch_items= items;
+        pep->batch_items_size= items_size;
+    }
+    else {
+        free(items);
+    }
+    return rc;
+}
 
+pep_error_t pep_getcachestats(PEP * pep, unsigned long * hits, unsigned long * misses, unsigned long * evictions) {
+    if (pep == NULL) {
+        log_error("pep_getcachestats: NULL pep handle");
+        return PEP_ERR_NULL_POINTER;
+    }
+    pep_cache_getstats(pep->cache,hits,misses,evictions);
     return PEP_OK;
 }
 
@@ -677,6 +1118,25 @@ void pep_destroy(PEP * pep) {
     
     if (pep == NULL) return;
 
+    /* abort the in-flight asynchronous authorizations */
+    pep_transfers_abort(pep,NULL);
+    llist_delete(pep->transfers);
+    while (llist_length(pep->transfers_idle) > 0) {
+        pep_transfer_delete(llist_remove(pep->transfers_idle,0));
+    }
+    llist_delete(pep->transfers_idle);
+    if (pep->curlm != NULL) {
+        curl_multi_cleanup(pep->curlm);
+        pep->curlm= NULL;
+    }
+    free(pep->batch_items);
+    pep->batch_items= NULL;
+    if (pep->cache != NULL) {
+        pep_cache_delete(pep->cache);
+        pep->cache= NULL;
+    }
+    pep_transport_delete(&(pep->transport));
+
     /* release curl http headers */
     if (pep->curl_http_headers != NULL) {
         curl_slist_free_all(pep->curl_http_headers);
@@ -752,11 +1212,641 @@ void pep_destroy(PEP * pep) {
 /*** INTERNAL FUNCTIONS ***/
 /**************************/
 
+/** apply the PIPs to the request, if enabled and any */
+static pep_error_t pep_process_pips(PEP * pep, xacml_request_t ** request) {
+    int pip_rc;
+    size_t i, pips_l;
+    if (!pep->option_pips_enabled || llist_length(pep->pips) == 0) {
+        return PEP_OK;
+    }
+    pips_l= llist_length(pep->pips);
+    log_info("pep_process_pips: PEP#%d %d PIPs available, processing...",pep->id, (int)pips_l);
+    for (i= 0; i<pips_l; i++) {
+        pep_pip_t * pip= llist_get(pep->pips,i);
+        if (pip != NULL) {
+            log_debug("pep_process_pips: PEP#%d calling pip[%s]->process(request)...",pep->id,pip->id);
+            pip_rc= pip->process(request);
+            if (pip_rc != 0) {
+                log_error("pep_process_pips: PIP[%s] process(request) failed: %d", pip->id, pip_rc);
+                return PEP_ERR_PIP_PROCESS;
+            }
+        }
+    }
+    return PEP_OK;
+}
+
+/**
+ * marshal the request, then lookup the response in the decision cache, if enabled,
+ * or configure the transfer curl handle to send the base64 encoded request.
+ */
+static pep_error_t pep_prepare_transfer(PEP * pep, pep_transfer_t * transfer) {
+    BUFFER * output;
+    pep_error_t rc, marshal_rc;
+    int cache_rc;
+    /* the output and input buffers are segmented to append large attribute
+       values (cert chain) without moving the bytes already written */
+    rc= pep_transport_acquire(pep,transfer);
+    if (rc != PEP_OK) {
+        return rc;
+    }
+
+    /* marshal the authorization request into output buffer */
+    output= transfer->output;
+    marshal_rc= xacml_request_marshalling(*(transfer->request),pep->option_hessian_version,output);
+    if ( marshal_rc != PEP_OK ) {
+        log_error("pep_prepare_transfer: PEP#%d can't marshal XACML request: %s.",pep->id,pep_strerror(marshal_rc));
+        return marshal_rc;
+    }
+
+    /* the serialized request is the decision cache and the request coalescing key */
+    if (pep->cache != NULL || pep->share != NULL) {
+        pep_transport_t * transport= transfer->transport;
+        transfer->key_l= buffer_length(output);
+        if (transport->key_size < transfer->key_l) {
+            free(transport->key);
+            transport->key_size= 0;
+            transport->key= malloc(transfer->key_l);
+            if (transport->key == NULL) {
+                log_error("pep_prepare_transfer: PEP#%d can't allocate request key (%d bytes).",pep->id,(int)transfer->key_l);
+                return PEP_ERR_MEMORY;
+            }
+            transport->key_size= transfer->key_l;
+        }
+        transfer->key= transport->key;
+        buffer_read(transfer->key,1,transfer->key_l,output);
+        buffer_rewind(output);
+    }
+    if (pep->cache != NULL) {
+        cache_rc= pep_cache_get(pep->cache,transfer->key,transfer->key_l,transfer->input);
+        if (cache_rc == PEP_CACHE_OK) {
+            log_debug("pep_prepare_transfer: PEP#%d decision cache hit.",pep->id);
+            transfer->cached= TRUE;
+            transfer->decoded= TRUE;
+            return PEP_OK;
+        }
+        log_debug("pep_prepare_transfer: PEP#%d decision cache miss.",pep->id);
+    }
+
+    /* the output buffer is base64 encoded while curl sends it, and the response decoded while received */
+    base64_encoder_reset(transfer->b64output,output,pep->option_base64_line_break ? BASE64_DEFAULT_LINE_SIZE : BASE64_NO_LINE_BREAK);
+    base64_decoder_reset(transfer->b64input,transfer->input);
+
+    /* asynchronous transfer: duplicate the PEP curl handle, unless still up to date */
+    if (transfer->curl == NULL) {
+        transfer->curl= curl_easy_duphandle(pep->curl);
+        if (transfer->curl == NULL) {
+            log_error("pep_prepare_transfer: PEP#%d can't duplicate CURL handle.",pep->id);
+            return PEP_ERR_CURL;
+        }
+        transfer->curl_serial= pep->options_serial;
+    }
+    return pep_setup_transfer(pep,transfer->curl,transfer->b64output,transfer->b64input);
+}
+
+/** configure the curl handle to POST the b64output encoded bytes and to decode the HTTP response with b64input */
+static pep_error_t pep_setup_transfer(PEP * pep, CURL * curl, base64_encoder_t * b64output, base64_decoder_t * b64input) {
+    CURLcode curl_rc;
+    size_t b64output_l;
+    curl_rc= curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    if (curl_rc != CURLE_OK) {
+        log_error("pep_setup_transfer: PEP#%d curl_easy_setopt(curl,CURLOPT_POST,1) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL;
+    }
+    b64output_l= base64_encoder_length(b64output);
+    curl_rc= curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)b64output_l);
+    if (curl_rc != CURLE_OK) {
+        log_error("pep_setup_transfer: PEP#%d curl_easy_setopt(curl,CURLOPT_POSTFIELDSIZE,%d) failed: %s.",pep->id,(int)b64output_l,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL;
+    }
+    curl_rc= curl_easy_setopt(curl, CURLOPT_READDATA, b64output);
+    if (curl_rc != CURLE_OK) {
+        log_error("pep_setup_transfer: PEP#%d curl_easy_setopt(curl,CURLOPT_READDATA,b64output) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL;
+    }
+    curl_rc= curl_easy_setopt(curl, CURLOPT_READFUNCTION, base64_encoder_read);
+    if (curl_rc != CURLE_OK) {
+        log_error("pep_setup_transfer: PEP#%d curl_easy_setopt(curl,CURLOPT_READFUNCTION,base64_encoder_read) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL;
+    }
+    curl_rc= curl_easy_setopt(curl, CURLOPT_WRITEDATA, b64input);
+    if (curl_rc != CURLE_OK) {
+        log_error("pep_setup_transfer: PEP#%d curl_easy_setopt(curl,CURLOPT_WRITEDATA,b64input) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL;
+    }
+    curl_rc= curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, base64_decoder_write);
+    if (curl_rc != CURLE_OK) {
+        log_error("pep_setup_transfer: PEP#%d curl_easy_setopt(curl,CURLOPT_WRITEFUNCTION,base64_decoder_write) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL;
+    }
+    return PEP_OK;
+}
+
+/** check the HTTP status of the performed transfer and decode the last base64 block of the response */
+static pep_error_t pep_decode_transfer(PEP * pep, pep_transfer_t * transfer) {
+    CURLcode curl_rc;
+    long http_code= 0;
+
+    pep_share_count_transfer(pep,transfer->curl);
+
+    /* check for HTTP 200 response code */
+    curl_rc= curl_easy_getinfo(transfer->curl,CURLINFO_RESPONSE_CODE,&http_code);
+    if (curl_rc != CURLE_OK) {
+        log_error("pep_decode_transfer: PEP#%d curl_easy_getinfo(curl,CURLINFO_RESPONSE_CODE,&http_code) failed: %s.",pep->id,curl_easy_strerror(curl_rc));
+        return PEP_ERR_CURL;
+    }
+    if (http_code != 200) {
+        log_error("pep_decode_transfer: PEP#%d: HTTP status code: %d.",pep->id,(int)http_code);
+        return PEP_ERR_AUTHZ_REQUEST;
+    }
+    log_debug("pep_decode_transfer: PEP#%d: HTTP status code: %d.",pep->id,(int)http_code);
+
+    /* the response was base64 decoded into the Hessian buffer while received */
+    if (base64_decoder_finish(transfer->b64input) != BUFFER_OK) {
+        log_error("pep_decode_transfer: PEP#%d can't decode the base64 response.",pep->id);
+        return PEP_ERR_MEMORY;
+    }
+    transfer->decoded= TRUE;
+    return PEP_OK;
+}
+
+/**
+ * decode the response of the performed transfer, unless already done or found in
+ * the decision cache, then unmarshal the response, replace the request by the
+ * effective one and apply the OHs.
+ */
+static pep_error_t pep_complete_transfer(PEP * pep, pep_transfer_t * transfer) {
+    pep_error_t rc;
+    pep_error_t unmarshal_rc;
+    xacml_request_t * effective_request;
+    xacml_request_t ** request= transfer->request;
+    xacml_response_t ** response= transfer->response;
+
+    if (!transfer->decoded) {
+        rc= pep_decode_transfer(pep,transfer);
+        if (rc != PEP_OK) {
+            return rc;
+        }
+    }
+
+    /* unmarshal the PEP response */
+    unmarshal_rc= xacml_response_unmarshalling(response,transfer->input,transfer->transport->arena);
+    if ( unmarshal_rc != PEP_OK) {
+        log_error("pep_complete_transfer: PEP#%d can't unmarshal the XACML response: %s.", pep->id, pep_strerror(unmarshal_rc));
+        return unmarshal_rc;
+    }
+    log_info("pep_complete_transfer: PEP#%d XACML Response decoded and unmarshalled.",pep->id);
+
+    /* cache the serialized response, before the OHs process it */
+    if (!transfer->cached && transfer->key != NULL && pep->cache != NULL) {
+        pep_cache_put(pep->cache,transfer->key,transfer->key_l,transfer->input,pep_cache_ttl(pep,*response));
+    }
+
+    /* get effective response */
+    effective_request= xacml_response_getrequest(*response);
+    if (effective_request != NULL) {
+        log_debug("pep_complete_transfer: PEP#%d effective request received",pep->id);
+        /* delete original */
+        xacml_request_delete(*request);
+        /* and replace by effective one */
+        *request= xacml_response_relinquishrequest(*response);
+    }
+
+    /* apply obligation handlers if enabled and any */
+    return pep_process_ohs(pep,request,response);
+}
+
+/**
+ * decision cache time to live of the response: the smallest TTL of its results
+ * decisions, 0 (not cached) if any decision is Indeterminate.
+ */
+static time_t pep_cache_ttl(const PEP * pep, const xacml_response_t * response) {
+    size_t i, results_l= xacml_response_results_length(response);
+    time_t ttl, min_ttl= -1;
+    for (i= 0; i<results_l; i++) {
+        xacml_result_t * result= xacml_response_getresult(response,i);
+        switch (xacml_result_getdecision(result)) {
+            case XACML_DECISION_PERMIT:
+                ttl= pep->option_cache_ttl_permit;
+                break;
+            case XACML_DECISION_DENY:
+                ttl= pep->option_cache_ttl_deny;
+                break;
+            case XACML_DECISION_NOT_APPLICABLE:
+                ttl= pep->option_cache_ttl_notapplicable;
+                break;
+            default:
+                ttl= 0;
+                break;
+        }
+        if (min_ttl < 0 || ttl < min_ttl) {
+            min_ttl= ttl;
+        }
+    }
+    return (min_ttl > 0) ? min_ttl : 0;
+}
+
+/** apply the obligation handlers to the response, if enabled and any */
+static pep_error_t pep_process_ohs(PEP * pep, xacml_request_t ** request, xacml_response_t ** response) {
+    int oh_rc;
+    size_t i, ohs_l;
+    if (!pep->option_ohs_enabled || llist_length(pep->ohs) == 0) {
+        return PEP_OK;
+    }
+    ohs_l= llist_length(pep->ohs);
+    log_info("pep_process_ohs: PEP#%d %d OHs available, processing...",pep->id,(int)ohs_l);
+    for (i= 0; i<ohs_l; i++) {
+        pep_obligationhandler_t * oh= llist_get(pep->ohs,i);
+        if (oh != NULL) {
+            log_debug("pep_process_ohs: PEP#%d calling OH[%s]->process(request,response)...",pep->id,oh->id);
+            oh_rc = oh->process(request,response);
+            if (oh_rc != 0) {
+                log_error("pep_process_ohs: PEP#%d OH[%s] process(request,response) failed: %d.",pep->id,oh->id,oh_rc);
+                return PEP_ERR_OH_PROCESS;
+            }
+        }
+    }
+    return PEP_OK;
+}
+
+/**
+ * create an asynchronous transfer, or reuse an idle one. Its curl handle is
+ * duplicated by pep_prepare_transfer, if none or outdated by pep_setoption.
+ */
+static pep_transfer_t * pep_transfer_create(PEP * pep, xacml_request_t ** request, xacml_response_t ** response, pep_authorize_callback * callback, void * callback_arg) {
+    pep_transfer_t * transfer;
+    size_t idle_l= llist_length(pep->transfers_idle);
+    if (idle_l > 0) {
+        transfer= llist_remove(pep->transfers_idle,(int)idle_l - 1);
+        if (transfer->curl != NULL && transfer->curl_serial != pep->options_serial) {
+            curl_easy_cleanup(transfer->curl);
+            transfer->curl= NULL;
+        }
+    }
+    else {
+        transfer= calloc(1,sizeof(pep_transfer_t));
+        if (transfer == NULL) {
+            log_error("pep_transfer_create: PEP#%d can't allocate transfer (%d bytes).",pep->id,(int)sizeof(pep_transfer_t));
+            return NULL;
+        }
+    }
+    transfer->transport= &(transfer->own_transport);
+    transfer->key_l= 0;
+    transfer->cached= FALSE;
+    transfer->decoded= FALSE;
+    transfer->request= request;
+    transfer->response= response;
+    transfer->callback= callback;
+    transfer->callback_arg= callback_arg;
+    return transfer;
+}
+
+/** give back the transfer buffers and cache key to its transport, but not its curl handle */
+static void pep_transfer_clear(pep_transfer_t * transfer) {
+    if (transfer->transport != NULL) {
+        pep_transport_release(transfer->transport,transfer);
+    }
+}
+
+/**
+ * take back the completed asynchronous transfer: keep it idle, with its curl handle
+ * and buffers, for the next pep_authorize_async, or release it if enough are idle.
+ */
+static void pep_transfer_recycle(PEP * pep, pep_transfer_t * transfer) {
+    pep_transfer_clear(transfer);
+    transfer->request= NULL;
+    transfer->response= NULL;
+    transfer->callback= NULL;
+    transfer->callback_arg= NULL;
+    if (llist_length(pep->transfers_idle) >= PEP_TRANSFERS_IDLE_MAX || llist_add(pep->transfers_idle,transfer) != LLIST_OK) {
+        pep_transfer_delete(transfer);
+    }
+}
+
+/**
+ * lend the transport buffers, encoder and decoder to the transfer, creating them
+ * on first use. The encoder and decoder are reset by pep_prepare_transfer.
+ */
+static pep_error_t pep_transport_acquire(PEP * pep, pep_transfer_t * transfer) {
+    pep_transport_t * transport= transfer->transport;
+    if (transport->output == NULL) transport->output= buffer_create_segmented();
+    if (transport->input == NULL) transport->input= buffer_create_segmented();
+    if (transport->output == NULL || transport->input == NULL) {
+        log_error("pep_transport_acquire: PEP#%d can't create output or input buffer.",pep->id);
+        return PEP_ERR_MEMORY;
+    }
+    if (transport->b64output == NULL) transport->b64output= base64_encoder_create(transport->output,BASE64_DEFAULT_LINE_SIZE);
+    if (transport->b64input == NULL) transport->b64input= base64_decoder_create(transport->input);
+    if (transport->b64output == NULL || transport->b64input == NULL) {
+        log_error("pep_transport_acquire: PEP#%d can't create base64 output encoder or input decoder.",pep->id);
+        return PEP_ERR_MEMORY;
+    }
+    if (transport->arena == NULL) transport->arena= arena_create(0);
+    if (transport->arena == NULL) {
+        log_error("pep_transport_acquire: PEP#%d can't create Hessian objects arena.",pep->id);
+        return PEP_ERR_MEMORY;
+    }
+    transfer->output= transport->output;
+    transfer->input= transport->input;
+    transfer->b64output= transport->b64output;
+    transfer->b64input= transport->b64input;
+    return PEP_OK;
+}
+
+/** running estimate of the recent sizes */
+#define PEP_TRANSPORT_ESTIMATE(estimate,size) ((estimate) - (estimate) / 4 + (size) / 4)
+
+/**
+ * take back the transport buffers lent to the transfer: update the size estimates,
+ * reset the buffers and release the memory beyond twice the estimates.
+ */
+static void pep_transport_release(pep_transport_t * transport, pep_transfer_t * transfer) {
+    if (transfer->output != NULL) {
+        buffer_rewind(transfer->output);
+        transport->output_estimate= PEP_TRANSPORT_ESTIMATE(transport->output_estimate,buffer_length(transfer->output));
+        buffer_reset(transfer->output);
+        buffer_trim(transfer->output,2 * transport->output_estimate);
+    }
+    if (transfer->input != NULL) {
+        buffer_rewind(transfer->input);
+        transport->input_estimate= PEP_TRANSPORT_ESTIMATE(transport->input_estimate,buffer_length(transfer->input));
+        buffer_reset(transfer->input);
+        buffer_trim(transfer->input,2 * transport->input_estimate);
+    }
+    transfer->key= NULL;
+    transfer->output= transfer->input= NULL;
+    transfer->b64output= NULL;
+    transfer->b64input= NULL;
+}
+
+/** release the PEP handle transport buffers */
+static void pep_transport_delete(pep_transport_t * transport) {
+    if (transport->output != NULL) buffer_delete(transport->output);
+    if (transport->input != NULL) buffer_delete(transport->input);
+    if (transport->b64output != NULL) base64_encoder_delete(transport->b64output);
+    if (transport->b64input != NULL) base64_decoder_delete(transport->b64input);
+    if (transport->key != NULL) free(transport->key);
+    if (transport->arena != NULL) arena_delete(transport->arena);
+    memset(transport,0,sizeof(pep_transport_t));
+}
+
+/** release the asynchronous transfer, its curl handle and buffers */
+static void pep_transfer_delete(pep_transfer_t * transfer) {
+    if (transfer == NULL) return;
+    pep_transfer_clear(transfer);
+    pep_transport_delete(&(transfer->own_transport));
+    if (transfer->curl != NULL) curl_easy_cleanup(transfer->curl);
+    free(transfer);
+}
+
+/** remove the transfer from the PEP in-flight transfers list */
+static void pep_transfers_remove(PEP * pep, pep_transfer_t * transfer) {
+    size_t i, transfers_l= llist_length(pep->transfers);
+    for (i= 0; i<transfers_l; i++) {
+        if (llist_get(pep->transfers,i) == transfer) {
+            llist_remove(pep->transfers,i);
+            return;
+        }
+    }
+}
+
+/**
+ * abort the in-flight asynchronous authorizations with the given callback,
+ * or all of them if callback is NULL. The callbacks are called with PEP_ERR_ABORTED.
+ */
+static void pep_transfers_abort(PEP * pep, pep_authorize_callback * callback) {
+    size_t i= 0;
+    while (i < llist_length(pep->transfers)) {
+        pep_transfer_t * transfer= llist_get(pep->transfers,i);
+        if (callback != NULL && transfer->callback != callback) {
+            i++;
+            continue;
+        }
+        llist_remove(pep->transfers,i);
+        log_warn("pep_transfers_abort: PEP#%d aborting in-flight asynchronous authorization.",pep->id);
+        if (transfer->cached) {
+            pep->transfers_cached--;
+        }
+        else {
+            curl_multi_remove_handle(pep->curlm,transfer->curl);
+        }
+        transfer->callback(pep,transfer->request,transfer->response,PEP_ERR_ABORTED,transfer->callback_arg);
+        pep_transfer_recycle(pep,transfer);
+    }
+}
+
+/** CURL share lock callback: one mutex per shared data type */
+static void pep_share_lock(CURL * curl, curl_lock_data data, curl_lock_access access, void * userptr) {
+    pep_share_t * share= userptr;
+    if (data < 0 || data >= CURL_LOCK_DATA_LAST) return;
+    pthread_mutex_lock(&(share->locks[data]));
+}
+
+/** CURL share unlock callback */
+static void pep_share_unlock(CURL * curl, curl_lock_data data, void * userptr) {
+    pep_share_t * share= userptr;
+    if (data < 0 || data >= CURL_LOCK_DATA_LAST) return;
+    pthread_mutex_unlock(&(share->locks[data]));
+}
+
+/** count the transfer in the shared context statistics, if any */
+static void pep_share_count_transfer(PEP * pep, CURL * curl) {
+    long num_connects= -1;
+    if (pep->share == NULL) return;
+    if (curl_easy_getinfo(curl,CURLINFO_NUM_CONNECTS,&num_connects) == CURLE_OK && num_connects == 0) {
+        /* an already established connection was reused */
+        pthread_mutex_lock(&(pep->share->stats_lock));
+        pep->share->connections_reused++;
+        pthread_mutex_unlock(&(pep->share->stats_lock));
+    }
+}
+
+/** compares two optional string options */
+static int pep_option_equals(const char * option, const char * other) {
+    if (option == NULL || other == NULL) {
+        return option == other;
+    }
+    return strcmp(option,other) == 0;
+}
+
+/** mixes an optional string option into the digest */
+static uint64_t pep_option_digest(uint64_t digest, const char * option) {
+    if (option != NULL) {
+        digest^= pep_cache_digest(option,strlen(option));
+    }
+    return digest * 0x100000001b3ULL;
+}
+
+/**
+ * digest of the transfer request and of the PEP handle options selecting the PEPd
+ * and the client identity: two handles sharing the context can target different
+ * PEPds, or authenticate differently, and must not get each other's decisions.
+ */
+static uint64_t pep_flight_digest(const PEP * pep, const pep_transfer_t * transfer) {
+    uint64_t digest= pep_cache_digest(transfer->key,transfer->key_l);
+    digest= pep_option_digest(digest,pep->option_endpoint_url);
+    digest= pep_option_digest(digest,pep->option_client_cert);
+    digest= pep_option_digest(digest,pep->option_client_key);
+    digest= pep_option_digest(digest,pep->option_client_keypassword);
+    digest= pep_option_digest(digest,pep->option_server_cert);
+    digest= pep_option_digest(digest,pep->option_server_capath);
+    digest= pep_option_digest(digest,pep->option_ssl_cipher_list);
+    return (digest ^ (uint64_t)pep->option_ssl_validation) * 0x100000001b3ULL;
+}
+
+/**
+ * true if the request in flight is the transfer request, sent to the same PEPd with
+ * the same client identity and SSL options. Called with the flights lock held, the
+ * first caller handle is valid while its request is in flight.
+ */
+static int pep_flight_matches(const pep_flight_t * flight, const PEP * pep, const pep_transfer_t * transfer) {
+    const PEP * first= flight->pep;
+    if (flight->key_l != transfer->key_l || memcmp(flight->key,transfer->key,transfer->key_l) != 0) {
+        return FALSE;
+    }
+    return pep_option_equals(first->option_endpoint_url,pep->option_endpoint_url)
+        && pep_option_equals(first->option_client_cert,pep->option_client_cert)
+        && pep_option_equals(first->option_client_key,pep->option_client_key)
+        && pep_option_equals(first->option_client_keypassword,pep->option_client_keypassword)
+        && pep_option_equals(first->option_server_cert,pep->option_server_cert)
+        && pep_option_equals(first->option_server_capath,pep->option_server_capath)
+        && pep_option_equals(first->option_ssl_cipher_list,pep->option_ssl_cipher_list)
+        && first->option_ssl_validation == pep->option_ssl_validation;
+}
+
+/**
+ * join the identical request in flight in the shared context and wait for its
+ * response, or register the transfer request as in flight if there is none.
+ */
+static pep_error_t pep_flight_join(PEP * pep, pep_transfer_t * transfer) {
+    pep_share_t * share= pep->share;
+    pep_flight_t * flight;
+    pep_error_t rc;
+    uint64_t digest= pep_flight_digest(pep,transfer);
+    int last;
+
+    pthread_mutex_lock(&(share->flights_lock));
+    for (flight= share->flights; flight != NULL; flight= flight->next) {
+        if (flight->digest == digest && pep_flight_matches(flight,pep,transfer)) {
+            break;
+        }
+    }
+    if (flight == NULL) {
+        /* first caller: send the request */
+        flight= calloc(1,sizeof(pep_flight_t));
+        if (flight == NULL) {
+            pthread_mutex_unlock(&(share->flights_lock));
+            log_warn("pep_flight_join: PEP#%d can't allocate in-flight request, not coalesced.",pep->id);
+            return PEP_OK;
+        }
+        flight->digest= digest;
+        flight->pep= pep;
+        flight->key= transfer->key;
+        flight->key_l= transfer->key_l;
+        pthread_cond_init(&(flight->cond),NULL);
+        flight->next= share->flights;
+        share->flights= flight;
+        transfer->flight= flight;
+        pthread_mutex_unlock(&(share->flights_lock));
+        return PEP_OK;
+    }
+
+    /* identical request in flight: wait for its response */
+    log_debug("pep_flight_join: PEP#%d identical request in flight, waiting for its response.",pep->id);
+    flight->waiters++;
+    share->requests_coalesced++;
+    while (!flight->landed) {
+        pthread_cond_wait(&(flight->cond),&(share->flights_lock));
+    }
+    pthread_mutex_unlock(&(share->flights_lock));
+
+    /* the landed response is not modified anymore */
+    rc= flight->rc;
+    if (rc == PEP_OK) {
+        if (buffer_write(flight->response,1,flight->response_l,transfer->input) != flight->response_l) {
+            log_error("pep_flight_join: PEP#%d can't write %d bytes coalesced response.",pep->id,(int)flight->response_l);
+            rc= PEP_ERR_MEMORY;
+        }
+        else {
+            transfer->decoded= TRUE;
+        }
+    }
+    else {
+        log_error("pep_flight_join: PEP#%d identical request in flight failed: %s.",pep->id,pep_strerror(rc));
+    }
+
+    pthread_mutex_lock(&(share->flights_lock));
+    last= (--flight->waiters == 0);
+    pthread_mutex_unlock(&(share->flights_lock));
+    if (last) {
+        pthread_cond_destroy(&(flight->cond));
+        free(flight->response);
+        free(flight);
+    }
+    return rc;
+}
+
+/**
+ * remove the transfer request from the requests in flight, and hand its decoded
+ * response or the error to the waiting identical requests.
+ */
+static void pep_flight_land(PEP * pep, pep_transfer_t * transfer, pep_error_t rc) {
+    pep_share_t * share= pep->share;
+    pep_flight_t * flight= transfer->flight;
+    pep_flight_t ** link;
+    int last;
+
+    transfer->flight= NULL;
+    if (rc == PEP_OK) {
+        buffer_rewind(transfer->input);
+        flight->response_l= buffer_length(transfer->input);
+        flight->response= malloc(flight->response_l);
+        if (flight->response == NULL) {
+            log_error("pep_flight_land: PEP#%d can't allocate coalesced response (%d bytes).",pep->id,(int)flight->response_l);
+            rc= PEP_ERR_MEMORY;
+        }
+        else {
+            buffer_read(flight->response,1,flight->response_l,transfer->input);
+            buffer_rewind(transfer->input);
+        }
+    }
+
+    pthread_mutex_lock(&(share->flights_lock));
+    link= &(share->flights);
+    while (*link != flight) {
+        link= &((*link)->next);
+    }
+    *link= flight->next;
+    flight->pep= NULL;
+    flight->key= NULL;
+    flight->rc= rc;
+    flight->landed= TRUE;
+    last= (flight->waiters == 0);
+    if (!last) {
+        log_debug("pep_flight_land: PEP#%d response handed to %d identical requests.",pep->id,(int)flight->waiters);
+        pthread_cond_broadcast(&(flight->cond));
+    }
+    pthread_mutex_unlock(&(share->flights_lock));
+    if (last) {
+        pthread_cond_destroy(&(flight->cond));
+        free(flight->response);
+        free(flight);
+    }
+}
+
+/** completion callback of the batch authorization requests */
+static void pep_batch_done(PEP * pep, xacml_request_t ** request, xacml_response_t ** response, pep_error_t rc, void * callback_arg) {
+    pep_batch_item_t * item= callback_arg;
+    item->rc= rc;
+    (*item->pending)--;
+}
+
 /** set the pep handle default values */
 static void init_pep_defaults(PEP * pep) {
     if (pep==NULL) return;
     /* increase client counter */
     pep->id= n_pep_clients++;
+    pep->curlm= NULL;
+    pep->share= NULL;
     pep->curl_http_headers= NULL;
     /* set default options */
     pep->option_endpoint_url= NULL;
@@ -772,6 +1862,13 @@ static void init_pep_defaults(PEP * pep) {
     pep->option_ssl_cipher_list= NULL;
     pep->option_pips_enabled= DEFAULT_PIPS_ENABLED;
     pep->option_ohs_enabled= DEFAULT_OHS_ENABLED;
+    pep->cache= NULL;
+    pep->option_cache_size= DEFAULT_CACHE_SIZE;
+    pep->option_cache_ttl_permit= DEFAULT_CACHE_TTL;
+    pep->option_cache_ttl_deny= DEFAULT_CACHE_TTL;
+    pep->option_cache_ttl_notapplicable= DEFAULT_CACHE_TTL;
+    pep->option_base64_line_break= DEFAULT_BASE64_LINE_BREAK;
+    pep->option_hessian_version= DEFAULT_HESSIAN_VERSION;
 }
 
 /** set some curl default value */
@@ -828,6 +1925,19 @@ static int set_curl_nosignal(const PEP * pep) {
     return 0;
 }
 
+/** set libcurl CURLOPT_SHARE, or unset it if option share is NULL */
+static int set_curl_share(const PEP * pep) {
+    CURLcode curl_rc;
+    CURLSH * curlsh= (pep->share != NULL) ? pep->share->curlsh : NULL;
+    log_debug("set_curl_share: PEP#%d share: %p",pep->id,pep->share);
+    curl_rc= curl_easy_setopt(pep->curl, CURLOPT_SHARE, curlsh);
+    if (curl_rc != CURLE_OK) {
+        log_error("set_curl_share: PEP#%d curl_easy_setopt(curl,CURLOPT_SHARE,%p) failed: %s.",pep->id,curlsh,curl_easy_strerror(curl_rc));
+        return 1;
+    }
+    return 0;
+}
+
 /** set libcurl CURLOPT_URL */
 static int set_curl_endpoint_url(const PEP * pep) {
     CURLcode curl_rc;
@@ -137,6 +137,23 @@ typedef int pep_log_handler_callback(int level, const char * format, va_list arg
  */
 typedef struct pep_handle PEP;
 
+/**
+ * PEP client shared context @b handle.
+ *
+ * A shared context is shared by many PEP client @b handles, possibly used by different threads.
+ * They share the DNS cache, the SSL session IDs and the connections to the PEPd, thus avoiding
+ * a new TCP connection per PEP client @b handle, and resuming the SSL sessions of the new ones.
+ *
+ * Identical requests sent concurrently with pep_authorize(pep,request,response) by PEP client
+ * @b handles sharing the context are coalesced: only the first one is sent to the PEPd, and
+ * the others wait for its response. Requests are only coalesced between @b handles with the
+ * same endpoint URL, client certificate, key and password, and server certificate and SSL options.
+ *
+ * @see pep_share_initialize()
+ * @see pep_setoption(pep,PEP_OPTION_SHARE,share)
+ */
+typedef struct pep_share pep_share_t;
+
 /**
  * PEP client configuration options.
  *
@@ -156,7 +173,14 @@ typedef enum pep_option {
     PEP_OPTION_ENDPOINT_TIMEOUT, /**< Timeout for the connection to endpoint URL in second (default 30s) */
     PEP_OPTION_ENABLE_PIPS, /**< Enable PIPs pre-processing: 0 or 1 (default 1) */
     PEP_OPTION_ENABLE_OBLIGATIONHANDLERS, /**< Enable OHs post-processing: 0 or 1 (default 1) */
-    PEP_OPTION_ENDPOINT_SSL_CIPHER_LIST /**< PEP client list of ciphers to use for the SSL connection: string */
+    PEP_OPTION_ENDPOINT_SSL_CIPHER_LIST, /**< PEP client list of ciphers to use for the SSL connection: string */
+    PEP_OPTION_SHARE, /**< Set the {@link #pep_share_t} shared context, or @c NULL to not share (default @c NULL) */
+    PEP_OPTION_CACHE_SIZE, /**< Enable the decision cache with the maximum number of cached responses, 0 to disable: int (default 0) */
+    PEP_OPTION_CACHE_TTL_PERMIT, /**< Time to live in second of a cached @b Permit decision: int (default 60s) */
+    PEP_OPTION_CACHE_TTL_DENY, /**< Time to live in second of a cached @b Deny decision: int (default 60s) */
+    PEP_OPTION_CACHE_TTL_NOTAPPLICABLE, /**< Time to live in second of a cached @b NotApplicable decision: int (default 60s) */
+    PEP_OPTION_ENDPOINT_BASE64_LINE_BREAK, /**< Break the base64 encoded request in lines of 64 chars: 0 or 1 (default 1), 0 if the PEP daemon accepts unbroken base64 */
+    PEP_OPTION_HESSIAN_VERSION /**< Hessian encoding of the request: 1 or 2 (default 1), 2 only if the PEP daemon supports Hessian 2.0. The response encoding is detected. */
 } pep_option_t;
 
 /**
@@ -174,6 +198,61 @@ const char * pep_version(void);
  */
 PEP * pep_initialize(void);
 
+/**
+ * Creates a new PEP client shared context @b handle. The shared context must be set on the
+ * PEP client @b handles with pep_setoption(pep,PEP_OPTION_SHARE,share), and it is thread safe.
+ *
+ * Example:
+ * @code
+ * // once per process
+ * pep_share_t * share= pep_share_initialize();
+ * ...
+ * // in each thread
+ * PEP * pep= pep_initialize();
+ * pep_setoption(pep,PEP_OPTION_SHARE,share);
+ * ...
+ * pep_destroy(pep);
+ * ...
+ * // when all PEP client handles are destroyed
+ * pep_share_destroy(share);
+ * @endcode
+ *
+ * @return the PEP client shared context @b handle or null on error.
+ */
+pep_share_t * pep_share_initialize(void);
+
+/**
+ * Returns the number of authorizations which reused an already established connection
+ * of the shared context, instead of opening a new one.
+ *
+ * New connections resuming a shared SSL session are not counted.
+ *
+ * @param share pointer to the shared context @b handle.
+ *
+ * @return the number of connections reused.
+ */
+unsigned long pep_share_getconnectionsreused(pep_share_t * share);
+
+/**
+ * Returns the number of authorizations which were not sent to the PEPd, because an identical
+ * request was already in flight in the shared context, and which received its response.
+ *
+ * @param share pointer to the shared context @b handle.
+ *
+ * @return the number of coalesced authorizations.
+ */
+unsigned long pep_share_getrequestscoalesced(pep_share_t * share);
+
+/**
+ * Cleanups and destroys the PEP client shared context. All the PEP client @b handles using it
+ * must have been destroyed, or set to another shared context, before.
+ *
+ * @param share pointer to the shared context @b handle.
+ *
+ * @return none
+ */
+void pep_share_destroy(pep_share_t * share);
+
 /**
  * Adds a PIP request pre-processor to the PEP client. The PIP init() function
  * is called in this method.
@@ -255,6 +334,27 @@ pep_error_t pep_addobligationhandler(PEP * pep, const pep_obligationhandler_t *
  *   // already enabled by default, only for example purpose
  *   pep_setoption(pep,PEP_OPTION_ENABLE_OBLIGATIONHANDLERS, (int)1);
  * @endcode
+ * Option {@link #PEP_OPTION_CACHE_SIZE} @c int argument:
+ * @code
+ *   // cache at most 1000 responses, Permit decisions during 5 minutes
+ *   pep_setoption(pep,PEP_OPTION_CACHE_SIZE, (int)1000);
+ *   pep_setoption(pep,PEP_OPTION_CACHE_TTL_PERMIT, (int)300);
+ * @endcode
+ * Option {@link #PEP_OPTION_ENDPOINT_BASE64_LINE_BREAK} @c int (@a FALSE or @a TRUE) argument:
+ * @code
+ *   // send the request base64 encoded without line break (3% smaller)
+ *   pep_setoption(pep,PEP_OPTION_ENDPOINT_BASE64_LINE_BREAK, (int)0);
+ * @endcode
+ * Option {@link #PEP_OPTION_HESSIAN_VERSION} @c int argument:
+ * @code
+ *   // send the request with the compact Hessian 2.0 encoding
+ *   pep_setoption(pep,PEP_OPTION_HESSIAN_VERSION, (int)2);
+ * @endcode
+ * Option {@link #PEP_OPTION_SHARE} {@link #pep_share_t} @c * argument:
+ * @code
+ *   // share connections, SSL sessions and DNS cache with other PEP client handles
+ *   pep_setoption(pep,PEP_OPTION_SHARE, (pep_share_t *)share);
+ * @endcode
  *
  */
 pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... );
@@ -264,8 +364,14 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... );
  *
  * If some PIPs are present, they will be applied to the XACML request before submitting
  * it to the PEPd.
+ * If the decision cache is enabled (see {@link #PEP_OPTION_CACHE_SIZE}), and a response
+ * for the same processed request is cached and not expired, this response is used instead of
+ * submitting the request. The response is cached, unless a decision is @b Indeterminate.
+ * If a shared context is set (see {@link #PEP_OPTION_SHARE}), and an identical processed request
+ * is already in flight on another PEP client @b handle sharing it, this function waits for and
+ * uses its response instead of submitting the request. Each caller receives its own response.
  * If some ObligationHandlers are present, they will be applied to the XACML response after
- * the response is received from the PEPd.
+ * the response is received from the PEPd, or from the decision cache.
  *
  * After the call, the @c request parameter is the @b effective XACML request, as processed by the PEPd.
  *
@@ -277,8 +383,128 @@ pep_error_t pep_setoption(PEP * pep, pep_option_t option, ... );
  */
 pep_error_t pep_authorize(PEP * pep, xacml_request_t ** request, xacml_response_t ** response);
 
+/**
+ * Completion callback function prototype for asynchronous authorization.
+ *
+ * Called by pep_perform(pep,running) or pep_wait(pep,timeout_ms,running) when the authorization
+ * submitted with pep_authorize_async(pep,request,response,callback,callback_arg) is completed.
+ * The OHs, if any, have already been applied to the response.
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param request address of the pointer to the {@link #xacml_request_t}, replaced by the @b effective XACML request.
+ * @param response address of the pointer to the {@link #xacml_response_t} received.
+ * @param rc {@link #pep_error_t} PEP_OK on success or an error code, as returned by pep_authorize(pep,request,response).
+ *        {@link #PEP_ERR_ABORTED} if the authorization was aborted before completion, by pep_destroy(pep).
+ * @param callback_arg the @c callback_arg pointer given to pep_authorize_async(...).
+ */
+typedef void pep_authorize_callback(PEP * pep, xacml_request_t ** request, xacml_response_t ** response, pep_error_t rc, void * callback_arg);
+
+/**
+ * Submits the XACML request to the PEP daemon without blocking, the response
+ * is delivered to the @c callback function.
+ *
+ * The PIPs, if any, are applied to the request before this function returns. The request is
+ * then sent and its response received by the subsequent calls to pep_perform(pep,running) or
+ * pep_wait(pep,timeout_ms,running), which apply the ObligationHandlers, if any, and call the
+ * @c callback function. Many asynchronous authorizations can be in flight on the same PEP client
+ * @b handle, they share the connections to the PEPd.
+ *
+ * The @c request and @c response pointers must remain valid until the @c callback is called.
+ * If this function does not return PEP_OK, the @c callback is never called.
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param request address of the pointer to the {@link #xacml_request_t} to send.
+ * @param response address of pointer to the {@link #xacml_response_t} to receive.
+ * @param callback the completion callback function.
+ * @param callback_arg pointer passed as is to the @c callback function.
+ *
+ * @return {@link #pep_error_t} PEP_OK on success or an error code.
+ *
+ * Example:
+ * @code
+ * static void done(PEP * pep, xacml_request_t ** request, xacml_response_t ** response, pep_error_t rc, void * arg) {
+ *     if (rc == PEP_OK) {
+ *         ... // process *response
+ *     }
+ *     xacml_request_delete(*request);
+ *     xacml_response_delete(*response);
+ * }
+ * ...
+ * int running= 0;
+ * pep_authorize_async(pep,&request,&response,done,NULL);
+ * do {
+ *     pep_wait(pep,1000,&running);
+ * } while (running > 0);
+ * @endcode
+ */
+pep_error_t pep_authorize_async(PEP * pep, xacml_request_t ** request, xacml_response_t ** response, pep_authorize_callback * callback, void * callback_arg);
+
+/**
+ * Drives the in-flight asynchronous authorizations without blocking, and calls the
+ * completion callback of each completed one.
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param running if not @c NULL, set to the number of asynchronous authorizations still in flight.
+ *
+ * @return {@link #pep_error_t} PEP_OK on success or an error code.
+ */
+pep_error_t pep_perform(PEP * pep, int * running);
+
+/**
+ * Waits at most @c timeout_ms milliseconds for activity on the in-flight asynchronous
+ * authorizations, then drives them like pep_perform(pep,running).
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param timeout_ms maximum time to wait in milliseconds.
+ * @param running if not @c NULL, set to the number of asynchronous authorizations still in flight.
+ *
+ * @return {@link #pep_error_t} PEP_OK on success or an error code.
+ */
+pep_error_t pep_wait(PEP * pep, int timeout_ms, int * running);
+
+/**
+ * Sends many XACML requests to the PEP daemon concurrently, and returns when all the
+ * XACML responses are received.
+ *
+ * All the requests are processed by the PIPs and marshalled before being sent, then they are
+ * in flight at the same time, sharing the connections to the PEPd, and the ObligationHandlers
+ * are applied to each response. The elapsed time is close to the slowest single authorization,
+ * not their sum. Each request is processed as by pep_authorize(pep,request,response).
+ *
+ * The asynchronous authorizations already in flight on the PEP client @b handle, if any, are
+ * also driven, and their callback called, while this function runs.
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param requests array of @c n pointers to the {@link #xacml_request_t} to send. After the call,
+ *        each request is the @b effective XACML request, as processed by the PEPd.
+ * @param n number of requests.
+ * @param responses array of @c n pointers set to the {@link #xacml_response_t} received, or
+ *        @c NULL if no response was received.
+ * @param errors array of @c n {@link #pep_error_t} set to the error code of each request,
+ *        or @c NULL. If driving the requests fails, the ones still in flight are aborted
+ *        with the {@link #PEP_ERR_ABORTED} error code.
+ *
+ * @return {@link #pep_error_t} PEP_OK if all the requests succeeded, or the error code of the
+ *         first failed request.
+ */
+pep_error_t pep_authorize_batch(PEP * pep, xacml_request_t ** requests, size_t n, xacml_response_t ** responses, pep_error_t * errors);
+
+/**
+ * Gets the decision cache counters of the PEP client.
+ *
+ * @param pep pointer to the @b handle of the PEP client.
+ * @param hits if not @c NULL, set to the number of responses found in the cache.
+ * @param misses if not @c NULL, set to the number of responses not found, or expired, in the cache.
+ * @param evictions if not @c NULL, set to the number of responses evicted to respect the cache size.
+ *
+ * @return {@link #pep_error_t} PEP_OK on success or an error code.
+ */
+pep_error_t pep_getcachestats(PEP * pep, unsigned long * hits, unsigned long * misses, unsigned long * evictions);
+
 /**
  * Cleanups and destroys the PEP client. Any uses of the @b handle after this function has been called are illegal. 
+ * The asynchronous authorizations still in flight are aborted, and their callback is called
+ * with the {@link #PEP_ERR_ABORTED} error code.
  *
  * @param pep pointer to the @b handle of the PEP client.
  *
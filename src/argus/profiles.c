@@ -106,7 +106,6 @@ static int authzinterop2gridwn_pip_process(xacml_request_t ** request) {
     int i, j, profile_id_present;
     size_t subjects_l= xacml_request_subjects_length(*request);
     xacml_environment_t * environment;
-    size_t environment_attrs_l;
     for (i= 0; i<subjects_l; i++) {
         xacml_subject_t * subject= xacml_request_getsubject(*request,i);
         size_t subject_attrs_l= xacml_subject_attributes_length(subject);
@@ -178,15 +177,10 @@ static int authzinterop2gridwn_pip_process(xacml_request_t ** request) {
             log_warn("%s: failed to create XACML Environment",AUTHZINTEROP_TO_GRIDWN_ADAPTER_ID);
         }
     }
-    environment_attrs_l= xacml_environment_attributes_length(environment);
     profile_id_present= 0;
-    for (i= 0; i<environment_attrs_l; i++) {
-        xacml_attribute_t * attr= xacml_environment_getattribute(environment,i);
-        const char * attr_id= xacml_attribute_getid(attr);
-        if (strncmp(XACML_GRIDWN_ATTRIBUTE_PROFILE_ID,attr_id,strlen(XACML_GRIDWN_ATTRIBUTE_PROFILE_ID))==0) {
-            log_debug("%s: found environment.attribute[%d].id= %s",AUTHZINTEROP_TO_GRIDWN_ADAPTER_ID,i,attr_id);
-            profile_id_present= 1;
-        }
+    if (environment!=NULL && xacml_environment_findattribute(environment,XACML_GRIDWN_ATTRIBUTE_PROFILE_ID)!=NULL) {
+        log_debug("%s: found environment.attribute.id= %s",AUTHZINTEROP_TO_GRIDWN_ADAPTER_ID,XACML_GRIDWN_ATTRIBUTE_PROFILE_ID);
+        profile_id_present= 1;
     }
     /* profile id is not present, then add it */
     if (!profile_id_present && environment) {
@@ -221,6 +215,10 @@ static int resolve_user_uidgid(const char * username, uid_t * pw_uid, gid_t * pw
 static int gridwn2authzinterop_oh_process(xacml_request_t ** request,xacml_response_t ** response) {
     int i, j, k, m;
     size_t results_l= xacml_response_results_length(*response);
+    /* attribute assignment ids are interned: compared with pointer equality */
+    const char * user_id= xacml_intern(XACML_GRIDWN_ATTRIBUTE_USER_ID);
+    const char * group_id_primary= xacml_intern(XACML_GRIDWN_ATTRIBUTE_GROUP_ID_PRIMARY);
+    const char * group_id= xacml_intern(XACML_GRIDWN_ATTRIBUTE_GROUP_ID);
     for (i= 0; i<results_l; i++) {
         xacml_result_t * result= xacml_response_getresult(*response,i);
         xacml_decision_t decision= xacml_result_getdecision(result);
@@ -242,13 +240,13 @@ static int gridwn2authzinterop_oh_process(xacml_request_t ** request,xacml_respo
                         xacml_attributeassignment_t * attr= xacml_obligation_getattributeassignment(obligation,k);
                         const char * attr_id= xacml_attributeassignment_getid(attr);
                         const char * attr_value= xacml_attributeassignment_getvalue(attr);
-                        if (strcmp(XACML_GRIDWN_ATTRIBUTE_USER_ID,attr_id)==0) {
+                        if (attr_id == user_id) {
                             username= attr_value;
                         }
-                        else if (strcmp(XACML_GRIDWN_ATTRIBUTE_GROUP_ID_PRIMARY,attr_id)==0) {
+                        else if (attr_id == group_id_primary) {
                             groupname= attr_value;
                         }
-                        else if (strcmp(XACML_GRIDWN_ATTRIBUTE_GROUP_ID,attr_id)==0) {
+                        else if (attr_id == group_id) {
                             groupnames[n_groupnames++]= (char *)attr_value;
                         }
                     }
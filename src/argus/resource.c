@@ -23,10 +23,12 @@
 #include "log.h"
 
 #include "xacml.h"
+#include "attributeindex.h"
 
 struct xacml_resource {
 	char * content;
 	linkedlist_t * attributes;
+	xacml_attributeindex_t * index; /* attributes by id, built by the first lookup */
 };
 
 xacml_resource_t * xacml_resource_create() {
@@ -42,6 +44,7 @@ xacml_resource_t * xacml_resource_create() {
 		return NULL;
 	}
 	resource->content= NULL;
+	resource->index= NULL;
 	return resource;
 }
 
@@ -54,7 +57,8 @@ int xacml_resource_addattribute(xacml_resource_t * resource, xacml_attribute_t *
 		log_error("xacml_resource_addattribute: can't add attribute to list.");
 		return PEP_XACML_ERROR;
 	}
-	else return PEP_XACML_OK;
+	xacml_attributeindex_add(&(resource->index),attr);
+	return PEP_XACML_OK;
 }
 
 size_t xacml_resource_attributes_length(const xacml_resource_t * resource) {
@@ -73,6 +77,14 @@ xacml_attribute_t * xacml_resource_getattribute(const xacml_resource_t * resourc
 	return llist_get(resource->attributes, index);
 }
 
+xacml_attribute_t * xacml_resource_findattribute(xacml_resource_t * resource, const char * id) {
+	if (resource == NULL || id == NULL) {
+		log_error("xacml_resource_findattribute: NULL resource or id.");
+		return NULL;
+	}
+	return xacml_attributeindex_find(&(resource->index),resource->attributes,id);
+}
+
 /* if content is NULL, delete existing */
 int xacml_resource_setcontent(xacml_resource_t * resource, const char * content) {
 	if (resource == NULL) {
@@ -104,6 +116,7 @@ const char * xacml_resource_getcontent(const xacml_resource_t * resource) {
 
 void xacml_resource_delete(xacml_resource_t * resource) {
 	if (resource == NULL) return;
+	xacml_attributeindex_delete(resource->index);
 	llist_delete_elements(resource->attributes,(delete_element_func)xacml_attribute_delete);
 	llist_delete(resource->attributes);
 	if (resource->content != NULL) free(resource->content);
@@ -23,6 +23,7 @@
 #include "log.h"
 
 #include "xacml.h"
+#include "intern.h"
 
 /************************************************************
  * PEP Status functions
@@ -119,7 +120,7 @@ void xacml_status_delete(xacml_status_t * status) {
  * PEP StatusCode functions
  */
 struct xacml_statuscode {
-    char * value;
+    const char * value; /* interned if known */
     struct xacml_statuscode * subcode;
 };
 
@@ -132,14 +133,12 @@ xacml_statuscode_t * xacml_statuscode_create(const char * value) {
     }
     status_code->value= NULL;
     if (value != NULL) {
-        size_t size= strlen(value);
-        status_code->value= calloc(size + 1,sizeof(char));
+        status_code->value= xacml_strintern(value);
         if (status_code->value == NULL) {
-            log_error("xacml_statuscode_create: can't allocate value (%d bytes).",(int)size);
+            log_error("xacml_statuscode_create: can't allocate value (%d bytes).",(int)strlen(value));
             free(status_code);
             return NULL;
         }
-        strncpy(status_code->value,value,size);
     }
     status_code->subcode= NULL;
     return status_code;
@@ -147,7 +146,6 @@ xacml_statuscode_t * xacml_statuscode_create(const char * value) {
 
 /* value NULL not allowed */
 int xacml_statuscode_setvalue(xacml_statuscode_t * status_code, const char * value) {
-    size_t size;
     if (status_code == NULL) {
         log_error("xacml_statuscode_setcode: NULL status_code object.");
         return PEP_XACML_ERROR;
@@ -156,14 +154,12 @@ int xacml_statuscode_setvalue(xacml_statuscode_t * status_code, const char * val
         log_error("xacml_statuscode_setcode: NULL value string.");
         return PEP_XACML_ERROR;
     }
-    if (status_code->value != NULL) free(status_code->value);
-    size= strlen(value);
-    status_code->value= calloc(size + 1,sizeof(char));
+    xacml_strfree(status_code->value);
+    status_code->value= xacml_strintern(value);
     if (status_code->value == NULL) {
-        log_error("xacml_statuscode_setcode: can't allocate value (%d bytes).",(int)size);
+        log_error("xacml_statuscode_setcode: can't allocate value (%d bytes).",(int)strlen(value));
         return PEP_XACML_ERROR;
     }
-    strncpy(status_code->value,value,size);
     return PEP_XACML_OK;
 }
 
@@ -198,7 +194,7 @@ xacml_statuscode_t * xacml_statuscode_getsubcode(const xacml_statuscode_t * stat
 
 void xacml_statuscode_delete(xacml_statuscode_t * status_code) {
     if (status_code == NULL) return;
-    if (status_code->value != NULL) free(status_code->value);
+    xacml_strfree(status_code->value);
     if (status_code->subcode != NULL) {
         xacml_statuscode_delete(status_code->subcode);
     }
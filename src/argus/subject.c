@@ -23,10 +23,13 @@
 #include "log.h"
 
 #include "xacml.h"
+#include "attributeindex.h"
+#include "intern.h"
 
 struct xacml_subject {
-	char * category;
+	const char * category; /* interned if known */
 	linkedlist_t * attributes;
+	xacml_attributeindex_t * index; /* attributes by id, built by the first lookup */
 };
 
 xacml_subject_t * xacml_subject_create() {
@@ -42,6 +45,7 @@ xacml_subject_t * xacml_subject_create() {
 		return NULL;
 	}
 	subject->category= NULL;
+	subject->index= NULL;
 	return subject;
 }
 
@@ -51,17 +55,14 @@ int xacml_subject_setcategory(xacml_subject_t * subject, const char * category)
 		log_error("xacml_subject_setcategory: NULL subject.");
 		return PEP_XACML_ERROR;
 	}
-	if (subject->category != NULL) {
-		free(subject->category);
-	}
+	xacml_strfree(subject->category);
+	subject->category= NULL;
 	if (category != NULL) {
-		size_t size= strlen(category);
-		subject->category= calloc(size + 1, sizeof(char));
+		subject->category= xacml_strintern(category);
 		if (subject->category == NULL) {
-			log_error("xacml_subject_setcategory: can't allocate category (%d bytes).", (int)size);
+			log_error("xacml_subject_setcategory: can't allocate category (%d bytes).", (int)strlen(category));
 			return PEP_XACML_ERROR;
 		}
-		strncpy(subject->category,category,size);
 	}
 	return PEP_XACML_OK;
 }
@@ -83,7 +84,8 @@ int xacml_subject_addattribute(xacml_subject_t * subject, xacml_attribute_t * at
 		log_error("xacml_subject_addattribute: can't add attribute to list.");
 		return PEP_XACML_ERROR;
 	}
-	else return PEP_XACML_OK;
+	xacml_attributeindex_add(&(subject->index),attr);
+	return PEP_XACML_OK;
 }
 
 size_t xacml_subject_attributes_length(const xacml_subject_t * subject) {
@@ -102,13 +104,20 @@ xacml_attribute_t * xacml_subject_getattribute(const xacml_subject_t * subject,
 	return llist_get(subject->attributes, index);
 }
 
+xacml_attribute_t * xacml_subject_findattribute(xacml_subject_t * subject, const char * id) {
+	if (subject == NULL || id == NULL) {
+		log_error("xacml_subject_findattribute: NULL subject or id.");
+		return NULL;
+	}
+	return xacml_attributeindex_find(&(subject->index),subject->attributes,id);
+}
+
 void xacml_subject_delete(xacml_subject_t * subject) {
 	if (subject == NULL) return;
+	xacml_attributeindex_delete(subject->index);
 	llist_delete_elements(subject->attributes,(delete_element_func)xacml_attribute_delete);
 	llist_delete(subject->attributes);
-	if (subject->category != NULL) {
-		free(subject->category);
-	}
+	xacml_strfree(subject->category);
 	free(subject);
 	subject= NULL;
 }
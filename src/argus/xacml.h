@@ -47,6 +47,21 @@ extern "C" {
 /* WARN: PEP_XACML_ERROR should be size_t (unsigned int) compatible! */
 #define PEP_XACML_ERROR  0 /**< PEP XACML model functions return code ERROR */
 
+/**
+ * Returns the interned copy of a known XACML identifier, or @a NULL if @a str
+ * is not one of the @c XACML_* identifier constants of xacml.h and profiles.h.
+ *
+ * The XACML model stores the known identifiers (ids, datatypes, categories,
+ * status codes, ...) interned and without copy, and their getters return the
+ * interned pointer: it can be compared with pointer equality, e.g.
+ * <code>xacml_attribute_getid(attr) == xacml_intern(XACML_SUBJECT_ID)</code>.
+ * The interned identifiers are process-wide, immutable and thread-safe.
+ *
+ * @param str the identifier to look up.
+ * @return const char * the interned identifier or @a NULL.
+ */
+const char * xacml_intern(const char * str);
+
 
 /*
  * XACML Data-types identifiers (XACML 2.0, Appendix B.3)
@@ -82,7 +97,9 @@ typedef struct xacml_attribute xacml_attribute_t;
 xacml_attribute_t * xacml_attribute_create(const char * id);
 
 /**
- * Sets the id attribute of the XACML Attribute.
+ * Sets the id attribute of the XACML Attribute. If the Attribute was already added
+ * to a Subject, Resource, Action or Environment, its attribute index is dropped
+ * and rebuilt by the next lookup.
  * @param attr pointer to the XACML Attribute
  * @param id the id attribute
  * @return int {@link #PEP_XACML_OK} or {@link #PEP_XACML_ERROR} on error.
@@ -236,6 +253,16 @@ size_t xacml_subject_attributes_length(const xacml_subject_t * subject);
  */
 xacml_attribute_t * xacml_subject_getattribute(const xacml_subject_t * subject, int attr_idx);
 
+/**
+ * Finds the XACML Attribute with the given id in the XACML Subject. The attributes
+ * of a large Subject are looked up in a hash index, built by the first call and
+ * updated by xacml_subject_addattribute() and dropped by xacml_attribute_setid().
+ * @param subject pointer to the XACML Subject
+ * @param id the XACML Attribute id to find
+ * @return xacml_attribute_t * pointer to the first XACML Attribute with the id or @a NULL if not found.
+ */
+xacml_attribute_t * xacml_subject_findattribute(xacml_subject_t * subject, const char * id);
+
 /**
  * Deletes the XACML Subject.
  * @param subject pointer to the XACML Subject
@@ -301,6 +328,15 @@ size_t xacml_resource_attributes_length(const xacml_resource_t * resource);
  */
 xacml_attribute_t * xacml_resource_getattribute(const xacml_resource_t * resource, int attr_idx);
 
+/**
+ * Finds the XACML Attribute with the given id in the XACML Resource.
+ * @param resource pointer to the XACML Resource
+ * @param id the XACML Attribute id to find
+ * @return xacml_attribute_t * pointer to the first XACML Attribute with the id or @a NULL if not found.
+ * @see xacml_subject_findattribute(xacml_subject_t * subject, const char * id)
+ */
+xacml_attribute_t * xacml_resource_findattribute(xacml_resource_t * resource, const char * id);
+
 /**
  * Deletes the XACML Resource. The XACML Attributes contained in the Resource will be deleted.
  * @param resource pointer to the XACML Resource
@@ -349,6 +385,15 @@ size_t xacml_action_attributes_length(const xacml_action_t * action);
  */
 xacml_attribute_t * xacml_action_getattribute(const xacml_action_t * action, int attr_idx);
 
+/**
+ * Finds the XACML Attribute with the given id in the XACML Action.
+ * @param action pointer to the XACML Action
+ * @param id the XACML Attribute id to find
+ * @return xacml_attribute_t * pointer to the first XACML Attribute with the id or @a NULL if not found.
+ * @see xacml_subject_findattribute(xacml_subject_t * subject, const char * id)
+ */
+xacml_attribute_t * xacml_action_findattribute(xacml_action_t * action, const char * id);
+
 /**
  * Deletes the XACML Action. The XACML Attributes contained in the Action will be deleted.
  * @param action pointer to the XACML Action to delete
@@ -399,6 +444,15 @@ size_t xacml_environment_attributes_length(const xacml_environment_t * env);
  */
 xacml_attribute_t * xacml_environment_getattribute(const xacml_environment_t * env, int attr_idx);
 
+/**
+ * Finds the XACML Attribute with the given id in the XACML Environment.
+ * @param env pointer to the XACML Environment
+ * @param id the XACML Attribute id to find
+ * @return xacml_attribute_t * pointer to the first XACML Attribute with the id or @a NULL if not found.
+ * @see xacml_subject_findattribute(xacml_subject_t * subject, const char * id)
+ */
+xacml_attribute_t * xacml_environment_findattribute(xacml_environment_t * env, const char * id);
+
 /**
  * Deletes the XACML Environment. The XACML Attributes contained in the Environment will be deleted.
  * @param env pointer to the XACML Environment to delete
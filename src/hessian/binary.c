@@ -66,7 +66,7 @@ static hessian_object_t * hessian_binary_ctor (hessian_object_t * object, va_lis
     	return NULL;
     }
     self->length= length;
-    self->data= calloc(self->length,sizeof(char));
+    self->data= hessian_malloc(hessian_getarena(self),self->length);
     if (self->data == NULL) {
 		log_error("hessian_binary_ctor: can't allocate data (%d bytes).",(int)self->length);
     	return NULL;
@@ -93,7 +93,7 @@ static int hessian_binary_dtor (hessian_object_t * object) {
 /**
  * hessian_binary deserialize method.
  */
-static int hessian_binary_deserialize (hessian_object_t * object, int tag, BUFFER * input) {
+static int hessian_binary_deserialize (hessian_object_t * object, int tag, BUFFER * input, hessian_refs_t * refs) {
     hessian_binary_t * self= object;
     const hessian_class_t * class;
     size_t buf_size, buf_l;
@@ -146,7 +146,7 @@ static int hessian_binary_deserialize (hessian_object_t * object, int tag, BUFFE
     /* copy the buffer into the hessian binary */
     buf_l= buffer_length(buf);
     self->length= buf_l;
-    self->data= calloc(self->length,sizeof(char));
+    self->data= hessian_malloc(hessian_getarena(self),self->length);
     if (self->data == NULL) {
     	log_error("hessian_binary_deserialize: can't allocated data (%d bytes).", (int)self->length);
         buffer_delete(buf);
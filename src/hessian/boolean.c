@@ -92,7 +92,7 @@ static int hessian_boolean_serialize (const hessian_object_t * object, BUFFER *
 /**
  * Hessian boolean deserialize method.
  */
-static int hessian_boolean_deserialize (hessian_object_t * object, int tag, BUFFER * input) {
+static int hessian_boolean_deserialize (hessian_object_t * object, int tag, BUFFER * input, hessian_refs_t * refs) {
     hessian_boolean_t * self= object;
     const hessian_class_t * class;
     if (self == NULL) {
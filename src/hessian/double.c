@@ -66,8 +66,7 @@ static hessian_object_t * hessian_double_ctor (hessian_object_t * object, va_lis
 static int hessian_double_serialize (const hessian_object_t * object, BUFFER * output) {
     const hessian_double_t * self= object;
     const hessian_class_t * class;
-    int64_t *lvalue, value;
-    int b8, b16, b24, b32, b40, b48, b56, b64;
+    uint64_t lvalue;
     if (self == NULL) {
 		log_error("hessian_double_serialize: NULL object pointer.");
     	return HESSIAN_ERROR;
@@ -82,36 +81,22 @@ static int hessian_double_serialize (const hessian_object_t * object, BUFFER * o
     	return HESSIAN_ERROR;
     }
     /* convert 64-bit double to a 64-bit long */
-    lvalue = (int64_t*) &(self->value);
-    value= *lvalue;
-    b64 = (value >> 56) & 0x000000FF;
-    b56 = (value >> 48) & 0x000000FF;
-    b48 = (value >> 40) & 0x000000FF;
-    b40 = (value >> 32) & 0x000000FF;
-    b32 = (value >> 24) & 0x000000FF;
-    b24 = (value >> 16) & 0x000000FF;
-    b16 = (value >> 8) & 0x000000FF;
-    b8 = value & 0x000000FF;
-    buffer_putc(class->tag,output);
-    buffer_putc(b64,output);
-    buffer_putc(b56,output);
-    buffer_putc(b48,output);
-    buffer_putc(b40,output);
-    buffer_putc(b32,output);
-    buffer_putc(b24,output);
-    buffer_putc(b16,output);
-    buffer_putc(b8,output);
+    memcpy(&lvalue,&(self->value),sizeof(lvalue));
+    if (buffer_putc(class->tag,output) == BUFFER_ERROR
+        || buffer_putbe64(lvalue,output) != BUFFER_OK) {
+		log_error("hessian_double_serialize: can't write double to output buffer.");
+    	return HESSIAN_ERROR;
+    }
     return HESSIAN_OK;
 }
 
 /**
  * HessianDouble deserialize method.
  */
-static int hessian_double_deserialize (hessian_object_t * object, int tag, BUFFER * input) {
+static int hessian_double_deserialize (hessian_object_t * object, int tag, BUFFER * input, hessian_refs_t * refs) {
     hessian_double_t * self= object;
     const hessian_class_t * class;
-    int64_t b8, b16, b24, b32, b40, b48, b56, b64, lvalue;
-    double * value;
+    uint64_t lvalue;
     if (self == NULL) {
 		log_error("hessian_double_deserialize: NULL object pointer.");
     	return HESSIAN_ERROR;
@@ -129,25 +114,12 @@ static int hessian_double_deserialize (hessian_object_t * object, int tag, BUFFE
 		log_error("hessian_double_deserialize: invalid tag: %c (%d).",(char)tag,tag);
     	return HESSIAN_ERROR;
     }
-    b64 = buffer_getc(input);
-    b56 = buffer_getc(input);
-    b48 = buffer_getc(input);
-    b40 = buffer_getc(input);
-    b32 = buffer_getc(input);
-    b24 = buffer_getc(input);
-    b16 = buffer_getc(input);
-    b8 = buffer_getc(input);
-    lvalue= (b64 << 56)
-		+ (b56 << 48)
-		+ (b48 << 40)
-		+ (b40 << 32)
-		+ (b32 << 24)
-		+ (b24 << 16)
-		+ (b16 << 8)
-		+ b8;
+    if (buffer_getbe64(input,&lvalue) != BUFFER_OK) {
+		log_error("hessian_double_deserialize: can't read double from input buffer.");
+    	return HESSIAN_ERROR;
+    }
     /* convert 64bit long to double */
-    value= (double *) &lvalue;
-    self->value= (*value);
+    memcpy(&(self->value),&lvalue,sizeof(lvalue));
     return HESSIAN_OK;
 }
 
@@ -20,6 +20,7 @@
 #include <stdio.h>
 
 #include "hessian.h"
+#include "i_hessian.h"
 #include "log.h"
 
 /**
@@ -152,44 +153,148 @@ static hessian_t _gettype(int tag) {
 }
 
 /**
- * Creates an Hessian object.
+ * Every Hessian object is preceded by a header recording the arena it was
+ * allocated from, or NULL for an object allocated on the heap, and for a heap
+ * object its number of additional owners (shared by Hessian refs).
+ */
+typedef union hessian_header {
+	struct {
+		arena_t * arena;
+		size_t shared;
+	} object;
+	int64_t align_int64;
+	double align_double;
+} hessian_header_t;
+
+/**
+ * Per-decode Hessian reference table: the maps and lists in stream order.
+ */
+struct hessian_refs {
+	arena_t * arena;
+	hessian_object_t ** objects;
+	size_t objects_l;
+	size_t size;
+};
+
+#define HESSIAN_REFS_SIZE 16
+
+#define HESSIAN_HEADER(object) ((hessian_header_t *)(object) - 1)
+
+/**
+ * Allocates a zeroed object of the class, from the arena or the heap.
  *
- * Returns the Hessian object or NULL
+ * Returns the object, with its class descriptor set, or NULL
  */
-hessian_object_t * hessian_create(hessian_t type, ...) {
+static hessian_object_t * _allocobject(arena_t * arena, const hessian_class_t * class) {
+	hessian_header_t * header;
+	void * object;
+	if (arena != NULL) {
+		header= arena_calloc(arena, 1, sizeof(hessian_header_t) + class->size);
+	}
+	else {
+		header= calloc(1, sizeof(hessian_header_t) + class->size);
+	}
+	if (header == NULL) {
+		log_error("_allocobject: can't allocate object (%d bytes).", (int)class->size);
+		return NULL;
+	}
+	header->object.arena= arena;
+	object= header + 1;
+	/* first memory element of object is the class descriptor pointer */
+	*(const hessian_class_t **) object = class;
+	return object;
+}
+
+/**
+ * Releases the object memory, only if allocated on the heap.
+ */
+static void _freeobject(hessian_object_t * object) {
+	hessian_header_t * header= HESSIAN_HEADER(object);
+	if (header->object.arena == NULL) free(header);
+}
+
+/**
+ * Allocates a zeroed object of the type, from the arena or the heap, for the
+ * typed constructors.
+ *
+ * Returns the object, with its class descriptor set, or NULL
+ */
+hessian_object_t * hessian_alloc(arena_t * arena, hessian_t type) {
 	const hessian_class_t * class = _getclass(type);
-    void * object;
+	if (class == NULL) {
+		log_error("hessian_alloc: no class descriptor for type: %d", (int)type);
+		return NULL;
+	}
+	return _allocobject(arena, class);
+}
+
+/**
+ * Creates an Hessian object, from the arena or the heap.
+ */
+static hessian_object_t * _create(arena_t * arena, hessian_t type, va_list * ap) {
+	const hessian_class_t * class = _getclass(type);
+	void * object;
 	if (class == NULL) {
 		log_error("hessian_create: no class descriptor for type: %d", (int)type);
 		return NULL;
 	}
-	object = calloc(1, class->size);
+	object = _allocobject(arena, class);
 	if (object == NULL) {
 		log_error("hessian_create: can't allocate object descriptor (%d bytes).", (int)class->size);
 		return NULL;
 	}
-	/* first memory element of object is the class descriptor pointer */
-	*(const hessian_class_t **) object = class;
 	/* call constructor if any */
 	if (class->ctor) {
-		va_list ap;
-		va_start(ap, type);
-		if ( class->ctor(object, &ap) == NULL ) {
+		if ( class->ctor(object, ap) == NULL ) {
 			log_error("hessian_create: object constructor failed.");
-			free(object);
+			_freeobject(object);
 			object= NULL;
 		}
-		va_end(ap);
 	}
 	return object;
 }
 
 /**
- * Delete an Hessian object.
+ * Creates an Hessian object.
+ *
+ * Returns the Hessian object or NULL
+ */
+hessian_object_t * hessian_create(hessian_t type, ...) {
+	void * object;
+	va_list ap;
+	va_start(ap, type);
+	object= _create(NULL, type, &ap);
+	va_end(ap);
+	return object;
+}
+
+/**
+ * Creates an Hessian object allocated from the arena.
+ *
+ * Returns the Hessian object or NULL
+ */
+hessian_object_t * hessian_create_arena(arena_t * arena, hessian_t type, ...) {
+	void * object;
+	va_list ap;
+	va_start(ap, type);
+	object= _create(arena, type, &ap);
+	va_end(ap);
+	return object;
+}
+
+/**
+ * Delete an Hessian object. Does nothing for an object allocated from an
+ * arena, it is released with the arena.
  */
 void hessian_delete(hessian_object_t * object) {
 	const hessian_class_t * class;
 	if (object == NULL) return;
+	if (HESSIAN_HEADER(object)->object.arena != NULL) return;
+	/* shared object: only release one owner */
+	if (HESSIAN_HEADER(object)->object.shared > 0) {
+		HESSIAN_HEADER(object)->object.shared--;
+		return;
+	}
 	class = hessian_getclass(object);
 	if (class == NULL) {
 		log_error("hessian_delete: no class descriptor.");
@@ -200,10 +305,48 @@ void hessian_delete(hessian_object_t * object) {
 			log_error("hessian_delete: object destructor failed.");
 		}
 	}
-	if (object != NULL) free(object);
+	_freeobject(object);
 	object= NULL;
 }
 
+/**
+ * Returns the arena the object was allocated from, or NULL.
+ */
+arena_t * hessian_getarena(const hessian_object_t * object) {
+	if (object == NULL) return NULL;
+	return HESSIAN_HEADER(object)->object.arena;
+}
+
+/**
+ * Allocates size bytes from the arena, or from the heap if arena is NULL.
+ */
+void * hessian_malloc(arena_t * arena, size_t size) {
+	if (arena != NULL) return arena_alloc(arena, size);
+	return malloc(size);
+}
+
+/**
+ * Copies the str_l first chars of str in a '\0' terminated string, allocated
+ * from the arena, or from the heap if arena is NULL.
+ */
+char * hessian_strndup(arena_t * arena, const char * str, size_t str_l) {
+	char * copy= hessian_malloc(arena, str_l + 1);
+	if (copy == NULL) {
+		log_error("hessian_strndup: can't allocate string (%d chars).", (int)str_l);
+		return NULL;
+	}
+	memcpy(copy, str, str_l);
+	copy[str_l]= '\0';
+	return copy;
+}
+
+/**
+ * Releases memory allocated by hessian_malloc(), does nothing if arena is not NULL.
+ */
+void hessian_free(arena_t * arena, void * ptr) {
+	if (arena == NULL) free(ptr);
+}
+
 int hessian_serialize(const hessian_object_t * object, BUFFER * output) {
 	const hessian_class_t * class = hessian_getclass(object);
 	if (class == NULL) {
@@ -221,12 +364,11 @@ int hessian_serialize(const hessian_object_t * object, BUFFER * output) {
     return HESSIAN_OK;
 }
 
-hessian_object_t * hessian_deserialize(BUFFER * input) {
-	int tag= buffer_getc(input);
-	return hessian_deserialize_tag(tag,input);
-}
-
-hessian_object_t * hessian_deserialize_tag(int tag, BUFFER * input) {
+/**
+ * Deserializes the object of the tag, its maps and lists being registered in,
+ * and their refs resolved with, the reference table.
+ */
+static hessian_object_t * _deserialize(hessian_refs_t * refs, arena_t * arena, int tag, BUFFER * input) {
 	hessian_t type= _gettype(tag);
 	const hessian_class_t * class;
     void * object;
@@ -239,29 +381,135 @@ hessian_object_t * hessian_deserialize_tag(int tag, BUFFER * input) {
 		log_error("hessian_deserialize: NULL class for tag: %c", tag );
 		return NULL;
 	}
-	/* allocate the object class descriptor */
-	object = calloc(1, class->size);
+	/* allocate the object, with its class descriptor */
+	object = _allocobject(arena, class);
 	if (object == NULL) {
 		log_error("hessian_deserialize: can't allocate object (%d bytes)", (int)class->size );
 		return NULL;
 	}
-	/* first memory element of object is the class pointer */
-	*(const hessian_class_t **) object = class;
 	/* deserialize the object */
 	if (class->deserialize) {
-		if (class->deserialize(object, tag, input) == HESSIAN_OK) return object;
+		if (class->deserialize(object, tag, input, refs) == HESSIAN_OK) return object;
 		else {
 			log_error("hessian_deserialize: failed to deserialize object: %s tag: %c", class->name, tag);
+			_freeobject(object);
 			return NULL;
 		}
 	}
 	else {
 		log_error("hessian_deserialize: No deserializer defined for class %s",
 				class->name);
+		_freeobject(object);
 		return NULL;
 	}
 }
 
+hessian_object_t * hessian_deserialize(BUFFER * input) {
+	int tag= buffer_getc(input);
+	return hessian_deserialize_tag_arena(NULL,tag,input);
+}
+
+hessian_object_t * hessian_deserialize_tag(int tag, BUFFER * input) {
+	return hessian_deserialize_tag_arena(NULL,tag,input);
+}
+
+hessian_object_t * hessian_deserialize_arena(arena_t * arena, BUFFER * input) {
+	int tag= buffer_getc(input);
+	return hessian_deserialize_tag_arena(arena,tag,input);
+}
+
+hessian_object_t * hessian_deserialize_tag_arena(arena_t * arena, int tag, BUFFER * input) {
+	hessian_refs_t refs;
+	hessian_object_t * object;
+	refs.arena= arena;
+	refs.objects= NULL;
+	refs.objects_l= 0;
+	refs.size= 0;
+	object= _deserialize(&refs, arena, tag, input);
+	hessian_free(arena, refs.objects);
+	return object;
+}
+
+/**
+ * Registers the map or list at the next index of the reference table.
+ */
+int hessian_refs_add(hessian_refs_t * refs, hessian_object_t * object) {
+	if (refs->objects_l >= refs->size) {
+		size_t size= (refs->size > 0) ? refs->size * 2 : HESSIAN_REFS_SIZE;
+		hessian_object_t ** objects;
+		if (refs->arena != NULL) {
+			objects= arena_realloc(refs->arena, refs->objects, refs->size * sizeof(hessian_object_t *), size * sizeof(hessian_object_t *));
+		}
+		else {
+			objects= realloc(refs->objects, size * sizeof(hessian_object_t *));
+		}
+		if (objects == NULL) {
+			log_error("hessian_refs_add: can't grow references table to %d objects.", (int)size);
+			return HESSIAN_ERROR;
+		}
+		refs->objects= objects;
+		refs->size= size;
+	}
+	refs->objects[refs->objects_l++]= object;
+	return HESSIAN_OK;
+}
+
+/**
+ * Returns the referenced map or list, which gets one more owner, or NULL.
+ */
+hessian_object_t * hessian_refs_get(hessian_refs_t * refs, int32_t ref_index) {
+	hessian_object_t * referenced;
+	if (ref_index < 0 || (size_t)ref_index >= refs->objects_l) {
+		log_error("hessian_refs_get: ref %d out of references table (%d objects).", (int)ref_index, (int)refs->objects_l);
+		return NULL;
+	}
+	referenced= refs->objects[ref_index];
+	if (HESSIAN_HEADER(referenced)->object.arena == NULL) {
+		HESSIAN_HEADER(referenced)->object.shared++;
+	}
+	return referenced;
+}
+
+/**
+ * Creates an empty reference table, from the arena or the heap.
+ */
+hessian_refs_t * hessian_refs_create(arena_t * arena) {
+	hessian_refs_t * refs= hessian_malloc(arena, sizeof(hessian_refs_t));
+	if (refs == NULL) {
+		log_error("hessian_refs_create: can't allocate references table.");
+		return NULL;
+	}
+	refs->arena= arena;
+	refs->objects= NULL;
+	refs->objects_l= 0;
+	refs->size= 0;
+	return refs;
+}
+
+/**
+ * Releases the reference table, not the objects. NULL is ignored.
+ */
+void hessian_refs_delete(hessian_refs_t * refs) {
+	if (refs == NULL) return;
+	hessian_free(refs->arena, refs->objects);
+	hessian_free(refs->arena, refs);
+}
+
+/**
+ * Deserializes a map or list element. A ref is replaced by the referenced
+ * object, which gets one more owner.
+ */
+hessian_object_t * hessian_deserialize_refs(hessian_refs_t * refs, arena_t * arena, int tag, BUFFER * input) {
+	hessian_object_t * object= _deserialize(refs, arena, tag, input);
+	int32_t ref_index;
+	if (object == NULL || hessian_gettype(object) != HESSIAN_REF) {
+		return object;
+	}
+	ref_index= hessian_ref_getvalue(object);
+	hessian_delete(object);
+	return hessian_refs_get(refs, ref_index);
+}
+
 /*******************************************************/
 
 const hessian_class_t * hessian_getclass(const hessian_object_t * object) {
@@ -27,11 +27,17 @@ extern "C" {
 
 #include "types.h"
 #include "buffer.h"
+#include "arena.h"
 
 /** Hessian return codes */
 #define HESSIAN_OK     0
 #define HESSIAN_ERROR -1
 
+/** Hessian encoding versions */
+#define HESSIAN_VERSION_AUTO 0
+#define HESSIAN_VERSION_1    1
+#define HESSIAN_VERSION_2    2
+
 /**
  * Creates a Hessian object.
  *
@@ -61,7 +67,25 @@ extern "C" {
 hessian_object_t * hessian_create (hessian_t type, ...);
 
 /**
- * Destroy a Hessian object.
+ * Creates a Hessian object allocated from the arena. See hessian_create().
+ *
+ * The object and all the memory it holds are released at once with the arena,
+ * hessian_delete() does nothing on it. A list or map allocated from an arena
+ * must only contain objects allocated from the same arena.
+ *
+ * @param arena_t * arena the arena to allocate from.
+ * @param hessian_t type The type of Hessian object to create.
+ * @param ... variable arguments depending of the Hessian object type.
+ *
+ * @return hessian_object_t * pointer to the created Hessian object
+ *         or NULL if an error occurs.
+ */
+hessian_object_t * hessian_create_arena (arena_t * arena, hessian_t type, ...);
+
+/**
+ * Destroy a Hessian object. Does nothing if the object was allocated from an arena.
+ * An object shared by Hessian refs in a deserialized graph is only destroyed
+ * by its last owner.
  *
  * @param hessian_object_t * object the pointer to the Hessian object to destroy.
  */
@@ -81,6 +105,11 @@ int hessian_serialize (const hessian_object_t * object, BUFFER * output);
  * Deserializes an Hessian object from the input buffer. The first character
  * delimiter is directly read from the buffer.
  *
+ * The Hessian refs in the input are resolved to the referenced maps and lists,
+ * numbered in stream order, which are then shared in the object graph. A ref
+ * to an enclosing map or list makes a cycle, and a cyclic graph allocated on
+ * the heap is never released: use an arena.
+ *
  * @param BUFFER * input pointer to the input buffer.
  *
  * @return hessian_object_t * pointer to the deserialized Hessian object
@@ -100,6 +129,315 @@ hessian_object_t * hessian_deserialize (BUFFER * input);
  */
 hessian_object_t * hessian_deserialize_tag (int tag, BUFFER * input);
 
+/**
+ * Deserializes an Hessian object from the input buffer. The object graph is
+ * allocated from the arena and released at once with it, see hessian_create_arena().
+ *
+ * @param arena_t * arena the arena to allocate from.
+ * @param BUFFER * input pointer to the input buffer.
+ *
+ * @return hessian_object_t * pointer to the deserialized Hessian object
+ *         or NULL if an error occurs.
+ */
+hessian_object_t * hessian_deserialize_arena (arena_t * arena, BUFFER * input);
+
+/**
+ * Deserializes an Hessian object from the input buffer, identified with the
+ * first tag character delimiter. The object graph is allocated from the arena.
+ *
+ * @param arena_t * arena the arena to allocate from, or NULL for the heap.
+ * @param int tag the first character delimiter.
+ * @param BUFFER * input pointer to the input buffer.
+ *
+ * @return hessian_object_t * pointer to the deserialized Hessian object
+ *         or NULL if an error occurs.
+ */
+hessian_object_t * hessian_deserialize_tag_arena (arena_t * arena, int tag, BUFFER * input);
+
+/**
+ * Streaming writer: writes the Hessian encoding of maps, lists, strings and
+ * nulls directly into the output buffer, without creating Hessian objects.
+ * The output is byte for byte the one of hessian_serialize() for the
+ * equivalent object graph.
+ *
+ * A map or list is opened with hessian_writer_begin_map() or
+ * hessian_writer_begin_list(), followed by its content (key and value
+ * alternated for a map) and closed with hessian_writer_end().
+ *
+ * Example:
+ *   hessian_writer_begin_map("org.example.Person",output);
+ *   hessian_write_string("name",output);
+ *   hessian_write_string(name,output);
+ *   hessian_writer_end(output);
+ *
+ * All functions return HESSIAN_OK or HESSIAN_ERROR if an error occurs.
+ */
+
+/**
+ * Opens a map.
+ *
+ * @param const char * type the map type, or NULL for an untyped map.
+ * @param BUFFER * output pointer to the output buffer.
+ */
+int hessian_writer_begin_map(const char * type, BUFFER * output);
+
+/**
+ * Opens a list of length elements.
+ *
+ * @param const char * type the list type, or NULL for an untyped list.
+ * @param size_t length the number of elements which will be written.
+ * @param BUFFER * output pointer to the output buffer.
+ */
+int hessian_writer_begin_list(const char * type, size_t length, BUFFER * output);
+
+/**
+ * Closes the last opened map or list.
+ *
+ * @param BUFFER * output pointer to the output buffer.
+ */
+int hessian_writer_end(BUFFER * output);
+
+/**
+ * Writes a UTF-8 string.
+ *
+ * @param const char * str the null terminated UTF-8 string.
+ * @param BUFFER * output pointer to the output buffer.
+ */
+int hessian_write_string(const char * str, BUFFER * output);
+
+/**
+ * Writes a null.
+ *
+ * @param BUFFER * output pointer to the output buffer.
+ */
+int hessian_write_null(BUFFER * output);
+
+/**
+ * Writes a precomputed fragment, see HESSIAN_STRING_FRAGMENT() and
+ * HESSIAN_MAP_FRAGMENT().
+ *
+ * @param const void * fragment the fragment bytes.
+ * @param size_t fragment_l the fragment length, sizeof(fragment).
+ * @param BUFFER * output pointer to the output buffer.
+ */
+int hessian_write_fragment(const void * fragment, size_t fragment_l, BUFFER * output);
+
+/**
+ * Defines the precomputed encoding of a constant string, and of the beginning
+ * of a typed map, to write with hessian_write_fragment(). The string or type
+ * must be an ASCII literal shorter than 256 chars.
+ *
+ * Example:
+ *   HESSIAN_STRING_FRAGMENT(name_key,"name");
+ *   hessian_write_fragment(&name_key,sizeof(name_key),output);
+ */
+#define HESSIAN_STRING_FRAGMENT(name,str) \
+    static const struct { \
+        char tag; unsigned char length[2]; char bytes[sizeof(str) - 1]; \
+    } name= { 'S', { 0, sizeof(str) - 1 }, str }
+#define HESSIAN_MAP_FRAGMENT(name,type) \
+    static const struct { \
+        char tag; char type_tag; unsigned char length[2]; char bytes[sizeof(type) - 1]; \
+    } name= { 'M', 't', { 0, sizeof(type) - 1 }, type }
+
+/**
+ * Hessian 2.0 streaming writer: writes the compact Hessian 2.0 encoding.
+ *
+ * An object is written as an instance of a class definition, which is written
+ * once per stream with hessian2_write_classdef(), and is referenced by its
+ * index (0 for the first definition of the stream). The object begins with
+ * hessian2_writer_begin_object(), followed by the values of its fields in the
+ * definition order. A list begins with hessian2_writer_begin_list(), followed
+ * by its length elements. Objects and lists have no end.
+ * Nulls are written with hessian_write_null().
+ *
+ * Example:
+ *   static const char * const fields[]= { "name", "age" };
+ *   hessian2_write_classdef("org.example.Person",fields,2,output);
+ *   hessian2_writer_begin_object(0,output);
+ *   hessian2_write_string(name,output);
+ *   hessian2_write_int(age,output);
+ *
+ * All functions return HESSIAN_OK or HESSIAN_ERROR if an error occurs.
+ */
+
+/**
+ * Writes a class definition.
+ *
+ * @param const char * type the class name.
+ * @param const char * const fields[] the field names.
+ * @param size_t fields_l the number of fields.
+ * @param BUFFER * output pointer to the output buffer.
+ */
+int hessian2_write_classdef(const char * type, const char * const fields[], size_t fields_l, BUFFER * output);
+
+/**
+ * Begins an object.
+ *
+ * @param int classdef the index of its class definition in the stream.
+ * @param BUFFER * output pointer to the output buffer.
+ */
+int hessian2_writer_begin_object(int classdef, BUFFER * output);
+
+/**
+ * Begins an untyped list of length elements.
+ *
+ * @param size_t length the number of elements which will be written.
+ * @param BUFFER * output pointer to the output buffer.
+ */
+int hessian2_writer_begin_list(size_t length, BUFFER * output);
+
+/**
+ * Writes a UTF-8 string, with a 1 byte header up to 31 chars and a 2 bytes
+ * header up to 1023 chars.
+ *
+ * @param const char * str the null terminated UTF-8 string.
+ * @param BUFFER * output pointer to the output buffer.
+ */
+int hessian2_write_string(const char * str, BUFFER * output);
+
+/**
+ * Writes an integer, in 1 byte from -16 to 47, 2 bytes from -2048 to 2047,
+ * 3 bytes from -262144 to 262143, and 5 bytes otherwise.
+ *
+ * @param int32_t value the integer.
+ * @param BUFFER * output pointer to the output buffer.
+ */
+int hessian2_write_int(int32_t value, BUFFER * output);
+
+/**
+ * Pull reader: reads the Hessian encoding from the input buffer token by
+ * token, without creating Hessian objects.
+ *
+ * hessian_reader_next() returns the type of the next token: HESSIAN_MAP or
+ * HESSIAN_LIST when a map or list begins, HESSIAN_END when it ends, or the
+ * type of a value. The content of a map is its keys and values alternated.
+ *
+ * The reader detects the Hessian 1.0 or 2.0 encoding on the first token. A
+ * Hessian 2.0 object is returned as a map typed with its class name, its
+ * field names and values alternated, and a fixed-length list ends with a
+ * HESSIAN_END token as well.
+ *
+ * Example:
+ *   hessian_reader_t * reader= hessian_reader_create(input);
+ *   if (hessian_reader_next(reader) == HESSIAN_MAP) {
+ *      while (hessian_reader_next(reader) == HESSIAN_STRING) {
+ *         const char * key= hessian_reader_getstring(reader,NULL);
+ *         ... process the value ...
+ *      }
+ *   }
+ *   hessian_reader_delete(reader);
+ */
+typedef struct hessian_reader hessian_reader_t;
+
+/**
+ * Creates a reader on the input buffer.
+ *
+ * @param BUFFER * input pointer to the input buffer.
+ *
+ * @return hessian_reader_t * the reader or NULL if an error occurs.
+ */
+hessian_reader_t * hessian_reader_create(BUFFER * input);
+
+/**
+ * Creates a reader on the input buffer, allocated from the arena. The reader
+ * is released with the arena, hessian_reader_delete() does nothing on it.
+ *
+ * @param arena_t * arena the arena to allocate from, or NULL for the heap.
+ * @param BUFFER * input pointer to the input buffer.
+ *
+ * @return hessian_reader_t * the reader or NULL if an error occurs.
+ */
+hessian_reader_t * hessian_reader_create_arena(arena_t * arena, BUFFER * input);
+
+/**
+ * Deletes the reader. The input buffer is not deleted.
+ *
+ * @param hessian_reader_t * reader the reader.
+ */
+void hessian_reader_delete(hessian_reader_t * reader);
+
+/**
+ * Sets the encoding version of the input, instead of detecting it on the
+ * first token.
+ *
+ * @param hessian_reader_t * reader the reader.
+ * @param int version HESSIAN_VERSION_1, HESSIAN_VERSION_2 or HESSIAN_VERSION_AUTO.
+ *
+ * @return int HESSIAN_OK or HESSIAN_ERROR if the version is invalid.
+ */
+int hessian_reader_setversion(hessian_reader_t * reader, int version);
+
+/**
+ * Returns the encoding version of the input, HESSIAN_VERSION_AUTO if not yet
+ * detected.
+ *
+ * @param const hessian_reader_t * reader the reader.
+ */
+int hessian_reader_getversion(const hessian_reader_t * reader);
+
+/**
+ * Reads the next token.
+ *
+ * @param hessian_reader_t * reader the reader.
+ *
+ * @return hessian_t the token type, HESSIAN_END at the end of a map or list, or
+ *         HESSIAN_UNKNOWN on error or unexpected end of input.
+ */
+hessian_t hessian_reader_next(hessian_reader_t * reader);
+
+/**
+ * Skips the content of the map or list just begun, up to its end.
+ *
+ * @param hessian_reader_t * reader the reader.
+ *
+ * @return int HESSIAN_OK or HESSIAN_ERROR if an error occurs.
+ */
+int hessian_reader_skip(hessian_reader_t * reader);
+
+/**
+ * Returns the '\0' terminated value of the last string, xml or binary token,
+ * the type of the last map or list, or the url of the last remote token. The
+ * memory belongs to the reader and is only valid until the next token.
+ *
+ * @param const hessian_reader_t * reader the reader.
+ * @param size_t * length set to the byte length, or NULL.
+ *
+ * @return const char * the value, or NULL for a map or list without type.
+ */
+const char * hessian_reader_getstring(const hessian_reader_t * reader, size_t * length);
+
+/**
+ * Returns the value of the last boolean, integer or ref token, or the length of
+ * the last list (-1 if not given).
+ */
+int32_t hessian_reader_getinteger(const hessian_reader_t * reader);
+
+/**
+ * Returns the value of the last long or date token.
+ */
+int64_t hessian_reader_getlong(const hessian_reader_t * reader);
+
+/**
+ * Returns the value of the last double token.
+ */
+double hessian_reader_getdouble(const hessian_reader_t * reader);
+
+/**
+ * Creates the Hessian object of the last token, of the type returned by
+ * hessian_reader_next(). The content of a map or list is read to its end, and
+ * the refs of the stream are resolved to the referenced maps and lists (and
+ * Hessian 2.0 objects, read as typed maps), which are then shared. The objects
+ * are allocated from the reader arena, or from the heap. Remote objects are
+ * not supported.
+ *
+ * @param hessian_reader_t * reader the reader.
+ * @param hessian_t type the type of the last token.
+ *
+ * @return hessian_object_t * the object or NULL if an error occurs.
+ */
+hessian_object_t * hessian_reader_getobject(hessian_reader_t * reader, hessian_t type);
+
 /**
  * Gets the type hessian_t of an object.
  *
@@ -171,10 +509,45 @@ size_t hessian_string_utf8_length(const hessian_object_t *string);
 size_t hessian_string_length(const hessian_object_t *string);
 const char * hessian_string_getstring(const hessian_object_t *string);
 
+/**
+ * Creates a Hessian string of the str_l bytes of str, which does not need to
+ * be '\0' terminated. The string is copied, inline in the object if short
+ * (no separate allocation).
+ *
+ * @param const char * str the UTF-8 string.
+ * @param size_t str_l the byte length of the string.
+ *
+ * @return hessian_object_t * the Hessian string or NULL if an error occurs.
+ */
+hessian_object_t * hessian_string_create(const char * str, size_t str_l);
+
+/**
+ * Creates a Hessian string allocated from the arena. See hessian_string_create()
+ * and hessian_create_arena().
+ */
+hessian_object_t * hessian_string_create_arena(arena_t * arena, const char * str, size_t str_l);
+
+/**
+ * Creates a Hessian string borrowing str, which is not copied nor released:
+ * str must be '\0' terminated at str_l and outlive the object, like a string
+ * literal.
+ *
+ * hessian_object_t * h_key= HESSIAN_STRING_STATIC("Attributes");
+ *
+ * @return hessian_object_t * the Hessian string or NULL if an error occurs.
+ */
+hessian_object_t * hessian_string_create_static(const char * str, size_t str_l);
+#define HESSIAN_STRING_STATIC(literal) hessian_string_create_static(literal, sizeof(literal) - 1)
+
 /**
  *  UTF-8 string utilities
  */
 size_t utf8_strlen(const char *array);
+
+/**
+ * Returns the number of UTF-8 chars in the str_l first bytes of str.
+ */
+size_t utf8_strnlen(const char * str, size_t str_l);
 char * utf8_bgets(size_t utf8_l, BUFFER * input);
 
 /**
@@ -235,6 +608,11 @@ int32_t hessian_ref_getvalue(const hessian_object_t * ref);
  * Adds a Hessian <key,value> objects pair to the Hessian map.
  */
 int hessian_map_add(hessian_object_t * map, hessian_object_t * key, hessian_object_t * value);
+
+/**
+ * Sets the optional Hessian map type, NULL for an untyped map.
+ */
+int hessian_map_settype(hessian_object_t * map, const char * type);
 const char * hessian_map_gettype(const hessian_object_t * map);
 size_t hessian_map_length(const hessian_object_t * map);
 hessian_object_t * hessian_map_getkey(const hessian_object_t * map, int index);
@@ -36,7 +36,7 @@ extern "C" {
 #define OBJECT_SERIALIZE(objname) \
     int objname ## _serialize (const hessian_object_t * self, BUFFER * output)
 #define OBJECT_DESERIALIZE(objname) \
-    int objname ## _deserialize (hessian_object_t * self, int tag, BUFFER * input)
+    int objname ## _deserialize (hessian_object_t * self, int tag, BUFFER * input, hessian_refs_t * refs)
 
 /*
  * Hessian serialization chunk size
@@ -46,6 +46,114 @@ extern "C" {
 #define HESSIAN_CHUNK_SIZE INT16_MAX
 #endif
 
+/*
+ * Hessian 2.0 compact encoding tags and ranges
+ */
+#define HESSIAN2_INT_DIRECT     0x90 /* x80-xbf: value - 0x90 */
+#define HESSIAN2_INT_DIRECT_MIN -0x10
+#define HESSIAN2_INT_DIRECT_MAX 0x2f
+#define HESSIAN2_INT_BYTE       0xc8 /* xc0-xcf b0 */
+#define HESSIAN2_INT_BYTE_MIN   -0x800
+#define HESSIAN2_INT_BYTE_MAX   0x7ff
+#define HESSIAN2_INT_SHORT      0xd4 /* xd0-xd7 b1 b0 */
+#define HESSIAN2_INT_SHORT_MIN  -0x40000
+#define HESSIAN2_INT_SHORT_MAX  0x3ffff
+#define HESSIAN2_LONG_DIRECT    0xe0 /* xd8-xef */
+#define HESSIAN2_LONG_BYTE      0xf8 /* xf0-xff b0 */
+#define HESSIAN2_LONG_SHORT     0x3c /* x38-x3f b1 b0 */
+#define HESSIAN2_LONG_INT       0x59 /* x59 b3 b2 b1 b0 */
+#define HESSIAN2_DOUBLE_ZERO    0x5b
+#define HESSIAN2_DOUBLE_ONE     0x5c
+#define HESSIAN2_DOUBLE_BYTE    0x5d
+#define HESSIAN2_DOUBLE_SHORT   0x5e
+#define HESSIAN2_DOUBLE_MILL    0x5f /* int value / 1000 */
+#define HESSIAN2_DATE_MILLIS    0x4a
+#define HESSIAN2_DATE_MINUTES   0x4b
+#define HESSIAN2_STRING_DIRECT_MAX 0x1f /* x00-x1f */
+#define HESSIAN2_STRING_SHORT   0x30 /* x30-x33 b0 */
+#define HESSIAN2_STRING_SHORT_MAX 0x3ff
+#define HESSIAN2_STRING_CHUNK   0x52 /* 'R' b1 b0: non-final chunk */
+#define HESSIAN2_BINARY_DIRECT  0x20 /* x20-x2f */
+#define HESSIAN2_BINARY_SHORT   0x34 /* x34-x37 b0 */
+#define HESSIAN2_BINARY_CHUNK   0x41 /* 'A' b1 b0: non-final chunk */
+#define HESSIAN2_LIST_VARIABLE  0x55 /* type value* 'Z' */
+#define HESSIAN2_LIST_VARIABLE_UNTYPED 0x57 /* value* 'Z' */
+#define HESSIAN2_LIST_FIXED     0x58 /* int value* */
+#define HESSIAN2_LIST_TYPED_DIRECT 0x70 /* x70-x77 type value* */
+#define HESSIAN2_LIST_DIRECT    0x78 /* x78-x7f value* */
+#define HESSIAN2_LIST_DIRECT_MAX 7
+#define HESSIAN2_OBJECT_DIRECT  0x60 /* x60-x6f value* */
+#define HESSIAN2_OBJECT_DIRECT_MAX 15
+#define HESSIAN2_REF            0x51 /* x51 int */
+
+/**
+ * Object memory: the arena an object was allocated from (NULL for the heap),
+ * and allocation of its members from the same arena. hessian_free() does
+ * nothing for arena memory.
+ */
+arena_t * hessian_getarena(const hessian_object_t * object);
+void * hessian_malloc(arena_t * arena, size_t size);
+char * hessian_strndup(arena_t * arena, const char * str, size_t str_l);
+void hessian_free(arena_t * arena, void * ptr);
+
+/**
+ * Allocates a zeroed object of the type, with its class descriptor set, from
+ * the arena or the heap (typed constructors). Release it with hessian_delete().
+ */
+hessian_object_t * hessian_alloc(arena_t * arena, hessian_t type);
+
+/**
+ * Hessian refs are global to the decoded stream: every map and list (and
+ * Hessian 2.0 object) gets the next index of the reference table when its
+ * deserialization begins. hessian_refs_add() registers the map or list,
+ * hessian_refs_get() resolves a ref in O(1) to the referenced object, which is
+ * then shared, and hessian_deserialize_refs() deserializes a map or list
+ * element, resolving a ref. hessian_reader_getobject() uses its own table.
+ */
+hessian_refs_t * hessian_refs_create(arena_t * arena);
+void hessian_refs_delete(hessian_refs_t * refs);
+int hessian_refs_add(hessian_refs_t * refs, hessian_object_t * object);
+hessian_object_t * hessian_refs_get(hessian_refs_t * refs, int32_t ref_index);
+hessian_object_t * hessian_deserialize_refs(hessian_refs_t * refs, arena_t * arena, int tag, BUFFER * input);
+
+/**
+ * Byte length of the utf8_l first UTF-8 chars of the str_l bytes of str, or
+ * UTF8_TRUNCATED (chunk boundaries of a string to write).
+ */
+size_t utf8_strnpos(const char * str, size_t str_l, size_t utf8_l);
+
+/**
+ * Byte length of the UTF-8 sequence starting with byte.
+ */
+size_t utf8_seqlen(unsigned char byte);
+
+/**
+ * Byte length of the utf8_l UTF-8 chars at the beginning of a buffer_peek()
+ * span, or UTF8_TRUNCATED if the span does not contain them all.
+ */
+#define UTF8_TRUNCATED ((size_t)-1)
+size_t utf8_bytelen(const unsigned char * span, size_t span_l, size_t utf8_l);
+
+/**
+ * Byte length of the utf8_l UTF-8 chars at the read position of the input,
+ * which are not read, or UTF8_TRUNCATED if they are not available in the
+ * first segments.
+ */
+size_t utf8_breadlen(size_t utf8_l, BUFFER * input);
+
+/**
+ * utf8_bgets() returning the byte length of the string, allocated from the
+ * arena or the heap if arena is NULL.
+ */
+char * utf8_bread(arena_t * arena, size_t utf8_l, BUFFER * input, size_t * bytes_l);
+
+/**
+ * Writes the UTF-8 string of str_l bytes and utf8_l chars with the final tag,
+ * split in chunk_tag chunks of HESSIAN_CHUNK_SIZE chars (string and xml
+ * serialization).
+ */
+int hessian_write_utf8(int tag, int chunk_tag, const char * str, size_t str_l, size_t utf8_l, BUFFER * output);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -70,7 +70,6 @@ static hessian_object_t * hessian_integer_ctor (hessian_object_t * object, va_li
 static int hessian_integer_serialize (const hessian_object_t * object, BUFFER * output) {
     const hessian_integer_t * self= object;
     const hessian_class_t * class;
-    int32_t value, b8, b16, b24, b32;
     if (self == NULL) {
 		log_error("hessian_integer_serialize: NULL object pointer.");
     	return HESSIAN_ERROR;
@@ -84,26 +83,21 @@ static int hessian_integer_serialize (const hessian_object_t * object, BUFFER *
 		log_error("hessian_integer_serialize: wrong class type: %d.", class->type);
     	return HESSIAN_ERROR;
     }
-    value= self->value;
-    b32 = (value >> 24) & 0x000000FF;
-    b24 = (value >> 16) & 0x000000FF;
-    b16 = (value >> 8) & 0x000000FF;
-    b8 = value & 0x000000FF;
-    buffer_putc(class->tag,output);
-    buffer_putc(b32,output);
-    buffer_putc(b24,output);
-    buffer_putc(b16,output);
-    buffer_putc(b8,output);
+    if (buffer_putc(class->tag,output) == BUFFER_ERROR
+        || buffer_putbe32((uint32_t)self->value,output) != BUFFER_OK) {
+		log_error("hessian_integer_serialize: can't write int32 to output buffer.");
+    	return HESSIAN_ERROR;
+    }
     return HESSIAN_OK;
 }
 
 /**
  * HessianInt deserialize method.
  */
-static int hessian_integer_deserialize (hessian_object_t * object, int tag, BUFFER * input) {
+static int hessian_integer_deserialize (hessian_object_t * object, int tag, BUFFER * input, hessian_refs_t * refs) {
     hessian_integer_t * self= object;
     const hessian_class_t * class;
-    int32_t value, b8, b16, b24, b32;
+    uint32_t value;
     if (self == NULL) {
 		log_error("hessian_integer_deserialize: NULL object pointer.");
     	return HESSIAN_ERROR;
@@ -124,13 +118,11 @@ static int hessian_integer_deserialize (hessian_object_t * object, int tag, BUFF
     }
 
     /* read int32 */
-    b32 = buffer_getc(input);
-    b24 = buffer_getc(input);
-    b16 = buffer_getc(input);
-    b8 = buffer_getc(input);
-    value= (b32 << 24) + (b24 << 16) + (b16 << 8) + b8;
-
-    self->value= value;
+    if (buffer_getbe32(input,&value) != BUFFER_OK) {
+		log_error("hessian_integer_deserialize: can't read int32 from input buffer.");
+    	return HESSIAN_ERROR;
+    }
+    self->value= (int32_t)value;
     return HESSIAN_OK;
 }
 
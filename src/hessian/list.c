@@ -49,6 +49,19 @@ static const hessian_class_t _hessian_list_descr = {
 const void * hessian_list_class = &_hessian_list_descr;
 
 
+/**
+ * Deletes the list of objects, once per element: an object shared by Hessian
+ * refs is released by each of its owners.
+ */
+static void list_objects_delete(linkedlist_t * objects) {
+    size_t objects_l= llist_length(objects);
+    int i;
+    for (i= 0; i < objects_l; i++) {
+        hessian_delete(llist_get(objects,i));
+    }
+    llist_delete(objects);
+}
+
 /**
  * Hessian list constructor. Creates an empty Hessian untyped list.
  *
@@ -61,7 +74,7 @@ static hessian_object_t * hessian_list_ctor (hessian_object_t * list, va_list *
         return NULL;
     }
     self->type= NULL;
-    self->list= llist_create();
+    self->list= llist_create_arena(hessian_getarena(self));
     if (self->list == NULL) {
         log_error("hessian_list_ctor: can't create list.");
         return NULL;
@@ -80,8 +93,7 @@ static int hessian_list_dtor (hessian_object_t * list) {
         return HESSIAN_ERROR;
     }
     if (self->type != NULL) free(self->type);
-    llist_delete_elements(self->list,(delete_element_func)hessian_delete);
-    llist_delete(self->list);
+    list_objects_delete(self->list);
     return HESSIAN_OK;
 }
 
@@ -181,13 +193,12 @@ static int hessian_list_serialize (const hessian_object_t * list, BUFFER * outpu
 /**
  * Hessian list deserialize method.
  */
-static int hessian_list_deserialize (hessian_object_t * list, int tag, BUFFER * input) {
+static int hessian_list_deserialize (hessian_object_t * list, int tag, BUFFER * input, hessian_refs_t * refs) {
     hessian_list_t * self= list;
     const hessian_class_t * class;
-    linkedlist_t * refs;
-    size_t refs_l;
+    arena_t * arena;
     int32_t length;
-    int next_tag, i;
+    int next_tag;
     if (self == NULL) {
         log_error("hessian_list_deserialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -207,10 +218,15 @@ static int hessian_list_deserialize (hessian_object_t * list, int tag, BUFFER *
         return HESSIAN_ERROR;
     }
     length= -1;
-    /* alloc the refs list for Hessian ref handling */
-    refs= llist_create();
-    if (refs == NULL) {
-        log_error("hessian_list_deserialize: can't create temp references list.");
+    arena= hessian_getarena(self);
+    /* the list is referenced by its index in the stream */
+    if (hessian_refs_add(refs,self) != HESSIAN_OK) {
+        log_error("hessian_list_deserialize: can't add list to references table.");
+        return HESSIAN_ERROR;
+    }
+    self->list= llist_create_arena(arena);
+    if (self->list == NULL) {
+        log_error("hessian_list_deserialize: can't create list.");
         return HESSIAN_ERROR;
     }
     /* begin parsing */
@@ -220,11 +236,11 @@ static int hessian_list_deserialize (hessian_object_t * list, int tag, BUFFER *
         /* read the utf8 type length */
         int b16= buffer_getc(input);
         int b8= buffer_getc(input);
-        size_t utf8_l= (b16 << 8) + b8;
-        char * type= utf8_bgets(utf8_l,input);
+        size_t utf8_l= (b16 << 8) + b8, bytes_l;
+        char * type= utf8_bread(arena,utf8_l,input,&bytes_l);
         if (type == NULL) {
             log_error("hessian_list_deserialize: can't read list type: %d chars.", (int)utf8_l);
-            llist_delete(refs);
+            llist_delete(self->list);
             return HESSIAN_ERROR;
         }
         self->type= type;
@@ -242,64 +258,23 @@ static int hessian_list_deserialize (hessian_object_t * list, int tag, BUFFER *
     }
     /* do until tag != 'z' */
     while( next_tag != class->chunk_tag && next_tag != BUFFER_EOF) {
-        /* standard Hessian object, add to the refs list. */
-        hessian_object_t * o= hessian_deserialize_tag(next_tag,input);
+        /* Hessian object, or the object referenced by a Hessian ref */
+        hessian_object_t * o= hessian_deserialize_refs(refs,arena,next_tag,input);
         if (o == NULL) {
             log_error("hessian_list_deserialize: can't deserialize object with tag: %c.", next_tag);
-            llist_delete_elements(refs,(delete_element_func)hessian_delete);
-            llist_delete(refs);
-            return HESSIAN_ERROR;
-        }
-        if (llist_add(refs,o) != LLIST_OK) {
-            log_error("hessian_list_deserialize: can't add object to temp references list.");
-            hessian_delete(o);
-            llist_delete_elements(refs,(delete_element_func)hessian_delete);
-            llist_delete(refs);
+            hessian_free(arena,self->type);
+            list_objects_delete(self->list);
             return HESSIAN_ERROR;
         }
-        next_tag= buffer_getc(input);
-    }
-
-    /* alloc the objects list and fill with element from the refs lists. */
-    self->list= llist_create();
-    if (self->list == NULL) {
-        log_error("hessian_list_deserialize: can't create list.");
-        llist_delete_elements(refs,(delete_element_func)hessian_delete);
-        llist_delete(refs);
-        return HESSIAN_ERROR;
-    }
-    refs_l= llist_length(refs);
-    for (i= 0; i < refs_l; i++) {
-        hessian_object_t * o= (hessian_object_t *)llist_get(refs,i);
-        if (o == NULL) {
-            log_error("hessian_list_deserialize: NULL object in refs at: %d.",i);
-            llist_delete_elements(refs,(delete_element_func)hessian_delete);
-            llist_delete(refs);
-            return HESSIAN_ERROR;
-        }
-        /* handle the ref object */
-        if (hessian_gettype(o) == HESSIAN_REF) {
-            /* get the ref index */
-            int ref_index= hessian_ref_getvalue(o);
-            hessian_delete(o); /* not needed anymore */
-            /* get the real object */
-            o= (hessian_object_t *)llist_get(refs,ref_index);
-            if (o == NULL) {
-                log_error("hessian_list_deserialize: NULL referenced object in refs at: %d.",ref_index);
-                llist_delete_elements(refs,(delete_element_func)hessian_delete);
-                llist_delete(refs);
-                return HESSIAN_ERROR;
-            }
-        }
         if (llist_add(self->list,o) != LLIST_OK) {
             log_error("hessian_list_deserialize: can't add object to list.");
             hessian_delete(o);
-            llist_delete_elements(refs,(delete_element_func)hessian_delete);
-            llist_delete(refs);
+            hessian_free(arena,self->type);
+            list_objects_delete(self->list);
             return HESSIAN_ERROR;
         }
+        next_tag= buffer_getc(input);
     }
-    llist_delete(refs);
     return HESSIAN_OK;
 }
 
@@ -324,17 +299,16 @@ int hessian_list_settype(hessian_object_t * list, const char * type) {
     }
     /* free if already set */
     if (self->type != NULL) {
-        free(self->type);
+        hessian_free(hessian_getarena(self),self->type);
         self->type= NULL;
     }
     if (type != NULL) {
         size_t type_l= strlen(type);
-        self->type= calloc(type_l + 1, sizeof(char));
+        self->type= hessian_strndup(hessian_getarena(self),type,type_l);
         if (self->type == NULL) {
             log_error("hessian_list_settype: can't allocate type (%d chars).",(int)type_l);
             return HESSIAN_ERROR;
         }
-        strncpy(self->type,type,type_l);
     }
     else {
         self->type= NULL;
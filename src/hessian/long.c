@@ -71,8 +71,6 @@ static hessian_object_t * hessian_long_ctor (hessian_object_t * object, va_list
 static int hessian_long_serialize (const hessian_object_t * object, BUFFER * output) {
     const hessian_long_t * self= object;
     const hessian_class_t * class;
-    int64_t value;
-    int b8, b16, b24, b32, b40, b48, b56, b64;
     if (self == NULL) {
         log_error("hessian_long_serialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -86,34 +84,21 @@ static int hessian_long_serialize (const hessian_object_t * object, BUFFER * out
         log_error("hessian_long_serialize: wrong class type: %d.",class->type);
         return HESSIAN_ERROR;
     }
-    value= self->value;
-    b64 = (value >> 56) & 0x000000FF;
-    b56 = (value >> 48) & 0x000000FF;
-    b48 = (value >> 40) & 0x000000FF;
-    b40 = (value >> 32) & 0x000000FF;
-    b32 = (value >> 24) & 0x000000FF;
-    b24 = (value >> 16) & 0x000000FF;
-    b16 = (value >> 8) & 0x000000FF;
-    b8 = value & 0x000000FF;
-    buffer_putc(class->tag,output);
-    buffer_putc(b64,output);
-    buffer_putc(b56,output);
-    buffer_putc(b48,output);
-    buffer_putc(b40,output);
-    buffer_putc(b32,output);
-    buffer_putc(b24,output);
-    buffer_putc(b16,output);
-    buffer_putc(b8,output);
+    if (buffer_putc(class->tag,output) == BUFFER_ERROR
+        || buffer_putbe64((uint64_t)self->value,output) != BUFFER_OK) {
+        log_error("hessian_long_serialize: can't write int64 to output buffer.");
+        return HESSIAN_ERROR;
+    }
     return HESSIAN_OK;
 }
 
 /**
  * hessian_long deserialize method.
  */
-static int hessian_long_deserialize (hessian_object_t * object, int tag, BUFFER * input) {
+static int hessian_long_deserialize (hessian_object_t * object, int tag, BUFFER * input, hessian_refs_t * refs) {
     hessian_long_t * self= object;
     const hessian_class_t * class;
-    int64_t b8, b16, b24, b32, b40, b48, b56, b64, value;
+    uint64_t value;
     if (self == NULL) {
         log_error("hessian_long_deserialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -131,24 +116,11 @@ static int hessian_long_deserialize (hessian_object_t * object, int tag, BUFFER
         log_error("hessian_long_deserialize: invalid tag: %c (%d).",(char)tag,tag);
         return HESSIAN_ERROR;
     }
-    b64 = buffer_getc(input);
-    b56 = buffer_getc(input);
-    b48 = buffer_getc(input);
-    b40 = buffer_getc(input);
-    b32 = buffer_getc(input);
-    b24 = buffer_getc(input);
-    b16 = buffer_getc(input);
-    b8 = buffer_getc(input);
-    value= (b64 << 56)
-        + (b56 << 48)
-        + (b48 << 40)
-        + (b40 << 32)
-        + (b32 << 24)
-        + (b24 << 16)
-        + (b16 << 8)
-        + b8;
-
-    self->value= value;
+    if (buffer_getbe64(input,&value) != BUFFER_OK) {
+        log_error("hessian_long_deserialize: can't read int64 from input buffer.");
+        return HESSIAN_ERROR;
+    }
+    self->value= (int64_t)value;
     return HESSIAN_OK;
 }
 
@@ -54,8 +54,9 @@ typedef struct map_pair {
     hessian_object_t * value;
 } map_pair_t;
 
-static map_pair_t * map_pair_create(hessian_object_t * key, hessian_object_t * value);
+static map_pair_t * map_pair_create(arena_t * arena, hessian_object_t * key, hessian_object_t * value);
 static void map_pair_delete(map_pair_t * pair);
+static void map_pairs_delete(arena_t * arena, linkedlist_t * pairs);
 
 
 /**
@@ -77,16 +78,15 @@ static hessian_object_t * hessian_map_ctor (hessian_object_t * object, va_list *
         return NULL;
     }
     type_l= strlen(type);
-    self->type= calloc(type_l + 1, sizeof(char));
+    self->type= hessian_strndup(hessian_getarena(self),type,type_l);
     if (self->type == NULL) {
         log_error("hessian_map_ctor: can't allocate type (%d chars).", (int)type_l);
         return NULL;
     }
-    strncpy(self->type,type,type_l);
-    self->map= llist_create();
+    self->map= llist_create_arena(hessian_getarena(self));
     if (self->map == NULL) {
         log_error("hessian_map_ctor: can't create map.");
-        free(self->type);
+        hessian_free(hessian_getarena(self),self->type);
         return NULL;
     }
     return self;
@@ -97,29 +97,11 @@ static hessian_object_t * hessian_map_ctor (hessian_object_t * object, va_list *
  */
 static int hessian_map_dtor (hessian_object_t * object) {
     hessian_map_t * self= object;
-    linkedlist_t * keys_values;
     if (self == NULL) {
         log_error("hessian_map_dtor: NULL object pointer.");
         return HESSIAN_ERROR;
     }
-    /* free map pairs in one single list (references handling) */
-    keys_values= llist_create();
-    if (keys_values == NULL) {
-        log_error("hessian_map_dtor: can't create temp keys_values list.");
-        return HESSIAN_ERROR;
-    }
-    while( llist_length(self->map) > 0 ) {
-        map_pair_t * kv= (map_pair_t *)llist_remove(self->map,0);
-        if (kv != NULL) {
-            llist_add(keys_values,kv->key);
-            llist_add(keys_values,kv->value);
-            free(kv);
-        }
-    }
-    llist_delete_elements(keys_values,(delete_element_func)hessian_delete);
-    llist_delete(keys_values);
-    /* should be empty */
-    llist_delete(self->map);
+    map_pairs_delete(NULL,self->map);
     if (self->type != NULL) free(self->type);
     return HESSIAN_OK;
 }
@@ -131,7 +113,7 @@ static int hessian_map_serialize (const hessian_object_t * object, BUFFER * outp
     const hessian_map_t * self= object;
     const hessian_class_t * class;
     size_t str_l, utf8_l, map_l;
-    int b16, b8, i;
+    int i;
     if (self == NULL) {
         log_error("hessian_map_serialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -150,11 +132,8 @@ static int hessian_map_serialize (const hessian_object_t * object, BUFFER * outp
     if (self->type != NULL) {
         str_l= strlen(self->type);
         utf8_l= utf8_strlen(self->type);
-        b16= utf8_l >> 8;
-        b8= utf8_l & 0x00FF;
         buffer_putc('t',output);
-        buffer_putc(b16,output);
-        buffer_putc(b8,output);
+        buffer_putbe16((uint16_t)utf8_l,output);
         buffer_write(self->type,1,str_l,output);
     }
 
@@ -187,12 +166,11 @@ static int hessian_map_serialize (const hessian_object_t * object, BUFFER * outp
 /**
  * Hessian map deserialize method.
  */
-static int hessian_map_deserialize (hessian_object_t * object, int tag, BUFFER * input) {
+static int hessian_map_deserialize (hessian_object_t * object, int tag, BUFFER * input, hessian_refs_t * refs) {
     hessian_map_t * self= object;
     const hessian_class_t * class;
-    linkedlist_t * refs;
-    size_t refs_l;
-    int next_tag, i;
+    arena_t * arena;
+    int next_tag;
     if (self == NULL) {
         log_error("hessian_map_deserialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -211,10 +189,15 @@ static int hessian_map_deserialize (hessian_object_t * object, int tag, BUFFER *
         log_error("hessian_map_deserialize: invalid tag: %c (%d).",(char)tag,tag);
         return HESSIAN_ERROR;
     }
-    /* alloc the refs list for Hessian ref handling */
-    refs= llist_create();
-    if (refs == NULL) {
-        log_error("hessian_map_deserialize: can't create temp references list.");
+    arena= hessian_getarena(self);
+    /* the map is referenced by its index in the stream */
+    if (hessian_refs_add(refs,self) != HESSIAN_OK) {
+        log_error("hessian_map_deserialize: can't add map to references table.");
+        return HESSIAN_ERROR;
+    }
+    self->map= llist_create_arena(arena);
+    if(self->map == NULL) {
+        log_error("hessian_map_deserialize: can't create map pairs list.");
         return HESSIAN_ERROR;
     }
     /* begin parsing */
@@ -223,14 +206,15 @@ static int hessian_map_deserialize (hessian_object_t * object, int tag, BUFFER *
     self->type= NULL;
     if (next_tag == 't') {
         /* read the utf8 type length */
-        int b16= buffer_getc(input);
-        int b8= buffer_getc(input);
-        size_t utf8_l= (b16 << 8) + b8;
-        /* TODO: handle empty type (0 length) */
-        char * type= utf8_bgets(utf8_l,input);
+        uint16_t utf8_l= 0;
+        size_t bytes_l;
+        char * type= NULL;
+        if (buffer_getbe16(input,&utf8_l) == BUFFER_OK) {
+            type= utf8_bread(arena,utf8_l,input,&bytes_l);
+        }
         if (type == NULL) {
             log_error("hessian_map_deserialize: can't read map type: %d chars.", (int)utf8_l);
-            llist_delete(refs);
+            llist_delete(self->map);
             return HESSIAN_ERROR;
         }
         self->type= type;
@@ -238,89 +222,45 @@ static int hessian_map_deserialize (hessian_object_t * object, int tag, BUFFER *
     }
     /* do until tag != 'z' */
     while( next_tag != class->chunk_tag && next_tag != BUFFER_EOF) {
-        /* standard Hessian object, add to the refs list. */
-        hessian_object_t * key= hessian_deserialize_tag(next_tag,input);
+        /* Hessian objects, or the objects referenced by Hessian refs */
+        hessian_object_t * key= hessian_deserialize_refs(refs,arena,next_tag,input);
         hessian_object_t * value;
         map_pair_t * kv;
         if (key == NULL) {
             log_error("hessian_map_deserialize: can't deserialize map pair<key> with tag: %c.", next_tag);
-            llist_delete_elements(refs,(delete_element_func)map_pair_delete);
-            llist_delete(refs);
+            hessian_free(arena,self->type);
+            map_pairs_delete(arena,self->map);
             return HESSIAN_ERROR;
         }
         next_tag= buffer_getc(input);
-        value= hessian_deserialize_tag(next_tag,input);
+        value= hessian_deserialize_refs(refs,arena,next_tag,input);
         if (value == NULL) {
             log_error("hessian_map_deserialize: can't deserialize map pair<value> with tag: %c.", next_tag);
             hessian_delete(key);
-            llist_delete_elements(refs,(delete_element_func)map_pair_delete);
-            llist_delete(refs);
+            hessian_free(arena,self->type);
+            map_pairs_delete(arena,self->map);
             return HESSIAN_ERROR;
         }
-        kv= map_pair_create(key,value);
+        kv= map_pair_create(arena,key,value);
         if (kv == NULL) {
             log_error("hessian_map_deserialize: can't create map pair<key,value>.");
             hessian_delete(key);
             hessian_delete(value);
-            llist_delete_elements(refs,(delete_element_func)map_pair_delete);
-            llist_delete(refs);
+            hessian_free(arena,self->type);
+            map_pairs_delete(arena,self->map);
             return HESSIAN_ERROR;
         }
-        if (llist_add(refs,kv) != LLIST_OK) {
-            log_error("hessian_map_deserialize: can't add map pair<key,value> to temp references list.");
+        if (llist_add(self->map,kv) != LLIST_OK) {
+            log_error("hessian_map_deserialize: can't add map pair<key,value> to pairs list.");
             hessian_delete(key);
             hessian_delete(value);
-            free(kv);
-            llist_delete_elements(refs,(delete_element_func)map_pair_delete);
-            llist_delete(refs);
+            hessian_free(arena,kv);
+            hessian_free(arena,self->type);
+            map_pairs_delete(arena,self->map);
             return HESSIAN_ERROR;
         }
-
         next_tag= buffer_getc(input);
     }
-    /* alloc the objects list and fill with element from the refs lists. */
-    self->map= llist_create();
-    if(self->map == NULL) {
-        log_error("hessian_map_deserialize: can't create map pairs list.");
-        llist_delete_elements(refs,(delete_element_func)map_pair_delete);
-        llist_delete(refs);
-        return HESSIAN_ERROR;
-    }
-    /* references handling, replace ref object by real referenced object. */
-    refs_l= llist_length(refs);
-    for (i= 0; i < refs_l; i++) {
-        map_pair_t * pair= llist_get(refs,i);
-        if(pair == NULL) {
-            log_error("hessian_map_deserialize: NULL map pair in temp references list at: %d.",i);
-            llist_delete_elements(refs,(delete_element_func)map_pair_delete);
-            llist_delete(refs);
-            return HESSIAN_ERROR;
-        }
-        /* handle the ref value */
-        if (hessian_gettype(pair->value) == HESSIAN_REF) {
-            hessian_object_t * ref= pair->value;
-            /* get the ref index */
-            int ref_index= hessian_ref_getvalue(ref);
-            /* get the real value */
-            map_pair_t * real_pair= llist_get(refs,ref_index);
-            if (real_pair != NULL) {
-                hessian_delete(ref); /* ref object not needed anymore */
-                pair->value= real_pair->value;
-            }
-            else {
-                log_warn("hessian_map_deserialize: ref object at %d reference NULL pair at: %d.",i,ref_index);
-            }
-        }
-        if (llist_add(self->map,pair) != LLIST_OK) {
-            log_error("hessian_map_deserialize: can't add map pair<key,value> to pairs list.");
-            /* delete list content! see dtor... */
-            llist_delete(refs);
-            llist_delete(self->map);
-            return HESSIAN_ERROR;
-        }
-    }
-
-    llist_delete(refs);
     return HESSIAN_OK;
 }
 
@@ -344,14 +284,14 @@ int hessian_map_add(hessian_object_t * object, hessian_object_t * key, hessian_o
         log_error("hessian_map_add: wrong class type: %d.",class->type);
         return HESSIAN_ERROR;
     }
-    pair= map_pair_create(key,value);
+    pair= map_pair_create(hessian_getarena(self),key,value);
     if (pair == NULL) {
         log_error("hessian_map_add: can't create map pair<key,value>.");
         return HESSIAN_ERROR;
     }
     if (llist_add(self->map,pair) != LLIST_OK) {
         log_error("hessian_map_add: can't add map pair<key,value> to list.");
-        free(pair);
+        hessian_free(hessian_getarena(self),pair);
         return HESSIAN_ERROR;
     }
     return HESSIAN_OK;
@@ -378,17 +318,16 @@ int hessian_map_settype(hessian_object_t * object, const char * type) {
     }
     /* free if already set */
     if (self->type != NULL) {
-        free(self->type);
+        hessian_free(hessian_getarena(self),self->type);
         self->type= NULL;
     }
     if (type != NULL) {
         size_t type_l= strlen(type);
-        self->type= calloc(type_l + 1, sizeof(char));
+        self->type= hessian_strndup(hessian_getarena(self),type,type_l);
         if (self->type == NULL) {
             log_error("hessian_map_settype: can't allocate type (%d chars).",(int)type_l);
             return HESSIAN_ERROR;
         }
-        strncpy(self->type,type,type_l);
     }
     else {
         self->type= NULL;
@@ -489,24 +428,25 @@ hessian_object_t * hessian_map_getvalue(const hessian_object_t * object, int ind
 /**
  * Create a map pair<key,value>. If the value is NULL an Hessian null object is added.
  *
+ * @param arena_t * arena the arena of the map, or NULL.
  * @param const hessian_object_t * key not NULL key object.
  * @param const hessian_object_t * value object, can be NULL.
  * @return map_pair_t * pointer to the map pair<key,value> or NULL if an error occurs.
  */
-static map_pair_t * map_pair_create(hessian_object_t * key, hessian_object_t * value) {
-    map_pair_t * pair= calloc(1,sizeof(map_pair_t));
+static map_pair_t * map_pair_create(arena_t * arena, hessian_object_t * key, hessian_object_t * value) {
+    map_pair_t * pair= hessian_malloc(arena,sizeof(map_pair_t));
     if (pair == NULL) {
         log_error("map_pair_create: can't allocate map pair.");
         return NULL;
     }
     if (key == NULL) {
         log_error("map_pair_create: NULL key.");
-        free(pair);
+        hessian_free(arena,pair);
         return NULL;
     }
     pair->key= key;
     if (value == NULL) {
-        pair->value= hessian_create(HESSIAN_NULL);
+        pair->value= hessian_create_arena(arena,HESSIAN_NULL);
     }
     else {
         pair->value= value;
@@ -522,3 +462,19 @@ static void map_pair_delete(map_pair_t * pair) {
     pair= NULL;
 }
 
+/**
+ * Deletes the list of map pairs and, if not allocated from an arena, the pairs.
+ * The keys and values are deleted once per pair: an object shared by Hessian
+ * refs is released by each of its owners.
+ */
+static void map_pairs_delete(arena_t * arena, linkedlist_t * pairs) {
+    size_t pairs_l;
+    int i;
+    if (arena == NULL) {
+        pairs_l= llist_length(pairs);
+        for (i= 0; i < pairs_l; i++) {
+            map_pair_delete(llist_get(pairs,i));
+        }
+    }
+    llist_delete(pairs);
+}
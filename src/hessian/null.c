@@ -64,7 +64,7 @@ static int hessian_null_serialize (const hessian_object_t * object, BUFFER * out
 /**
  * Hessian null deserialize method.
  */
-static int hessian_null_deserialize (hessian_object_t * object, int tag, BUFFER * input) {
+static int hessian_null_deserialize (hessian_object_t * object, int tag, BUFFER * input, hessian_refs_t * refs) {
     const hessian_class_t * class= hessian_getclass(object);
     if (class == NULL) {
         log_error("hessian_null_deserialize: NULL class descriptor.");
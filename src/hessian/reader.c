@@ -0,0 +1,964 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "hessian.h"
+#include "i_hessian.h"
+#include "log.h"
+
+/****************************************************
+ * Hessian pull reader: reads the Hessian 1.0 or    *
+ * 2.0 encoding token by token, without creating    *
+ * the Hessian objects.                             *
+ ****************************************************/
+
+/* initial size of the string buffer */
+#define READER_STRING_SIZE 256
+
+/* maximum nesting of Hessian 2.0 objects, lists and maps */
+#ifndef HESSIAN_READER_DEPTH
+#define HESSIAN_READER_DEPTH 64
+#endif
+
+/* a class definition type, field name or list type */
+typedef struct reader_name {
+    const char * name;
+    size_t name_l;
+} reader_name_t;
+
+/* Hessian 2.0 class definition */
+typedef struct reader_classdef {
+    reader_name_t type;
+    reader_name_t * fields;
+    size_t fields_l;
+} reader_classdef_t;
+
+/* Hessian 2.0 open object, list or map */
+enum { FRAME_OBJECT, FRAME_LIST, FRAME_OPEN };
+typedef struct reader_frame {
+    int kind; /* FRAME_OBJECT, FRAME_LIST (fixed-length) or FRAME_OPEN (ends with 'Z') */
+    const reader_classdef_t * def; /* object class definition */
+    size_t next; /* object: next field, list: elements left */
+    int key; /* object: TRUE if the next token is the field name */
+} reader_frame_t;
+
+struct hessian_reader {
+    arena_t * arena; /* NULL for the heap */
+    BUFFER * input;
+    int version; /* HESSIAN_VERSION_AUTO until the first token */
+    char * string; /* string, xml, binary, type or url of the last token */
+    size_t string_l;
+    size_t string_size;
+    int has_string; /* FALSE for a map or list without type */
+    int64_t value; /* boolean, integer, long, date, ref or list length */
+    double double_value;
+    /* Hessian 2.0 state */
+    arena_t * pool; /* class definitions and types, own arena for the heap */
+    reader_classdef_t * defs;
+    size_t defs_l;
+    size_t defs_size;
+    reader_name_t * types;
+    size_t types_l;
+    size_t types_size;
+    reader_frame_t frames[HESSIAN_READER_DEPTH];
+    size_t frames_l;
+};
+
+hessian_reader_t * hessian_reader_create(BUFFER * input) {
+    return hessian_reader_create_arena(NULL,input);
+}
+
+hessian_reader_t * hessian_reader_create_arena(arena_t * arena, BUFFER * input) {
+    hessian_reader_t * reader= hessian_malloc(arena,sizeof(hessian_reader_t));
+    if (reader == NULL) {
+        log_error("hessian_reader_create: can't allocate reader.");
+        return NULL;
+    }
+    memset(reader,0,sizeof(hessian_reader_t));
+    reader->arena= arena;
+    reader->input= input;
+    reader->version= HESSIAN_VERSION_AUTO;
+    reader->pool= arena;
+    return reader;
+}
+
+void hessian_reader_delete(hessian_reader_t * reader) {
+    if (reader == NULL || reader->arena != NULL) return;
+    arena_delete(reader->pool);
+    free(reader->string);
+    free(reader);
+}
+
+int hessian_reader_setversion(hessian_reader_t * reader, int version) {
+    if (reader == NULL || (version != HESSIAN_VERSION_AUTO && version != HESSIAN_VERSION_1 && version != HESSIAN_VERSION_2)) {
+        log_error("hessian_reader_setversion: NULL reader or invalid version: %d.",version);
+        return HESSIAN_ERROR;
+    }
+    reader->version= version;
+    return HESSIAN_OK;
+}
+
+int hessian_reader_getversion(const hessian_reader_t * reader) {
+    return (reader != NULL) ? reader->version : HESSIAN_VERSION_AUTO;
+}
+
+/**
+ * Ensures the string buffer can hold n more bytes and the '\0'.
+ */
+static int reader_reserve(hessian_reader_t * reader, size_t n) {
+    size_t size;
+    char * string;
+    if (reader->string_l + n < reader->string_size) {
+        return HESSIAN_OK;
+    }
+    size= (reader->string_size > 0) ? reader->string_size : READER_STRING_SIZE;
+    while (size <= reader->string_l + n) {
+        size*= 2;
+    }
+    if (reader->arena != NULL) {
+        string= arena_realloc(reader->arena,reader->string,reader->string_size,size);
+    }
+    else {
+        string= realloc(reader->string,size);
+    }
+    if (string == NULL) {
+        log_error("hessian_reader: can't allocate string buffer (%d bytes).",(int)size);
+        return HESSIAN_ERROR;
+    }
+    reader->string= string;
+    reader->string_size= size;
+    return HESSIAN_OK;
+}
+
+/**
+ * Appends n bytes (utf8 FALSE) or n UTF-8 chars (utf8 TRUE) read from the input
+ * to the string buffer.
+ */
+static int reader_append(hessian_reader_t * reader, size_t n, int utf8) {
+    size_t bytes_l= n, i;
+    if (utf8) {
+        bytes_l= utf8_breadlen(n,reader->input);
+    }
+    if (bytes_l != UTF8_TRUNCATED) {
+        if (reader_reserve(reader,bytes_l) != HESSIAN_OK) {
+            return HESSIAN_ERROR;
+        }
+        if (buffer_read(reader->string + reader->string_l,1,bytes_l,reader->input) != bytes_l) {
+            log_error("hessian_reader: truncated input, %d bytes not available.",(int)bytes_l);
+            return HESSIAN_ERROR;
+        }
+        reader->string_l+= bytes_l;
+        reader->string[reader->string_l]= '\0';
+        return HESSIAN_OK;
+    }
+    /* truncated or too many segments: read char by char */
+    for (i= 0; i < n; i++) {
+        int byte= buffer_getc(reader->input);
+        size_t seq_l;
+        if (byte == BUFFER_EOF) {
+            log_error("hessian_reader: truncated input, %d utf8 chars not available.",(int)n);
+            return HESSIAN_ERROR;
+        }
+        seq_l= utf8_seqlen((unsigned char)byte);
+        if (reader_reserve(reader,seq_l) != HESSIAN_OK) {
+            return HESSIAN_ERROR;
+        }
+        reader->string[reader->string_l++]= (char)byte;
+        while (--seq_l > 0) {
+            byte= buffer_getc(reader->input);
+            if (byte == BUFFER_EOF) {
+                log_error("hessian_reader: truncated input, %d utf8 chars not available.",(int)n);
+                return HESSIAN_ERROR;
+            }
+            reader->string[reader->string_l++]= (char)byte;
+        }
+    }
+    reader->string[reader->string_l]= '\0';
+    return HESSIAN_OK;
+}
+
+/**
+ * Reads the chunks of a string, xml or binary into the string buffer.
+ */
+static int reader_chunks(hessian_reader_t * reader, int tag, int final_tag, int chunk_tag, int utf8) {
+    reader->string_l= 0;
+    reader->has_string= TRUE;
+    if (reader_reserve(reader,0) != HESSIAN_OK) {
+        return HESSIAN_ERROR;
+    }
+    reader->string[0]= '\0';
+    for (;;) {
+        uint16_t chunk_l;
+        if (buffer_getbe16(reader->input,&chunk_l) != BUFFER_OK) {
+            log_error("hessian_reader: truncated input, can't read chunk length.");
+            return HESSIAN_ERROR;
+        }
+        if (reader_append(reader,chunk_l,utf8) != HESSIAN_OK) {
+            return HESSIAN_ERROR;
+        }
+        if (tag == final_tag) {
+            return HESSIAN_OK;
+        }
+        tag= buffer_getc(reader->input);
+        if (tag != final_tag && tag != chunk_tag) {
+            log_error("hessian_reader: invalid chunk tag: %c (%d).",(char)tag,tag);
+            return HESSIAN_ERROR;
+        }
+    }
+}
+
+/**
+ * Reads the optional type of a map or list.
+ */
+static int reader_type(hessian_reader_t * reader) {
+    int tag= buffer_getc(reader->input);
+    reader->has_string= FALSE;
+    if (tag != 't') {
+        if (tag != BUFFER_EOF) buffer_ungetc(tag,reader->input);
+        return HESSIAN_OK;
+    }
+    return reader_chunks(reader,'S','S','s',TRUE);
+}
+
+/****************************************************
+ * Hessian 2.0: compact values, class definitions,  *
+ * objects presented as typed maps with the field   *
+ * names as keys, and fixed-length lists.           *
+ ****************************************************/
+
+/**
+ * Sets the string buffer to the name.
+ */
+static int reader_setstring(hessian_reader_t * reader, const reader_name_t * name) {
+    reader->string_l= 0;
+    if (reader_reserve(reader,name->name_l) != HESSIAN_OK) {
+        return HESSIAN_ERROR;
+    }
+    memcpy(reader->string,name->name,name->name_l);
+    reader->string_l= name->name_l;
+    reader->string[reader->string_l]= '\0';
+    reader->has_string= TRUE;
+    return HESSIAN_OK;
+}
+
+/**
+ * Returns the arena of the class definitions and types, created on first use
+ * for a heap reader.
+ */
+static arena_t * reader_pool(hessian_reader_t * reader) {
+    if (reader->pool == NULL) {
+        reader->pool= arena_create(0);
+        if (reader->pool == NULL) {
+            log_error("hessian_reader: can't create class definitions arena.");
+        }
+    }
+    return reader->pool;
+}
+
+/**
+ * Copies the string buffer to a name allocated from the pool.
+ */
+static int reader_copystring(hessian_reader_t * reader, reader_name_t * name) {
+    char * copy;
+    if (reader_pool(reader) == NULL) {
+        return HESSIAN_ERROR;
+    }
+    copy= arena_alloc(reader->pool,reader->string_l + 1);
+    if (copy == NULL) {
+        log_error("hessian_reader: can't allocate name (%d bytes).",(int)reader->string_l);
+        return HESSIAN_ERROR;
+    }
+    memcpy(copy,reader->string,reader->string_l + 1);
+    name->name= copy;
+    name->name_l= reader->string_l;
+    return HESSIAN_OK;
+}
+
+/**
+ * Grows the array of elem_size elements to hold one more.
+ */
+static void * reader_grow(hessian_reader_t * reader, void * array, size_t * size, size_t length, size_t elem_size) {
+    size_t new_size;
+    void * new_array;
+    if (length < *size) {
+        return array;
+    }
+    if (reader_pool(reader) == NULL) {
+        return NULL;
+    }
+    new_size= (*size > 0) ? *size * 2 : 8;
+    new_array= arena_realloc(reader->pool,array,*size * elem_size,new_size * elem_size);
+    if (new_array == NULL) {
+        log_error("hessian_reader: can't grow table to %d elements.",(int)new_size);
+        return NULL;
+    }
+    *size= new_size;
+    return new_array;
+}
+
+/**
+ * Reads the string (utf8 TRUE) or binary chunks beginning with tag into the
+ * string buffer.
+ */
+static int reader2_chunks(hessian_reader_t * reader, int tag, int utf8) {
+    reader->string_l= 0;
+    reader->has_string= TRUE;
+    if (reader_reserve(reader,0) != HESSIAN_OK) {
+        return HESSIAN_ERROR;
+    }
+    reader->string[0]= '\0';
+    for (;;) {
+        size_t chunk_l;
+        int final= TRUE;
+        if (utf8 && tag >= 0 && tag <= HESSIAN2_STRING_DIRECT_MAX) {
+            chunk_l= tag;
+        }
+        else if (!utf8 && tag >= HESSIAN2_BINARY_DIRECT && tag < HESSIAN2_BINARY_DIRECT + 16) {
+            chunk_l= tag - HESSIAN2_BINARY_DIRECT;
+        }
+        else if ((utf8 && tag >= HESSIAN2_STRING_SHORT && tag < HESSIAN2_STRING_SHORT + 4)
+                 || (!utf8 && tag >= HESSIAN2_BINARY_SHORT && tag < HESSIAN2_BINARY_SHORT + 4)) {
+            int b0= buffer_getc(reader->input);
+            if (b0 == BUFFER_EOF) {
+                log_error("hessian_reader: truncated input, can't read chunk length.");
+                return HESSIAN_ERROR;
+            }
+            chunk_l= ((size_t)(tag - (utf8 ? HESSIAN2_STRING_SHORT : HESSIAN2_BINARY_SHORT)) << 8) + b0;
+        }
+        else if ((utf8 && (tag == 'S' || tag == HESSIAN2_STRING_CHUNK))
+                 || (!utf8 && (tag == 'B' || tag == HESSIAN2_BINARY_CHUNK))) {
+            uint16_t length;
+            if (buffer_getbe16(reader->input,&length) != BUFFER_OK) {
+                log_error("hessian_reader: truncated input, can't read chunk length.");
+                return HESSIAN_ERROR;
+            }
+            chunk_l= length;
+            final= (tag == 'S' || tag == 'B');
+        }
+        else {
+            log_error("hessian_reader: invalid %s chunk tag: 0x%02X.",utf8 ? "string" : "binary",tag);
+            return HESSIAN_ERROR;
+        }
+        if (reader_append(reader,chunk_l,utf8) != HESSIAN_OK) {
+            return HESSIAN_ERROR;
+        }
+        if (final) {
+            return HESSIAN_OK;
+        }
+        tag= buffer_getc(reader->input);
+    }
+}
+
+/**
+ * Returns TRUE if the tag begins a Hessian 2.0 string.
+ */
+static int reader2_isstring(int tag) {
+    return (tag >= 0 && tag <= HESSIAN2_STRING_DIRECT_MAX)
+        || (tag >= HESSIAN2_STRING_SHORT && tag < HESSIAN2_STRING_SHORT + 4)
+        || tag == 'S' || tag == HESSIAN2_STRING_CHUNK;
+}
+
+/**
+ * Reads the Hessian 2.0 int beginning with tag.
+ */
+static int reader2_int(hessian_reader_t * reader, int tag, int32_t * value) {
+    int b1, b0;
+    uint32_t value32;
+    if (tag >= HESSIAN2_INT_DIRECT + HESSIAN2_INT_DIRECT_MIN && tag <= HESSIAN2_INT_DIRECT + HESSIAN2_INT_DIRECT_MAX) {
+        *value= tag - HESSIAN2_INT_DIRECT;
+        return HESSIAN_OK;
+    }
+    if (tag >= HESSIAN2_INT_BYTE - 8 && tag < HESSIAN2_INT_BYTE + 8) {
+        if ((b0= buffer_getc(reader->input)) == BUFFER_EOF) return HESSIAN_ERROR;
+        *value= (tag - HESSIAN2_INT_BYTE) * 256 + b0;
+        return HESSIAN_OK;
+    }
+    if (tag >= HESSIAN2_INT_SHORT - 4 && tag < HESSIAN2_INT_SHORT + 4) {
+        if ((b1= buffer_getc(reader->input)) == BUFFER_EOF) return HESSIAN_ERROR;
+        if ((b0= buffer_getc(reader->input)) == BUFFER_EOF) return HESSIAN_ERROR;
+        *value= (tag - HESSIAN2_INT_SHORT) * 65536 + b1 * 256 + b0;
+        return HESSIAN_OK;
+    }
+    if (tag == 'I' && buffer_getbe32(reader->input,&value32) == BUFFER_OK) {
+        *value= (int32_t)value32;
+        return HESSIAN_OK;
+    }
+    log_error("hessian_reader: can't read int with tag: 0x%02X.",tag);
+    return HESSIAN_ERROR;
+}
+
+/**
+ * Reads the Hessian 2.0 long beginning with tag.
+ */
+static int reader2_long(hessian_reader_t * reader, int tag, int64_t * value) {
+    int b0;
+    uint16_t value16;
+    uint32_t value32;
+    uint64_t value64;
+    if (tag >= HESSIAN2_LONG_DIRECT - 8 && tag < HESSIAN2_LONG_DIRECT + 16) {
+        *value= tag - HESSIAN2_LONG_DIRECT;
+        return HESSIAN_OK;
+    }
+    if (tag >= HESSIAN2_LONG_BYTE - 8 && tag < HESSIAN2_LONG_BYTE + 8) {
+        if ((b0= buffer_getc(reader->input)) == BUFFER_EOF) return HESSIAN_ERROR;
+        *value= (int64_t)(tag - HESSIAN2_LONG_BYTE) * 256 + b0;
+        return HESSIAN_OK;
+    }
+    if (tag >= HESSIAN2_LONG_SHORT - 4 && tag < HESSIAN2_LONG_SHORT + 4) {
+        if (buffer_getbe16(reader->input,&value16) != BUFFER_OK) return HESSIAN_ERROR;
+        *value= (int64_t)(tag - HESSIAN2_LONG_SHORT) * 65536 + value16;
+        return HESSIAN_OK;
+    }
+    if (tag == HESSIAN2_LONG_INT) {
+        if (buffer_getbe32(reader->input,&value32) != BUFFER_OK) return HESSIAN_ERROR;
+        *value= (int32_t)value32;
+        return HESSIAN_OK;
+    }
+    if (tag == 'L') {
+        if (buffer_getbe64(reader->input,&value64) != BUFFER_OK) return HESSIAN_ERROR;
+        *value= (int64_t)value64;
+        return HESSIAN_OK;
+    }
+    return HESSIAN_ERROR;
+}
+
+/**
+ * Reads the Hessian 2.0 double beginning with tag.
+ */
+static int reader2_double(hessian_reader_t * reader, int tag, double * value) {
+    int b0;
+    uint16_t value16;
+    uint32_t value32;
+    uint64_t value64;
+    switch (tag) {
+    case HESSIAN2_DOUBLE_ZERO:
+        *value= 0.0;
+        return HESSIAN_OK;
+    case HESSIAN2_DOUBLE_ONE:
+        *value= 1.0;
+        return HESSIAN_OK;
+    case HESSIAN2_DOUBLE_BYTE:
+        if ((b0= buffer_getc(reader->input)) == BUFFER_EOF) return HESSIAN_ERROR;
+        *value= (int8_t)b0;
+        return HESSIAN_OK;
+    case HESSIAN2_DOUBLE_SHORT:
+        if (buffer_getbe16(reader->input,&value16) != BUFFER_OK) return HESSIAN_ERROR;
+        *value= (int16_t)value16;
+        return HESSIAN_OK;
+    case HESSIAN2_DOUBLE_MILL:
+        if (buffer_getbe32(reader->input,&value32) != BUFFER_OK) return HESSIAN_ERROR;
+        *value= 0.001 * (int32_t)value32;
+        return HESSIAN_OK;
+    case 'D':
+        if (buffer_getbe64(reader->input,&value64) != BUFFER_OK) return HESSIAN_ERROR;
+        memcpy(value,&value64,sizeof(value64));
+        return HESSIAN_OK;
+    default:
+        return HESSIAN_ERROR;
+    }
+}
+
+/**
+ * Reads the type of a list or map: a string, added to the types, or the int
+ * index of a previous type.
+ */
+static int reader2_type(hessian_reader_t * reader) {
+    int tag= buffer_getc(reader->input);
+    int32_t index;
+    if (reader2_isstring(tag)) {
+        if (reader2_chunks(reader,tag,TRUE) != HESSIAN_OK) {
+            return HESSIAN_ERROR;
+        }
+        reader->types= reader_grow(reader,reader->types,&(reader->types_size),reader->types_l,sizeof(reader_name_t));
+        if (reader->types == NULL) {
+            return HESSIAN_ERROR;
+        }
+        return reader_copystring(reader,&(reader->types[reader->types_l++]));
+    }
+    if (reader2_int(reader,tag,&index) != HESSIAN_OK) {
+        return HESSIAN_ERROR;
+    }
+    if (index < 0 || (size_t)index >= reader->types_l) {
+        log_error("hessian_reader: invalid type ref: %d.",(int)index);
+        return HESSIAN_ERROR;
+    }
+    return reader_setstring(reader,&(reader->types[index]));
+}
+
+/**
+ * Reads a class definition, after the 'C' tag.
+ */
+static int reader2_classdef(hessian_reader_t * reader) {
+    reader_classdef_t * def;
+    int32_t fields_l, i;
+    reader->defs= reader_grow(reader,reader->defs,&(reader->defs_size),reader->defs_l,sizeof(reader_classdef_t));
+    if (reader->defs == NULL) {
+        return HESSIAN_ERROR;
+    }
+    def= &(reader->defs[reader->defs_l]);
+    if (reader2_chunks(reader,buffer_getc(reader->input),TRUE) != HESSIAN_OK
+        || reader_copystring(reader,&(def->type)) != HESSIAN_OK
+        || reader2_int(reader,buffer_getc(reader->input),&fields_l) != HESSIAN_OK) {
+        log_error("hessian_reader: can't read class definition.");
+        return HESSIAN_ERROR;
+    }
+    if (fields_l < 0 || fields_l > HESSIAN_CHUNK_SIZE) {
+        log_error("hessian_reader: invalid number of fields: %d in class definition: %s.",(int)fields_l,def->type.name);
+        return HESSIAN_ERROR;
+    }
+    def->fields= arena_alloc(reader->pool,(fields_l > 0 ? fields_l : 1) * sizeof(reader_name_t));
+    if (def->fields == NULL) {
+        log_error("hessian_reader: can't allocate %d fields of class definition: %s.",(int)fields_l,def->type.name);
+        return HESSIAN_ERROR;
+    }
+    def->fields_l= fields_l;
+    for (i= 0; i < fields_l; i++) {
+        if (reader2_chunks(reader,buffer_getc(reader->input),TRUE) != HESSIAN_OK
+            || reader_copystring(reader,&(def->fields[i])) != HESSIAN_OK) {
+            log_error("hessian_reader: can't read field %d of class definition: %s.",(int)i,def->type.name);
+            return HESSIAN_ERROR;
+        }
+    }
+    reader->defs_l++;
+    return HESSIAN_OK;
+}
+
+/**
+ * Opens an object, list or map frame.
+ */
+static int reader2_push(hessian_reader_t * reader, int kind, const reader_classdef_t * def, size_t next) {
+    reader_frame_t * frame;
+    if (reader->frames_l >= HESSIAN_READER_DEPTH) {
+        log_error("hessian_reader: objects, lists and maps nested deeper than %d.",HESSIAN_READER_DEPTH);
+        return HESSIAN_ERROR;
+    }
+    frame= &(reader->frames[reader->frames_l++]);
+    frame->kind= kind;
+    frame->def= def;
+    frame->next= next;
+    frame->key= TRUE;
+    return HESSIAN_OK;
+}
+
+/**
+ * Reads a list, with the optional type and length.
+ */
+static hessian_t reader2_list(hessian_reader_t * reader, int tag) {
+    int32_t length= -1;
+    int typed= (tag == HESSIAN2_LIST_VARIABLE || tag == 'V'
+                || (tag >= HESSIAN2_LIST_TYPED_DIRECT && tag < HESSIAN2_LIST_DIRECT));
+    if (typed && reader2_type(reader) != HESSIAN_OK) {
+        return HESSIAN_UNKNOWN;
+    }
+    if (tag == 'V' || tag == HESSIAN2_LIST_FIXED) {
+        if (reader2_int(reader,buffer_getc(reader->input),&length) != HESSIAN_OK || length < 0) {
+            log_error("hessian_reader: can't read list length.");
+            return HESSIAN_UNKNOWN;
+        }
+    }
+    else if (tag >= HESSIAN2_LIST_TYPED_DIRECT && tag < HESSIAN2_LIST_DIRECT) {
+        length= tag - HESSIAN2_LIST_TYPED_DIRECT;
+    }
+    else if (tag >= HESSIAN2_LIST_DIRECT && tag <= HESSIAN2_LIST_DIRECT + HESSIAN2_LIST_DIRECT_MAX) {
+        length= tag - HESSIAN2_LIST_DIRECT;
+    }
+    if (reader2_push(reader,(length < 0) ? FRAME_OPEN : FRAME_LIST,NULL,(length < 0) ? 0 : length) != HESSIAN_OK) {
+        return HESSIAN_UNKNOWN;
+    }
+    reader->value= length;
+    return HESSIAN_LIST;
+}
+
+/**
+ * Reads the next Hessian 2.0 token.
+ */
+static hessian_t reader2_next(hessian_reader_t * reader) {
+    reader_frame_t * frame= (reader->frames_l > 0) ? &(reader->frames[reader->frames_l - 1]) : NULL;
+    int tag;
+    int32_t index;
+    reader->has_string= FALSE;
+    if (frame != NULL && frame->kind == FRAME_OBJECT) {
+        if (frame->key) {
+            /* field name, or end of object */
+            if (frame->next == frame->def->fields_l) {
+                reader->frames_l--;
+                return HESSIAN_END;
+            }
+            frame->key= FALSE;
+            if (reader_setstring(reader,&(frame->def->fields[frame->next])) != HESSIAN_OK) {
+                return HESSIAN_UNKNOWN;
+            }
+            return HESSIAN_STRING;
+        }
+        frame->key= TRUE;
+        frame->next++;
+    }
+    else if (frame != NULL && frame->kind == FRAME_LIST) {
+        if (frame->next == 0) {
+            reader->frames_l--;
+            return HESSIAN_END;
+        }
+        frame->next--;
+    }
+    tag= buffer_getc(reader->input);
+    while (tag == 'C') {
+        if (reader2_classdef(reader) != HESSIAN_OK) {
+            return HESSIAN_UNKNOWN;
+        }
+        tag= buffer_getc(reader->input);
+    }
+    if (tag == BUFFER_EOF) {
+        log_error("hessian_reader_next: unexpected end of input.");
+        return HESSIAN_UNKNOWN;
+    }
+    if (reader2_isstring(tag)) {
+        return (reader2_chunks(reader,tag,TRUE) == HESSIAN_OK) ? HESSIAN_STRING : HESSIAN_UNKNOWN;
+    }
+    if ((tag >= HESSIAN2_BINARY_DIRECT && tag <= 0x2f) || (tag >= HESSIAN2_BINARY_SHORT && tag <= 0x37)
+        || tag == 'B' || tag == HESSIAN2_BINARY_CHUNK) {
+        return (reader2_chunks(reader,tag,FALSE) == HESSIAN_OK) ? HESSIAN_BINARY : HESSIAN_UNKNOWN;
+    }
+    if ((tag >= 0x80 && tag <= 0xd7) || tag == 'I') {
+        if (reader2_int(reader,tag,&index) != HESSIAN_OK) return HESSIAN_UNKNOWN;
+        reader->value= index;
+        return HESSIAN_INTEGER;
+    }
+    if (tag >= 0xd8 || (tag >= 0x38 && tag <= 0x3f) || tag == HESSIAN2_LONG_INT || tag == 'L') {
+        if (reader2_long(reader,tag,&(reader->value)) != HESSIAN_OK) {
+            log_error("hessian_reader_next: can't read long with tag: 0x%02X.",tag);
+            return HESSIAN_UNKNOWN;
+        }
+        return HESSIAN_LONG;
+    }
+    if ((tag >= HESSIAN2_DOUBLE_ZERO && tag <= HESSIAN2_DOUBLE_MILL) || tag == 'D') {
+        if (reader2_double(reader,tag,&(reader->double_value)) != HESSIAN_OK) {
+            log_error("hessian_reader_next: can't read double with tag: 0x%02X.",tag);
+            return HESSIAN_UNKNOWN;
+        }
+        return HESSIAN_DOUBLE;
+    }
+    if (tag >= HESSIAN2_OBJECT_DIRECT && tag <= HESSIAN2_OBJECT_DIRECT + HESSIAN2_OBJECT_DIRECT_MAX) {
+        index= tag - HESSIAN2_OBJECT_DIRECT;
+        tag= 'O';
+    }
+    else if (tag == 'O' && reader2_int(reader,buffer_getc(reader->input),&index) != HESSIAN_OK) {
+        return HESSIAN_UNKNOWN;
+    }
+    if ((tag >= HESSIAN2_LIST_TYPED_DIRECT && tag <= HESSIAN2_LIST_DIRECT + HESSIAN2_LIST_DIRECT_MAX)
+        || tag == HESSIAN2_LIST_VARIABLE || tag == 'V' || tag == HESSIAN2_LIST_VARIABLE_UNTYPED || tag == HESSIAN2_LIST_FIXED) {
+        return reader2_list(reader,tag);
+    }
+    switch (tag) {
+    case 'Z':
+        if (frame == NULL || frame->kind != FRAME_OPEN) {
+            log_error("hessian_reader_next: unexpected end of list or map.");
+            return HESSIAN_UNKNOWN;
+        }
+        reader->frames_l--;
+        return HESSIAN_END;
+    case 'N':
+        return HESSIAN_NULL;
+    case 'T':
+    case 'F':
+        reader->value= (tag == 'T');
+        return HESSIAN_BOOLEAN;
+    case HESSIAN2_DATE_MILLIS:
+        if (reader2_long(reader,'L',&(reader->value)) != HESSIAN_OK) break;
+        return HESSIAN_DATE;
+    case HESSIAN2_DATE_MINUTES:
+        if (reader2_int(reader,'I',&index) != HESSIAN_OK) break;
+        reader->value= (int64_t)index * 60000;
+        return HESSIAN_DATE;
+    case HESSIAN2_REF:
+        if (reader2_int(reader,buffer_getc(reader->input),&index) != HESSIAN_OK) break;
+        reader->value= index;
+        return HESSIAN_REF;
+    case 'M':
+    case 'H':
+        if (tag == 'M' && reader2_type(reader) != HESSIAN_OK) break;
+        if (reader2_push(reader,FRAME_OPEN,NULL,0) != HESSIAN_OK) break;
+        return HESSIAN_MAP;
+    case 'O':
+        if (index < 0 || (size_t)index >= reader->defs_l) {
+            log_error("hessian_reader_next: undefined class definition: %d.",(int)index);
+            return HESSIAN_UNKNOWN;
+        }
+        if (reader_setstring(reader,&(reader->defs[index].type)) != HESSIAN_OK
+            || reader2_push(reader,FRAME_OBJECT,&(reader->defs[index]),0) != HESSIAN_OK) break;
+        return HESSIAN_MAP;
+    default:
+        log_error("hessian_reader_next: unknown Hessian 2.0 tag: 0x%02X.",tag);
+        return HESSIAN_UNKNOWN;
+    }
+    log_error("hessian_reader_next: can't read value with tag: 0x%02X.",tag);
+    return HESSIAN_UNKNOWN;
+}
+
+hessian_t hessian_reader_next(hessian_reader_t * reader) {
+    int tag;
+    uint32_t value32;
+    uint64_t value64;
+    if (reader == NULL || reader->input == NULL) {
+        log_error("hessian_reader_next: NULL reader or input buffer.");
+        return HESSIAN_UNKNOWN;
+    }
+    if (reader->version == HESSIAN_VERSION_AUTO) {
+        /* a Hessian 2.0 stream begins with a class definition or an untyped map */
+        tag= buffer_getc(reader->input);
+        reader->version= (tag == 'C' || tag == 'H') ? HESSIAN_VERSION_2 : HESSIAN_VERSION_1;
+        if (tag != BUFFER_EOF) buffer_ungetc(tag,reader->input);
+    }
+    if (reader->version == HESSIAN_VERSION_2) {
+        return reader2_next(reader);
+    }
+    reader->has_string= FALSE;
+    tag= buffer_getc(reader->input);
+    switch (tag) {
+    case 'z':
+        return HESSIAN_END;
+    case 'N':
+        return HESSIAN_NULL;
+    case 'T':
+    case 'F':
+        reader->value= (tag == 'T');
+        return HESSIAN_BOOLEAN;
+    case 'I':
+    case 'R':
+        if (buffer_getbe32(reader->input,&value32) != BUFFER_OK) break;
+        reader->value= (int32_t)value32;
+        return (tag == 'I') ? HESSIAN_INTEGER : HESSIAN_REF;
+    case 'L':
+    case 'd':
+        if (buffer_getbe64(reader->input,&value64) != BUFFER_OK) break;
+        reader->value= (int64_t)value64;
+        return (tag == 'L') ? HESSIAN_LONG : HESSIAN_DATE;
+    case 'D':
+        if (buffer_getbe64(reader->input,&value64) != BUFFER_OK) break;
+        memcpy(&(reader->double_value),&value64,sizeof(value64));
+        return HESSIAN_DOUBLE;
+    case 'S':
+    case 's':
+        if (reader_chunks(reader,tag,'S','s',TRUE) != HESSIAN_OK) break;
+        return HESSIAN_STRING;
+    case 'X':
+    case 'x':
+        if (reader_chunks(reader,tag,'X','x',TRUE) != HESSIAN_OK) break;
+        return HESSIAN_XML;
+    case 'B':
+    case 'b':
+        if (reader_chunks(reader,tag,'B','b',FALSE) != HESSIAN_OK) break;
+        return HESSIAN_BINARY;
+    case 'M':
+        if (reader_type(reader) != HESSIAN_OK) break;
+        return HESSIAN_MAP;
+    case 'V':
+        if (reader_type(reader) != HESSIAN_OK) break;
+        /* optional length */
+        reader->value= -1;
+        tag= buffer_getc(reader->input);
+        if (tag == 'l') {
+            if (buffer_getbe32(reader->input,&value32) != BUFFER_OK) break;
+            reader->value= (int32_t)value32;
+        }
+        else if (tag != BUFFER_EOF) {
+            buffer_ungetc(tag,reader->input);
+        }
+        return HESSIAN_LIST;
+    case 'r':
+        /* remote: the type is skipped, the url is the string */
+        if (buffer_getc(reader->input) != 't'
+            || reader_chunks(reader,'S','S','s',TRUE) != HESSIAN_OK
+            || buffer_getc(reader->input) != 'S'
+            || reader_chunks(reader,'S','S','s',TRUE) != HESSIAN_OK) break;
+        return HESSIAN_REMOTE;
+    case BUFFER_EOF:
+        log_error("hessian_reader_next: unexpected end of input.");
+        return HESSIAN_UNKNOWN;
+    default:
+        log_error("hessian_reader_next: unknown tag: %c (0x%0X).",tag,tag);
+        return HESSIAN_UNKNOWN;
+    }
+    log_error("hessian_reader_next: can't read value with tag: %c.",tag);
+    return HESSIAN_UNKNOWN;
+}
+
+int hessian_reader_skip(hessian_reader_t * reader) {
+    int depth= 1;
+    while (depth > 0) {
+        switch (hessian_reader_next(reader)) {
+        case HESSIAN_MAP:
+        case HESSIAN_LIST:
+            depth++;
+            break;
+        case HESSIAN_END:
+            depth--;
+            break;
+        case HESSIAN_UNKNOWN:
+            log_error("hessian_reader_skip: can't skip list or map content.");
+            return HESSIAN_ERROR;
+        default:
+            break;
+        }
+    }
+    return HESSIAN_OK;
+}
+
+const char * hessian_reader_getstring(const hessian_reader_t * reader, size_t * length) {
+    if (reader == NULL || !reader->has_string) {
+        if (length != NULL) *length= 0;
+        return NULL;
+    }
+    if (length != NULL) *length= reader->string_l;
+    return reader->string;
+}
+
+int32_t hessian_reader_getinteger(const hessian_reader_t * reader) {
+    return (reader != NULL) ? (int32_t)reader->value : 0;
+}
+
+int64_t hessian_reader_getlong(const hessian_reader_t * reader) {
+    return (reader != NULL) ? reader->value : 0;
+}
+
+double hessian_reader_getdouble(const hessian_reader_t * reader) {
+    return (reader != NULL) ? reader->double_value : 0;
+}
+
+/**
+ * Reads the map or list content to its end into the container, registered in
+ * refs before its elements.
+ */
+static int reader_content(hessian_reader_t * reader, hessian_refs_t * refs, hessian_object_t * container);
+
+/**
+ * Creates the Hessian object of the token of the type, reading the content of
+ * a map or list. A ref is resolved to the referenced map or list.
+ */
+static hessian_object_t * reader_object(hessian_reader_t * reader, hessian_refs_t * refs, hessian_t type) {
+    arena_t * arena= reader->arena;
+    hessian_object_t * object= NULL;
+    const char * string;
+    size_t string_l;
+    switch (type) {
+    case HESSIAN_NULL:
+        object= hessian_create_arena(arena,HESSIAN_NULL);
+        break;
+    case HESSIAN_BOOLEAN:
+        object= hessian_create_arena(arena,HESSIAN_BOOLEAN,(int)reader->value);
+        break;
+    case HESSIAN_INTEGER:
+        object= hessian_create_arena(arena,HESSIAN_INTEGER,(int32_t)reader->value);
+        break;
+    case HESSIAN_LONG:
+    case HESSIAN_DATE:
+        object= hessian_create_arena(arena,type,reader->value);
+        break;
+    case HESSIAN_DOUBLE:
+        object= hessian_create_arena(arena,HESSIAN_DOUBLE,reader->double_value);
+        break;
+    case HESSIAN_STRING:
+    case HESSIAN_XML:
+        object= hessian_create_arena(arena,type,reader->string);
+        break;
+    case HESSIAN_BINARY:
+        object= hessian_create_arena(arena,HESSIAN_BINARY,reader->string_l,reader->string);
+        break;
+    case HESSIAN_REF:
+        return hessian_refs_get(refs,(int32_t)reader->value);
+    case HESSIAN_MAP:
+    case HESSIAN_LIST:
+        string= hessian_reader_getstring(reader,&string_l);
+        if (type == HESSIAN_MAP) {
+            /* the map constructor requires a type */
+            object= hessian_create_arena(arena,HESSIAN_MAP,"");
+            if (object != NULL && hessian_map_settype(object,string) != HESSIAN_OK) {
+                hessian_delete(object);
+                return NULL;
+            }
+        }
+        else {
+            object= hessian_create_arena(arena,HESSIAN_LIST);
+            if (object != NULL && string != NULL && hessian_list_settype(object,string) != HESSIAN_OK) {
+                hessian_delete(object);
+                return NULL;
+            }
+        }
+        if (object != NULL && reader_content(reader,refs,object) != HESSIAN_OK) {
+            hessian_delete(object);
+            return NULL;
+        }
+        return object;
+    case HESSIAN_REMOTE:
+        log_error("hessian_reader_getobject: remote object not supported.");
+        return NULL;
+    default:
+        log_error("hessian_reader_getobject: unexpected token: %d.",(int)type);
+        return NULL;
+    }
+    if (object == NULL) {
+        log_error("hessian_reader_getobject: can't create object of type: %d.",(int)type);
+    }
+    return object;
+}
+
+static int reader_content(hessian_reader_t * reader, hessian_refs_t * refs, hessian_object_t * container) {
+    int map= (hessian_gettype(container) == HESSIAN_MAP);
+    hessian_t type;
+    if (hessian_refs_add(refs,container) != HESSIAN_OK) {
+        return HESSIAN_ERROR;
+    }
+    while ((type= hessian_reader_next(reader)) != HESSIAN_END) {
+        hessian_object_t * key= NULL;
+        hessian_object_t * value;
+        if (map) {
+            key= reader_object(reader,refs,type);
+            if (key == NULL) {
+                return HESSIAN_ERROR;
+            }
+            type= hessian_reader_next(reader);
+        }
+        value= reader_object(reader,refs,type);
+        if (value == NULL
+            || (map && hessian_map_add(container,key,value) != HESSIAN_OK)
+            || (!map && hessian_list_add(container,value) != HESSIAN_OK)) {
+            log_error("hessian_reader_getobject: can't read %s element.",map ? "map" : "list");
+            hessian_delete(key);
+            hessian_delete(value);
+            return HESSIAN_ERROR;
+        }
+    }
+    return HESSIAN_OK;
+}
+
+hessian_object_t * hessian_reader_getobject(hessian_reader_t * reader, hessian_t type) {
+    hessian_refs_t * refs;
+    hessian_object_t * object;
+    if (reader == NULL || reader->input == NULL) {
+        log_error("hessian_reader_getobject: NULL reader or input buffer.");
+        return NULL;
+    }
+    refs= hessian_refs_create(reader->arena);
+    if (refs == NULL) {
+        return NULL;
+    }
+    object= reader_object(reader,refs,type);
+    hessian_refs_delete(refs);
+    return object;
+}
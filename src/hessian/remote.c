@@ -70,20 +70,18 @@ static hessian_object_t * hessian_remote_ctor (hessian_object_t * object, va_lis
         return NULL;
     }
     type_l= strlen(type);
-    self->type= calloc(type_l + 1, sizeof(char));
+    self->type= hessian_strndup(hessian_getarena(self),type,type_l);
     if (self->type == NULL) {
         log_error("hessian_remote_ctor: can't allocate type (%d chars).", (int)type_l);
         return NULL;
     }
-    strncpy(self->type,type,type_l);
     url_l= strlen(url);
-    self->url= calloc(url_l + 1, sizeof(char));
-    if (self->type == NULL) {
+    self->url= hessian_strndup(hessian_getarena(self),url,url_l);
+    if (self->url == NULL) {
         log_error("hessian_remote_ctor: can't allocate url (%d chars).", (int)url_l);
-        free(self->type);
+        hessian_free(hessian_getarena(self),self->type);
         return NULL;
     }
-    strncpy(self->url,url,url_l);
     return self;
 }
 
@@ -151,11 +149,11 @@ static int hessian_remote_serialize (const hessian_object_t * object, BUFFER * o
 /**
  * hessian_remote deserialize method.
  */
-static int hessian_remote_deserialize (hessian_object_t * object, int tag, BUFFER * input) {
+static int hessian_remote_deserialize (hessian_object_t * object, int tag, BUFFER * input, hessian_refs_t * refs) {
     hessian_remote_t * self= object;
     const hessian_class_t * class;
     int b8, b16, type_tag, url_tag;
-    size_t utf8_l;
+    size_t utf8_l, bytes_l;
     char * type, * url;
     if (self == NULL) {
         log_error("hessian_remote_deserialize: NULL object pointer.");
@@ -185,7 +183,7 @@ static int hessian_remote_deserialize (hessian_object_t * object, int tag, BUFFE
     b16= buffer_getc(input);
     b8= buffer_getc(input);
     utf8_l= (b16 << 8) + b8;
-    type= utf8_bgets(utf8_l,input);
+    type= utf8_bread(hessian_getarena(self),utf8_l,input,&bytes_l);
     self->type= type;
     url_tag= buffer_getc(input);
     if (url_tag != 'S') {
@@ -196,7 +194,7 @@ static int hessian_remote_deserialize (hessian_object_t * object, int tag, BUFFE
     b16= buffer_getc(input);
     b8= buffer_getc(input);
     utf8_l= (b16 << 8) + b8;
-    url= utf8_bgets(utf8_l,input);
+    url= utf8_bread(hessian_getarena(self),utf8_l,input,&bytes_l);
     self->url= url;
     return HESSIAN_OK;
 }
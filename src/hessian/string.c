@@ -35,6 +35,9 @@ static OBJECT_DTOR(hessian_string);
 static OBJECT_SERIALIZE(hessian_string);
 static OBJECT_DESERIALIZE(hessian_string);
 
+static char * utf8_bappend(arena_t * arena, char * utf8, size_t * bytes_l, size_t utf8_l, BUFFER * input);
+static int hessian_string_set(hessian_string_t * self, const char * str, size_t str_l, int borrowed);
+
 
 /**
  * Initializes and registers the string class.
@@ -69,15 +72,72 @@ static hessian_object_t * hessian_string_ctor (hessian_object_t * object, va_lis
         return NULL;
     }
     str_l= strlen(str);
-    self->string= calloc(str_l + 1,sizeof(char));
-    if (self->string == NULL) {
+    if (hessian_string_set(self,str,str_l,FALSE) != HESSIAN_OK) {
         log_error("hessian_string_ctor: can't allocate string (%d chars).",(int)str_l);
         return NULL;
     }
-    strncpy(self->string,str,str_l);
     return self;
 }
 
+/**
+ * Sets the string of str_l bytes: borrowed, copied inline if short, or else
+ * copied in an allocated string.
+ */
+static int hessian_string_set(hessian_string_t * self, const char * str, size_t str_l, int borrowed) {
+    if (borrowed) {
+        self->string= (char *)str;
+    }
+    else if (str_l < HESSIAN_STRING_INLINE_SIZE) {
+        memcpy(self->inline_string,str,str_l);
+        self->inline_string[str_l]= '\0';
+        self->string= self->inline_string;
+    }
+    else {
+        self->string= hessian_strndup(hessian_getarena(self),str,str_l);
+        if (self->string == NULL) {
+            return HESSIAN_ERROR;
+        }
+    }
+    self->borrowed= borrowed;
+    self->string_l= str_l;
+    self->utf8_l= utf8_strnlen(str,str_l);
+    return HESSIAN_OK;
+}
+
+/**
+ * Creates the Hessian string of str_l bytes, from the arena or the heap.
+ */
+static hessian_object_t * hessian_string_create_from(arena_t * arena, const char * str, size_t str_l, int borrowed) {
+    hessian_object_t * object;
+    if (str == NULL) {
+        log_error("hessian_string_create: NULL string.");
+        return NULL;
+    }
+    object= hessian_alloc(arena,HESSIAN_STRING);
+    if (object == NULL) {
+        log_error("hessian_string_create: can't allocate object.");
+        return NULL;
+    }
+    if (hessian_string_set(object,str,str_l,borrowed) != HESSIAN_OK) {
+        log_error("hessian_string_create: can't allocate string (%d chars).",(int)str_l);
+        hessian_delete(object);
+        return NULL;
+    }
+    return object;
+}
+
+hessian_object_t * hessian_string_create(const char * str, size_t str_l) {
+    return hessian_string_create_from(NULL,str,str_l,FALSE);
+}
+
+hessian_object_t * hessian_string_create_arena(arena_t * arena, const char * str, size_t str_l) {
+    return hessian_string_create_from(arena,str,str_l,FALSE);
+}
+
+hessian_object_t * hessian_string_create_static(const char * str, size_t str_l) {
+    return hessian_string_create_from(NULL,str,str_l,TRUE);
+}
+
 /**
  * string destructor.
  */
@@ -87,7 +147,8 @@ static int hessian_string_dtor (hessian_object_t * object) {
         log_error("hessian_string_dtor: NULL object pointer.");
         return HESSIAN_ERROR;
     }
-    if (self->string != NULL) {
+    /* inline and borrowed strings are not allocated */
+    if (self->string != NULL && self->string != self->inline_string && !self->borrowed) {
         free(self->string);
     }
     self->string= NULL;
@@ -100,9 +161,6 @@ static int hessian_string_dtor (hessian_object_t * object) {
 static int hessian_string_serialize (const hessian_object_t * object, BUFFER * output) {
     const hessian_string_t * self= object;
     const hessian_class_t * class;
-    size_t str_l, utf8_l, pos;
-    const char * chunk, * rest;
-    int b8, b16;
     if (self == NULL) {
         log_error("hessian_string_serialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -116,57 +174,16 @@ static int hessian_string_serialize (const hessian_object_t * object, BUFFER * o
         log_error("hessian_string_serialize: wrong class type: %d.",class->type);
         return HESSIAN_ERROR;
     }
-    str_l= strlen(self->string); /* effective chars (bytes) */
-    utf8_l= utf8_strlen(self->string);
-    pos= 0;
-    /* WARN: number of chars != number of bytes (multi-byte utf8) */
-    while (utf8_l > HESSIAN_CHUNK_SIZE) {
-        size_t start_pos;
-        int n_utf8s;
-        /* send utf8 chunks */
-        b16= (HESSIAN_CHUNK_SIZE >> 8) & 0x00FF;
-        b8= HESSIAN_CHUNK_SIZE & 0x00FF;
-        buffer_putc(class->chunk_tag,output);
-        buffer_putc(b16,output);
-        buffer_putc(b8,output);
-        /* write HESSIAN_CHUNK_SIZE utf8 chars */
-        chunk= &(self->string[pos]);
-        /* number of effective bytes */
-        start_pos= pos;
-        n_utf8s= 0;
-        while( n_utf8s < HESSIAN_CHUNK_SIZE ) {
-            int byte= self->string[pos++];
-            if ((byte & 0xC0) != 0x80) {
-                n_utf8s++;
-                if ((byte & 0xE0) == 0xC0) pos++; /* start of the 2-byte seq. */
-                else if ((byte & 0xF0) == 0xE0) pos+= 2; /* start of the 3-byte seq. */
-                else if ((byte & 0xF0) == 0xF0) pos+= 3; /* start of the 4-byte seq. */
-            }
-        }
-        buffer_write(chunk,1,(pos - start_pos),output);
-        utf8_l= utf8_l - HESSIAN_CHUNK_SIZE;
-    }
-
-    b16= utf8_l >> 8;
-    b8= utf8_l & 0x00FF;
-    buffer_putc(class->tag,output);
-    buffer_putc(b16,output);
-    buffer_putc(b8,output);
-    rest= &(self->string[pos]);
-    buffer_write(rest,1,(str_l - pos),output);
-
-    return HESSIAN_OK;
+    return hessian_write_utf8(class->tag,class->chunk_tag,self->string,self->string_l,self->utf8_l,output);
 }
 
 /**
  * Hessian string deserialize method.
  */
-static int hessian_string_deserialize (hessian_object_t * object, int tag, BUFFER * input) {
+static int hessian_string_deserialize (hessian_object_t * object, int tag, BUFFER * input, hessian_refs_t * refs) {
     hessian_string_t * self= object;
     const hessian_class_t * class;
-    BUFFER * sb;
-    size_t sb_size, sb_l;
-    int fully_read;
+    arena_t * arena;
     if (self == NULL) {
         log_error("hessian_string_deserialize: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -185,46 +202,48 @@ static int hessian_string_deserialize (hessian_object_t * object, int tag, BUFFE
         log_error("hessian_string_deserialize: invalid tag: %c (%d).",(char)tag,tag);
         return HESSIAN_ERROR;
     }
-    /* use a string buffer as tmp */
-    sb_size= 32;
-    if (tag == class->chunk_tag) sb_size= HESSIAN_CHUNK_SIZE;
-    sb= buffer_create(sb_size);
-    if (sb == NULL) {
-        log_error("hessian_string_deserialize: can't create temp buffer (%d bytes).",(int)sb_size);
-        return HESSIAN_ERROR;
-    }
-    fully_read= FALSE;
-    while (!fully_read) {
+    /* the chunks are appended to the string, directly from the input buffer */
+    arena= hessian_getarena(self);
+    self->string= NULL;
+    self->string_l= 0;
+    self->utf8_l= 0;
+    for (;;) {
+        uint16_t utf8_l;
         /* read the utf8 str length */
-        int b16= buffer_getc(input);
-        int b8= buffer_getc(input);
-        size_t utf8_l= (b16 << 8) + b8;
-        /* fully read UTF8 string (chunk) */
-        char * utf8= utf8_bgets(utf8_l,input);
-        /* FIXME: utf8 == NULL ?? */
-        buffer_write(utf8,sizeof(char),strlen(utf8),sb);
-        free(utf8);
+        if (buffer_getbe16(input,&utf8_l) != BUFFER_OK) {
+            log_error("hessian_string_deserialize: can't read string length.");
+            hessian_free(arena,self->string);
+            return HESSIAN_ERROR;
+        }
+        /* a short final string is read inline */
+        if (tag == class->tag && self->string == NULL && utf8_l < HESSIAN_STRING_INLINE_SIZE) {
+            size_t bytes_l= utf8_breadlen(utf8_l,input);
+            if (bytes_l < HESSIAN_STRING_INLINE_SIZE) {
+                buffer_read(self->inline_string,sizeof(char),bytes_l,input);
+                self->inline_string[bytes_l]= '\0';
+                self->string= self->inline_string;
+                self->string_l= bytes_l;
+                self->utf8_l= utf8_l;
+                return HESSIAN_OK;
+            }
+        }
+        self->string= utf8_bappend(arena,self->string,&(self->string_l),utf8_l,input);
+        if (self->string == NULL) {
+            log_error("hessian_string_deserialize: can't read string (%d chars).",(int)utf8_l);
+            return HESSIAN_ERROR;
+        }
+        self->utf8_l+= utf8_l;
         /* was it final chunk? */
-        if (tag == class->chunk_tag) {
-            tag= buffer_getc(input);
+        if (tag == class->tag) {
+            return HESSIAN_OK;
         }
-        else {
-            /* tag == class->tag (final) */
-            fully_read= TRUE;
+        tag= buffer_getc(input);
+        if (tag != class->tag && tag != class->chunk_tag) {
+            log_error("hessian_string_deserialize: invalid chunk tag: %c (%d).",(char)tag,tag);
+            hessian_free(arena,self->string);
+            return HESSIAN_ERROR;
         }
-    } /* while */
-
-    /* copy the string buffer into the hessian string */
-    sb_l= buffer_length(sb);
-    self->string= calloc(sb_l + 1,sizeof(char));
-    if (self->string == NULL) {
-        log_error("hessian_string_deserialize: can't allocate string (%d chars).", (int)sb_l);
-        buffer_delete(sb);
-        return HESSIAN_ERROR;
     }
-    buffer_read(self->string,sizeof(char),sb_l,sb);
-    buffer_delete(sb);
-    return HESSIAN_OK;
 }
 
 /**
@@ -256,62 +275,240 @@ const char * hessian_string_getstring(const hessian_object_t * object) {
  * @return a char array pointer or NULL on error.
  */
 char * utf8_bgets(size_t utf8_l, BUFFER * input) {
-    size_t n_utf8, tmp_l;
-    char * utf8;
-    /* use a tmp buffer */
-    BUFFER * tmp= buffer_create(utf8_l);
-    if (tmp == NULL) {
-        log_error("utf8_bgets: can't create temp buffer (%d bytes).", (int)utf8_l);
-        return NULL;
+    size_t bytes_l;
+    return utf8_bread(NULL,utf8_l,input,&bytes_l);
+}
+
+/**
+ * Returns the byte length of the UTF-8 sequence starting with byte.
+ */
+size_t utf8_seqlen(unsigned char byte) {
+    if (byte < 0x80) return 1;
+    if ((byte & 0xE0) == 0xC0) return 2; /* start of the 2-byte seq. */
+    if ((byte & 0xF0) == 0xE0) return 3; /* start of the 3-byte seq. */
+    if ((byte & 0xF0) == 0xF0) return 4; /* start of the 4-byte seq. */
+    return 1; /* stray continuation byte */
+}
+
+/**
+ * Returns the number of ASCII bytes, at most max, at the beginning of the
+ * span. Pure ASCII runs (DNs, URIs) are scanned a word at a time.
+ */
+#define UTF8_ASCII_MASK UINT64_C(0x8080808080808080)
+static size_t utf8_asciilen(const unsigned char * span, size_t max) {
+    size_t pos= 0;
+    uint64_t word;
+    while (pos + sizeof(word) <= max) {
+        memcpy(&word,span + pos,sizeof(word));
+        if ((word & UTF8_ASCII_MASK) != 0) break;
+        pos+= sizeof(word);
+    }
+    while (pos < max && span[pos] < 0x80) {
+        pos++;
+    }
+    return pos;
+}
+
+/**
+ * Returns the number of bytes of the utf8_l UTF-8 chars at the beginning of
+ * the span, or UTF8_TRUNCATED if the span is too short.
+ */
+size_t utf8_bytelen(const unsigned char * span, size_t span_l, size_t utf8_l) {
+    size_t pos= 0, ascii_l;
+    while (utf8_l > 0) {
+        if (pos >= span_l) {
+            return UTF8_TRUNCATED;
+        }
+        if (span[pos] < 0x80) {
+            /* an ASCII byte is one char */
+            ascii_l= utf8_asciilen(span + pos,(span_l - pos < utf8_l) ? span_l - pos : utf8_l);
+            pos+= ascii_l;
+            utf8_l-= ascii_l;
+        }
+        else {
+            /* multi-byte chars run */
+            do {
+                pos+= utf8_seqlen(span[pos]);
+                utf8_l--;
+            } while (utf8_l > 0 && pos < span_l && span[pos] >= 0x80);
+        }
     }
-    n_utf8= 0;
-    while(n_utf8 < utf8_l) {
-        int byte= buffer_getc(input);
-        buffer_putc(byte,tmp);
-        if ((byte & 0xC0) == 0xC0) {
-            /* utf8 multi-byte char sequence */
-            int n_mbyte= 0;
-            if ((byte & 0xF0) == 0xC0) n_mbyte= 1; /* c is start of the 2-byte seq. */
-            else if ((byte & 0xF0) == 0xE0) n_mbyte= 2; /* c is start of the 3-byte seq. */
-            else if ((byte & 0xF0) == 0xF0) n_mbyte= 3; /* c is start of the 4-byte seq. */
-            else log_error("utf8_bgets: unknown multi-bytes utf8 sequence: 0x%0X",byte);
-            /* read additional bytes */
-            while (n_mbyte-- > 0) {
-                int mbyte= buffer_getc(input);
-                buffer_putc(mbyte,tmp);
+    return (pos <= span_l) ? pos : UTF8_TRUNCATED;
+}
+
+/**
+ * Returns the number of bytes of the utf8_l UTF-8 chars at the beginning of the
+ * UTF8_SEGMENTS_MAX first segments of the input BUFFER, or UTF8_TRUNCATED.
+ */
+#define UTF8_SEGMENTS_MAX 64
+static size_t utf8_bytelen_segments(BUFFER * input, size_t utf8_l) {
+    struct iovec iov[UTF8_SEGMENTS_MAX];
+    int iov_l= buffer_getiovec(input,iov,UTF8_SEGMENTS_MAX), i;
+    size_t pos= 0, off= 0, ascii_l;
+    for (i= 0; i < iov_l; i++) {
+        const unsigned char * span= iov[i].iov_base;
+        size_t span_l= iov[i].iov_len;
+        /* off > 0 if the previous multi-byte sequence continues in this segment */
+        while (utf8_l > 0 && off < span_l) {
+            if (span[off] < 0x80) {
+                ascii_l= utf8_asciilen(span + off,(span_l - off < utf8_l) ? span_l - off : utf8_l);
+                off+= ascii_l;
+                utf8_l-= ascii_l;
+            }
+            else {
+                /* multi-byte chars run */
+                do {
+                    off+= utf8_seqlen(span[off]);
+                    utf8_l--;
+                } while (utf8_l > 0 && off < span_l && span[off] >= 0x80);
             }
         }
-        n_utf8++;
-    }
-    /* alloc the char array */
-    tmp_l= buffer_length(tmp);
-    utf8= calloc(tmp_l + 1, sizeof(char));
-    if (utf8 == NULL) {
-        log_error("utf8_bgets: can't allocate string (%d chars).", (int)tmp_l);
-        buffer_delete(tmp);
-        return NULL;
+        if (utf8_l == 0 && off <= span_l) {
+            return pos + off;
+        }
+        pos+= span_l;
+        off-= span_l;
     }
-    /* copy tmp buffer to char array */
-    buffer_read(utf8,sizeof(char),tmp_l,tmp);
-    buffer_delete(tmp);
+    return UTF8_TRUNCATED;
+}
+
+/**
+ * Returns the number of bytes of the utf8_l UTF-8 chars at the read position
+ * of the input BUFFER, without reading them, or UTF8_TRUNCATED.
+ */
+size_t utf8_breadlen(size_t utf8_l, BUFFER * input) {
+    const unsigned char * span;
+    size_t span_l, n;
+    span= buffer_peek(input,&span_l);
+    if (span == NULL) {
+        return UTF8_TRUNCATED;
+    }
+    n= utf8_bytelen(span,span_l,utf8_l);
+    if (n == UTF8_TRUNCATED && buffer_length(input) > span_l) {
+        n= utf8_bytelen_segments(input,utf8_l);
+    }
+    return n;
+}
+
+/**
+ * Number of UTF-8 chars measured at once: at most 4 bytes per char, they are
+ * in the UTF8_SEGMENTS_MAX first segments of a segmented buffer. A Hessian
+ * string chunk is always measured at once.
+ */
+#define UTF8_SEGMENTS_CHARS 32768
+
+/**
+ * Reads utf8_l UTF-8 chars from the input BUFFER and appends them to the utf8
+ * string of bytes_l bytes, or NULL. The string is reallocated from the arena,
+ * or from the heap if arena is NULL, and bytes_l updated. The chars are
+ * measured in the input buffer memory, then copied at once.
+ *
+ * Returns the '\0' terminated string, or NULL on error (the string is released).
+ */
+static char * utf8_bappend(arena_t * arena, char * utf8, size_t * bytes_l, size_t utf8_l, BUFFER * input) {
+    do {
+        size_t chars_l= (utf8_l < UTF8_SEGMENTS_CHARS) ? utf8_l : UTF8_SEGMENTS_CHARS;
+        size_t n= (chars_l > 0) ? utf8_breadlen(chars_l,input) : 0;
+        char * string;
+        if (n == UTF8_TRUNCATED) {
+            log_error("utf8_bread: truncated input, %d utf8 chars not available.", (int)chars_l);
+            hessian_free(arena,utf8);
+            return NULL;
+        }
+        if (arena != NULL) {
+            string= arena_realloc(arena,utf8,(utf8 != NULL) ? *bytes_l + 1 : 0,*bytes_l + n + 1);
+        }
+        else {
+            string= realloc(utf8,*bytes_l + n + 1);
+        }
+        if (string == NULL) {
+            log_error("utf8_bread: can't allocate string (%d chars).", (int)(*bytes_l + n));
+            hessian_free(arena,utf8);
+            return NULL;
+        }
+        utf8= string;
+        buffer_read(utf8 + *bytes_l,sizeof(char),n,input);
+        *bytes_l+= n;
+        utf8[*bytes_l]= '\0';
+        utf8_l-= chars_l;
+    } while (utf8_l > 0);
     return utf8;
 }
 
+/**
+ * Returns a char array ('\0' terminated) containing utf8_l UTF-8 chars, read
+ * from the input BUFFER, and sets bytes_l to its length. The array is allocated
+ * from the arena, or from the heap if arena is NULL, and the chars are copied
+ * at once from the input buffer memory.
+ */
+char * utf8_bread(arena_t * arena, size_t utf8_l, BUFFER * input, size_t * bytes_l) {
+    if (input == NULL) {
+        log_error("utf8_bread: NULL input buffer.");
+        return NULL;
+    }
+    *bytes_l= 0;
+    return utf8_bappend(arena,NULL,bytes_l,utf8_l,input);
+}
+
 /**
  * Returns the effective UTF8 string length
  */
 size_t utf8_strlen(const char *s) {
-    int i = 0;
-    size_t j = 0;
     if (s == NULL) {
         log_error("utf8_strlen: NULL string pointer.");
         return 0;
     }
-    while (s[i]) {
-        if ((s[i] & 0xc0) != 0x80) j++; /* multi byte char */
-        i++;
+    return utf8_strnlen(s,strlen(s));
+}
+
+/**
+ * Returns the number of UTF-8 chars in the str_l first bytes: str_l minus the
+ * continuation bytes (10xxxxxx), counted a word at a time.
+ */
+#define UTF8_ONES UINT64_C(0x0101010101010101)
+size_t utf8_strnlen(const char * str, size_t str_l) {
+    const unsigned char * s= (const unsigned char *)str;
+    size_t pos= 0, cont_l= 0;
+    uint64_t word, cont;
+    while (pos + sizeof(word) <= str_l) {
+        memcpy(&word,s + pos,sizeof(word));
+        /* bit 7 of each continuation byte: bit 7 set and bit 6 clear */
+        cont= word & ~(word << 1) & UTF8_ASCII_MASK;
+        /* popcount of the at most 8 bits */
+        cont_l+= (size_t)(((cont >> 7) * UTF8_ONES) >> 56);
+        pos+= sizeof(word);
+    }
+    for (; pos < str_l; pos++) {
+        if ((s[pos] & 0xC0) == 0x80) cont_l++;
+    }
+    return str_l - cont_l;
+}
+
+/**
+ * Returns the byte length of the utf8_l first UTF-8 chars of str (str_l bytes),
+ * or UTF8_TRUNCATED if str is shorter. The chars are counted as utf8_strnlen()
+ * does, a word at a time, up to the word containing the last one.
+ */
+size_t utf8_strnpos(const char * str, size_t str_l, size_t utf8_l) {
+    const unsigned char * s= (const unsigned char *)str;
+    size_t pos= 0, chars_l= 0, word_l;
+    uint64_t word, cont;
+    while (pos + sizeof(word) <= str_l) {
+        memcpy(&word,s + pos,sizeof(word));
+        cont= word & ~(word << 1) & UTF8_ASCII_MASK;
+        word_l= sizeof(word) - (size_t)(((cont >> 7) * UTF8_ONES) >> 56);
+        if (chars_l + word_l >= utf8_l) break;
+        chars_l+= word_l;
+        pos+= sizeof(word);
+    }
+    /* the end of the last char is the next char start (or the end of str) */
+    for (; pos < str_l; pos++) {
+        if ((s[pos] & 0xC0) != 0x80) {
+            if (chars_l == utf8_l) return pos;
+            chars_l++;
+        }
     }
-    return j;
+    return (chars_l == utf8_l) ? pos : UTF8_TRUNCATED;
 }
 
 /* return TRUE iff the byte is part of an UTF8 multi-byte sequence. */
@@ -347,7 +544,7 @@ size_t hessian_string_utf8_length(const hessian_object_t * object) {
         log_error("hessian_string_utf8_length: wrong class type: %d.",class->type);
         return 0;
     }
-    return utf8_strlen(self->string);
+    return self->utf8_l;
 }
 
 /**
@@ -369,7 +566,7 @@ size_t hessian_string_length(const hessian_object_t * object) {
         log_error("hessian_string_length: wrong class type: %d.",class->type);
         return 0;
     }
-    return strlen(self->string);
+    return self->string_l;
 }
 
 /**
@@ -378,7 +575,6 @@ size_t hessian_string_length(const hessian_object_t * object) {
 int hessian_string_equals(const hessian_object_t * object, const char *str) {
     const hessian_string_t * self= object;
     const hessian_class_t * class;
-    size_t string_l;
     if (self == NULL) {
         log_error("hessian_string_equals: NULL object pointer.");
         return HESSIAN_ERROR;
@@ -398,8 +594,7 @@ int hessian_string_equals(const hessian_object_t * object, const char *str) {
     if (str == NULL) {
         return FALSE;
     }
-    string_l= strlen(self->string);
-    return (strncmp(self->string, str, string_l) == 0) ? TRUE : FALSE;
+    return (strncmp(self->string, str, self->string_l) == 0) ? TRUE : FALSE;
 }
 
 /**
@@ -45,7 +45,9 @@ typedef enum {
     HESSIAN_LIST,
     HESSIAN_MAP,
     HESSIAN_NULL,
-    HESSIAN_REF
+    HESSIAN_REF,
+    /* end of list or map, only returned by hessian_reader_next() */
+    HESSIAN_END
 } hessian_t;
 
 /**
@@ -53,6 +55,11 @@ typedef enum {
  */
 typedef void hessian_object_t;
 
+/**
+ * Per-decode Hessian reference table (opaque)
+ */
+typedef struct hessian_refs hessian_refs_t;
+
 /**
  * Hessian internal class descriptor type.
  *
@@ -67,7 +74,7 @@ typedef struct hessian_class {
     hessian_object_t * (* ctor) (hessian_object_t * self, va_list * app);
     int (* dtor) (hessian_object_t * self);
     int (* serialize) (const hessian_object_t * self, BUFFER * output);
-    int (* deserialize) (hessian_object_t * self, int tag, BUFFER * input);
+    int (* deserialize) (hessian_object_t * self, int tag, BUFFER * input, hessian_refs_t * refs);
 } hessian_class_t;
 
 /**
@@ -131,11 +138,21 @@ typedef struct hessian_double {
 } hessian_double_t;
 
 /**
- * Hessian UTF-8 string and XML class types.
+ * Inline storage of the short strings, '\0' included.
+ */
+#define HESSIAN_STRING_INLINE_SIZE 24
+
+/**
+ * Hessian UTF-8 string and XML class types. The string is stored inline if
+ * short, else allocated, or borrowed (static string, not released).
  */
 typedef struct hessian_string {
     const void * class;
-    char * string;
+    char * string; /* inline, allocated or borrowed */
+    size_t string_l; /* byte length */
+    size_t utf8_l; /* number of UTF-8 chars */
+    int borrowed;
+    char inline_string[HESSIAN_STRING_INLINE_SIZE];
 } hessian_string_t, hessian_xml_t;
 
 /**
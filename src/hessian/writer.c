@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <stdint.h>
+
+#include "hessian.h"
+#include "i_hessian.h"
+#include "log.h"
+
+/*****************************************************
+ * Hessian streaming writer: writes the Hessian 1.0  *
+ * encoding without creating the Hessian objects.    *
+ *****************************************************/
+
+/**
+ * Writes the optional type ('t' b16 b8 type-string) of a map or list.
+ */
+static int hessian_write_type(const char * type, BUFFER * output) {
+    size_t str_l, utf8_l;
+    str_l= strlen(type);
+    utf8_l= utf8_strnlen(type,str_l);
+    if (buffer_putc('t',output) == BUFFER_ERROR
+        || buffer_putbe16((uint16_t)utf8_l,output) != BUFFER_OK
+        || buffer_write(type,1,str_l,output) != str_l) {
+        log_error("hessian_write_type: can't write type: %s.",type);
+        return HESSIAN_ERROR;
+    }
+    return HESSIAN_OK;
+}
+
+/**
+ * Writes the leading chunks of HESSIAN_CHUNK_SIZE UTF-8 chars of str (str_l
+ * bytes), with the chunk_tag, sets pos to the byte position of the final
+ * chunk in str and utf8_l to the number of chars left for the final chunk.
+ *
+ * @return int HESSIAN_OK or HESSIAN_ERROR if the output buffer can't be written.
+ */
+static int hessian_write_chunks(int chunk_tag, const char * str, size_t str_l, size_t * pos, size_t * utf8_l, BUFFER * output) {
+    *pos= 0;
+    /* WARN: number of chars != number of bytes (multi-byte utf8) */
+    while (*utf8_l > HESSIAN_CHUNK_SIZE) {
+        /* byte length of the HESSIAN_CHUNK_SIZE utf8 chars */
+        size_t chunk_l= utf8_strnpos(str + *pos,str_l - *pos,HESSIAN_CHUNK_SIZE);
+        if (chunk_l == UTF8_TRUNCATED) {
+            /* invalid UTF-8 at the end of str: the final chunk gets the rest */
+            break;
+        }
+        /* send utf8 chunks */
+        if (buffer_putc(chunk_tag,output) == BUFFER_ERROR
+            || buffer_putbe16(HESSIAN_CHUNK_SIZE,output) != BUFFER_OK
+            || buffer_write(&(str[*pos]),1,chunk_l,output) != chunk_l) {
+            log_error("hessian_write_chunks: can't write string chunk to output buffer.");
+            return HESSIAN_ERROR;
+        }
+        *pos+= chunk_l;
+        *utf8_l= *utf8_l - HESSIAN_CHUNK_SIZE;
+    }
+    return HESSIAN_OK;
+}
+
+int hessian_write_utf8(int tag, int chunk_tag, const char * str, size_t str_l, size_t utf8_l, BUFFER * output) {
+    size_t pos;
+    if (str == NULL || output == NULL) {
+        log_error("hessian_write_utf8: NULL string or output buffer.");
+        return HESSIAN_ERROR;
+    }
+    if (hessian_write_chunks(chunk_tag,str,str_l,&pos,&utf8_l,output) != HESSIAN_OK) {
+        return HESSIAN_ERROR;
+    }
+    if (buffer_putc(tag,output) == BUFFER_ERROR
+        || buffer_putbe16((uint16_t)utf8_l,output) != BUFFER_OK
+        || buffer_write(&(str[pos]),1,(str_l - pos),output) != (str_l - pos)) {
+        log_error("hessian_write_utf8: can't write string to output buffer.");
+        return HESSIAN_ERROR;
+    }
+    return HESSIAN_OK;
+}
+
+int hessian_write_string(const char * str, BUFFER * output) {
+    size_t str_l;
+    if (str == NULL) {
+        log_error("hessian_write_string: NULL string.");
+        return HESSIAN_ERROR;
+    }
+    str_l= strlen(str);
+    return hessian_write_utf8('S','s',str,str_l,utf8_strnlen(str,str_l),output);
+}
+
+int hessian_write_null(BUFFER * output) {
+    if (buffer_putc('N',output) == BUFFER_ERROR) {
+        log_error("hessian_write_null: can't write to output buffer.");
+        return HESSIAN_ERROR;
+    }
+    return HESSIAN_OK;
+}
+
+int hessian_write_fragment(const void * fragment, size_t fragment_l, BUFFER * output) {
+    if (buffer_write(fragment,1,fragment_l,output) != fragment_l) {
+        log_error("hessian_write_fragment: can't write %d bytes to output buffer.",(int)fragment_l);
+        return HESSIAN_ERROR;
+    }
+    return HESSIAN_OK;
+}
+
+int hessian_writer_begin_map(const char * type, BUFFER * output) {
+    if (buffer_putc('M',output) == BUFFER_ERROR) {
+        log_error("hessian_writer_begin_map: can't write to output buffer.");
+        return HESSIAN_ERROR;
+    }
+    if (type != NULL) {
+        return hessian_write_type(type,output);
+    }
+    return HESSIAN_OK;
+}
+
+int hessian_writer_begin_list(const char * type, size_t length, BUFFER * output) {
+    if (buffer_putc('V',output) == BUFFER_ERROR) {
+        log_error("hessian_writer_begin_list: can't write to output buffer.");
+        return HESSIAN_ERROR;
+    }
+    if (type != NULL && hessian_write_type(type,output) != HESSIAN_OK) {
+        return HESSIAN_ERROR;
+    }
+    /* length is optional, and omitted for an empty list */
+    if (length > 0) {
+        if (buffer_putc('l',output) == BUFFER_ERROR
+            || buffer_putbe32((uint32_t)length,output) != BUFFER_OK) {
+            log_error("hessian_writer_begin_list: can't write list length: %d.",(int)length);
+            return HESSIAN_ERROR;
+        }
+    }
+    return HESSIAN_OK;
+}
+
+int hessian_writer_end(BUFFER * output) {
+    if (buffer_putc('z',output) == BUFFER_ERROR) {
+        log_error("hessian_writer_end: can't write to output buffer.");
+        return HESSIAN_ERROR;
+    }
+    return HESSIAN_OK;
+}
+
+/*****************************************************
+ * Hessian 2.0 streaming writer: compact encoding of *
+ * strings and integers, objects and fixed-length    *
+ * lists.                                            *
+ *****************************************************/
+
+int hessian2_write_string(const char * str, BUFFER * output) {
+    size_t str_l, utf8_l, pos;
+    int rc;
+    if (str == NULL || output == NULL) {
+        log_error("hessian2_write_string: NULL string or output buffer.");
+        return HESSIAN_ERROR;
+    }
+    str_l= strlen(str);
+    utf8_l= utf8_strnlen(str,str_l);
+    if (hessian_write_chunks(HESSIAN2_STRING_CHUNK,str,str_l,&pos,&utf8_l,output) != HESSIAN_OK) {
+        return HESSIAN_ERROR;
+    }
+    if (utf8_l <= HESSIAN2_STRING_DIRECT_MAX) {
+        /* x00-x1f: short string, length in the tag */
+        rc= buffer_putc((int)utf8_l,output);
+    }
+    else if (utf8_l <= HESSIAN2_STRING_SHORT_MAX) {
+        /* x30-x33 b0 */
+        if (buffer_putc(HESSIAN2_STRING_SHORT + (int)(utf8_l >> 8),output) == BUFFER_ERROR) {
+            rc= BUFFER_ERROR;
+        }
+        else {
+            rc= buffer_putc((int)(utf8_l & 0xFF),output);
+        }
+    }
+    else {
+        if (buffer_putc('S',output) == BUFFER_ERROR) {
+            rc= BUFFER_ERROR;
+        }
+        else {
+            rc= buffer_putbe16((uint16_t)utf8_l,output);
+        }
+    }
+    if (rc == BUFFER_ERROR || buffer_write(&(str[pos]),1,(str_l - pos),output) != (str_l - pos)) {
+        log_error("hessian2_write_string: can't write string to output buffer.");
+        return HESSIAN_ERROR;
+    }
+    return HESSIAN_OK;
+}
+
+int hessian2_write_int(int32_t value, BUFFER * output) {
+    unsigned char bytes[5];
+    size_t bytes_l;
+    if (value >= HESSIAN2_INT_DIRECT_MIN && value <= HESSIAN2_INT_DIRECT_MAX) {
+        /* x80-xbf */
+        bytes[0]= (unsigned char)(HESSIAN2_INT_DIRECT + value);
+        bytes_l= 1;
+    }
+    else if (value >= HESSIAN2_INT_BYTE_MIN && value <= HESSIAN2_INT_BYTE_MAX) {
+        /* xc0-xcf b0 */
+        bytes[0]= (unsigned char)(HESSIAN2_INT_BYTE + (value >> 8));
+        bytes[1]= (unsigned char)(value & 0xFF);
+        bytes_l= 2;
+    }
+    else if (value >= HESSIAN2_INT_SHORT_MIN && value <= HESSIAN2_INT_SHORT_MAX) {
+        /* xd0-xd7 b1 b0 */
+        bytes[0]= (unsigned char)(HESSIAN2_INT_SHORT + (value >> 16));
+        bytes[1]= (unsigned char)((value >> 8) & 0xFF);
+        bytes[2]= (unsigned char)(value & 0xFF);
+        bytes_l= 3;
+    }
+    else {
+        uint32_t uvalue= (uint32_t)value;
+        bytes[0]= 'I';
+        bytes[1]= (unsigned char)(uvalue >> 24);
+        bytes[2]= (unsigned char)(uvalue >> 16);
+        bytes[3]= (unsigned char)(uvalue >> 8);
+        bytes[4]= (unsigned char)uvalue;
+        bytes_l= 5;
+    }
+    if (buffer_write(bytes,1,bytes_l,output) != bytes_l) {
+        log_error("hessian2_write_int: can't write int: %d.",(int)value);
+        return HESSIAN_ERROR;
+    }
+    return HESSIAN_OK;
+}
+
+int hessian2_write_classdef(const char * type, const char * const fields[], size_t fields_l, BUFFER * output) {
+    size_t i;
+    if (buffer_putc('C',output) == BUFFER_ERROR
+        || hessian2_write_string(type,output) != HESSIAN_OK
+        || hessian2_write_int((int32_t)fields_l,output) != HESSIAN_OK) {
+        log_error("hessian2_write_classdef: can't write class definition: %s.",type);
+        return HESSIAN_ERROR;
+    }
+    for (i= 0; i < fields_l; i++) {
+        if (hessian2_write_string(fields[i],output) != HESSIAN_OK) {
+            log_error("hessian2_write_classdef: can't write field: %s of class: %s.",fields[i],type);
+            return HESSIAN_ERROR;
+        }
+    }
+    return HESSIAN_OK;
+}
+
+int hessian2_writer_begin_object(int classdef, BUFFER * output) {
+    int rc;
+    if (classdef <= HESSIAN2_OBJECT_DIRECT_MAX) {
+        /* x60-x6f */
+        rc= (buffer_putc(HESSIAN2_OBJECT_DIRECT + classdef,output) == BUFFER_ERROR) ? HESSIAN_ERROR : HESSIAN_OK;
+    }
+    else if (buffer_putc('O',output) == BUFFER_ERROR) {
+        rc= HESSIAN_ERROR;
+    }
+    else {
+        rc= hessian2_write_int(classdef,output);
+    }
+    if (rc != HESSIAN_OK) {
+        log_error("hessian2_writer_begin_object: can't write object of class definition: %d.",classdef);
+    }
+    return rc;
+}
+
+int hessian2_writer_begin_list(size_t length, BUFFER * output) {
+    int rc;
+    if (length <= HESSIAN2_LIST_DIRECT_MAX) {
+        /* x78-x7f: untyped fixed-length list */
+        rc= (buffer_putc(HESSIAN2_LIST_DIRECT + (int)length,output) == BUFFER_ERROR) ? HESSIAN_ERROR : HESSIAN_OK;
+    }
+    else if (buffer_putc(HESSIAN2_LIST_FIXED,output) == BUFFER_ERROR) {
+        rc= HESSIAN_ERROR;
+    }
+    else {
+        rc= hessian2_write_int((int32_t)length,output);
+    }
+    if (rc != HESSIAN_OK) {
+        log_error("hessian2_writer_begin_list: can't write list length: %d.",(int)length);
+    }
+    return rc;
+}
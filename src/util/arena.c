@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "log.h"
+
+/*
+ * default chunk size of the arenas
+ */
+#ifndef ARENA_CHUNK_SIZE
+#define ARENA_CHUNK_SIZE 8192
+#endif
+
+/*
+ * maximum memory kept by arena_reset, a larger workload releases the rest
+ */
+#ifndef ARENA_RETAIN_SIZE
+#define ARENA_RETAIN_SIZE 262144
+#endif
+
+/* memory alignment of the allocations */
+typedef union arena_align {
+    void * p;
+    long long ll;
+    double d;
+} arena_align_t;
+
+#define ARENA_ALIGN(size) (((size) + sizeof(arena_align_t) - 1) & ~(sizeof(arena_align_t) - 1))
+
+/* memory chunk */
+typedef struct arena_chunk {
+    struct arena_chunk * next;
+    size_t size; /* allocated data size */
+    size_t used; /* bytes allocated from the chunk */
+    arena_align_t data[];
+} arena_chunk_t;
+
+/* arena structure */
+struct arena {
+    size_t chunk_size;
+    arena_chunk_t * chunks; /* current chunk first */
+};
+
+static arena_chunk_t * arena_chunk_create(size_t size) {
+    arena_chunk_t * chunk= malloc(sizeof(arena_chunk_t) + size);
+    if (chunk == NULL) {
+        log_error("arena_chunk_create: malloc of %d bytes failed.", (int)size);
+        return NULL;
+    }
+    chunk->next= NULL;
+    chunk->size= size;
+    chunk->used= 0;
+    return chunk;
+}
+
+arena_t * arena_create(size_t chunk_size) {
+    arena_t * arena= calloc(1,sizeof(arena_t));
+    if (arena == NULL) {
+        log_error("arena_create: can't allocate arena_t.");
+        return NULL;
+    }
+    arena->chunk_size= (chunk_size > 0) ? ARENA_ALIGN(chunk_size) : ARENA_CHUNK_SIZE;
+    arena->chunks= NULL;
+    return arena;
+}
+
+void * arena_alloc(arena_t * arena, size_t size) {
+    arena_chunk_t * chunk;
+    if (arena == NULL) {
+        log_error("arena_alloc: NULL arena.");
+        return NULL;
+    }
+    if (size > SIZE_MAX - sizeof(arena_align_t)) {
+        log_error("arena_alloc: size %lu too large.", (unsigned long)size);
+        return NULL;
+    }
+    size= (size > 0) ? ARENA_ALIGN(size) : sizeof(arena_align_t);
+    chunk= arena->chunks;
+    if (chunk != NULL && chunk->size - chunk->used >= size) {
+        void * ptr= (char *)chunk->data + chunk->used;
+        chunk->used+= size;
+        return ptr;
+    }
+    if (chunk != NULL && size > arena->chunk_size / 4) {
+        /* large block in its own chunk, the current chunk stays current */
+        arena_chunk_t * large= arena_chunk_create(size);
+        if (large == NULL) {
+            return NULL;
+        }
+        large->used= size;
+        large->next= chunk->next;
+        chunk->next= large;
+        return large->data;
+    }
+    chunk= arena_chunk_create(size > arena->chunk_size ? size : arena->chunk_size);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    chunk->used= size;
+    chunk->next= arena->chunks;
+    arena->chunks= chunk;
+    return chunk->data;
+}
+
+void * arena_calloc(arena_t * arena, size_t nmemb, size_t size) {
+    void * ptr;
+    if (size > 0 && nmemb > SIZE_MAX / size) {
+        log_error("arena_calloc: %lu elements of %lu bytes too large.", (unsigned long)nmemb, (unsigned long)size);
+        return NULL;
+    }
+    ptr= arena_alloc(arena,nmemb * size);
+    if (ptr != NULL) {
+        memset(ptr,0,nmemb * size);
+    }
+    return ptr;
+}
+
+void * arena_realloc(arena_t * arena, void * ptr, size_t old_size, size_t size) {
+    arena_chunk_t * chunk;
+    void * new_ptr;
+    if (ptr == NULL) {
+        return arena_alloc(arena,size);
+    }
+    if (size <= old_size) {
+        return ptr;
+    }
+    chunk= arena->chunks;
+    if (chunk != NULL && chunk->used >= ARENA_ALIGN(old_size) && size <= SIZE_MAX - sizeof(arena_align_t)) {
+        size_t old_used= chunk->used - ARENA_ALIGN(old_size);
+        /* last block of the current chunk: extend in place */
+        if ((char *)ptr == (char *)chunk->data + old_used && chunk->size - old_used >= ARENA_ALIGN(size)) {
+            chunk->used= old_used + ARENA_ALIGN(size);
+            return ptr;
+        }
+    }
+    new_ptr= arena_alloc(arena,size);
+    if (new_ptr == NULL) {
+        return NULL;
+    }
+    memcpy(new_ptr,ptr,old_size);
+    return new_ptr;
+}
+
+void arena_reset(arena_t * arena) {
+    arena_chunk_t * chunk;
+    size_t used, retain;
+    if (arena == NULL || arena->chunks == NULL) return;
+    retain= (arena->chunk_size > ARENA_RETAIN_SIZE) ? arena->chunk_size : ARENA_RETAIN_SIZE;
+    if (arena->chunks->next == NULL && arena->chunks->size <= retain) {
+        arena->chunks->used= 0;
+        return;
+    }
+    /* replace the chunks by one holding all they served, including the unused
+       end of the full chunks, plus half for a growing workload, but not more
+       than the retained size: a single large message does not pin its memory */
+    used= arena->chunks->used;
+    chunk= arena->chunks->next;
+    free(arena->chunks);
+    while (chunk != NULL) {
+        arena_chunk_t * next= chunk->next;
+        used+= chunk->size;
+        free(chunk);
+        chunk= next;
+    }
+    used= (used > retain / 3 * 2) ? retain : ARENA_ALIGN(used + used / 2);
+    arena->chunks= arena_chunk_create(used > arena->chunk_size ? used : arena->chunk_size);
+}
+
+void arena_delete(arena_t * arena) {
+    arena_chunk_t * chunk;
+    if (arena == NULL) return;
+    chunk= arena->chunks;
+    while (chunk != NULL) {
+        arena_chunk_t * next= chunk->next;
+        free(chunk);
+        chunk= next;
+    }
+    free(arena);
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _PEP_ARENA_H_
+#define _PEP_ARENA_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * The arena type: a bump allocator. The memory is carved from large chunks,
+ * and is only released all at once by arena_reset() or arena_delete().
+ *
+ * An arena is not thread-safe.
+ */
+typedef struct arena arena_t;
+
+/**
+ * Creates an empty arena. No memory is allocated before the first arena_alloc().
+ *
+ * @param size_t chunk_size the size of the memory chunks, or 0 for the default
+ *        (8 KB). A larger allocation gets its own chunk.
+ *
+ * @return arena_t * the new arena or NULL if an error occurs.
+ */
+arena_t * arena_create(size_t chunk_size);
+
+/**
+ * Allocates size bytes from the arena. The memory is suitably aligned for
+ * any type, and is not initialized.
+ *
+ * @param arena_t * arena the arena.
+ * @param size_t size the number of bytes.
+ *
+ * @return void * the memory or NULL if an error occurs.
+ */
+void * arena_alloc(arena_t * arena, size_t size);
+
+/**
+ * Allocates a zeroed array of nmemb elements of size bytes from the arena.
+ *
+ * @param arena_t * arena the arena.
+ * @param size_t nmemb the number of elements.
+ * @param size_t size the element size.
+ *
+ * @return void * the memory or NULL if an error occurs.
+ */
+void * arena_calloc(arena_t * arena, size_t nmemb, size_t size);
+
+/**
+ * Grows a memory block allocated from the arena. The block is extended in
+ * place if it is the last one allocated and the chunk has room left, otherwise
+ * it is copied to a new block and the old one is wasted until the next reset.
+ *
+ * @param arena_t * arena the arena.
+ * @param void * ptr the memory block, or NULL.
+ * @param size_t old_size the current block size.
+ * @param size_t size the new block size.
+ *
+ * @return void * the memory or NULL if an error occurs (the block is unchanged).
+ */
+void * arena_realloc(arena_t * arena, void * ptr, size_t old_size, size_t size);
+
+/**
+ * Releases all the memory allocated from the arena at once. The chunks are
+ * kept for reuse: if several were needed since the last reset, they are
+ * replaced by a single chunk large enough for all of them, so a repeated
+ * workload is served from one chunk without calling malloc. The kept chunk is
+ * at most ARENA_RETAIN_SIZE (256 KB) or the arena chunk size, if larger; the
+ * memory of a larger workload is released.
+ *
+ * @param arena_t * arena the arena.
+ */
+void arena_reset(arena_t * arena);
+
+/**
+ * Deletes the arena and all the memory allocated from it.
+ *
+ * @param arena_t * arena the arena.
+ */
+void arena_delete(arena_t * arena);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
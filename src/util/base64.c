@@ -15,16 +15,70 @@
  * limitations under the License.
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include "base64.h"
+#include "log.h"
 
-#define NO_LINE_BREAK -1000
+/* SSSE3 and AVX2 encoders and decoders, selected at runtime on x86 */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(BASE64_NO_SIMD)
+#define BASE64_SIMD 1
+#include <immintrin.h>
+#endif
+
+#define NO_LINE_BREAK BASE64_NO_LINE_BREAK
+
+/** number of 3 bytes blocks encoded at once by the streaming encoder */
+#define ENCODER_BLOCKS 256
+/** encoded chunk maximum size: 4 chars and a line break per block */
+#define ENCODER_CHUNK_SIZE (ENCODER_BLOCKS * 6)
+/** extra bytes after the chunk to encode, read but not encoded by the vector encoders */
+#define ENCODER_IN_SLACK 4
+
+/**
+ * Streaming encoder state: the in buffer, the current line length and the
+ * encoded bytes not yet read.
+ */
+struct base64_encoder {
+    BUFFER * in;
+    int linesize;
+    size_t line_l;
+    size_t length; /* total encoded length */
+    unsigned char pending[ENCODER_CHUNK_SIZE];
+    size_t pending_l;
+    size_t pending_pos;
+};
 
 /**
  * Base64 codec table (RFC1113)
  */
 static const char base64[]="ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+/** value not in the base64 reverse table */
+#define NOT_BASE64 0xff
+
+/**
+ * Base64 reverse table: the index in the codec table of each char, or NOT_BASE64
+ */
+static const unsigned char base64_rev[256]= {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+    0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
 /**
  * Encodes int_l 8-bit binary bytes as 4 '6-bit' characters (including '=' padding).
  */
@@ -36,6 +90,165 @@ static void encodeblock( const unsigned char in[3], int in_l, unsigned char out[
     out[3] = (unsigned char) (in_l > 2 ? base64[ in[2] & 0x3f ] : '=');
 }
 
+/**
+ * Vector encoder: encodes as many groups of blocks as possible of the blocks 3 bytes
+ * blocks of in, into 4 chars per block. Up to ENCODER_IN_SLACK bytes after the blocks
+ * are read, but not encoded. Returns the number of blocks encoded.
+ */
+typedef size_t encode_vector_f(const unsigned char * in, size_t blocks, unsigned char * out);
+
+#ifdef BASE64_SIMD
+
+/*
+ * Vector encoding: the 3 bytes of each block are spread in a 32-bit lane, the 4 x 6-bit
+ * values are shifted in place by multiplications, and translated into chars by adding
+ * an offset looked up by value range.
+ */
+#define ENCODE_SPREAD 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10
+#define ENCODE_LUT_SHIFT 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0
+
+__attribute__((target("ssse3")))
+static size_t encode_ssse3(const unsigned char * in, size_t blocks, unsigned char * out) {
+    const __m128i spread= _mm_setr_epi8(ENCODE_SPREAD);
+    const __m128i lut_shift= _mm_setr_epi8(ENCODE_LUT_SHIFT);
+    size_t i= 0;
+    while (i + 4 <= blocks) {
+        __m128i str= _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&in[i * 3]),spread);
+        __m128i hi= _mm_mulhi_epu16(_mm_and_si128(str,_mm_set1_epi32(0x0fc0fc00)),_mm_set1_epi32(0x04000040));
+        __m128i lo= _mm_mullo_epi16(_mm_and_si128(str,_mm_set1_epi32(0x003f03f0)),_mm_set1_epi32(0x01000010));
+        __m128i values= _mm_or_si128(hi,lo);
+        __m128i range= _mm_subs_epu8(values,_mm_set1_epi8(51));
+        range= _mm_or_si128(range,_mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26),values),_mm_set1_epi8(13)));
+        str= _mm_add_epi8(_mm_shuffle_epi8(lut_shift,range),values);
+        _mm_storeu_si128((__m128i *)&out[i * 4],str);
+        i+= 4;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t encode_avx2(const unsigned char * in, size_t blocks, unsigned char * out) {
+    const __m256i spread= _mm256_setr_epi8(ENCODE_SPREAD, ENCODE_SPREAD);
+    const __m256i lut_shift= _mm256_setr_epi8(ENCODE_LUT_SHIFT, ENCODE_LUT_SHIFT);
+    size_t i= 0;
+    while (i + 8 <= blocks) {
+        __m256i str= _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)&in[i * 3])),_mm_loadu_si128((const __m128i *)&in[i * 3 + 12]),1);
+        __m256i hi, lo, values, range;
+        str= _mm256_shuffle_epi8(str,spread);
+        hi= _mm256_mulhi_epu16(_mm256_and_si256(str,_mm256_set1_epi32(0x0fc0fc00)),_mm256_set1_epi32(0x04000040));
+        lo= _mm256_mullo_epi16(_mm256_and_si256(str,_mm256_set1_epi32(0x003f03f0)),_mm256_set1_epi32(0x01000010));
+        values= _mm256_or_si256(hi,lo);
+        range= _mm256_subs_epu8(values,_mm256_set1_epi8(51));
+        range= _mm256_or_si256(range,_mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26),values),_mm256_set1_epi8(13)));
+        str= _mm256_add_epi8(_mm256_shuffle_epi8(lut_shift,range),values);
+        _mm256_storeu_si256((__m256i *)&out[i * 4],str);
+        i+= 8;
+    }
+    return i;
+}
+
+/** returns the best vector encoder for the CPU, or NULL */
+static encode_vector_f * encode_vector_select(void) {
+    /* the CPU features are detected once, by a libgcc constructor */
+    if (__builtin_cpu_supports("avx2")) return encode_avx2;
+    if (__builtin_cpu_supports("ssse3")) return encode_ssse3;
+    return NULL;
+}
+
+#else
+
+static encode_vector_f * encode_vector_select(void) {
+    return NULL;
+}
+
+#endif
+
+/**
+ * Encodes the blocks 3 bytes blocks of in into out, returns the number of chars.
+ */
+static size_t encode_blocks(encode_vector_f * encode_vector, const unsigned char * in, size_t blocks, unsigned char * out) {
+    const unsigned char * b;
+    unsigned char * o;
+    size_t i= 0;
+    if (encode_vector != NULL) {
+        i= encode_vector(in,blocks,out);
+    }
+    for (; i < blocks; i++) {
+        b= &in[i * 3];
+        o= &out[i * 4];
+        o[0]= base64[b[0] >> 2];
+        o[1]= base64[((b[0] & 0x03) << 4) | (b[1] >> 4)];
+        o[2]= base64[((b[1] & 0x0f) << 2) | (b[2] >> 6)];
+        o[3]= base64[b[2] & 0x3f];
+    }
+    return blocks * 4;
+}
+
+/**
+ * Encodes the next ENCODER_BLOCKS blocks, at most, of the encoder in buffer into out,
+ * with the line breaks of base64_encode_l: after each line of at least linesize chars,
+ * and after the last block.
+ */
+static size_t encoder_encodechunk(base64_encoder_t * encoder, unsigned char * out) {
+    encode_vector_f * encode_vector= encode_vector_select();
+    unsigned char copy[ENCODER_BLOCKS * 3 + ENCODER_IN_SLACK];
+    const unsigned char * in;
+    unsigned char block[3];
+    size_t in_l, blocks, line_blocks, n, i= 0, out_l= 0;
+    /* encode the whole blocks directly from the in buffer memory, when
+       followed by the slack read by the vector encoder */
+    in= buffer_peek(encoder->in,&in_l);
+    if (in != NULL && in_l >= 3 + ENCODER_IN_SLACK) {
+        in_l-= ENCODER_IN_SLACK;
+        if (in_l > ENCODER_BLOCKS * 3) {
+            in_l= ENCODER_BLOCKS * 3;
+        }
+        in_l-= in_l % 3;
+        buffer_skip(encoder->in,in_l);
+    }
+    else {
+        in_l= buffer_read(copy,1,ENCODER_BLOCKS * 3,encoder->in);
+        memset(&copy[in_l],0,ENCODER_IN_SLACK);
+        in= copy;
+    }
+    blocks= in_l / 3;
+    if (encoder->linesize == NO_LINE_BREAK) {
+        out_l= encode_blocks(encode_vector,in,blocks,out);
+    }
+    else {
+        line_blocks= (encoder->linesize + 3) / 4;
+        while (i < blocks) {
+            /* the blocks up to the end of the line */
+            n= line_blocks - encoder->line_l / 4;
+            if (n > blocks - i) {
+                n= blocks - i;
+            }
+            out_l+= encode_blocks(encode_vector,&in[i * 3],n,&out[out_l]);
+            encoder->line_l+= n * 4;
+            i+= n;
+            if (encoder->line_l >= encoder->linesize) {
+                out[out_l++]= '\r';
+                out[out_l++]= '\n';
+                encoder->line_l= 0;
+            }
+        }
+    }
+    /* the last block, padded */
+    if (in_l % 3 != 0) {
+        block[0]= block[1]= block[2]= 0;
+        memcpy(block,&in[blocks * 3],in_l % 3);
+        encodeblock(block,in_l % 3,&out[out_l]);
+        out_l+= 4;
+        encoder->line_l+= 4;
+    }
+    if (encoder->linesize != NO_LINE_BREAK && encoder->line_l > 0 && buffer_eof(encoder->in)) {
+        out[out_l++]= '\r';
+        out[out_l++]= '\n';
+        encoder->line_l= 0;
+    }
+    return out_l;
+}
+
 /**
  * Base64 encodes the in buffer into the out buffer (without line break).
  */
@@ -47,36 +260,103 @@ void base64_encode( BUFFER * inbuf, BUFFER * outbuf ) {
  * Base64 encodes the in buffer into the out buffer.
  */
 void base64_encode_l( BUFFER * inbuf, BUFFER * outbuf, int linesize ) {
+    base64_encoder_t encoder;
+    unsigned char out[ENCODER_CHUNK_SIZE];
+    size_t out_l;
 
-    unsigned char in[3], out[4];
-    int i= 0, in_l= 0;
-    size_t b_out = 0; /* byte written */
+    if (linesize != NO_LINE_BREAK && linesize < 4) {
+        linesize= BASE64_DEFAULT_LINE_SIZE;
+    }
+    memset(&encoder,0,sizeof(base64_encoder_t));
+    encoder.in= inbuf;
+    encoder.linesize= linesize;
+    while( !buffer_eof( inbuf ) ) {
+        out_l= encoder_encodechunk(&encoder,out);
+        buffer_write(out,1,out_l,outbuf);
+    }
+}
 
-	if (linesize != NO_LINE_BREAK && linesize < 4) {
-	    linesize= BASE64_DEFAULT_LINE_SIZE;
-	}
+base64_encoder_t * base64_encoder_create(BUFFER * in, int linesize) {
+    base64_encoder_t * encoder;
+    if (in == NULL) {
+        log_error("base64_encoder_create: in is a NULL pointer.");
+        return NULL;
+    }
+    encoder= calloc(1,sizeof(base64_encoder_t));
+    if (encoder == NULL) {
+        log_error("base64_encoder_create: can't allocate encoder.");
+        return NULL;
+    }
+    base64_encoder_reset(encoder,in,linesize);
+    return encoder;
+}
 
-    while( !buffer_eof( inbuf ) ) {
-        in_l = 0;
-        in[0] = in[1] = in[2] = 0;
-        for( i = 0; i < 3; i++ ) {
-        	int c = buffer_getc( inbuf );
-            if ( c != BUFFER_EOF ) {
-            	in[i] = (unsigned char) c;
-                in_l++;
+int base64_encoder_reset(base64_encoder_t * encoder, BUFFER * in, int linesize) {
+    size_t blocks, line_blocks;
+    if (encoder == NULL || in == NULL) {
+        log_error("base64_encoder_reset: encoder or in is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    if (linesize != NO_LINE_BREAK && linesize < 4) {
+        linesize= BASE64_DEFAULT_LINE_SIZE;
+    }
+    encoder->in= in;
+    encoder->linesize= linesize;
+    encoder->line_l= 0;
+    encoder->pending_l= encoder->pending_pos= 0;
+    /* 4 chars per block, and a line break every line_blocks blocks and after the last one */
+    blocks= (buffer_length(in) + 2) / 3;
+    encoder->length= blocks * 4;
+    if (linesize != NO_LINE_BREAK) {
+        line_blocks= (linesize + 3) / 4;
+        encoder->length+= 2 * ((blocks + line_blocks - 1) / line_blocks);
+    }
+    return BUFFER_OK;
+}
+
+size_t base64_encoder_length(const base64_encoder_t * encoder) {
+    return (encoder != NULL) ? encoder->length : 0;
+}
+
+size_t base64_encoder_read(void * dst, size_t size, size_t count, void * _encoder) {
+    base64_encoder_t * encoder;
+    unsigned char * out= dst;
+    size_t room, n, out_l= 0;
+    if (dst == NULL || _encoder == NULL) {
+        log_error("base64_encoder_read: dst or encoder is a NULL pointer.");
+        return 0;
+    }
+    encoder= (base64_encoder_t *)_encoder;
+    room= size * count;
+    while (out_l < room) {
+        if (encoder->pending_pos < encoder->pending_l) {
+            /* encoded bytes left from the previous read */
+            n= encoder->pending_l - encoder->pending_pos;
+            if (n > room - out_l) {
+                n= room - out_l;
             }
+            memcpy(&out[out_l],&(encoder->pending[encoder->pending_pos]),n);
+            encoder->pending_pos+= n;
+            out_l+= n;
         }
-        if( in_l > 0 ) {
-            encodeblock( in, in_l, out );
-            b_out += buffer_write(out,1,4,outbuf);
+        else if (buffer_eof(encoder->in)) {
+            break;
         }
-        if (linesize != NO_LINE_BREAK) {
-            if( b_out >= linesize || buffer_eof( inbuf )) {
-                buffer_write("\r\n",1,2,outbuf);
-                b_out = 0;
-            }
+        else if (room - out_l >= ENCODER_CHUNK_SIZE) {
+            /* enough room: encode directly into dst */
+            out_l+= encoder_encodechunk(encoder,&out[out_l]);
+        }
+        else {
+            encoder->pending_l= encoder_encodechunk(encoder,encoder->pending);
+            encoder->pending_pos= 0;
         }
     }
+    return out_l;
+}
+
+void base64_encoder_delete(base64_encoder_t * encoder) {
+    if (encoder == NULL) return;
+    free(encoder);
 }
 
 /**
@@ -88,35 +368,268 @@ static void decodeblock( const unsigned char in[4], unsigned char out[3] ) {
 	out[2] = (((in[2] << 6) & 0xc0) | in[3]);
 }
 
+/** size of the decoded bytes array, flushed to the out buffer when full */
+#define DECODER_OUT_SIZE 768
+/** extra room for the vector stores, wider than the decoded bytes */
+#define DECODER_OUT_SLACK 8
+
 /**
- * Base64 decodes the in buffer into the out buffer.
+ * Streaming decoder state: the out buffer and the chars of the incomplete block.
  */
-void base64_decode( BUFFER * inbuf, BUFFER * outbuf ) {
-    unsigned char in[4], out[3];
-    int c, i, in_l;
-    char * p;
+struct base64_decoder {
+    BUFFER * out;
+    unsigned char in[4];
+    int in_l;
+};
 
-    while( !buffer_eof( inbuf ) ) {
-    	in_l= 0;
-    	in[0] = in[1] = in[2] = in[3] = 0;
-        for( i = 0; i < 4;) {
-        	c= buffer_getc( inbuf );
-        	if (c == BUFFER_EOF) break;
-        	/* drop every char not in table */
-			p= strchr(base64,c);
-			if (p != NULL) {
-				/* index of c in base64 table */
-				in[i] = p - base64;
-				in_l++;
-				i++;
-			}
+/**
+ * Vector decoder: decodes the blocks of block_l chars of in, while all their chars are in
+ * the base64 table, and stores the 3/4 as many decoded bytes into out.
+ * Returns the number of chars decoded, and sets invalid to the offset of the first char
+ * not in table if a block was rejected, or to in_l.
+ */
+typedef size_t decode_vector_f(const unsigned char * in, size_t in_l, unsigned char * out, size_t * invalid);
+
+#ifdef BASE64_SIMD
+
+/*
+ * Vector decoding: a char is in the table if the lookups by its low and high nibbles
+ * have no common bit, its value is the char plus an offset looked up by its high nibble
+ * ('/' shares its high nibble with '+'). The 4 x 6-bit values of each 32-bit lane are
+ * then merged by multiply-add into 3 bytes, and the bytes packed together.
+ */
+#define DECODE_LUT_LO 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a
+#define DECODE_LUT_HI 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+#define DECODE_LUT_ROLL 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0
+#define DECODE_PACK 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+
+__attribute__((target("ssse3")))
+static size_t decode_ssse3(const unsigned char * in, size_t in_l, unsigned char * out, size_t * invalid) {
+    const __m128i lut_lo= _mm_setr_epi8(DECODE_LUT_LO);
+    const __m128i lut_hi= _mm_setr_epi8(DECODE_LUT_HI);
+    const __m128i lut_roll= _mm_setr_epi8(DECODE_LUT_ROLL);
+    const __m128i pack= _mm_setr_epi8(DECODE_PACK);
+    const __m128i mask_2f= _mm_set1_epi8(0x2f);
+    const __m128i mask_0f= _mm_set1_epi8(0x0f);
+    size_t i= 0;
+    while (i + 16 <= in_l) {
+        __m128i str= _mm_loadu_si128((const __m128i *)&in[i]);
+        __m128i hi_nibbles= _mm_and_si128(_mm_srli_epi32(str,4),mask_0f);
+        __m128i lo_nibbles= _mm_and_si128(str,mask_0f);
+        __m128i lo= _mm_shuffle_epi8(lut_lo,lo_nibbles);
+        __m128i hi= _mm_shuffle_epi8(lut_hi,hi_nibbles);
+        __m128i roll;
+        unsigned valid= _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo,hi),_mm_setzero_si128()));
+        if (valid != 0xffff) {
+            *invalid= i + __builtin_ctz(~valid);
+            return i;
+        }
+        roll= _mm_shuffle_epi8(lut_roll,_mm_add_epi8(_mm_cmpeq_epi8(str,mask_2f),hi_nibbles));
+        str= _mm_add_epi8(str,roll);
+        str= _mm_maddubs_epi16(str,_mm_set1_epi32(0x01400140));
+        str= _mm_madd_epi16(str,_mm_set1_epi32(0x00011000));
+        str= _mm_shuffle_epi8(str,pack);
+        _mm_storeu_si128((__m128i *)out,str);
+        out+= 12;
+        i+= 16;
+    }
+    *invalid= in_l;
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t decode_avx2(const unsigned char * in, size_t in_l, unsigned char * out, size_t * invalid) {
+    const __m256i lut_lo= _mm256_setr_epi8(DECODE_LUT_LO, DECODE_LUT_LO);
+    const __m256i lut_hi= _mm256_setr_epi8(DECODE_LUT_HI, DECODE_LUT_HI);
+    const __m256i lut_roll= _mm256_setr_epi8(DECODE_LUT_ROLL, DECODE_LUT_ROLL);
+    const __m256i pack= _mm256_setr_epi8(DECODE_PACK, DECODE_PACK);
+    const __m256i pack_lanes= _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+    const __m256i mask_2f= _mm256_set1_epi8(0x2f);
+    const __m256i mask_0f= _mm256_set1_epi8(0x0f);
+    size_t i= 0;
+    while (i + 32 <= in_l) {
+        __m256i str= _mm256_loadu_si256((const __m256i *)&in[i]);
+        __m256i hi_nibbles= _mm256_and_si256(_mm256_srli_epi32(str,4),mask_0f);
+        __m256i lo_nibbles= _mm256_and_si256(str,mask_0f);
+        __m256i lo= _mm256_shuffle_epi8(lut_lo,lo_nibbles);
+        __m256i hi= _mm256_shuffle_epi8(lut_hi,hi_nibbles);
+        __m256i roll;
+        if (!_mm256_testz_si256(lo,hi)) {
+            unsigned valid= _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(lo,hi),_mm256_setzero_si256()));
+            *invalid= i + __builtin_ctz(~valid);
+            return i;
+        }
+        roll= _mm256_shuffle_epi8(lut_roll,_mm256_add_epi8(_mm256_cmpeq_epi8(str,mask_2f),hi_nibbles));
+        str= _mm256_add_epi8(str,roll);
+        str= _mm256_maddubs_epi16(str,_mm256_set1_epi32(0x01400140));
+        str= _mm256_madd_epi16(str,_mm256_set1_epi32(0x00011000));
+        str= _mm256_shuffle_epi8(str,pack);
+        str= _mm256_permutevar8x32_epi32(str,pack_lanes);
+        _mm256_storeu_si256((__m256i *)out,str);
+        out+= 24;
+        i+= 32;
+    }
+    *invalid= in_l;
+    return i;
+}
+
+/** returns the best vector decoder for the CPU, or NULL */
+static decode_vector_f * decode_vector_select(void) {
+    /* the CPU features are detected once, by a libgcc constructor */
+    if (__builtin_cpu_supports("avx2")) return decode_avx2;
+    if (__builtin_cpu_supports("ssse3")) return decode_ssse3;
+    return NULL;
+}
+
+#else
+
+static decode_vector_f * decode_vector_select(void) {
+    return NULL;
+}
+
+#endif
+
+/**
+ * Decodes the in_l chars into the decoder out buffer, keeping the chars of the
+ * last incomplete block in the decoder.
+ *
+ * Between incomplete blocks, the chars are decoded by the vector decoder, if any, or
+ * 4 at once. The chars not in table (line breaks, padding) are handled one by one.
+ */
+static int decoder_decode(base64_decoder_t * decoder, const unsigned char * in, size_t in_l) {
+    decode_vector_f * decode_vector= decode_vector_select();
+    unsigned char out[DECODER_OUT_SIZE + DECODER_OUT_SLACK];
+    size_t i= 0, out_l= 0, vector_from= 0, m, n, invalid;
+    unsigned char a, b, c, d;
+
+    while (i < in_l) {
+        if (out_l + 3 > DECODER_OUT_SIZE) {
+            if (buffer_write(out,1,out_l,decoder->out) != out_l) return BUFFER_ERROR;
+            out_l= 0;
         }
-        if( in_l > 0) {
-            decodeblock( in, out );
-            for( i = 0; i < in_l - 1; i++ ) {
-                buffer_putc( out[i], outbuf );
+        if (decoder->in_l == 0) {
+            if (decode_vector != NULL && i >= vector_from) {
+                /* as many blocks as fit in out */
+                m= (DECODER_OUT_SIZE - out_l) / 3 * 4;
+                if (m > in_l - i) m= in_l - i;
+                n= decode_vector(&in[i],m,&out[out_l],&invalid);
+                out_l+= n / 4 * 3;
+                if (invalid < m) {
+                    /* no vector decoding until the char not in table is passed */
+                    vector_from= i + invalid + 1;
+                }
+                i+= n;
+                if (n > 0) continue;
+            }
+            if (i + 4 <= in_l) {
+                a= base64_rev[in[i]];
+                b= base64_rev[in[i+1]];
+                c= base64_rev[in[i+2]];
+                d= base64_rev[in[i+3]];
+                if (((a | b | c | d) & 0xc0) == 0) {
+                    out[out_l++]= (a << 2 | b >> 4);
+                    out[out_l++]= (b << 4 | c >> 2);
+                    out[out_l++]= (c << 6 | d);
+                    i+= 4;
+                    continue;
+                }
             }
         }
+        /* drop every char not in table */
+        a= base64_rev[in[i++]];
+        if (a == NOT_BASE64) continue;
+        decoder->in[decoder->in_l++]= a;
+        if (decoder->in_l == 4) {
+            decodeblock(decoder->in,&out[out_l]);
+            out_l+= 3;
+            decoder->in_l= 0;
+        }
+    }
+    if (out_l > 0 && buffer_write(out,1,out_l,decoder->out) != out_l) return BUFFER_ERROR;
+    return BUFFER_OK;
+}
+
+/**
+ * Decodes the last incomplete block of the decoder, if any.
+ */
+static int decoder_finish(base64_decoder_t * decoder) {
+    unsigned char out[3];
+    size_t out_l;
+    if (decoder->in_l == 0) return BUFFER_OK;
+    out_l= decoder->in_l - 1;
+    while (decoder->in_l < 4) {
+        decoder->in[decoder->in_l++]= 0;
+    }
+    decodeblock(decoder->in,out);
+    decoder->in_l= 0;
+    if (out_l > 0 && buffer_write(out,1,out_l,decoder->out) != out_l) return BUFFER_ERROR;
+    return BUFFER_OK;
+}
+
+base64_decoder_t * base64_decoder_create(BUFFER * out) {
+    base64_decoder_t * decoder;
+    if (out == NULL) {
+        log_error("base64_decoder_create: out is a NULL pointer.");
+        return NULL;
+    }
+    decoder= calloc(1,sizeof(base64_decoder_t));
+    if (decoder == NULL) {
+        log_error("base64_decoder_create: can't allocate decoder.");
+        return NULL;
+    }
+    decoder->out= out;
+    return decoder;
+}
+
+int base64_decoder_reset(base64_decoder_t * decoder, BUFFER * out) {
+    if (decoder == NULL || out == NULL) {
+        log_error("base64_decoder_reset: decoder or out is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    decoder->out= out;
+    decoder->in_l= 0;
+    return BUFFER_OK;
+}
+
+size_t base64_decoder_write(const void * src, size_t size, size_t count, void * _decoder) {
+    size_t src_l= size * count;
+    if (src == NULL || _decoder == NULL) {
+        log_error("base64_decoder_write: src or decoder is a NULL pointer.");
+        return 0;
+    }
+    if (decoder_decode((base64_decoder_t *)_decoder,src,src_l) != BUFFER_OK) {
+        log_error("base64_decoder_write: can't write decoded bytes.");
+        return 0;
+    }
+    return src_l;
+}
+
+int base64_decoder_finish(base64_decoder_t * decoder) {
+    if (decoder == NULL) {
+        log_error("base64_decoder_finish: decoder is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    return decoder_finish(decoder);
+}
+
+void base64_decoder_delete(base64_decoder_t * decoder) {
+    if (decoder == NULL) return;
+    free(decoder);
+}
+
+/**
+ * Base64 decodes the in buffer into the out buffer.
+ */
+void base64_decode( BUFFER * inbuf, BUFFER * outbuf ) {
+    unsigned char in[1024];
+    size_t in_l;
+    base64_decoder_t decoder;
+    memset(&decoder,0,sizeof(base64_decoder_t));
+    decoder.out= outbuf;
+    while( !buffer_eof( inbuf ) ) {
+        in_l= buffer_read(in,1,sizeof(in),inbuf);
+        decoder_decode(&decoder,in,in_l);
     }
+    decoder_finish(&decoder);
 }
 
@@ -29,6 +29,9 @@ extern "C" {
 #define BASE64_DEFAULT_LINE_SIZE 64
 #endif
 
+/* line size for base64 encoding without line break */
+#define BASE64_NO_LINE_BREAK -1000
+
 /**
  * Base64 encodes the in buffer into the out buffer (without line break).
  *
@@ -47,6 +50,121 @@ void base64_encode(BUFFER * in, BUFFER * out);
  */
 void base64_encode_l(BUFFER * in, BUFFER * out, int linesize);
 
+/**
+ * Streaming base64 encoder, encoding the in buffer on demand.
+ */
+typedef struct base64_encoder base64_encoder_t;
+
+/**
+ * Creates a streaming base64 encoder for the unread bytes of the in buffer.
+ * The encoded bytes and line breaks are the ones of base64_encode_l(in,out,linesize),
+ * but are only produced when read with base64_encoder_read(...).
+ *
+ * @param BUFFER * in pointer to the in buffer, must not be modified until fully read.
+ * @param int linesize length of the line (min 4), or BASE64_NO_LINE_BREAK
+ *
+ * @return base64_encoder_t * pointer to the new encoder or NULL if an error occurs.
+ */
+base64_encoder_t * base64_encoder_create(BUFFER * in, int linesize);
+
+/**
+ * Resets the encoder to encode the unread bytes of another in buffer, as a
+ * new encoder created by base64_encoder_create(in,linesize), without allocation.
+ *
+ * @param base64_encoder_t * encoder pointer to the encoder.
+ * @param BUFFER * in pointer to the in buffer, must not be modified until fully read.
+ * @param int linesize length of the line (min 4), or BASE64_NO_LINE_BREAK
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
+ */
+int base64_encoder_reset(base64_encoder_t * encoder, BUFFER * in, int linesize);
+
+/**
+ * Returns the total length of the base64 encoded bytes, line breaks included.
+ *
+ * @param base64_encoder_t * encoder pointer to the encoder.
+ *
+ * @return size_t the encoded length.
+ */
+size_t base64_encoder_length(const base64_encoder_t * encoder);
+
+/**
+ * Reads count element, each size byte long, of base64 encoded bytes into the
+ * destination array. The signature is the one of a libcurl CURLOPT_READFUNCTION.
+ *
+ * @param void * dst pointer to the destination array.
+ * @param size_t size in byte of each element.
+ * @param size_t count number of element to read.
+ * @param base64_encoder_t * encoder pointer to the encoder.
+ *
+ * @return size_t number of bytes read, 0 when all the encoded bytes were read.
+ */
+size_t base64_encoder_read(void * dst, size_t size, size_t count, void * encoder);
+
+/**
+ * Deletes the encoder, but not its in buffer.
+ *
+ * @param base64_encoder_t * encoder pointer to the encoder.
+ */
+void base64_encoder_delete(base64_encoder_t * encoder);
+
+/**
+ * Streaming base64 decoder, decoding the written chunks into an out buffer.
+ */
+typedef struct base64_decoder base64_decoder_t;
+
+/**
+ * Creates a streaming base64 decoder writing the decoded bytes into the out buffer.
+ * As base64_decode(in,out), the chars not in the base64 table (line breaks, padding)
+ * are dropped.
+ *
+ * @param BUFFER * out pointer to the out buffer.
+ *
+ * @return base64_decoder_t * pointer to the new decoder or NULL if an error occurs.
+ */
+base64_decoder_t * base64_decoder_create(BUFFER * out);
+
+/**
+ * Resets the decoder to write into another out buffer, dropping the chars of an
+ * incomplete block, as a new decoder created by base64_decoder_create(out).
+ *
+ * @param base64_decoder_t * decoder pointer to the decoder.
+ * @param BUFFER * out pointer to the out buffer.
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
+ */
+int base64_decoder_reset(base64_decoder_t * decoder, BUFFER * out);
+
+/**
+ * Decodes count element, each size byte long, of base64 encoded chars from the source
+ * array. The chars of an incomplete 4 chars block are kept until the next write, or
+ * base64_decoder_finish(decoder). The signature is the one of a libcurl CURLOPT_WRITEFUNCTION.
+ *
+ * @param void * src pointer to the source array.
+ * @param size_t size size in byte of each element.
+ * @param size_t count number of element to decode.
+ * @param base64_decoder_t * decoder pointer to the decoder.
+ *
+ * @return size_t number of bytes consumed from the source array, or 0 if an error occurs.
+ */
+size_t base64_decoder_write(const void * src, size_t size, size_t count, void * decoder);
+
+/**
+ * Decodes the last incomplete block, if any, into the out buffer.
+ *
+ * @param base64_decoder_t * decoder pointer to the decoder.
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
+ */
+int base64_decoder_finish(base64_decoder_t * decoder);
+
+/**
+ * Deletes the decoder, but not its out buffer.
+ *
+ * @param base64_decoder_t * decoder pointer to the decoder.
+ */
+void base64_decoder_delete(base64_decoder_t * decoder);
+
 /**
  * Base64 decodes the in buffer into the out buffer.
  *
@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "buffer.h"
 #include "log.h"
@@ -40,14 +41,128 @@
 #define BUFFER_INITIAL_SIZE 16
 #endif
 
+/*
+ * segment size of the segmented buffers, and maximum number of free segments
+ * kept in the process-wide pool
+ */
+#ifndef BUFFER_SEGMENT_SIZE
+#define BUFFER_SEGMENT_SIZE 8192
+#endif
+#ifndef BUFFER_SEGMENT_POOL_SIZE
+#define BUFFER_SEGMENT_POOL_SIZE 64
+#endif
+
+/* segment of a segmented buffer */
+typedef struct buffer_segment {
+    struct buffer_segment * next;
+    size_t size; /* allocated data size */
+    size_t start; /* first byte, > 0 only after a buffer_ungetc() at the beginning */
+    size_t wpos; /* write position */
+    unsigned char data[];
+} buffer_segment_t;
+
 /* memory buffer structure */
 struct buffer {
     unsigned char * data; /* bytes */
     size_t size; /* allocated size */
-    size_t wpos; /* write position */
-    size_t rpos; /* read position */
+    size_t wpos; /* write position, or number of bytes written if segmented */
+    size_t rpos; /* read position, or number of bytes read if segmented */
+    buffer_segment_t * head; /* segments, NULL if the buffer is not segmented */
+    buffer_segment_t * tail;
+    buffer_segment_t * rseg; /* read segment */
+    size_t roff; /* read position in the read segment */
+    buffer_segment_t * spare; /* segments kept by buffer_reset() for reuse */
 };
 
+#define SEGMENTED(buffer) ((buffer)->head != NULL)
+
+/* free segments pool */
+static pthread_mutex_t segment_pool_lock= PTHREAD_MUTEX_INITIALIZER;
+static buffer_segment_t * segment_pool= NULL;
+static size_t segment_pool_l= 0;
+
+/** gets a segment of at least size bytes, from the pool if possible */
+static buffer_segment_t * segment_get(size_t size) {
+    buffer_segment_t * segment= NULL;
+    if (size <= BUFFER_SEGMENT_SIZE) {
+        size= BUFFER_SEGMENT_SIZE;
+        pthread_mutex_lock(&segment_pool_lock);
+        if (segment_pool != NULL) {
+            segment= segment_pool;
+            segment_pool= segment->next;
+            segment_pool_l--;
+        }
+        pthread_mutex_unlock(&segment_pool_lock);
+    }
+    if (segment == NULL) {
+        segment= malloc(sizeof(buffer_segment_t) + size);
+        if (segment == NULL) {
+            log_error("segment_get: malloc of %d bytes failed.", (int)size);
+            return NULL;
+        }
+        segment->size= size;
+    }
+    segment->next= NULL;
+    segment->start= 0;
+    segment->wpos= 0;
+    return segment;
+}
+
+/** returns the segments chain to the pool, or frees them */
+static void segment_release(buffer_segment_t * segment) {
+    while (segment != NULL) {
+        buffer_segment_t * next= segment->next;
+        int pooled= FALSE;
+        if (segment->size == BUFFER_SEGMENT_SIZE) {
+            pthread_mutex_lock(&segment_pool_lock);
+            if (segment_pool_l < BUFFER_SEGMENT_POOL_SIZE) {
+                segment->next= segment_pool;
+                segment_pool= segment;
+                segment_pool_l++;
+                pooled= TRUE;
+            }
+            pthread_mutex_unlock(&segment_pool_lock);
+        }
+        if (!pooled) free(segment);
+        segment= next;
+    }
+}
+
+/**
+ * appends a spare segment of at least min bytes if any, or a new segment of at
+ * least size bytes
+ */
+static buffer_segment_t * segment_append(BUFFER * buffer, size_t min, size_t size) {
+    buffer_segment_t * segment= buffer->spare;
+    if (segment != NULL && segment->size >= min) {
+        buffer->spare= segment->next;
+        segment->next= NULL;
+        segment->start= 0;
+        segment->wpos= 0;
+    }
+    else {
+        segment= segment_get(size);
+        if (segment == NULL) {
+            return NULL;
+        }
+    }
+    buffer->tail->next= segment;
+    buffer->tail= segment;
+    return segment;
+}
+
+/**
+ * Moves the read segment to the next segment with unread bytes, if the read
+ * segment is fully read. Returns the number of contiguous unread bytes.
+ */
+static size_t segment_readable(BUFFER * buffer) {
+    while (buffer->roff >= buffer->rseg->wpos && buffer->rseg->next != NULL) {
+        buffer->rseg= buffer->rseg->next;
+        buffer->roff= buffer->rseg->start;
+    }
+    return buffer->rseg->wpos - buffer->roff;
+}
+
 /* constructor */
 BUFFER * buffer_create(size_t size) {
     BUFFER * buffer= calloc(1,sizeof(BUFFER));
@@ -71,10 +186,29 @@ BUFFER * buffer_create(size_t size) {
     return buffer;
 }
 
+BUFFER * buffer_create_segmented(void) {
+    BUFFER * buffer= calloc(1,sizeof(BUFFER));
+    if (buffer == NULL) {
+        log_error("buffer_create_segmented: calloc BUFFER failed.");
+        return NULL;
+    }
+    buffer->head= segment_get(BUFFER_SEGMENT_SIZE);
+    if (buffer->head == NULL) {
+        log_error("buffer_create_segmented: can't allocate first segment.");
+        free(buffer);
+        return NULL;
+    }
+    buffer->tail= buffer->rseg= buffer->head;
+    buffer->roff= 0;
+    return buffer;
+}
+
 /* destroy */
 void buffer_delete(BUFFER * buffer) {
     if (buffer == NULL) return;
     if (buffer->data != NULL) free(buffer->data);
+    segment_release(buffer->head);
+    segment_release(buffer->spare);
     free(buffer);
     buffer= NULL;
 }
@@ -123,6 +257,14 @@ size_t buffer_fwrite(BUFFER * buffer, FILE * ostream) {
         return BUFFER_ERROR;
     }
     /* TODO: only write unread data [rpos..wpos] or all? */
+    if (SEGMENTED(buffer)) {
+        buffer_segment_t * segment;
+        size_t nbytes= 0;
+        for (segment= buffer->head; segment != NULL; segment= segment->next) {
+            nbytes+= fwrite(&(segment->data[segment->start]),sizeof(char),segment->wpos - segment->start,ostream);
+        }
+        return nbytes;
+    }
     return fwrite(buffer->data,sizeof(char),buffer->wpos,ostream);
 }
 
@@ -136,6 +278,31 @@ size_t buffer_write(const void * src, size_t size, size_t count, void * _buffer)
     }
     buffer = (BUFFER *)_buffer;
     nbytes = size * count;
+    if (SEGMENTED(buffer)) {
+        /* fill the last segment, then append new ones */
+        const unsigned char * bytes= src;
+        size_t written= 0;
+        while (written < nbytes) {
+            buffer_segment_t * segment= buffer->tail;
+            size_t n= segment->size - segment->wpos;
+            if (n == 0) {
+                segment= segment_append(buffer, 1, nbytes - written);
+                if (segment == NULL) {
+                    log_error("buffer_write: can't append a segment for %d bytes.", (int)(nbytes - written));
+                    return BUFFER_ERROR;
+                }
+                n= segment->size;
+            }
+            if (n > nbytes - written) {
+                n= nbytes - written;
+            }
+            memcpy(&(segment->data[segment->wpos]), &bytes[written], n);
+            segment->wpos+= n;
+            written+= n;
+        }
+        buffer->wpos+= nbytes;
+        return nbytes;
+    }
     if (buffer_ensure_capacity(buffer, nbytes) != BUFFER_OK) {
         log_error("buffer_write: can't increase buffer capacity by %d bytes.", (int)nbytes);
         return BUFFER_ERROR;
@@ -174,6 +341,21 @@ size_t buffer_read(void * dst, size_t size, size_t count, void * _buffer) {
         /* copy only available bytes */
         nbytes= available;
     }
+    if (SEGMENTED(buffer)) {
+        unsigned char * bytes= dst;
+        size_t n, copied= 0;
+        while (copied < nbytes) {
+            n= segment_readable(buffer);
+            if (n > nbytes - copied) {
+                n= nbytes - copied;
+            }
+            memcpy(&bytes[copied], &(buffer->rseg->data[buffer->roff]), n);
+            buffer->roff+= n;
+            copied+= n;
+        }
+        buffer->rpos+= nbytes;
+        return nbytes;
+    }
     memcpy(dst, &(buffer->data[buffer->rpos]), nbytes);
     buffer->rpos += nbytes;
     return nbytes;
@@ -195,6 +377,11 @@ int buffer_getc(BUFFER * buffer) {
     }
     if (buffer_eof(buffer))
         return BUFFER_EOF;
+    else if (SEGMENTED(buffer)) {
+        segment_readable(buffer);
+        buffer->rpos++;
+        return buffer->rseg->data[buffer->roff++];
+    }
     else {
         c= buffer->data[buffer->rpos];
         buffer->rpos++;
@@ -209,6 +396,44 @@ int buffer_ungetc(int c, BUFFER * buffer) {
         return BUFFER_ERROR;
     }
     uc= (unsigned char)c;
+    if (SEGMENTED(buffer)) {
+        if (buffer->roff <= buffer->rseg->start) {
+            buffer_segment_t * prev= NULL, * segment;
+            /* last segment with bytes before the read segment */
+            for (segment= buffer->head; segment != buffer->rseg; segment= segment->next) {
+                if (segment->wpos > segment->start) prev= segment;
+            }
+            if (prev != NULL) {
+                buffer->rseg= prev;
+                buffer->roff= prev->wpos;
+            }
+            else if (buffer->head->start == 0) {
+                /* prepend a segment, filled from its end */
+                segment= segment_get(BUFFER_SEGMENT_SIZE);
+                if (segment == NULL) {
+                    log_error("buffer_ungetc: can't prepend a segment.");
+                    return BUFFER_ERROR;
+                }
+                segment->start= segment->wpos= segment->size;
+                segment->next= buffer->head;
+                buffer->head= buffer->rseg= segment;
+                buffer->roff= segment->wpos;
+                buffer->wpos++;
+                buffer->rpos++;
+                segment->start--;
+            }
+            else {
+                buffer->rseg= buffer->head;
+                buffer->roff= buffer->head->start;
+                buffer->head->start--;
+                buffer->wpos++;
+                buffer->rpos++;
+            }
+        }
+        buffer->rpos--;
+        buffer->rseg->data[--buffer->roff]= uc;
+        return BUFFER_OK;
+    }
     if (buffer->rpos == 0) {
         /* shift the whole data buffer by 1 */
         if (buffer_ensure_capacity(buffer, 1) != BUFFER_OK) {
@@ -232,6 +457,19 @@ int buffer_putc(int c, BUFFER * buffer) {
         return BUFFER_ERROR;
     }
     uc= (unsigned char)c;
+    if (SEGMENTED(buffer)) {
+        buffer_segment_t * segment= buffer->tail;
+        if (segment->wpos == segment->size) {
+            segment= segment_append(buffer, 1, 1);
+            if (segment == NULL) {
+                log_error("buffer_putc: can't append a segment.");
+                return BUFFER_ERROR;
+            }
+        }
+        segment->data[segment->wpos++]= uc;
+        buffer->wpos++;
+        return c;
+    }
     if (buffer_ensure_capacity(buffer, 1) != BUFFER_OK) {
         log_error("buffer_putc: can't increase buffer capacity by 1 byte.");
         return BUFFER_ERROR;
@@ -248,6 +486,10 @@ int buffer_rewind(BUFFER * buffer) {
         log_error("buffer_rewind: buffer is a NULL pointer.");
         return BUFFER_ERROR;
     }
+    if (SEGMENTED(buffer)) {
+        buffer->rseg= buffer->head;
+        buffer->roff= buffer->head->start;
+    }
     buffer->rpos= 0;
     return BUFFER_OK;
 }
@@ -259,7 +501,17 @@ int buffer_reset(BUFFER * buffer) {
     }
     buffer->rpos= 0;
     buffer->wpos= 0;
-    memset(buffer->data,0,buffer->size);
+    if (SEGMENTED(buffer)) {
+        /* the segments after the first one are kept for reuse */
+        if (buffer->head->next != NULL) {
+            buffer->tail->next= buffer->spare;
+            buffer->spare= buffer->head->next;
+            buffer->head->next= NULL;
+        }
+        buffer->head->start= buffer->head->wpos= 0;
+        buffer->tail= buffer->rseg= buffer->head;
+        buffer->roff= 0;
+    }
     return BUFFER_OK;
 }
 
@@ -273,3 +525,263 @@ size_t buffer_length(BUFFER * buffer) {
 
 
 
+
+const unsigned char * buffer_peek(BUFFER * buffer, size_t * length) {
+    if (buffer == NULL || length == NULL) {
+        log_error("buffer_peek: buffer or length is a NULL pointer.");
+        return NULL;
+    }
+    if (SEGMENTED(buffer)) {
+        *length= segment_readable(buffer);
+        return &(buffer->rseg->data[buffer->roff]);
+    }
+    *length= buffer->wpos - buffer->rpos;
+    return &(buffer->data[buffer->rpos]);
+}
+
+int buffer_skip(BUFFER * buffer, size_t n) {
+    if (buffer == NULL) {
+        log_error("buffer_skip: buffer is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    if (n > buffer->wpos - buffer->rpos) {
+        return BUFFER_EOF;
+    }
+    buffer->rpos+= n;
+    if (SEGMENTED(buffer)) {
+        while (n > 0) {
+            size_t available= segment_readable(buffer);
+            if (available > n) {
+                available= n;
+            }
+            buffer->roff+= available;
+            n-= available;
+        }
+    }
+    return BUFFER_OK;
+}
+
+unsigned char * buffer_reserve(BUFFER * buffer, size_t n) {
+    if (buffer == NULL) {
+        log_error("buffer_reserve: buffer is a NULL pointer.");
+        return NULL;
+    }
+    if (SEGMENTED(buffer)) {
+        buffer_segment_t * segment= buffer->tail;
+        if (n > segment->size - segment->wpos) {
+            segment= segment_append(buffer, n, n);
+            if (segment == NULL) {
+                log_error("buffer_reserve: can't append a segment for %d bytes.",(int)n);
+                return NULL;
+            }
+        }
+        return &(segment->data[segment->wpos]);
+    }
+    if (buffer_ensure_capacity(buffer, n) != BUFFER_OK) {
+        log_error("buffer_reserve: can't increase buffer capacity by %d bytes.",(int)n);
+        return NULL;
+    }
+    return &(buffer->data[buffer->wpos]);
+}
+
+int buffer_commit(BUFFER * buffer, size_t n) {
+    if (buffer == NULL) {
+        log_error("buffer_commit: buffer is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    if (SEGMENTED(buffer)) {
+        if (n > buffer->tail->size - buffer->tail->wpos) {
+            log_error("buffer_commit: %d bytes exceed the reserved capacity.",(int)n);
+            return BUFFER_ERROR;
+        }
+        buffer->tail->wpos+= n;
+        buffer->wpos+= n;
+        return BUFFER_OK;
+    }
+    if (n > buffer->size - buffer->wpos) {
+        log_error("buffer_commit: %d bytes exceed the reserved capacity.",(int)n);
+        return BUFFER_ERROR;
+    }
+    buffer->wpos+= n;
+    return BUFFER_OK;
+}
+
+/*
+ * big-endian fixed width integers: the width is checked once, then the bytes
+ * are read or written directly in the buffer memory.
+ */
+
+/**
+ * Consumes n unread bytes, n must be available. Returns a pointer to the bytes
+ * in the buffer memory, or copied in tmp if they span several segments.
+ */
+static const unsigned char * buffer_take(BUFFER * buffer, size_t n, unsigned char * tmp) {
+    const unsigned char * p;
+    if (SEGMENTED(buffer)) {
+        if (segment_readable(buffer) < n) {
+            buffer_read(tmp, 1, n, buffer);
+            return tmp;
+        }
+        p= &(buffer->rseg->data[buffer->roff]);
+        buffer->roff+= n;
+    }
+    else {
+        p= &(buffer->data[buffer->rpos]);
+    }
+    buffer->rpos+= n;
+    return p;
+}
+int buffer_getbe16(BUFFER * buffer, uint16_t * value) {
+    unsigned char tmp[2];
+    const unsigned char * p;
+    if (buffer == NULL || value == NULL) {
+        log_error("buffer_getbe16: buffer or value is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    if (buffer->wpos - buffer->rpos < 2) {
+        return BUFFER_EOF;
+    }
+    p= buffer_take(buffer, sizeof(tmp), tmp);
+    *value= (uint16_t)((p[0] << 8) | p[1]);
+    return BUFFER_OK;
+}
+
+int buffer_getbe32(BUFFER * buffer, uint32_t * value) {
+    unsigned char tmp[4];
+    const unsigned char * p;
+    if (buffer == NULL || value == NULL) {
+        log_error("buffer_getbe32: buffer or value is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    if (buffer->wpos - buffer->rpos < 4) {
+        return BUFFER_EOF;
+    }
+    p= buffer_take(buffer, sizeof(tmp), tmp);
+    *value= ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+    return BUFFER_OK;
+}
+
+int buffer_getbe64(BUFFER * buffer, uint64_t * value) {
+    unsigned char tmp[8];
+    const unsigned char * p;
+    if (buffer == NULL || value == NULL) {
+        log_error("buffer_getbe64: buffer or value is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    if (buffer->wpos - buffer->rpos < 8) {
+        return BUFFER_EOF;
+    }
+    p= buffer_take(buffer, sizeof(tmp), tmp);
+    *value= ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48)
+          | ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32)
+          | ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16)
+          | ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+    return BUFFER_OK;
+}
+
+int buffer_putbe16(uint16_t value, BUFFER * buffer) {
+    unsigned char * p= buffer_reserve(buffer, 2);
+    if (p == NULL) {
+        return BUFFER_ERROR;
+    }
+    p[0]= (unsigned char)(value >> 8);
+    p[1]= (unsigned char)value;
+    return buffer_commit(buffer, 2);
+}
+
+int buffer_putbe32(uint32_t value, BUFFER * buffer) {
+    unsigned char * p= buffer_reserve(buffer, 4);
+    if (p == NULL) {
+        return BUFFER_ERROR;
+    }
+    p[0]= (unsigned char)(value >> 24);
+    p[1]= (unsigned char)(value >> 16);
+    p[2]= (unsigned char)(value >> 8);
+    p[3]= (unsigned char)value;
+    return buffer_commit(buffer, 4);
+}
+
+int buffer_putbe64(uint64_t value, BUFFER * buffer) {
+    unsigned char * p= buffer_reserve(buffer, 8);
+    int i;
+    if (p == NULL) {
+        return BUFFER_ERROR;
+    }
+    for (i= 7; i >= 0; i--) {
+        p[i]= (unsigned char)value;
+        value>>= 8;
+    }
+    return buffer_commit(buffer, 8);
+}
+
+int buffer_getiovec(BUFFER * buffer, struct iovec * iov, int iovcnt) {
+    buffer_segment_t * segment;
+    size_t offset;
+    int n= 0;
+    if (buffer == NULL) {
+        log_error("buffer_getiovec: buffer is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    if (!SEGMENTED(buffer)) {
+        if (buffer->wpos == buffer->rpos) {
+            return 0;
+        }
+        if (iov != NULL && iovcnt > 0) {
+            iov[0].iov_base= &(buffer->data[buffer->rpos]);
+            iov[0].iov_len= buffer->wpos - buffer->rpos;
+        }
+        return 1;
+    }
+    offset= buffer->roff;
+    for (segment= buffer->rseg; segment != NULL; segment= segment->next) {
+        if (segment->wpos > offset) {
+            if (iov != NULL) {
+                if (n >= iovcnt) break;
+                iov[n].iov_base= &(segment->data[offset]);
+                iov[n].iov_len= segment->wpos - offset;
+            }
+            n++;
+        }
+        if (segment->next != NULL) {
+            offset= segment->next->start;
+        }
+    }
+    return n;
+}
+
+int buffer_trim(BUFFER * buffer, size_t size) {
+    if (buffer == NULL) {
+        log_error("buffer_trim: buffer is a NULL pointer.");
+        return BUFFER_ERROR;
+    }
+    if (SEGMENTED(buffer)) {
+        buffer_segment_t * segment, ** link;
+        size_t capacity= 0;
+        for (segment= buffer->head; segment != NULL; segment= segment->next) {
+            capacity+= segment->size;
+        }
+        /* keep the spare segments fitting in size */
+        link= &(buffer->spare);
+        while (*link != NULL && capacity + (*link)->size <= size) {
+            capacity+= (*link)->size;
+            link= &((*link)->next);
+        }
+        segment_release(*link);
+        *link= NULL;
+        return BUFFER_OK;
+    }
+    if (size < buffer->wpos) {
+        size= buffer->wpos;
+    }
+    if (size < BUFFER_INITIAL_SIZE) {
+        size= BUFFER_INITIAL_SIZE;
+    }
+    if (size < buffer->size) {
+        unsigned char * tmp_data= realloc(buffer->data, size);
+        if (tmp_data != NULL) {
+            buffer->data= tmp_data;
+            buffer->size= size;
+        }
+    }
+    return BUFFER_OK;
+}
@@ -23,8 +23,10 @@ extern "C" {
 #endif
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <limits.h>
+#include <sys/uio.h> /* struct iovec */
 
 /** buffer EOF and ERROR */
 #define BUFFER_EOF    INT_MIN
@@ -55,6 +57,20 @@ typedef struct buffer BUFFER;
  */
 BUFFER * buffer_create(size_t size);
 
+/**
+ * Creates a segmented buffer: the bytes are stored in a chain of fixed-size
+ * segments, taken from a process-wide pool. Growing the buffer appends a
+ * segment, and never moves the bytes already written. A write larger than
+ * a segment is stored in a single segment of its size.
+ *
+ * A segmented buffer has the same semantics as a buffer created by
+ * buffer_create(), except that buffer_peek() and buffer_reserve() regions
+ * are limited to one segment. Use buffer_getiovec() to get all the segments.
+ *
+ * @return a pointer to the new buffer or NULL if an error occurs.
+ */
+BUFFER * buffer_create_segmented(void);
+
 /**
  * Delete the buffer.
  *
@@ -160,7 +176,8 @@ int buffer_putc(int c, BUFFER * buffer);
 int buffer_rewind(BUFFER * buffer);
 
 /**
- * Reset the buffer write and read position pointer, and zero the buffer content.
+ * Reset the buffer write and read position pointer. The allocated memory is
+ * kept to be reused, see buffer_trim().
  *
  * @param BUFFER * buffer pointer to the buffer.
  *
@@ -168,6 +185,18 @@ int buffer_rewind(BUFFER * buffer);
  */
 int buffer_reset(BUFFER * buffer);
 
+/**
+ * Releases the memory allocated by the buffer beyond size bytes, if not used
+ * by the written bytes. Usually called after buffer_reset() to bound the memory
+ * kept between two uses of the buffer.
+ *
+ * @param BUFFER * buffer pointer to the buffer.
+ * @param size_t size maximum size of the allocated memory to keep.
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
+ */
+int buffer_trim(BUFFER * buffer, size_t size);
+
 /**
  * Returns the number of char available to read.
  *
@@ -177,6 +206,96 @@ int buffer_reset(BUFFER * buffer);
  */
 size_t buffer_length(BUFFER * buffer);
 
+/**
+ * Returns the contiguous region of unread bytes, without consuming them. For a
+ * segmented buffer, the region ends at the end of the current segment and can
+ * be shorter than buffer_length().
+ * The region is valid until the next write into the buffer. Use buffer_skip()
+ * to consume the bytes.
+ *
+ * @param BUFFER * buffer pointer to the buffer.
+ * @param size_t * length set to the number of bytes available in the region.
+ *
+ * @return const unsigned char * pointer to the first unread byte
+ *                               or NULL if an error occurs.
+ */
+const unsigned char * buffer_peek(BUFFER * buffer, size_t * length);
+
+/**
+ * Consumes n unread bytes, usually after a buffer_peek().
+ *
+ * @param BUFFER * buffer pointer to the buffer.
+ * @param size_t n number of bytes to consume.
+ *
+ * @return int BUFFER_OK, BUFFER_EOF if less than n bytes are available (nothing
+ *             is consumed) or BUFFER_ERROR if an error occurs.
+ */
+int buffer_skip(BUFFER * buffer, size_t n);
+
+/**
+ * Reserves a contiguous writable region of at least n bytes at the end of
+ * the buffer. The bytes written in the region are added to the buffer by
+ * buffer_commit(). The region is valid until the next write into the buffer.
+ *
+ * @param BUFFER * buffer pointer to the buffer.
+ * @param size_t n number of bytes to reserve.
+ *
+ * @return unsigned char * pointer to the writable region
+ *                         or NULL if an error occurs.
+ */
+unsigned char * buffer_reserve(BUFFER * buffer, size_t n);
+
+/**
+ * Adds the n first bytes of the region returned by buffer_reserve() to the buffer.
+ *
+ * @param BUFFER * buffer pointer to the buffer.
+ * @param size_t n number of bytes written in the reserved region.
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if an error occurs (n larger than
+ *             the reserved region).
+ */
+int buffer_commit(BUFFER * buffer, size_t n);
+
+/**
+ * Reads a 16, 32 or 64-bit big-endian (network order) unsigned integer.
+ *
+ * @param BUFFER * buffer pointer to the buffer.
+ * @param uintN_t * value set to the integer read.
+ *
+ * @return int BUFFER_OK, BUFFER_EOF if not enough bytes are available (nothing
+ *             is consumed) or BUFFER_ERROR if an error occurs.
+ */
+int buffer_getbe16(BUFFER * buffer, uint16_t * value);
+int buffer_getbe32(BUFFER * buffer, uint32_t * value);
+int buffer_getbe64(BUFFER * buffer, uint64_t * value);
+
+/**
+ * Adds a 16, 32 or 64-bit unsigned integer in big-endian (network order) at
+ * the end of the buffer.
+ *
+ * @param uintN_t value the integer to add.
+ * @param BUFFER * buffer pointer to the buffer.
+ *
+ * @return int BUFFER_OK or BUFFER_ERROR if an error occurs.
+ */
+int buffer_putbe16(uint16_t value, BUFFER * buffer);
+int buffer_putbe32(uint32_t value, BUFFER * buffer);
+int buffer_putbe64(uint64_t value, BUFFER * buffer);
+
+/**
+ * Describes the unread bytes of the buffer as an array of contiguous regions,
+ * one per segment for a segmented buffer. The regions are valid until the next
+ * write into the buffer.
+ *
+ * @param BUFFER * buffer pointer to the buffer.
+ * @param struct iovec * iov the array to fill, or NULL to only count the regions.
+ * @param int iovcnt the size of the iov array.
+ *
+ * @return int number of regions filled in iov, or the total number of regions
+ *             if iov is NULL, or BUFFER_ERROR if an error occurs.
+ */
+int buffer_getiovec(BUFFER * buffer, struct iovec * iov, int iovcnt);
+
 #ifdef  __cplusplus
 }
 #endif
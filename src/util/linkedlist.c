@@ -17,25 +17,36 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdint.h>
 
 #include "linkedlist.h"
 #include "log.h"
 
-/**
- * List node
+/*
+ * initial capacity of the elements array, allocated on first add
  */
-struct linkedlist_node {
-    void * element;
-    struct linkedlist_node * next;
-};
+#ifndef LLIST_INITIAL_CAPACITY
+#define LLIST_INITIAL_CAPACITY 8
+#endif
+
+/*
+ * llist_delete_elements dedupes lists up to this length with a linear scan,
+ * longer lists with a pointer hash set
+ */
+#ifndef LLIST_DEDUPE_LINEAR_MAX
+#define LLIST_DEDUPE_LINEAR_MAX 16
+#endif
 
 /**
- * Linked list type
+ * Linked list type, backed by a growable array of element pointers:
+ * O(1) indexed access and amortized O(1) append.
  */
 struct linkedlist {
     size_t length;
-    struct linkedlist_node * head;
-    struct linkedlist_node * tail;
+    size_t capacity;
+    void ** elements;
+    arena_t * arena; /* NULL if allocated on the heap */
 };
 
 linkedlist_t * llist_create( void ) {
@@ -44,9 +55,24 @@ linkedlist_t * llist_create( void ) {
 		log_error("llist_create: can't allocate linkedlist_t.");
 		return NULL;
 	}
-	list->head= NULL;
-	list->tail= list->head;
+	list->elements= NULL;
+	list->capacity= 0;
 	list->length= 0;
+	list->arena= NULL;
+	return list;
+}
+
+linkedlist_t * llist_create_arena(arena_t * arena) {
+	linkedlist_t * list;
+	if (arena == NULL) {
+		return llist_create();
+	}
+	list= arena_calloc(arena,1,sizeof(linkedlist_t));
+	if (list == NULL) {
+		log_error("llist_create_arena: can't allocate linkedlist_t from arena.");
+		return NULL;
+	}
+	list->arena= arena;
 	return list;
 }
 
@@ -58,34 +84,48 @@ size_t llist_length(const linkedlist_t * list) {
 	return list->length;
 }
 
+/**
+ * Ensures that the elements array can store at least one more element.
+ * The capacity is doubled on overflow.
+ *
+ * @return LLIST_OK or LLIST_ERROR if the realloc failed.
+ */
+static int llist_ensure_capacity(linkedlist_t * list) {
+	size_t new_capacity;
+	void ** tmp_elements;
+	if (list->length < list->capacity) {
+		return LLIST_OK;
+	}
+	new_capacity= (list->capacity == 0) ? LLIST_INITIAL_CAPACITY : list->capacity * 2;
+	if (list->arena != NULL) {
+		tmp_elements= arena_realloc(list->arena, list->elements, list->capacity * sizeof(void *), new_capacity * sizeof(void *));
+	}
+	else {
+		tmp_elements= realloc(list->elements, new_capacity * sizeof(void *));
+	}
+	if (tmp_elements == NULL) {
+		log_error("llist_ensure_capacity: can't reallocate elements array (%d elements).", (int)new_capacity);
+		return LLIST_ERROR;
+	}
+	list->elements= tmp_elements;
+	list->capacity= new_capacity;
+	return LLIST_OK;
+}
+
 int llist_add(linkedlist_t * list, void * element) {
-    struct linkedlist_node * node;
 	if (list == NULL) {
 		log_error("llist_add: NULL pointer list.");
 		return LLIST_ERROR;
 	}
-    node= calloc(1,sizeof(struct linkedlist_node));
-	if (node == NULL) {
-		log_error("llist_add: can't allocate linkedlist node.");
+	if (llist_ensure_capacity(list) != LLIST_OK) {
+		log_error("llist_add: can't increase list capacity.");
 		return LLIST_ERROR;
 	}
-    node->element= element;
-    node->next= NULL;
-    if (list->head == NULL) {
-        /* empty list */
-        list->head= node;
-    }
-    else {
-        list->tail->next= node;
-    }
-    list->tail= node;
-    list->length++;
-    return LLIST_OK;
+	list->elements[list->length++]= element;
+	return LLIST_OK;
 }
 
 void * llist_get(linkedlist_t * list, int i) {
-	int j;
-    struct linkedlist_node * current;
 	if (list == NULL) {
 		log_error("llist_get: NULL pointer list.");
 		return NULL;
@@ -94,17 +134,7 @@ void * llist_get(linkedlist_t * list, int i) {
 		log_error("llist_get: index %d out of range.", i);
 		return NULL;
 	}
-	current= list->head;
-    j= 0;
-	while( j < i ) {
-		if (current == NULL) {
-			log_error("llist_get: element at %d is NULL.",j);
-			return NULL;
-		}
-		current= current->next;
-		j++;
-	}
-	return current->element;
+	return list->elements[i];
 }
 
 /**
@@ -112,9 +142,7 @@ void * llist_get(linkedlist_t * list, int i) {
  * Returns the removed element or NULL.
  */
 void * llist_remove(linkedlist_t * list, int i) {
-    int j;
-    struct linkedlist_node * current, * previous;
-    void * element;
+	void * element;
 	if (list == NULL) {
 		log_error("llist_remove: NULL pointer list.");
 		return NULL;
@@ -123,88 +151,111 @@ void * llist_remove(linkedlist_t * list, int i) {
 		log_error("llist_remove: index %d out of range.", i);
 		return NULL; /* empty list case included */
 	}
-	j= 0;
-	current= list->head;
-	previous= NULL;
-	while( j++ < i ) {
-		if (current == NULL) {
-			log_error("llist_remove: index %d not found, NULL at %d.", i, j);
-			return NULL;
-		}
-		previous= current;
-		current= current->next;
-	}
-	if (current == list->head) {
-		/* first element */
-		list->head= current->next;
-	}
-	else {
-		/* not the first element */
-		previous->next= current->next;
-	}
-	if (current == list->tail) {
-		/* last element */
-		list->tail= previous;
-	}
-
-	element= current->element;
-	free(current);
+	element= list->elements[i];
+	/* shift the following elements down by one */
+	memmove(&(list->elements[i]), &(list->elements[i+1]), (list->length - i - 1) * sizeof(void *));
 	list->length--;
 	return element;
 }
 
+/*
+ * Open addressing pointer set used to dedupe the elements before deletion.
+ * The table size is a power of two at least twice the number of elements,
+ * so the load factor stays below 1/2 and probes remain short.
+ */
+static size_t ptrset_hash(const void * ptr, size_t mask) {
+    uintptr_t h= (uintptr_t)ptr;
+    h^= h >> 4; /* allocator alignment leaves the low bits unused */
+    h*= (uintptr_t)0x9E3779B97F4A7C15ULL;
+    return (size_t)(h ^ (h >> 29)) & mask;
+}
+
+/*
+ * Adds ptr to the set. Returns 1 if ptr was added, 0 if it was already in.
+ */
+static int ptrset_add(void ** set, size_t mask, void * ptr) {
+    size_t i= ptrset_hash(ptr,mask);
+    while (set[i] != NULL) {
+        if (set[i] == ptr) {
+            return 0;
+        }
+        i= (i + 1) & mask;
+    }
+    set[i]= ptr;
+    return 1;
+}
+
 int llist_delete_elements(linkedlist_t * list, delete_element_func deletef) {
-    size_t list_l;
-    void ** unique_elts;
-    void * elt, * unique_elt;
-    int unique_elts_l, i, j, duplicated;
+    size_t i, j, set_size, unique_elts_l;
+    void ** set, ** unique_elts;
+    void * elt;
 	if (list == NULL) {
 		log_error("llist_delete_elements: NULL pointer list.");
 		return LLIST_ERROR;
 	}
+	if (list->length == 0) {
+		return LLIST_OK;
+	}
 	/* WARN: the list can contains many times the same element (same memory address) */
-	list_l= llist_length(list);
-	unique_elts= calloc(list_l,sizeof(void *));
-	unique_elts_l= 0, i= 0, j= 0;
-	for (i=0; i<list_l; i++) {
-		elt= llist_get(list,i);
-		/* add elt to elts list if not already included */
-		duplicated= 0;
-		for(j= 0; j<unique_elts_l; j++) {
-			if (elt == unique_elts[j]) {
-				duplicated= 1;
+	/* compact the unique elements in the list array, keeping their order */
+	unique_elts= list->elements;
+	unique_elts_l= 0;
+	if (list->length <= LLIST_DEDUPE_LINEAR_MAX) {
+		/* short list: a linear scan is cheaper than the hash set */
+		for (i= 0; i<list->length; i++) {
+			elt= list->elements[i];
+			for (j= 0; elt != NULL && j<unique_elts_l; j++) {
+				if (elt == unique_elts[j]) {
+					elt= NULL;
+				}
+			}
+			if (elt != NULL) {
+				unique_elts[unique_elts_l++]= elt;
 			}
 		}
-		if (!duplicated) {
-			/* add at end */
-			unique_elts[unique_elts_l++]= elt;
+	}
+	else {
+		set_size= LLIST_INITIAL_CAPACITY;
+		while (set_size < 2 * list->length) {
+			set_size<<= 1;
+		}
+		set= calloc(set_size,sizeof(void *));
+		if (set == NULL) {
+			log_error("llist_delete_elements: can't allocate pointer set (%d slots).",(int)set_size);
+			return LLIST_ERROR;
 		}
+		for (i= 0; i<list->length; i++) {
+			elt= list->elements[i];
+			if (elt != NULL && ptrset_add(set,set_size - 1,elt)) {
+				unique_elts[unique_elts_l++]= elt;
+			}
+		}
+		free(set);
 	}
+	list->length= 0;
 	/* apply delete func on unique element */
-	for(i= 0; i<unique_elts_l; i++) {
-		unique_elt= unique_elts[i];
-		if (deletef) {
-			deletef(unique_elt);
+	if (deletef) {
+		for(i= 0; i<unique_elts_l; i++) {
+			deletef(unique_elts[i]);
 		}
 	}
-	free(unique_elts);
 	return LLIST_OK;
 }
 
 int llist_delete(linkedlist_t * list) {
-    struct linkedlist_node * current, * next;
 	if (list == NULL) {
 		log_error("llist_delete: NULL pointer list.");
 		return LLIST_ERROR;
 	}
-	current= list->head;
-    while( current != NULL ) {
-        next= current->next;
-        free(current);
-        current= next;
-    }
-    free(list);
-    list= NULL;
-    return LLIST_OK;
+	if (list->arena != NULL) {
+		/* released with the arena */
+		return LLIST_OK;
+	}
+	if (list->elements != NULL) {
+		free(list->elements);
+	}
+	free(list);
+	list= NULL;
+	return LLIST_OK;
 }
 
@@ -23,6 +23,7 @@ extern "C" {
 #endif
 
 #include <stddef.h>
+#include "arena.h"
 
 /* Return code OK */
 #define LLIST_OK 0
@@ -30,7 +31,8 @@ extern "C" {
 #define LLIST_ERROR -1
 
 /**
- * Linked list type
+ * Linked list type. The list is backed by a contiguous growable array:
+ * llist_get() is O(1) and llist_add() is amortized O(1).
  */
 typedef struct linkedlist linkedlist_t;
 
@@ -41,6 +43,17 @@ typedef struct linkedlist linkedlist_t;
  */
 linkedlist_t * llist_create( void );
 
+/**
+ * Creates an empty linked list allocated from the arena. The list and its
+ * elements array are released with the arena, llist_delete() does nothing.
+ *
+ * @param arena_t * arena the arena to allocate from, or NULL to allocate the
+ *        list on the heap, as llist_create().
+ *
+ * @return a pointer to the new linked list or NULL if an error occurs.
+ */
+linkedlist_t * llist_create_arena(arena_t * arena);
+
 /**
  * Returns the linked list length.
  *
@@ -72,7 +85,8 @@ int llist_add(linkedlist_t * list, void * element);
 void * llist_get(linkedlist_t * list, int i);
 
 /**
- * Removes the element at position i [0..n-1].
+ * Removes the element at position i [0..n-1]. The following elements are
+ * shifted down, removing the last element is O(1).
  *
  * @param linkedlist_t * list pointer to the linked list.
  * @param int index of the element to remove.
@@ -95,6 +109,9 @@ int llist_delete(linkedlist_t * list);
 /**
  * Applies the delete function on each element contained in the list. The
  * linked list is not released.
+ * An element contained many times in the list (same memory address) is only
+ * deleted once, and NULL elements are skipped. Duplicates are detected with
+ * a pointer hash set, in O(n). The list is empty on return.
  *
  * @param linkedlist_t * list pointer to the linked list.
  * @param delete_element_func delete function to apply to each element.
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Allocation counting shim, included by test/Makefile before the transport
+ * layer sources: their malloc, calloc and realloc calls are counted in
+ * test_allocations.
+ */
+
+#ifndef _TEST_ALLOC_COUNT_H_
+#define _TEST_ALLOC_COUNT_H_
+
+#include <stdlib.h>
+
+extern unsigned long test_allocations;
+
+static inline void * test_malloc(size_t size) {
+    test_allocations++;
+    return malloc(size);
+}
+
+static inline void * test_calloc(size_t n, size_t size) {
+    test_allocations++;
+    return calloc(n,size);
+}
+
+static inline void * test_realloc(void * ptr, size_t size) {
+    test_allocations++;
+    return realloc(ptr,size);
+}
+
+#define malloc(size) test_malloc(size)
+#define calloc(n,size) test_calloc(n,size)
+#define realloc(ptr,size) test_realloc(ptr,size)
+
+#endif
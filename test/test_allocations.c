@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Transport layer allocation test: once a PEP handle is warm, the synchronous,
+ * asynchronous, batch and cached authorizations must not allocate in pep.c,
+ * cache.c, buffer.c and base64.c (counted by alloc_count.h). The requests are
+ * sent to a mock PEP daemon running in a thread.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "pep.h"
+#include "profiles.h"
+#include "hessian.h"
+#include "buffer.h"
+#include "base64.h"
+
+/* warm up calls, then counted calls */
+#define WARMUP 5
+#define COUNTED 20
+#define BATCH 4
+
+unsigned long test_allocations= 0;
+
+static const char * MODEL= "org.glite.authz.common.model.";
+
+/* base64 encoded Hessian response of the mock PEPd */
+static char * mock_response= NULL;
+static size_t mock_response_l= 0;
+
+static hessian_object_t * model_map(const char * class) {
+    char type[128];
+    snprintf(type,sizeof(type),"%s%s",MODEL,class);
+    return hessian_create(HESSIAN_MAP,type);
+}
+
+static void map_put(hessian_object_t * map, const char * key, hessian_object_t * value) {
+    hessian_map_add(map,hessian_create(HESSIAN_STRING,key),value);
+}
+
+/** the Hessian response: one Permit result, without obligation */
+static int mock_response_create(void) {
+    hessian_object_t * response= model_map("Response");
+    hessian_object_t * results= hessian_create(HESSIAN_LIST);
+    hessian_object_t * result= model_map("Result");
+    hessian_object_t * status= model_map("Status");
+    hessian_object_t * status_code= model_map("StatusCode");
+    BUFFER * hessian= buffer_create(1024);
+    BUFFER * b64= buffer_create(1024);
+    map_put(status_code,"code",hessian_create(HESSIAN_STRING,XACML_STATUSCODE_OK));
+    map_put(status_code,"subCode",hessian_create(HESSIAN_NULL));
+    map_put(status,"message",hessian_create(HESSIAN_STRING,"OK"));
+    map_put(status,"statusCode",status_code);
+    map_put(result,"decision",hessian_create(HESSIAN_INTEGER,(int32_t)XACML_DECISION_PERMIT));
+    map_put(result,"resourceId",hessian_create(HESSIAN_STRING,"x-urn:test:resource"));
+    map_put(result,"status",status);
+    map_put(result,"obligations",hessian_create(HESSIAN_LIST));
+    hessian_list_add(results,result);
+    map_put(response,"request",hessian_create(HESSIAN_NULL));
+    map_put(response,"results",results);
+    if (hessian_serialize(response,hessian) != HESSIAN_OK) {
+        return -1;
+    }
+    hessian_delete(response);
+    base64_encode_l(hessian,b64,BASE64_NO_LINE_BREAK);
+    mock_response_l= buffer_length(b64);
+    mock_response= calloc(mock_response_l + 1,1);
+    buffer_read(mock_response,1,mock_response_l,b64);
+    buffer_delete(hessian);
+    buffer_delete(b64);
+    return 0;
+}
+
+/** serves the HTTP/1.1 keep-alive connection: skips each request and answers the mock response */
+static void * mock_connection(void * arg) {
+    int fd= (int)(long)arg;
+    char header[8192], reply[256], discard[16384];
+    for (;;) {
+        size_t header_l= 0;
+        long content_l= 0;
+        char * end= NULL, * length;
+        ssize_t n;
+        while (end == NULL) {
+            n= recv(fd,header + header_l,sizeof(header) - header_l - 1,0);
+            if (n <= 0) {
+                close(fd);
+                return NULL;
+            }
+            header_l+= (size_t)n;
+            header[header_l]= '\0';
+            end= strstr(header,"\r\n\r\n");
+        }
+        length= strstr(header,"Content-Length:");
+        if (length != NULL) {
+            content_l= atol(length + strlen("Content-Length:"));
+        }
+        content_l-= (long)(header_l - (size_t)(end + 4 - header));
+        while (content_l > 0) {
+            n= recv(fd,discard,(content_l < (long)sizeof(discard)) ? (size_t)content_l : sizeof(discard),0);
+            if (n <= 0) {
+                close(fd);
+                return NULL;
+            }
+            content_l-= n;
+        }
+        n= snprintf(reply,sizeof(reply),"HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: %d\r\n\r\n",(int)mock_response_l);
+        if (send(fd,reply,(size_t)n,0) != n || send(fd,mock_response,mock_response_l,0) != (ssize_t)mock_response_l) {
+            close(fd);
+            return NULL;
+        }
+    }
+}
+
+static void * mock_pepd(void * arg) {
+    int listen_fd= (int)(long)arg;
+    for (;;) {
+        pthread_t thread;
+        int fd= accept(listen_fd,NULL,NULL);
+        if (fd < 0) {
+            return NULL;
+        }
+        pthread_create(&thread,NULL,mock_connection,(void *)(long)fd);
+        pthread_detach(thread);
+    }
+}
+
+/** starts the mock PEPd on a free port of the loopback, and returns its port or -1 */
+static int mock_pepd_start(void) {
+    struct sockaddr_in addr;
+    socklen_t addr_l= sizeof(addr);
+    pthread_t thread;
+    int fd= socket(AF_INET,SOCK_STREAM,0);
+    memset(&addr,0,sizeof(addr));
+    addr.sin_family= AF_INET;
+    addr.sin_addr.s_addr= htonl(INADDR_LOOPBACK);
+    addr.sin_port= 0;
+    if (fd < 0 || bind(fd,(struct sockaddr *)&addr,sizeof(addr)) != 0 || listen(fd,16) != 0
+        || getsockname(fd,(struct sockaddr *)&addr,&addr_l) != 0) {
+        return -1;
+    }
+    pthread_create(&thread,NULL,mock_pepd,(void *)(long)fd);
+    pthread_detach(thread);
+    return ntohs(addr.sin_port);
+}
+
+/** a request with a certificate chain of about chain_l bytes */
+static xacml_request_t * request_create(size_t chain_l) {
+    xacml_request_t * request= xacml_request_create();
+    xacml_subject_t * subject= xacml_subject_create();
+    xacml_resource_t * resource= xacml_resource_create();
+    xacml_attribute_t * attribute= xacml_attribute_create(XACML_SUBJECT_ID);
+    char * chain= malloc(chain_l + 1);
+    memset(chain,'A',chain_l);
+    chain[chain_l]= '\0';
+    xacml_attribute_addvalue(attribute,"CN=Test User,O=Example");
+    xacml_subject_addattribute(subject,attribute);
+    attribute= xacml_attribute_create(XACML_AUTHZINTEROP_SUBJECT_CERTCHAIN);
+    xacml_attribute_addvalue(attribute,chain);
+    xacml_subject_addattribute(subject,attribute);
+    xacml_request_addsubject(request,subject);
+    attribute= xacml_attribute_create(XACML_RESOURCE_ID);
+    xacml_attribute_addvalue(attribute,"x-urn:test:resource");
+    xacml_resource_addattribute(resource,attribute);
+    xacml_request_addresource(request,resource);
+    free(chain);
+    return request;
+}
+
+/** chain size of the i-th call: 20 KB, varying a bit */
+static size_t chain_size(int i) {
+    return 20000 + (size_t)(i % 4) * 500;
+}
+
+static int failures= 0;
+
+static void check(const char * test, pep_error_t rc, unsigned long allocations) {
+    if (rc != PEP_OK) {
+        printf("FAIL %s: %s\n",test,pep_strerror(rc));
+        failures++;
+    }
+    else if (allocations != 0) {
+        printf("FAIL %s: %lu transport allocations in %d warm calls\n",test,allocations,COUNTED);
+        failures++;
+    }
+    else {
+        printf("ok   %s: 0 transport allocations in %d warm calls\n",test,COUNTED);
+    }
+}
+
+/** synchronous authorizations, with or without decision cache */
+static void test_authorize(const char * url, int cache_size) {
+    PEP * pep= pep_initialize();
+    pep_error_t rc= PEP_OK;
+    unsigned long allocations= 0;
+    int i;
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,url);
+    pep_setoption(pep,PEP_OPTION_CACHE_SIZE,cache_size);
+    for (i= 0; i < WARMUP + COUNTED && rc == PEP_OK; i++) {
+        xacml_request_t * request= request_create(cache_size > 0 ? chain_size(0) : chain_size(i));
+        xacml_response_t * response= NULL;
+        unsigned long before= test_allocations;
+        rc= pep_authorize(pep,&request,&response);
+        if (i >= WARMUP) allocations+= test_allocations - before;
+        xacml_request_delete(request);
+        xacml_response_delete(response);
+    }
+    check(cache_size > 0 ? "pep_authorize, decision cache" : "pep_authorize",rc,allocations);
+    pep_destroy(pep);
+}
+
+static void async_done(PEP * pep, xacml_request_t ** request, xacml_response_t ** response, pep_error_t rc, void * callback_arg) {
+    pep_error_t * done_rc= callback_arg;
+    *done_rc= rc;
+}
+
+/** asynchronous authorizations, BATCH in flight at a time */
+static void test_authorize_async(const char * url) {
+    PEP * pep= pep_initialize();
+    pep_error_t rc= PEP_OK;
+    unsigned long allocations= 0;
+    int i, j, running;
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,url);
+    for (i= 0; i < WARMUP + COUNTED && rc == PEP_OK; i++) {
+        xacml_request_t * requests[BATCH];
+        xacml_response_t * responses[BATCH];
+        pep_error_t rcs[BATCH];
+        unsigned long before;
+        for (j= 0; j < BATCH; j++) {
+            requests[j]= request_create(chain_size(i + j));
+            responses[j]= NULL;
+            rcs[j]= PEP_ERR_ABORTED;
+        }
+        before= test_allocations;
+        for (j= 0; j < BATCH && rc == PEP_OK; j++) {
+            rc= pep_authorize_async(pep,&requests[j],&responses[j],async_done,&rcs[j]);
+        }
+        do {
+            pep_wait(pep,1000,&running);
+        } while (running > 0);
+        if (i >= WARMUP) allocations+= test_allocations - before;
+        for (j= 0; j < BATCH; j++) {
+            if (rc == PEP_OK) rc= rcs[j];
+            xacml_request_delete(requests[j]);
+            xacml_response_delete(responses[j]);
+        }
+    }
+    check("pep_authorize_async",rc,allocations);
+    pep_destroy(pep);
+}
+
+/** batch authorizations of BATCH requests */
+static void test_authorize_batch(const char * url) {
+    PEP * pep= pep_initialize();
+    pep_error_t rc= PEP_OK;
+    unsigned long allocations= 0;
+    int i, j;
+    pep_setoption(pep,PEP_OPTION_ENDPOINT_URL,url);
+    for (i= 0; i < WARMUP + COUNTED && rc == PEP_OK; i++) {
+        xacml_request_t * requests[BATCH];
+        xacml_response_t * responses[BATCH];
+        unsigned long before;
+        for (j= 0; j < BATCH; j++) {
+            requests[j]= request_create(chain_size(i + j));
+        }
+        before= test_allocations;
+        rc= pep_authorize_batch(pep,requests,BATCH,responses,NULL);
+        if (i >= WARMUP) allocations+= test_allocations - before;
+        for (j= 0; j < BATCH; j++) {
+            xacml_request_delete(requests[j]);
+            xacml_response_delete(responses[j]);
+        }
+    }
+    check("pep_authorize_batch",rc,allocations);
+    pep_destroy(pep);
+}
+
+int main(void) {
+    char url[64];
+    int port;
+    if (mock_response_create() != 0) {
+        printf("FAIL can't create the mock PEPd response\n");
+        return 1;
+    }
+    port= mock_pepd_start();
+    if (port < 0) {
+        printf("FAIL can't start the mock PEPd\n");
+        return 1;
+    }
+    snprintf(url,sizeof(url),"http://127.0.0.1:%d/authz",port);
+    test_authorize(url,0);
+    test_authorize(url,16);
+    test_authorize_async(url);
+    test_authorize_batch(url);
+    free(mock_response);
+    return (failures > 0) ? 1 : 0;
+}
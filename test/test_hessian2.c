@@ -0,0 +1,518 @@
+/*
+ * Copyright (c) Members of the EGEE Collaboration. 2006-2010.
+ * See http://www.eu-egee.org/partners/ for details on the copyright holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Hessian 2.0 round trip tests:
+ *  - strings and integers written by the Hessian 2.0 writer are read back;
+ *  - XACML requests marshalled in Hessian 1.0 and 2.0 decode to the same
+ *    Hessian objects tree, and their payload sizes are compared;
+ *  - the same XACML response, in Hessian 1.0 and 2.0, with and without refs,
+ *    unmarshals to the same XACML response, and every truncation of it fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "hessian.h"
+#include "buffer.h"
+#include "io.h"
+#include "xacml.h"
+#include "profiles.h"
+
+static int failures= 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAIL "); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+/*****************************************************
+ * Strings and integers                              *
+ *****************************************************/
+
+static const int32_t test_ints[]= {
+    0, 1, -1, -16, 47, -17, 48, -2048, 2047, -2049, 2048,
+    -262144, 262143, -262145, 262144, INT32_MIN, INT32_MAX
+};
+
+#define TEST_INTS (sizeof(test_ints) / sizeof(test_ints[0]))
+
+/** a string of n copies of the UTF-8 char c */
+static char * string_create(const char * c, size_t n) {
+    size_t c_l= strlen(c), i;
+    char * str= malloc(n * c_l + 1);
+    for (i= 0; i < n; i++) {
+        memcpy(str + i * c_l,c,c_l);
+    }
+    str[n * c_l]= '\0';
+    return str;
+}
+
+static void test_values(void) {
+    /* direct, short, 'S' and chunked lengths, 1, 2 and 4 bytes chars */
+    static const size_t lengths[]= { 0, 1, 31, 32, 1023, 1024, 32768, 40000 };
+    static const char * const chars[]= { "x", "\xc3\xa9", "\xf0\x9d\x84\x9e" };
+    char * strings[sizeof(lengths) / sizeof(lengths[0]) * 3];
+    size_t strings_l= 0, i, j;
+    BUFFER * output= buffer_create(1024);
+    hessian_reader_t * reader;
+    int errors= failures;
+    for (i= 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        for (j= 0; j < 3; j++) {
+            strings[strings_l]= string_create(chars[j],lengths[i]);
+            CHECK(hessian2_write_string(strings[strings_l],output) == HESSIAN_OK,"write string of %d chars",(int)lengths[i]);
+            strings_l++;
+        }
+    }
+    for (i= 0; i < TEST_INTS; i++) {
+        CHECK(hessian2_write_int(test_ints[i],output) == HESSIAN_OK,"write int %d",(int)test_ints[i]);
+    }
+    reader= hessian_reader_create(output);
+    hessian_reader_setversion(reader,HESSIAN_VERSION_2);
+    for (i= 0; i < strings_l; i++) {
+        size_t str_l;
+        const char * str;
+        CHECK(hessian_reader_next(reader) == HESSIAN_STRING,"read string %d",(int)i);
+        str= hessian_reader_getstring(reader,&str_l);
+        CHECK(str != NULL && str_l == strlen(strings[i]) && memcmp(str,strings[i],str_l) == 0,"string %d of %d bytes differs",(int)i,(int)strlen(strings[i]));
+        free(strings[i]);
+    }
+    for (i= 0; i < TEST_INTS; i++) {
+        CHECK(hessian_reader_next(reader) == HESSIAN_INTEGER && hessian_reader_getinteger(reader) == test_ints[i],"int %d differs",(int)test_ints[i]);
+    }
+    CHECK(buffer_length(output) == 0,"%d bytes left after the values",(int)buffer_length(output));
+    hessian_reader_delete(reader);
+    buffer_delete(output);
+    if (failures == errors) {
+        printf("ok   %d strings and %d integers read back\n",(int)strings_l,(int)TEST_INTS);
+    }
+}
+
+/*****************************************************
+ * XACML requests                                    *
+ *****************************************************/
+
+static xacml_attribute_t * attribute_create(const char * id, const char * datatype, const char * value) {
+    xacml_attribute_t * attribute= xacml_attribute_create(id);
+    if (datatype != NULL) xacml_attribute_setdatatype(attribute,datatype);
+    if (value != NULL) xacml_attribute_addvalue(attribute,value);
+    return attribute;
+}
+
+/** a Grid WN request: resources_l resources, fqans_l FQANs and a chain_l bytes cert chain */
+static xacml_request_t * request_create(int resources_l, int fqans_l, size_t chain_l) {
+    xacml_request_t * request= xacml_request_create();
+    xacml_subject_t * subject= xacml_subject_create();
+    xacml_action_t * action= xacml_action_create();
+    xacml_environment_t * environment= xacml_environment_create();
+    xacml_attribute_t * fqans= attribute_create(XACML_GRIDWN_ATTRIBUTE_FQAN,XACML_GRIDWN_DATATYPE_FQAN,NULL);
+    char * chain= string_create("A",chain_l);
+    char value[128];
+    int i;
+    xacml_subject_addattribute(subject,attribute_create(XACML_SUBJECT_ID,XACML_DATATYPE_X500NAME,"CN=Test User,OU=Unit,O=Example,C=CH"));
+    xacml_subject_addattribute(subject,attribute_create(XACML_GRIDWN_ATTRIBUTE_SUBJECT_ISSUER,XACML_DATATYPE_X500NAME,"CN=Test CA,O=Example,C=CH"));
+    xacml_subject_addattribute(subject,attribute_create(XACML_GRIDWN_ATTRIBUTE_VIRTUAL_ORGANIZATION,XACML_DATATYPE_STRING,"example.org"));
+    if (chain_l > 0) {
+        xacml_subject_addattribute(subject,attribute_create(XACML_SUBJECT_KEY_INFO,XACML_DATATYPE_STRING,chain));
+    }
+    for (i= 0; i < fqans_l; i++) {
+        snprintf(value,sizeof(value),"/example.org/group%d/Role=NULL/Capability=NULL",i);
+        xacml_attribute_addvalue(fqans,value);
+    }
+    if (fqans_l > 0) {
+        xacml_subject_addattribute(subject,fqans);
+    }
+    else {
+        xacml_attribute_delete(fqans);
+    }
+    xacml_request_addsubject(request,subject);
+    for (i= 0; i < resources_l; i++) {
+        xacml_resource_t * resource= xacml_resource_create();
+        snprintf(value,sizeof(value),"x-urn:example:resource:%d",i);
+        xacml_resource_addattribute(resource,attribute_create(XACML_RESOURCE_ID,NULL,value));
+        xacml_request_addresource(request,resource);
+    }
+    xacml_action_addattribute(action,attribute_create(XACML_ACTION_ID,NULL,"x-urn:example:action:execute"));
+    xacml_request_setaction(request,action);
+    xacml_environment_addattribute(environment,attribute_create(XACML_GRIDWN_ATTRIBUTE_PROFILE_ID,XACML_DATATYPE_ANYURI,XACML_GRIDWN_PROFILE_VERSION));
+    xacml_request_setenvironment(request,environment);
+    free(chain);
+    return request;
+}
+
+static int tree_equals(const hessian_object_t * a, const hessian_object_t * b);
+
+/** TRUE if the string keyed values of a are in b, null values being optional */
+static int map_contains(const hessian_object_t * a, const hessian_object_t * b) {
+    size_t a_l= hessian_map_length(a), b_l= hessian_map_length(b), i, j;
+    for (i= 0; i < a_l; i++) {
+        const hessian_object_t * key= hessian_map_getkey(a,(int)i);
+        const hessian_object_t * value= hessian_map_getvalue(a,(int)i);
+        if (hessian_gettype(key) != HESSIAN_STRING) return FALSE;
+        for (j= 0; j < b_l; j++) {
+            const hessian_object_t * b_key= hessian_map_getkey(b,(int)j);
+            if (hessian_gettype(b_key) == HESSIAN_STRING
+                && strcmp(hessian_string_getstring(key),hessian_string_getstring(b_key)) == 0) break;
+        }
+        if (j == b_l) {
+            if (hessian_gettype(value) != HESSIAN_NULL) return FALSE;
+        }
+        else if (!tree_equals(value,hessian_map_getvalue(b,(int)j))) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * TRUE if both Hessian trees hold the same values: list types are ignored,
+ * Hessian 2.0 objects write their null fields where Hessian 1.0 maps omit them.
+ */
+static int tree_equals(const hessian_object_t * a, const hessian_object_t * b) {
+    hessian_t type= hessian_gettype(a);
+    size_t i;
+    if (type != hessian_gettype(b)) return FALSE;
+    switch (type) {
+    case HESSIAN_NULL:
+        return TRUE;
+    case HESSIAN_BOOLEAN:
+        return hessian_boolean_getvalue(a) == hessian_boolean_getvalue(b);
+    case HESSIAN_INTEGER:
+        return hessian_integer_getvalue(a) == hessian_integer_getvalue(b);
+    case HESSIAN_STRING:
+        return strcmp(hessian_string_getstring(a),hessian_string_getstring(b)) == 0;
+    case HESSIAN_LIST:
+        if (hessian_list_length(a) != hessian_list_length(b)) return FALSE;
+        for (i= 0; i < hessian_list_length(a); i++) {
+            if (!tree_equals(hessian_list_get(a,(int)i),hessian_list_get(b,(int)i))) return FALSE;
+        }
+        return TRUE;
+    case HESSIAN_MAP:
+        if ((hessian_map_gettype(a) == NULL) != (hessian_map_gettype(b) == NULL)
+            || (hessian_map_gettype(a) != NULL && strcmp(hessian_map_gettype(a),hessian_map_gettype(b)) != 0)) {
+            return FALSE;
+        }
+        return map_contains(a,b) && map_contains(b,a);
+    default:
+        return FALSE;
+    }
+}
+
+static void test_request(const char * name, xacml_request_t * request) {
+    BUFFER * v1= buffer_create(1024);
+    BUFFER * v2= buffer_create(1024);
+    hessian_object_t * tree1= NULL, * tree2= NULL;
+    hessian_reader_t * reader;
+    size_t v1_l, v2_l;
+    CHECK(xacml_request_marshalling(request,HESSIAN_VERSION_1,v1) == PEP_OK,"%s: marshal Hessian 1.0",name);
+    CHECK(xacml_request_marshalling(request,HESSIAN_VERSION_2,v2) == PEP_OK,"%s: marshal Hessian 2.0",name);
+    v1_l= buffer_length(v1);
+    v2_l= buffer_length(v2);
+    tree1= hessian_deserialize(v1);
+    reader= hessian_reader_create(v2);
+    if (reader != NULL) {
+        tree2= hessian_reader_getobject(reader,hessian_reader_next(reader));
+        CHECK(hessian_reader_getversion(reader) == HESSIAN_VERSION_2,"%s: Hessian 2.0 not detected",name);
+    }
+    CHECK(tree1 != NULL && tree2 != NULL && tree_equals(tree1,tree2),"%s: Hessian 1.0 and 2.0 requests differ",name);
+    CHECK(buffer_length(v1) == 0 && buffer_length(v2) == 0,"%s: input left after the request",name);
+    CHECK(v2_l < v1_l,"%s: Hessian 2.0 request not smaller",name);
+    printf("ok   request %-36s Hessian 1.0: %7d bytes, 2.0: %7d bytes (%+.0f%%)\n",name,(int)v1_l,(int)v2_l,(v2_l - (double)v1_l) * 100 / v1_l);
+    hessian_delete(tree1);
+    hessian_delete(tree2);
+    hessian_reader_delete(reader);
+    buffer_delete(v1);
+    buffer_delete(v2);
+    xacml_request_delete(request);
+}
+
+/*****************************************************
+ * XACML responses                                   *
+ *****************************************************/
+
+/* response classes, and their fields in the Hessian 2.0 definitions */
+enum { CLASS_RESPONSE, CLASS_RESULT, CLASS_STATUS, CLASS_STATUSCODE, CLASS_OBLIGATION, CLASS_ASSIGNMENT, CLASSES };
+
+static const char * const class_names[CLASSES]= {
+    "org.glite.authz.common.model.Response",
+    "org.glite.authz.common.model.Result",
+    "org.glite.authz.common.model.Status",
+    "org.glite.authz.common.model.StatusCode",
+    "org.glite.authz.common.model.Obligation",
+    "org.glite.authz.common.model.AttributeAssignment"
+};
+
+static const char * const response_fields[]= { "request", "results" };
+static const char * const result_fields[]= { "decision", "resourceId", "status", "obligations" };
+static const char * const status_fields[]= { "message", "statusCode" };
+static const char * const statuscode_fields[]= { "code", "subCode" };
+static const char * const obligation_fields[]= { "id", "fulfillOn", "attributeAssignments" };
+static const char * const assignment_fields[]= { "attributeId", "dataType", "value" };
+
+static const char * const * const class_fields[CLASSES]= {
+    response_fields, result_fields, status_fields, statuscode_fields, obligation_fields, assignment_fields
+};
+
+static const size_t class_fields_l[CLASSES]= { 2, 4, 2, 2, 3, 3 };
+
+/* writes the same response in Hessian 1.0 or 2.0, with the same ref numbers */
+typedef struct writer {
+    BUFFER * output;
+    int version;
+    int refs; /* maps, lists and objects written */
+    int defs[CLASSES]; /* Hessian 2.0 class definition index, or -1 */
+    int defs_l;
+} writer_t;
+
+static void writer_init(writer_t * w, int version) {
+    int i;
+    w->output= buffer_create(1024);
+    w->version= version;
+    w->refs= 0;
+    for (i= 0; i < CLASSES; i++) w->defs[i]= -1;
+    w->defs_l= 0;
+}
+
+/** begins an object, returns its ref */
+static int write_begin(writer_t * w, int class) {
+    if (w->version == HESSIAN_VERSION_1) {
+        hessian_writer_begin_map(class_names[class],w->output);
+    }
+    else {
+        if (w->defs[class] < 0) {
+            hessian2_write_classdef(class_names[class],class_fields[class],class_fields_l[class],w->output);
+            w->defs[class]= w->defs_l++;
+        }
+        hessian2_writer_begin_object(w->defs[class],w->output);
+    }
+    return w->refs++;
+}
+
+static void write_end(writer_t * w) {
+    if (w->version == HESSIAN_VERSION_1) hessian_writer_end(w->output);
+}
+
+/** begins a list, returns its ref */
+static int write_begin_list(writer_t * w, size_t length) {
+    if (w->version == HESSIAN_VERSION_1) {
+        hessian_writer_begin_list(NULL,length,w->output);
+    }
+    else {
+        hessian2_writer_begin_list(length,w->output);
+    }
+    return w->refs++;
+}
+
+/** the field name, only written as map key in Hessian 1.0 */
+static void write_field(writer_t * w, const char * name) {
+    if (w->version == HESSIAN_VERSION_1) hessian_write_string(name,w->output);
+}
+
+static void write_string(writer_t * w, const char * name, const char * value) {
+    write_field(w,name);
+    if (value == NULL) {
+        hessian_write_null(w->output);
+    }
+    else if (w->version == HESSIAN_VERSION_1) {
+        hessian_write_string(value,w->output);
+    }
+    else {
+        hessian2_write_string(value,w->output);
+    }
+}
+
+static void write_int(writer_t * w, const char * name, int32_t value) {
+    write_field(w,name);
+    if (w->version == HESSIAN_VERSION_1) {
+        buffer_putc('I',w->output);
+        buffer_putbe32((uint32_t)value,w->output);
+    }
+    else {
+        hessian2_write_int(value,w->output);
+    }
+}
+
+static void write_ref(writer_t * w, const char * name, int ref) {
+    write_field(w,name);
+    if (w->version == HESSIAN_VERSION_1) {
+        buffer_putc('R',w->output);
+        buffer_putbe32((uint32_t)ref,w->output);
+    }
+    else {
+        buffer_putc('Q',w->output);
+        hessian2_write_int(ref,w->output);
+    }
+}
+
+/**
+ * Writes a response of results_l results of obligations_l obligations. With
+ * shared, the results after the first refer to its status and obligations.
+ */
+static BUFFER * response_write(int version, int results_l, int obligations_l, int shared) {
+    writer_t w;
+    int status_ref= -1, obligations_ref= -1, i, j, k;
+    char value[64];
+    writer_init(&w,version);
+    write_begin(&w,CLASS_RESPONSE);
+    write_string(&w,"request",NULL);
+    write_field(&w,"results");
+    write_begin_list(&w,results_l);
+    for (i= 0; i < results_l; i++) {
+        write_begin(&w,CLASS_RESULT);
+        write_int(&w,"decision",XACML_DECISION_PERMIT);
+        snprintf(value,sizeof(value),"x-urn:example:resource:%d",i);
+        write_string(&w,"resourceId",value);
+        if (shared && i > 0) {
+            write_ref(&w,"status",status_ref);
+        }
+        else {
+            write_field(&w,"status");
+            status_ref= write_begin(&w,CLASS_STATUS);
+            write_string(&w,"message","OK");
+            write_field(&w,"statusCode");
+            write_begin(&w,CLASS_STATUSCODE);
+            write_string(&w,"code",XACML_STATUSCODE_OK);
+            write_string(&w,"subCode",NULL);
+            write_end(&w);
+            write_end(&w);
+        }
+        if (shared && i > 0) {
+            write_ref(&w,"obligations",obligations_ref);
+        }
+        else {
+            write_field(&w,"obligations");
+            obligations_ref= write_begin_list(&w,obligations_l);
+            for (j= 0; j < obligations_l; j++) {
+                write_begin(&w,CLASS_OBLIGATION);
+                write_string(&w,"id",XACML_GRIDWN_OBLIGATION_LOCAL_ENVIRONMENT_MAP_POSIX);
+                write_int(&w,"fulfillOn",XACML_FULFILLON_PERMIT);
+                write_field(&w,"attributeAssignments");
+                write_begin_list(&w,2);
+                for (k= 0; k < 2; k++) {
+                    write_begin(&w,CLASS_ASSIGNMENT);
+                    write_string(&w,"attributeId",(k == 0) ? XACML_GRIDWN_ATTRIBUTE_USER_ID : XACML_GRIDWN_ATTRIBUTE_GROUP_ID_PRIMARY);
+                    write_string(&w,"dataType",XACML_DATATYPE_STRING);
+                    snprintf(value,sizeof(value),"%s%d",(k == 0) ? "user" : "group",j);
+                    write_string(&w,"value",value);
+                    write_end(&w);
+                }
+                if (version == HESSIAN_VERSION_1) hessian_writer_end(w.output);
+                write_end(&w);
+            }
+            if (version == HESSIAN_VERSION_1) hessian_writer_end(w.output);
+        }
+        write_end(&w);
+    }
+    if (version == HESSIAN_VERSION_1) hessian_writer_end(w.output);
+    write_end(&w);
+    return w.output;
+}
+
+/** the response as text, or NULL if it can't be unmarshalled */
+static char * response_dump(BUFFER * input) {
+    xacml_response_t * response= NULL;
+    char * dump= NULL;
+    size_t dump_l, results_l, i, j, k;
+    FILE * out;
+    if (xacml_response_unmarshalling(&response,input,NULL) != PEP_OK) {
+        return NULL;
+    }
+    out= open_memstream(&dump,&dump_l);
+    results_l= xacml_response_results_length(response);
+    for (i= 0; i < results_l; i++) {
+        xacml_result_t * result= xacml_response_getresult(response,(int)i);
+        xacml_status_t * status= xacml_result_getstatus(result);
+        size_t obligations_l= xacml_result_obligations_length(result);
+        fprintf(out,"result %d %s status %s %s\n",(int)xacml_result_getdecision(result),xacml_result_getresourceid(result),
+                xacml_status_getmessage(status),xacml_statuscode_getvalue(xacml_status_getcode(status)));
+        for (j= 0; j < obligations_l; j++) {
+            xacml_obligation_t * obligation= xacml_result_getobligation(result,(int)j);
+            size_t assignments_l= xacml_obligation_attributeassignments_length(obligation);
+            fprintf(out," obligation %s %d\n",xacml_obligation_getid(obligation),(int)xacml_obligation_getfulfillon(obligation));
+            for (k= 0; k < assignments_l; k++) {
+                xacml_attributeassignment_t * assignment= xacml_obligation_getattributeassignment(obligation,(int)k);
+                fprintf(out,"  %s %s %s\n",xacml_attributeassignment_getid(assignment),
+                        xacml_attributeassignment_getdatatype(assignment),xacml_attributeassignment_getvalue(assignment));
+            }
+        }
+    }
+    fclose(out);
+    xacml_response_delete(response);
+    return dump;
+}
+
+static void test_response(int results_l, int obligations_l) {
+    BUFFER * v1= response_write(HESSIAN_VERSION_1,results_l,obligations_l,FALSE);
+    BUFFER * v2= response_write(HESSIAN_VERSION_2,results_l,obligations_l,FALSE);
+    BUFFER * v1_refs= response_write(HESSIAN_VERSION_1,results_l,obligations_l,TRUE);
+    BUFFER * v2_refs= response_write(HESSIAN_VERSION_2,results_l,obligations_l,TRUE);
+    size_t v1_l= buffer_length(v1), v2_l= buffer_length(v2), v1_refs_l= buffer_length(v1_refs), v2_refs_l= buffer_length(v2_refs);
+    char * dump= response_dump(v1);
+    char * dump2= response_dump(v2);
+    char * dump1_refs= response_dump(v1_refs);
+    char * dump2_refs= response_dump(v2_refs);
+    int errors= failures;
+    CHECK(dump != NULL,"response: can't unmarshal Hessian 1.0");
+    CHECK(dump2 != NULL && dump != NULL && strcmp(dump,dump2) == 0,"response: Hessian 2.0 differs from 1.0");
+    CHECK(dump1_refs != NULL && dump != NULL && strcmp(dump,dump1_refs) == 0,"response: Hessian 1.0 with refs differs");
+    CHECK(dump2_refs != NULL && dump != NULL && strcmp(dump,dump2_refs) == 0,"response: Hessian 2.0 with refs differs");
+    if (failures == errors) {
+        printf("ok   response %d results %3d obligations  Hessian 1.0: %7d bytes, 2.0: %7d bytes (%+.0f%%), with refs: %d and %d bytes\n",
+               results_l,obligations_l,(int)v1_l,(int)v2_l,(v2_l - (double)v1_l) * 100 / v1_l,(int)v1_refs_l,(int)v2_refs_l);
+    }
+    free(dump);
+    free(dump2);
+    free(dump1_refs);
+    free(dump2_refs);
+    buffer_delete(v1);
+    buffer_delete(v2);
+    buffer_delete(v1_refs);
+    buffer_delete(v2_refs);
+}
+
+/** every truncation of the Hessian 2.0 response with refs fails */
+static void test_truncations(void) {
+    BUFFER * full= response_write(HESSIAN_VERSION_2,3,2,TRUE);
+    size_t full_l= buffer_length(full), l;
+    unsigned char * bytes= malloc(full_l);
+    int errors= failures;
+    buffer_read(bytes,1,full_l,full);
+    for (l= 0; l < full_l; l++) {
+        BUFFER * input= buffer_create(full_l);
+        xacml_response_t * response= NULL;
+        buffer_write(bytes,1,l,input);
+        CHECK(xacml_response_unmarshalling(&response,input,NULL) != PEP_OK,"response truncated to %d bytes of %d unmarshalled",(int)l,(int)full_l);
+        xacml_response_delete(response);
+        buffer_delete(input);
+    }
+    if (failures == errors) {
+        printf("ok   %d truncations of a Hessian 2.0 response with refs fail\n",(int)full_l);
+    }
+    free(bytes);
+    buffer_delete(full);
+}
+
+int main(void) {
+    test_values();
+    test_request("1 resource",request_create(1,0,0));
+    test_request("1 resource, 10 FQANs, 5 KB chain",request_create(1,10,5000));
+    test_request("50 resources, 200 FQANs, 5 KB chain",request_create(50,200,5000));
+    test_response(1,1);
+    test_response(3,20);
+    test_response(20,200);
+    test_truncations();
+    return (failures > 0) ? 1 : 0;
+}